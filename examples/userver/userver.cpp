@@ -78,6 +78,8 @@ public:
       //
       // LISTEN_BACKLOG             max number of ready to be delivered connections to accept()
       // SET_REALTIME_PRIORITY      flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
+      // REUSEPORT_CPU_STEERING     flag indicating that every preforked process is pinned to a cpu and that the kernel steers (SO_REUSEPORT+BPF)
+      //                            the new connections to the listening socket of the process running on the cpu that received them
       //
       // CLIENT_THRESHOLD           min number of clients to active polling
       // CLIENT_FOR_PARALLELIZATION minum number of clients to active parallelization 
@@ -0,0 +1,125 @@
+// userver_logdec.cpp
+
+#include <ulib/file.h>
+#include <ulib/utility/services.h>
+#include <ulib/utility/string_ext.h>
+#include <ulib/utility/binary_access_log.h>
+
+#undef  PACKAGE
+#define PACKAGE "userver_logdec"
+
+#define ARGS "[path of binary apache like log...]"
+
+#define U_OPTIONS \
+"purpose 'decode the apache like log written by userver with APACHE_LIKE_LOG_BINARY (NCSA combined format or JSON, read standard input without file)'\n" \
+"option j json  0 'output a JSON object for every record' ''\n" \
+"option s stat  0 'print on standard error the number of records decoded' ''\n"
+
+#include <ulib/application.h>
+
+class Application : public UApplication {
+public:
+
+   Application()
+      {
+      U_TRACE(5, "Application::Application()")
+
+      json = false;
+      }
+
+   ~Application()
+      {
+      U_TRACE(5, "Application::~Application()")
+      }
+
+   void decode(UString& content)
+      {
+      U_TRACE(5, "Application::decode(%u)", content.size())
+
+#  ifdef USE_LIBZ
+      if (UStringExt::isGzip(content)) content = UStringExt::gunzip(content); // NB: a segment of the log rotated with LOG_FILE_SZ...
+#  endif
+
+      uaccesslogrecord r;
+
+      reader.setInput(U_STRING_TO_PARAM(content));
+
+      while (reader.next(r))
+         {
+         if (json) UBinaryAccessLogReader::appendJSON(output, r);
+         else      UBinaryAccessLogReader::appendCombined(output, r);
+
+         if (output.size() >= (64U * 1024U)) flush();
+         }
+      }
+
+   void flush()
+      {
+      U_TRACE_NO_PARAM(5, "Application::flush()")
+
+      if (output)
+         {
+         (void) write(STDOUT_FILENO, U_STRING_TO_PARAM(output));
+
+         output.setEmpty();
+         }
+      }
+
+   void run(int argc, char* argv[], char* env[])
+      {
+      U_TRACE(5, "Application::run(%d,%p,%p)", argc, argv, env)
+
+      UApplication::run(argc, argv, env);
+
+      bool stat = false;
+
+      if (UApplication::isOptions())
+         {
+         json = (opt['j'] == U_STRING_FROM_CONSTANT("1"));
+         stat = (opt['s'] == U_STRING_FROM_CONSTANT("1"));
+         }
+
+      output.setBuffer(128U * 1024U);
+
+      if (optind >= argc)
+         {
+         UString content(U_CAPACITY);
+
+         UServices::readEOF(STDIN_FILENO, content);
+
+         decode(content);
+         }
+      else
+         {
+         for (; optind < argc; ++optind)
+            {
+            UString content = UFile::contentOf(UString(argv[optind]));
+
+            if (content) decode(content);
+            else
+               {
+               U_WARNING("%s: I can't read the file or it is empty", argv[optind]);
+               }
+            }
+         }
+
+      flush();
+
+      if (stat)
+         {
+         U_MESSAGE("%u records, %u segments, %u records skipped (the start of the segment is not in the input), %u bytes not decoded",
+                     reader.getNumRecord(), reader.getNumSegment(), reader.getNumSkipped(), reader.getNumGarbage());
+         }
+      }
+
+private:
+   UBinaryAccessLogReader reader;
+   UString output;
+   bool json;
+
+#ifndef U_COVERITY_FALSE_POSITIVE
+   U_DISALLOW_COPY_AND_ASSIGN(Application)
+#endif
+};
+
+U_MAIN
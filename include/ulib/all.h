@@ -2,6 +2,7 @@
 
 #include <ulib/base/hash.h>
 #include <ulib/cache.h>
+#include <ulib/shared_cache.h>
 #include <ulib/timer.h>
 #include <ulib/options.h>
 #include <ulib/process.h>
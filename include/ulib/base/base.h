@@ -185,6 +185,7 @@ typedef void* (*pvPFpv)  (void*);
 typedef void  (*vpFpcu)  (const char*,uint32_t);
 typedef bool  (*bPFpcu)  (const char*,uint32_t);
 typedef void  (*vPFpvu)  (void*,uint32_t);
+typedef void  (*vPFpvb)  (void*,bool);
 typedef int   (*iPFpvpv) (void*,void*);
 typedef bool  (*bPFpvpv) (void*,void*);
 typedef bool  (*bPFpcpc) (const char*,const char*);
@@ -0,0 +1,463 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    flat_hash_map.h - open addressing variant of UHashMap
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_FLAT_HASH_MAP_H
+#define ULIB_FLAT_HASH_MAP_H 1
+
+#include <ulib/container/hash_map.h>
+
+/**
+ * UFlatHashMap is an open addressing (swiss table like) variant of UHashMap with the same API (find(), insertAfterFind(), eraseAfterFind(),
+ * callForAllEntry(), ...), so that a hot user can switch to it changing only the type.
+ *
+ * The entries (key, elem, hash) are stored inline in an array of slots: an insert don't allocate a node and a lookup don't chase pointers.
+ * For every slot a control byte holds a 7 bit fingerprint of the hash (0x00-0x7F) or the marks EMPTY/DELETED. A lookup compares the control
+ * bytes of a group of slots at once (with SSE2) and reads only the slots that match, stopping at the first group with an empty slot.
+ * The control bytes of the first group are replicated after the end of the array, so the load of a group never wraps.
+ *
+ * The table grows at 7/8 of load. An erase leaves a tombstone (DELETED) only if some probe sequence can have crossed the slot, the tombstones
+ * are purged by the next rehash. NB: an erase don't move the other entries, so it is safe to erase the current entry while traversing the table...
+ */
+
+#define U_FLAT_HASH_MAP_GROUP 16
+
+#define U_FLAT_HASH_MAP_EMPTY   ((int8_t)-128) // 0x80
+#define U_FLAT_HASH_MAP_DELETED ((int8_t)  -2) // 0xFE
+
+typedef struct uflathashmapslot {
+   const void* elem;
+   const UStringRep* key;
+   uint32_t hash;
+} uflathashmapslot;
+
+
+template <> class U_EXPORT UFlatHashMap<void*> {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   // Costruttori e distruttore
+
+   UFlatHashMap(uint32_t n = 64, bool ignore_case = false);
+
+   ~UFlatHashMap()
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UFlatHashMap<void*>)
+
+      U_INTERNAL_ASSERT_EQUALS(_length, 0)
+
+      if (_capacity) _deallocate();
+      }
+
+   // size and capacity
+
+   uint32_t size() const
+      {
+      U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::size()")
+
+      U_RETURN(_length);
+      }
+
+   uint32_t capacity() const
+      {
+      U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::capacity()")
+
+      U_RETURN(_capacity);
+      }
+
+   bool empty() const
+      {
+      U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::empty()")
+
+      if (_length) U_RETURN(false);
+
+      U_RETURN(true);
+      }
+
+   void setIgnoreCase(bool flag)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::setIgnoreCase(%b)", flag)
+
+      U_INTERNAL_ASSERT_EQUALS(_length, 0)
+
+      bignore_case = flag;
+      }
+
+   bool ignoreCase() const { return bignore_case; }
+
+   // ricerche
+
+   bool find(const UString& _key)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::find(%V)", _key.rep)
+
+      lookup(_key.rep);
+
+      if (slot) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   bool find(const char* _key, uint32_t keylen)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::find(%.*S,%u)", keylen, _key, keylen)
+
+      lookup(_key, keylen);
+
+      if (slot) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   // set/get methods
+
+   void* operator[](const char*       _key) { return at(_key, u__strlen(_key, __PRETTY_FUNCTION__)); }
+   void* operator[](const UString&    _key) { return at(_key.rep); }
+   void* operator[](const UStringRep* _key) { return at(_key); }
+
+   const void* elem() const      { return slot->elem; }
+   const UString getKey() const  { return UString(slot->key); }
+   const UStringRep* key() const { return slot->key; }
+
+   template <typename T> T* get(const UString& _key)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::get(%V)", _key.rep)
+
+      return (T*) operator[](_key);
+      }
+
+   // sets a field, overwriting any existing value
+
+   void insert(const UString& _key, const void* _elem)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::insert(%V,%p)", _key.rep, _elem)
+
+      lookup(_key.rep);
+
+      if (slot) slot->elem = _elem;
+      else      insertAfterFind(_key.rep, _elem);
+      }
+
+   // after called find() (don't make the lookup)
+
+   void insertAfterFind(const UString&    _key, const void* _elem) { insertAfterFind(_key.rep, _elem); }
+   void insertAfterFind(const UStringRep* _key, const void* _elem);
+
+   void   eraseAfterFind();
+   void replaceAfterFind(const void* _elem)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::replaceAfterFind(%p)", _elem)
+
+      U_INTERNAL_ASSERT_POINTER(slot)
+
+      slot->elem = _elem;
+      }
+
+   void* erase(const char*       _key);
+   void* erase(const UString&    _key) { return erase(_key.rep); }
+   void* erase(const UStringRep* _key);
+
+   // make room for a total of n element (without rehash)
+
+   void reserve(uint32_t n);
+
+   // Traverse the hash table for all entry
+
+   uflathashmapslot* first();
+   bool              next();
+
+   // call function for all entry
+
+   void callForAllEntry(bPFprpv function);
+   void callForAllEntrySorted(bPFprpv function)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::callForAllEntrySorted(%p)", function)
+
+      U_INTERNAL_DUMP("_length = %u", _length)
+
+      if (_length < 2)
+         {
+         callForAllEntry(function);
+
+         return;
+         }
+
+      _callForAllEntrySorted(function);
+      }
+
+   void getKeys(UVector<UString>& vec);
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   int8_t* ctrl;
+   uflathashmapslot* slot;
+   uflathashmapslot* slots;
+   uint32_t _capacity, _length, ndeleted, hash;
+public:
+   uint32_t index;
+protected:
+   bool bignore_case;
+
+#ifdef DEBUG
+   bool check_memory() const; // check all element
+#endif
+
+   // allocate and deallocate methods
+
+   void _allocate(uint32_t n);
+   void _deallocate();
+
+   void rehash(uint32_t n);
+
+   // NB: we replicate the control bytes of the first group after the end, so the load of a group never wraps...
+
+   void setCtrl(uint32_t i, int8_t h)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::setCtrl(%u,%d)", i, h)
+
+      U_INTERNAL_ASSERT_MINOR(i, _capacity)
+
+      ctrl[i] = h;
+
+      if (i < U_FLAT_HASH_MAP_GROUP) ctrl[_capacity + i] = h;
+      }
+
+   uint32_t growthLimit() const { return _capacity - (_capacity / 8); } // 7/8 of load
+
+   static uint32_t capacityFor(uint32_t n)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::capacityFor(%u)", n)
+
+      n += n / 7 + 1;
+
+      if (n <= U_FLAT_HASH_MAP_GROUP) U_RETURN(U_FLAT_HASH_MAP_GROUP);
+
+      uint32_t sz = (uint32_t)u_nextPowerOfTwo(n);
+
+      U_RETURN(sz);
+      }
+
+   // Find a elem in the array with <key>
+
+   void* at(const UStringRep* _key)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::at(%V)", _key)
+
+      lookup(_key);
+
+      if (slot) U_RETURN((void*)slot->elem);
+
+      U_RETURN((void*)U_NULLPTR);
+      }
+
+   void* at(const char* _key, uint32_t keylen)
+      {
+      U_TRACE(0, "UFlatHashMap<void*>::at(%.*S,%u)", keylen, _key, keylen)
+
+      lookup(_key, keylen);
+
+      if (slot) U_RETURN((void*)slot->elem);
+
+      U_RETURN((void*)U_NULLPTR);
+      }
+
+   void lookup(const UStringRep* keyr) { lookup(keyr->data(), keyr->size()); }
+   void lookup(const char* key, uint32_t keylen);
+
+   uint32_t findFree(uint32_t _hash) const __pure;
+
+   void _callForAllEntrySorted(bPFprpv function);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UFlatHashMap<void*>)
+};
+
+template <class T> class U_EXPORT UFlatHashMap<T*> : public UFlatHashMap<void*> {
+public:
+
+   UFlatHashMap(uint32_t n = 64, bool ignore_case = false) : UFlatHashMap<void*>(n, ignore_case)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UFlatHashMap<T*>, "%u,%b", n, ignore_case)
+      }
+
+   ~UFlatHashMap()
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UFlatHashMap<T*>)
+
+      clear();
+      }
+
+   T* erase(const char*       _key) { return (T*) UFlatHashMap<void*>::erase(_key); }
+   T* erase(const UString&    _key) { return (T*) UFlatHashMap<void*>::erase(_key.rep); }
+   T* erase(const UStringRep* _key) { return (T*) UFlatHashMap<void*>::erase(_key); }
+
+   T* elem() const { return (T*) UFlatHashMap<void*>::elem(); }
+
+   T* operator[](const char*       _key) { return (T*) UFlatHashMap<void*>::operator[](_key); }
+   T* operator[](const UString&    _key) { return (T*) UFlatHashMap<void*>::operator[](_key); }
+   T* operator[](const UStringRep* _key) { return (T*) UFlatHashMap<void*>::operator[](_key); }
+
+   void eraseAfterFind()
+      {
+      U_TRACE_NO_PARAM(0, "UFlatHashMap<T*>::eraseAfterFind()")
+
+      U_INTERNAL_ASSERT_POINTER(slot)
+
+      u_destroy<T>((const T*)slot->elem);
+
+      UFlatHashMap<void*>::eraseAfterFind();
+      }
+
+   void insertAfterFind(const UStringRep* _key, const T* _elem)
+      {
+      U_TRACE(0, "UFlatHashMap<T*>::insertAfterFind(%V,%p)", _key, _elem)
+
+      u_construct<T>(&_elem, false);
+
+      if (slot == U_NULLPTR) UFlatHashMap<void*>::insertAfterFind(_key, _elem);
+      else
+         {
+         u_destroy<T>((const T*)slot->elem);
+
+         slot->elem = _elem;
+         }
+      }
+
+   void insertAfterFind(const UString& _key, const T* _elem) { insertAfterFind(_key.rep, _elem); }
+
+   void replaceAfterFind(const T* _elem)
+      {
+      U_TRACE(0, "UFlatHashMap<T*>::replaceAfterFind(%p)", _elem)
+
+      U_INTERNAL_ASSERT_POINTER(slot)
+
+      u_construct<T>(&_elem, false);
+
+      u_destroy<T>((const T*)slot->elem);
+
+      UFlatHashMap<void*>::replaceAfterFind(_elem);
+      }
+
+   // sets a field, overwriting any existing value
+
+   void insert(const UStringRep* _key, const T* _elem)
+      {
+      U_TRACE(0, "UFlatHashMap<T*>::insert(%V,%p)", _key, _elem)
+
+      UFlatHashMap<void*>::lookup(_key);
+
+      insertAfterFind(_key, _elem);
+      }
+
+   void insert(const UString& _key, const T* _elem) { insert(_key.rep, _elem); }
+
+   // find a elem in the array with <key>
+
+   T* at(const UString& _key)               { return (T*) UFlatHashMap<void*>::at(_key.rep); }
+   T* at(const UStringRep* keyr)            { return (T*) UFlatHashMap<void*>::at(keyr); }
+   T* at(const char* _key, uint32_t keylen) { return (T*) UFlatHashMap<void*>::at(_key, keylen); }
+
+   void clear() // erase all element
+      {
+      U_TRACE_NO_PARAM(0, "UFlatHashMap<T*>::clear()")
+
+      U_INTERNAL_DUMP("_length = %u ndeleted = %u", _length, ndeleted)
+
+      if (_length ||
+          ndeleted)
+         {
+         for (uint32_t i = 0; i < _capacity; ++i)
+            {
+            if (ctrl[i] >= 0) // full
+               {
+               u_destroy<T>((const T*)slots[i].elem);
+
+               ((UStringRep*)slots[i].key)->release(); // NB: we decreases the reference string...
+               }
+            }
+
+         (void) U_SYSCALL(memset, "%p,%d,%u", ctrl, U_FLAT_HASH_MAP_EMPTY, _capacity + U_FLAT_HASH_MAP_GROUP);
+
+         slot    = U_NULLPTR;
+         _length =
+         ndeleted = 0;
+         }
+      }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const { return UFlatHashMap<void*>::dump(reset); }
+#endif
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UFlatHashMap<T*>)
+};
+
+template <> class U_EXPORT UFlatHashMap<UString> : public UFlatHashMap<UStringRep*> {
+public:
+
+   explicit UFlatHashMap(uint32_t n = 64, bool ignore_case = false) : UFlatHashMap<UStringRep*>(n, ignore_case)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UFlatHashMap<UString>, "%u,%b", n, ignore_case)
+      }
+
+   ~UFlatHashMap()
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UFlatHashMap<UString>)
+      }
+
+   void replaceAfterFind(const UString& str)
+      {
+      U_TRACE(0, "UFlatHashMap<UString>::replaceAfterFind(%V)", str.rep)
+
+      UFlatHashMap<UStringRep*>::replaceAfterFind(str.rep);
+      }
+
+   void insert(const UString& _key, const UString& str)
+      {
+      U_TRACE(0, "UFlatHashMap<UString>::insert(%V,%V)", _key.rep, str.rep)
+
+      UFlatHashMap<UStringRep*>::insert(_key.rep, str.rep);
+      }
+
+   void insertAfterFind(const UString& _key, const UString& str)
+      {
+      U_TRACE(0, "UFlatHashMap<UString>::insertAfterFind(%V,%V)", _key.rep, str.rep)
+
+      UFlatHashMap<UStringRep*>::insertAfterFind(_key.rep, str.rep);
+      }
+
+   UString erase(const UString& key);
+
+   // OPERATOR []
+
+   UString operator[](const char*       _key) { return at(_key, u__strlen(_key, __PRETTY_FUNCTION__)); }
+   UString operator[](const UString&    _key) { return at(_key.rep); }
+   UString operator[](const UStringRep* _key) { return at(_key); }
+
+protected:
+   UString at(const UStringRep* keyr);
+   UString at(const char* _key, uint32_t keylen);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UFlatHashMap<UString>)
+};
+
+#endif
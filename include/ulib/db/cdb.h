@@ -41,10 +41,20 @@
  * A record is located as follows. Compute the hash value of the key in the record.
  * The hash value modulo 512 is the number of a hash table.
  * The hash value divided by 512, modulo the length of that table, is a slot number.
- * Probe that slot, the next higher slot, and so on, until you find the record or run into an empty slot
+ * Probe that slot, the next higher slot, and so on, until you find the record or run into an empty slot.
+ *
+ * With setFingerprint() we write a variant of the format (the classic format is always readable):
+ * +----------------+------------+-------+-----+---------+-----+----------------------+-----+---------+
+ * | p0 p1 ... p511 | records... | hash0 | ... | hash511 | pad | fp0 fp1 ... fpnslot  | pad | trailer |
+ * +----------------+------------+-------+-----+---------+-----+----------------------+-----+---------+
+ * the hash tables have twice the slots of the records (so the probe sequences are short) and after them, aligned on a
+ * cache line, there is a 16-bit fingerprint of the hash value for each slot (0 -> slot empty). A lookup compares 8 (SSE2)
+ * or 16 (AVX2) fingerprints at once and reads only the slots (and the records) that match. The trailer (nrecord, position
+ * of the fingerprints and magic) identifies the variant, that a classic reader can still search through the hash tables
  */
 
 #define CDB_NUM_HASH_TABLE_POINTER 512
+#define CDB_FINGERPRINT_MAGIC      U_MULTICHAR_CONSTANT32('U','C','D','F')
 
 class URDB;
 class UHTTP;
@@ -80,6 +90,12 @@ public:
       uint32_t pos;  // starting byte position of the record (0 -> slot empty)
    } cdb_hash_table_slot;
 
+   typedef struct cdb_fingerprint_trailer {
+      uint32_t nrecord; // number of records
+      uint32_t pos;     // starting byte position of the fingerprints
+      uint32_t magic;   // CDB_FINGERPRINT_MAGIC
+   } cdb_fingerprint_trailer;
+
    UCDB(int ignore_case = 0)
       {
       U_TRACE_REGISTER_OBJECT(0, UCDB, "%d", ignore_case)
@@ -137,6 +153,16 @@ public:
 
    bool findNext(); // handles repeated keys...
 
+   // Search a batch of keys (prefetching the hash table slots), the value of a key not found is null. Return the number of keys found
+
+   uint32_t findMany(const UString* keys, uint32_t n, UString* values);
+
+   // Fingerprint variant of the format
+
+   bool isFingerprint() const { return (fp != U_NULLPTR); }
+
+   void setFingerprint(bool b = true) { bfingerprint = b; } // NB: used when writing the db...
+
    // Get methods
 
    uint32_t size() const
@@ -207,13 +233,17 @@ public:
 
    // Save memory hash table as Constant DataBase
 
-   static uint32_t sizeFor(uint32_t _nrecord)
+   static uint32_t sizeFor(uint32_t _nrecord, bool bfp = false)
       {
-      U_TRACE(0, "UCDB::sizeFor(%u)", _nrecord)
+      U_TRACE(0, "UCDB::sizeFor(%u,%b)", _nrecord, bfp)
 
       uint32_t size = CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer) +
                       _nrecord * (sizeof(cdb_record_header) + sizeof(cdb_hash_table_slot));
 
+      // NB: the fingerprint variant has two slots (with their fingerprint) for record, the padding and the trailer...
+
+      if (bfp) size += _nrecord * (sizeof(cdb_hash_table_slot) + 2 * sizeof(uint16_t)) + 128;
+
       U_RETURN(size);
       }
 
@@ -243,6 +273,7 @@ protected:
    cdb_record_header* hr;      // initialized if findNext() returns 1
    cdb_hash_table_slot* slot;  // initialized in find()
    cdb_hash_table_pointer* hp; // initialized in find()
+   uint16_t* fp;               // fingerprints of the slots (U_NULLPTR -> classic format)
 
    // internal
 
@@ -265,6 +296,7 @@ protected:
             start_hash_table_slot;
 
    unsigned char flag[4];
+   bool bfingerprint;
 
    bool find();
    UString at();
@@ -295,6 +327,29 @@ protected:
    char* start() const { return (UFile::map + CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer)); }
    char*   end() const { return (UFile::map + start_hash_table_slot); }
 
+   // END of hash table slots
+
+   char* eos() const
+      {
+      if (fp == U_NULLPTR) return (UFile::map + (ptrdiff_t)UFile::st_size);
+
+      cdb_hash_table_pointer* last = (cdb_hash_table_pointer*)UFile::map + (CDB_NUM_HASH_TABLE_POINTER-1);
+
+      return (UFile::map + last->pos + last->slots * sizeof(cdb_hash_table_slot));
+      }
+
+   // Fingerprint variant
+
+   bool checkFingerprint();
+   bool findFingerprint();
+
+   static uint16_t fingerprint(uint32_t _hash)
+      {
+      uint16_t result = (uint16_t)((_hash * 0x9E3779B1) >> 16); // NB: other bits than the ones used for the table and the slot...
+
+      return (result ? result : 1); // NB: 0 -> slot empty...
+      }
+
    // Call function for all entry
 
    void callForAllEntry(vPFpvpc function);
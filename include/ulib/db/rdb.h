@@ -27,7 +27,12 @@
  * The idea behind URDB is to take UCDB and put a journal over it.
  * Then provide an abstraction layer that looks like ndbm and writes updates to the journal.
  * Read operations are answered by consulting the cache (build with journal) and the cdb file.
- * The result should be a reasonably small yet crash-proof read-write database
+ * The result should be a reasonably small yet crash-proof read-write database.
+ *
+ * When the database is shared between processes (with semaphore) the lookup (find(), fetch(), at()) don't take the lock:
+ * the journal is append only, so the key/data bytes never change once written, and every writer increment a sequence
+ * counter on lock() and unlock() (seqlock). The reader check that the counter is even and unchanged across the walk of
+ * the hash tree, otherwise retry (and after some failed attempts fall back to take the lock)
  */
 
 class URDBServer;
@@ -42,6 +47,8 @@ class URDBClientImage;
 
 #  define CACHE_HASHTAB_LEN 769
 
+#  define U_RDB_JOURNAL_VERSION 2 // NB: must be less than the old sizeof(cache_struct) (see URDB::open())...
+
 #  define RDB_off(prdb)      ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->off
 #  define RDB_capacity(prdb) (uint32_t)(((URDB*)prdb)->journal.st_size - RDB_off(prdb))
 #  define RDB_eof(prdb)      (((URDB*)prdb)->journal.map+(ptrdiff_t)((URDB*)prdb)->journal.st_size)
@@ -50,6 +57,8 @@ class URDBClientImage;
 #  define RDB_sync(prdb)      ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->sync
 #  define RDB_nrecord(prdb)   ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->nrecord
 #  define RDB_reference(prdb) ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->reference
+#  define RDB_version(prdb)   ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->version
+#  define RDB_sequence(prdb)  ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->sequence
 #  define RDB_hashtab(prdb)  (((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->hashtab)
 
 #  define RDB_ptr(prdb)      (((URDB*)prdb)->journal.map+sizeof(URDB::cache_struct))
@@ -76,6 +85,7 @@ public:
 
       plock = U_NULLPTR;
       pnode = U_NULLPTR;
+      pinfo = U_NULLPTR;
        node = 0;
 
       key1.dptr  = U_NULLPTR;
@@ -88,6 +98,7 @@ public:
 
       plock = U_NULLPTR;
       pnode = U_NULLPTR;
+      pinfo = U_NULLPTR;
        node = 0;
 
       key1.dptr  = U_NULLPTR;
@@ -107,6 +118,8 @@ public:
          delete[] preclock;
                   preclock = U_NULLPTR;
          }
+
+      if (pinfo) UFile::munmap(pinfo, sizeof(reorganize_info));
       }
 
    // Open a Reliable DataBase
@@ -141,6 +154,55 @@ public:
 
    bool closeReorganize();
 
+   // BACKGROUND REORGANIZE
+   // ---------------------------------------------------------------------------------------------------------------------
+   // The new cdb file is built by a child process that takes the lock only for one slot of the hash table (or one block of
+   // the old cdb) at a time, so we continue to serve reads and writes on the old generation. When the child has finished
+   // (checked at every write or with endReorganize()) the new cdb is renamed on the old one, the mapping is substituted
+   // and the journal keeps only the entries changed after the start. The processes that still map the old cdb file
+   // continue to use it until they drop the mapping. NB: the journal must be shared with a semaphore (psem != &nolock)...
+   // ---------------------------------------------------------------------------------------------------------------------
+
+   typedef struct reorganize_info {
+      pid_t    pid;                   // child that build the new cdb (0 => none)
+      int      result;                // -1 => running, 0 => failed, 1 => done
+      uint32_t cut;                   // RDB_off at the start: the entries changed after are kept in the journal
+      uint32_t ntotal, ndone;         // progress (number of records)
+      uint32_t nrecord, start_hash_table_slot; // the new cdb (written by the child)
+      uint32_t duration_build;        // ms (child)
+      uint32_t duration_swap;         // ms (with the lock held)
+      uint32_t nreorganize;           // number of background reorganize completed
+   } reorganize_info;
+
+   bool startReorganize();
+   bool endReorganize(bool bwait = false); // return true if the new cdb has been substituted
+
+   bool isReorganizeRunning() const
+      {
+      U_TRACE_NO_PARAM(0, "URDB::isReorganizeRunning()")
+
+      if (pinfo &&
+          pinfo->pid)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   uint32_t getReorganizeProgress() const // percent
+      {
+      U_TRACE_NO_PARAM(0, "URDB::getReorganizeProgress()")
+
+      if (isReorganizeRunning() == false) U_RETURN(100);
+
+      uint32_t percent = (pinfo->ntotal ? U_min(99, pinfo->ndone * 100 / pinfo->ntotal) : 0);
+
+      U_RETURN(percent);
+      }
+
+   const reorganize_info* getReorganizeInfo() const { return pinfo; }
+
    // ---------------------------------------------------------------------
    // Write a key/value pair to a reliable database
    // ---------------------------------------------------------------------
@@ -273,8 +335,39 @@ public:
 
    static void initRecordLock();
 
-   void   lock() { if (_lock.sem) _lock.lock(); }
-   void unlock() { if (_lock.sem) _lock.unlock(); }
+   void lock()
+      {
+      U_TRACE_NO_PARAM(0, "URDB::lock()")
+
+      if (_lock.sem &&
+          _lock.isLocked() == false)
+         {
+         _lock.lock();
+
+         // NB: start of the write side of the seqlock (the sequence become odd)...
+
+         RDB_sequence(this)++;
+
+         U_INTERNAL_ASSERT_EQUALS(RDB_sequence(this) & 1, 1)
+
+         __sync_synchronize();
+         }
+      }
+
+   void unlock()
+      {
+      U_TRACE_NO_PARAM(0, "URDB::unlock()")
+
+      if (_lock.sem &&
+          _lock.isLocked())
+         {
+         __sync_synchronize();
+
+         if (journal.map != (char*)MAP_FAILED) RDB_sequence(this)++; // NB: close() can unmap the journal before unlock...
+
+         _lock.unlock();
+         }
+      }
 
    // TRANSACTION
 
@@ -337,6 +430,8 @@ protected:
       uint32_t sync;                       // RDB_sync
       uint32_t nrecord;                    // RDB_nrecord
       uint32_t reference;                  // RDB_reference
+      uint32_t version;                    // RDB_version (layout of the journal: U_RDB_JOURNAL_VERSION)
+      uint32_t sequence;                   // RDB_sequence (seqlock: odd while a writer is changing the cache)
       uint32_t hashtab[CACHE_HASHTAB_LEN]; // RDB_hashtab
       // -----> data storage...            // RDB_ptr
    } cache_struct;
@@ -348,9 +443,10 @@ protected:
    int  remove();
    bool _fetch();
    bool isDeleted();
+   int  fetchWithoutLock();
    bool reorganize(); // Combines the old cdb file and the diffs in a new cdb file
    int  store(int flag);
-   bool compactionJournal();
+   bool compactionJournal(bool bchanged = false); // bchanged => keep only the entries changed after the start of the background reorganize
    int _store(int flag, bool exist);
    int  substitute(UCDB::datum* new_key, int flag);
 
@@ -393,6 +489,7 @@ private:
    uint32_t* pnode;
    uint32_t   node; // RDB_node
    UCDB::datum key1;
+   reorganize_info* pinfo; // NB: shared with the child of the background reorganize...
 
    static uint32_t nerror;
 
@@ -400,19 +497,35 @@ private:
    inline void setNodeRight() U_NO_EXPORT;
 
    void copy1(URDB* prdb, uint32_t offset) U_NO_EXPORT;
+   void copy2(URDB* prdb, uint32_t offset) U_NO_EXPORT;
    void call1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
    void print1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
    void getKeys1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
    void makeAdd1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
 
    bool logJournal(int op) U_NO_EXPORT;
+   bool makeReorganize(UCDB& cdb) U_NO_EXPORT;
+   bool checkReorganize(UCDB& cdb, uint32_t space) U_NO_EXPORT;
    bool resizeJournal(uint32_t oversize) U_NO_EXPORT;
    void call(UCDB* pcdb, vPFpvu function1, vPFpvpc function2) U_NO_EXPORT;
    void callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2) U_NO_EXPORT;
    bool writev(const struct iovec* iov, int n, uint32_t size) U_NO_EXPORT;
 
+   void checkForReorganize()
+      {
+      U_TRACE_NO_PARAM(0, "URDB::checkForReorganize()")
+
+      if (pinfo         &&
+          pinfo->pid    &&
+          pinfo->result != -1) // NB: the child of the background reorganize has finished...
+         {
+         (void) endReorganize(false);
+         }
+      }
+
    static void htAlloc(URDB* prdb) U_NO_EXPORT;       // Alloc one node for the hash tree
    static bool htLookup(URDB* prdb) U_NO_EXPORT;      // Search one key/data pair in the cache
+   static int  htFind(URDB* prdb) U_NO_EXPORT;        // Search one key/data pair in the cache without lock (read only)
    static void htInsert(URDB* prdb) U_NO_EXPORT;      // Insert one key/data pair in the cache
    static void htRemoveAlloc(URDB* prdb) U_NO_EXPORT; // remove one node allocated for the hash tree
 
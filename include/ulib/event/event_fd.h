@@ -20,6 +20,10 @@
 #  include <ulib/libevent/event.h>
 #endif
 
+#if defined(USE_IO_URING) && (!defined(U_LINUX) || !defined(HAVE_EPOLL_WAIT) || defined(USE_LIBEVENT))
+#  undef USE_IO_URING
+#endif
+
 #ifndef EPOLLIN
 #define EPOLLIN    0x0001
 #endif
@@ -52,12 +56,19 @@ public:
 
    int fd;
    uint32_t op_mask; // [ EPOLLIN | EPOLLOUT ]
+#ifdef USE_IO_URING
+   uint32_t ring_gen; // generation of the poll request (upper half of the user_data, see UNotifier::pollAdd())
+#endif
 
    UEventFd()
       {
       fd      = -1;
       op_mask = EPOLLIN | EPOLLRDHUP;
 
+#  ifdef USE_IO_URING
+      ring_gen = 0;
+#  endif
+
 #  ifdef USE_LIBEVENT
       pevent = 0;
 #  endif
@@ -128,6 +128,7 @@ public:
 
 protected:
    long tolerance;
+   uint32_t timer_index; // position in the UTimer heap (U_NOT_FOUND if not scheduled)
 
    static long diff1, diff2;
    static struct timeval  timeout1;
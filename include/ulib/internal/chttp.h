@@ -247,7 +247,8 @@ extern U_EXPORT uclientimage_info u_clientimage_info;
 
 #define U_http_len_user1 u_clientimage_info.http_info.flag[13]
 #define U_http_len_user2 u_clientimage_info.http_info.flag[14]
-#define U_http_len_user3 u_clientimage_info.http_info.flag[15]
+
+#define U_http_encoding u_clientimage_info.http_info.flag[15]
 
 enum HttpRequestType {
    HTTP_IS_SENDFILE            = 0x0001,
@@ -271,6 +272,14 @@ enum HttpRequestType {
 #define U_http_is_accept_gzip         ((U_http_flag      & HTTP_IS_ACCEPT_GZIP)    != 0)
 #define U_http_is_accept_gzip_save    ((U_http_flag_save & HTTP_IS_ACCEPT_GZIP)    != 0)
 
+enum HttpEncodingType { /* the content codings besides gzip (U_http_flag is full...) */
+   HTTP_IS_ACCEPT_BR   = 0x01,
+   HTTP_IS_RESPONSE_BR = 0x02
+};
+
+#define U_http_is_accept_br   ((U_http_encoding & HTTP_IS_ACCEPT_BR)   != 0)
+#define U_http_is_response_br ((U_http_encoding & HTTP_IS_RESPONSE_BR) != 0)
+
 #define U_HTTP_INFO_INIT(c)  (void) U_SYSCALL(memset, "%p,%d,%u", &(u_clientimage_info.http_info),               c, sizeof(uhttpinfo))
 #define U_HTTP_INFO_RESET(c) (void) U_SYSCALL(memset, "%p,%d,%u", &(u_clientimage_info.http_info.nResponseCode), c, 52)
 
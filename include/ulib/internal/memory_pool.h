@@ -521,7 +521,9 @@ public:
 
 private:
 #ifdef ENABLE_MEMPOOL
-   static void deallocate(void* ptr, uint32_t length);
+   static char*        mmap(uint32_t* plength); // NB: UFile::mmap() (request over U_MAX_SIZE_PREALLOCATE) with the lock of the depot...
+   static void   deallocate(void* ptr, uint32_t length);
+   static void __deallocate(void* ptr, uint32_t length); // NB: without the lock of the depot...
 #else
    static void deallocate(void* ptr, uint32_t length)
       {
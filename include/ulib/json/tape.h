@@ -0,0 +1,204 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    tape.h - JSON parser on a flat tape with a SIMD structural index
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_JSON_TAPE_H
+#define ULIB_JSON_TAPE_H 1
+
+#include <ulib/string.h>
+
+/**
+ * @class UJsonTape
+ *
+ * @brief UJsonTape parse a JSON document in two stages (@see https://arxiv.org/abs/1902.08318 - Parsing Gigabytes of JSON per Second)
+ *
+ * stage 1: the document is read in blocks of 64 bytes and with SIMD compare (SSE2 or AVX2) we build the bitmasks of the quotes, the backslashes,
+ *          the structural chars ({}[]:,) and the whitespaces. The escaped quotes are removed, the mask of the strings is the prefix xor of the
+ *          quotes and the index keep the position of every structural char, of every quote that open or close a string and of the first char
+ *          of every number or literal outside the strings
+ *
+ * stage 2: we walk the index validating the grammar (RFC 8259 - no comments) and we write a flat tape of 64 bit words:
+ *
+ * [tag:8][payload:56]
+ *
+ * U_OBJECT_VALUE, U_ARRAY_VALUE - payload: position on the tape of the closing word (tag | U_JSON_TAPE_END, payload: position of the opening word)
+ * U_STRING_VALUE                - payload: offset on the document of the first char after the quote, the next word is the length (NB: not decoded)
+ * U_REAL_VALUE                  - payload: offset on the document of the number,                     the next word is the length (NB: converted on demand)
+ * U_INT_VALUE, U_UINT_VALUE     - payload: the value (NB: 32 bit as in UValue, other integers are U_REAL_VALUE)
+ * U_TRUE_VALUE, U_FALSE_VALUE, U_NULL_VALUE
+ *
+ * The strings and the numbers are not copied: a value is the position of its first word on the tape (the root is at 0) and the cursor
+ * methods (at(), first(), next(), getString(), getDouble(), ...) read only what is asked. A container can be skipped in O(1)...
+ */
+
+#define U_JSON_TAPE_END 0x80
+
+class UValue;
+
+class U_EXPORT UJsonTape {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UJsonTape()
+      {
+      U_TRACE_REGISTER_OBJECT(0, UJsonTape, "", 0)
+
+      tape  = U_NULLPTR;
+      index = U_NULLPTR;
+
+      tape_len = tape_max = index_len = index_max = 0;
+      }
+
+   ~UJsonTape();
+
+   // SERVICES
+
+   bool parse(const UString& document);
+
+   void clear()
+      {
+      U_TRACE_NO_PARAM(0, "UJsonTape::clear()")
+
+      document.clear();
+
+      tape_len = index_len = 0;
+      }
+
+   bool empty() const
+      {
+      U_TRACE_NO_PARAM(0, "UJsonTape::empty()")
+
+      if (tape_len == 0) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   uint32_t size() const { return tape_len; }
+
+   UString& getDocument() { return document; }
+
+   // CURSOR
+
+   uint32_t getTag(uint32_t pos) const
+      {
+      U_TRACE(0, "UJsonTape::getTag(%u)", pos)
+
+      U_INTERNAL_ASSERT_MINOR(pos, tape_len)
+
+      uint32_t tag = getWordTag(tape[pos]);
+
+      U_INTERNAL_ASSERT(tag <= U_NULL_VALUE)
+
+      U_RETURN(tag);
+      }
+
+   uint32_t skip(uint32_t pos) const // position of the value that follow
+      {
+      U_TRACE(0, "UJsonTape::skip(%u)", pos)
+
+      U_INTERNAL_ASSERT_MINOR(pos, tape_len)
+
+      uint64_t word = tape[pos];
+
+      switch (getWordTag(word))
+         {
+         case U_ARRAY_VALUE:
+         case U_OBJECT_VALUE: pos = getWordPayload(word) + 1; break;
+         case U_REAL_VALUE:
+         case U_STRING_VALUE: pos += 2;                   break;
+         default:             pos += 1;                   break;
+         }
+
+      U_RETURN(pos);
+      }
+
+   uint32_t first(uint32_t pos) const // first element of an array or first key of an object (U_NOT_FOUND if empty)
+      {
+      U_TRACE(0, "UJsonTape::first(%u)", pos)
+
+      U_INTERNAL_ASSERT(getTag(pos) == U_ARRAY_VALUE || getTag(pos) == U_OBJECT_VALUE)
+
+      if ((getWordTag(tape[++pos]) & U_JSON_TAPE_END) != 0) U_RETURN(U_NOT_FOUND);
+
+      U_RETURN(pos);
+      }
+
+   uint32_t next(uint32_t pos) const // element that follow in the same array (for an object: next(value(key)) is the key that follow)
+      {
+      U_TRACE(0, "UJsonTape::next(%u)", pos)
+
+      pos = skip(pos);
+
+      if ((getWordTag(tape[pos]) & U_JSON_TAPE_END) != 0) U_RETURN(U_NOT_FOUND);
+
+      U_RETURN(pos);
+      }
+
+   uint32_t value(uint32_t key) const { return key+2; } // value of the member of an object
+
+   uint32_t getSize(uint32_t pos) const __pure; // number of elements of an array or of members of an object
+
+   uint32_t at(uint32_t pos, uint32_t idx) const __pure;
+   uint32_t at(uint32_t pos, const char* key, uint32_t key_len) const __pure;
+
+   uint32_t at(uint32_t pos, const UString& key) const { return at(pos, U_STRING_TO_PARAM(key)); }
+
+   bool getBool(uint32_t pos) const { return (getTag(pos) == U_TRUE_VALUE); }
+
+   int      getInt(uint32_t pos) const;
+   unsigned getUInt(uint32_t pos) const;
+   double   getDouble(uint32_t pos) const;
+
+   // string (or number) as it is on the document, without the quotes
+
+   const char* getPtr(uint32_t pos) const { return document.data() + getWordPayload(tape[pos]); }
+   uint32_t    getLen(uint32_t pos) const { return                            tape[pos+1]; }
+
+   UString getString(uint32_t pos) const; // the escape sequences are decoded
+
+   void stringify(UString& result, uint32_t pos = 0) const; // minified
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UString document;
+   uint64_t* tape;
+   uint32_t* index; // stage 1: position of the structural chars, of the quotes and of the start of the numbers and literals
+   uint32_t tape_len, tape_max, index_len, index_max;
+
+   static uint32_t getWordTag(uint64_t word)     { return (uint32_t)(word >> 56); }
+   static uint64_t getWordPayload(uint64_t word) { return (word & 0x00FFFFFFFFFFFFFFULL); }
+   static uint64_t getWord(uint32_t tag, uint64_t payload) { return (((uint64_t)tag << 56) | payload); }
+
+private:
+   bool buildIndex() U_NO_EXPORT;
+   bool buildTape() U_NO_EXPORT;
+   bool addNumber(const char* start, const char* end) U_NO_EXPORT;
+
+   void stringify(char*& ptr, uint32_t pos) const U_NO_EXPORT;
+
+   U_DISALLOW_COPY_AND_ASSIGN(UJsonTape)
+
+   friend class UValue;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #ifndef ULIB_VALUE_H
 #define ULIB_VALUE_H 1
 
+#include <ulib/json/tape.h>
 #include <ulib/container/hash_map.h>
 
 #include <math.h>
@@ -440,12 +441,33 @@ public:
       {
       U_TRACE(0, "UValue::fromJSON<T>(%.*S,%u,%p)", len, name, len, &member)
 
+      if (isOnDemand()) // NB: we read from the tape only the member that is binded (@see JSON_parse())...
+         {
+         uint32_t vpos = ptape->at(getTapePos(), name+1, len-2);
+
+         if (vpos == U_NOT_FOUND) member.clear();
+         else
+            {
+            UValue node;
+
+            node.setTape(vpos, UJsonTypeHandler<T>::on_demand);
+
+            member.fromJSON(node);
+            }
+
+         return;
+         }
+
       UValue* node = at(name+1, len-2);
 
       if (node) member.fromJSON(*node);
       else      member.clear();
       }
 
+   // the value at position _pos of a tape (@see json/tape.h)
+
+   void fromTape(const UJsonTape& tape, uint32_t _pos = 0);
+
    // =======================================================================================================================
    // An in-place JSON element reader (@see http://www.codeproject.com/Articles/885389/jRead-an-in-place-JSON-element-reader)
    // =======================================================================================================================
@@ -594,6 +616,31 @@ protected:
    static union jval o;
    static parser_stack_data sd[U_JSON_PARSE_STACK_SIZE];
 
+   // on demand (@see JSON_parse()): an object of the tape that is not materialized is an empty object with the position on the tape in the key
+
+   static UJsonTape* ptape;
+
+   bool isOnDemand() const
+      {
+      U_TRACE_NO_PARAM(0, "UValue::isOnDemand()")
+
+      if (ptape                                              &&
+          getTag(pkey.ival) == U_OBJECT_VALUE                &&
+          value.ival == getValue(U_OBJECT_VALUE, U_NULLPTR))
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   uint32_t getTapePos() const { return (uint32_t)u_getPayload(pkey.ival); }
+
+   void setTape(uint32_t _pos, int mode);
+
+   static uint64_t tapeToValue( const UJsonTape& tape, uint32_t _pos, int mode);
+   static uint64_t tapeToString(const UJsonTape& tape, uint32_t _pos);
+
    static void initParser()
       {
       U_TRACE_NO_PARAM(0, "UValue::initParser()")
@@ -864,6 +911,7 @@ private:
    template <class T> friend class UHashMap;
    template <class T> friend class UJsonTypeHandler;
    template <class T> friend void JSON_stringify(UString&, UValue&, T&);
+   template <class T> friend bool JSON_parse(const UString&, T&);
 };
 
 #if defined(U_STDCPP_ENABLE) && defined(HAVE_CXX11)
@@ -917,6 +965,11 @@ public:
       U_INTERNAL_ASSERT_POINTER(pval)
       }
 
+   // on demand binding (@see JSON_parse()): 0 => the value is materialized, 1 => the members of an object are read from the tape
+   // only when they are binded, 2 => the same for the objects that are elements of an array
+
+   enum { on_demand = 0 };
+
 #ifdef DEBUG
    const char* dump(bool _reset) const;
 #endif
@@ -983,6 +1036,8 @@ public:
    explicit UJsonTypeHandler(T* val) : UJsonTypeHandler_Base( val) {}
    explicit UJsonTypeHandler(T& val) : UJsonTypeHandler_Base(&val) {}
 
+   enum { on_demand = 1 };
+
    // SERVICES
 
    void clear()
@@ -1052,16 +1107,31 @@ template <class T> bool JSON_parse(const UString& str, T& obj)
 {
    U_TRACE(0, "JSON_parse(%p,%p)", &str, &obj)
 
+   bool result;
    UValue json;
+   UJsonTape tape;
+   UJsonTape* prev = UValue::ptape; // NB: JSON_parse() can be called from a fromJSON()...
 
-   if (json.parse(str))
+   if (tape.parse(str)) // NB: the object is not materialized, the members are read from the tape only when they are binded (@see UValue::fromJSON<T>())...
       {
+      UValue::ptape = &tape;
+
+      json.setTape(0, UJsonTypeHandler<T>::on_demand);
+
       UJsonTypeHandler<T>(obj).fromJSON(json);
 
+      UValue::ptape = prev;
+
       U_RETURN(true);
       }
 
-   U_RETURN(false);
+   UValue::ptape = U_NULLPTR; // NB: the tape is strict (RFC 8259), UValue::parse() accept also the comments...
+
+   if ((result = json.parse(str))) UJsonTypeHandler<T>(obj).fromJSON(json);
+
+   UValue::ptape = prev;
+
+   U_RETURN(result);
 }
 
 template <class T> void JSON_OBJ_stringify(UString& str, T& obj)
@@ -1779,6 +1849,8 @@ public:
 
    explicit UJsonTypeHandler(uvector& val) : UJsonTypeHandler_Base(&val) {}
 
+   enum { on_demand = (UJsonTypeHandler<T>::on_demand == 1 ? 2 : 0) };
+
    void clear()
       {
       U_TRACE_NO_PARAM(0, "UJsonTypeHandler<uvector>::clear()")
@@ -2179,6 +2251,8 @@ public:
 
    explicit UJsonTypeHandler(stdvector& val) : UJsonTypeHandler_Base(&val) {}
 
+   enum { on_demand = (UJsonTypeHandler<T>::on_demand == 1 ? 2 : 0) };
+
    void clear()
       {
       U_TRACE_NO_PARAM(0, "UJsonTypeHandler<stdvector>::clear()")
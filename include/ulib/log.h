@@ -20,7 +20,9 @@
 
 class ULib;
 class UHTTP;
+class ULogWriter;
 class UHTTP2;
+class UBinaryAccessLog;
 class Application;
 class UTimeThread;
 class UProxyPlugIn;
@@ -48,6 +50,7 @@ public:
       uint32_t file_ptr;
       uint32_t file_page;
       uint32_t gzip_len;
+      uint32_t nrotate; // number of rotation of the memory mapped log
       sem_t lock_shared;
       // --------------> maybe unnamed array of char for gzip compression...
    } log_data;
@@ -70,6 +73,10 @@ public:
 #  ifdef USE_LIBZ
       if (buf_path_compress) delete buf_path_compress;
 #  endif
+
+#  if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+      if (pwriter) stopAsync();
+#  endif
       }
 
    void reopen()
@@ -169,6 +176,49 @@ public:
       U_RETURN_STRING(result);
       }
 
+   // ASYNC
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   /**
+    * In async mode the records are copied (by the process that serve the requests) in a per process ring buffer of async_sz bytes,
+    * drained by a dedicated writer thread that writes thousands of lines with a single syscall and manages also the rotation/compression
+    * of the memory mapped log. If the ring is full the record is dropped and counted. setAsync() must be called before the fork of the
+    * children, startAsync() in every child (the thread don't survive to fork()), stopAsync() writes the records that are still in the ring
+    */
+
+   void setAsync(uint32_t sz)
+      {
+      U_TRACE(0, "ULog::setAsync(%u)", sz)
+
+      U_INTERNAL_ASSERT_EQUALS(pwriter, U_NULLPTR)
+      U_INTERNAL_ASSERT_EQUALS(U_Log_syslog(this), false)
+
+      async_sz = sz;
+      }
+
+   bool isAsync() const
+      {
+      U_TRACE_NO_PARAM(0, "ULog::isAsync()")
+
+      if (pwriter) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   bool     startAsync();
+   void      stopAsync();
+   uint32_t getDroppedRecords() const __pure;
+#endif
+
+   // BINARY (the records are in the format of UBinaryAccessLog: the batch of the writer thread and the rotation must know it)
+
+   void setBinary(UBinaryAccessLog* ptr)
+      {
+      U_TRACE(0, "ULog::setBinary(%p)", ptr)
+
+      binary = ptr;
+      }
+
    // LOCK
 
    void   lock() { if (_lock.sem) _lock.lock(); }
@@ -178,6 +228,10 @@ public:
 
    void write(const char* msg, uint32_t len);
 
+   // write a record already formatted (Ex: apache like log)
+
+   void write(const struct iovec* iov, int n);
+
    void log(const char* fmt, uint32_t fmt_size, ...)
       {
       U_TRACE(0, "ULog::log(%.*S,%u)", fmt_size, fmt, fmt_size)
@@ -215,9 +269,15 @@ public:
 protected:
    ULock _lock;
    log_data* ptr_log_data;
+   UBinaryAccessLog* binary;
    uint32_t log_file_sz,
-            log_gzip_sz;
+            log_gzip_sz,
+            nrotate; // the rotation of the last write of this process
    unsigned char flag[4];
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   ULogWriter* pwriter;
+   uint32_t async_sz, dropped_logged;
+#endif
 
 #ifdef DEBUG
    ULog* next;
@@ -226,7 +286,7 @@ protected:
 
    void startup();
    void closeLogInternal();
-   void write(const struct iovec* iov, int n);
+   void writeInternal(const struct iovec* iov, int n, bool bwriter = false); // bwriter: we are the writer thread (the consumer of the ring buffer)
    void logResponse(const UString& data,  const char* format, uint32_t fmt_size, ...);
    void log(const struct iovec* iov, const char* type, int ncount, const char* msg, uint32_t msg_len, const char* format, uint32_t fmt_size, ...);
 
@@ -250,7 +310,9 @@ private:
    friend class ULib;
    friend class UHTTP;
    friend class UHTTP2;
+   friend class ULogWriter;
    friend class Application;
+   friend class UBinaryAccessLog;
    friend class UTimeThread;
    friend class UProxyPlugIn;
    friend class UNoCatPlugIn;
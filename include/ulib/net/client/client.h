@@ -307,7 +307,7 @@ private:
 template <class Socket> class U_EXPORT UClient : public UClient_Base {
 public:
 
-   UClient(UFileConfig* pcfg) : UClient_Base(pcfg)
+   UClient(UFileConfig* pcfg = U_NULLPTR) : UClient_Base(pcfg)
       {
       U_TRACE_REGISTER_OBJECT(0, UClient, "%p", pcfg)
 
@@ -333,7 +333,7 @@ private:
 template <> class U_EXPORT UClient<USSLSocket> : public UClient_Base {
 public:
 
-   UClient(UFileConfig* pcfg) : UClient_Base(pcfg)
+   UClient(UFileConfig* pcfg = U_NULLPTR) : UClient_Base(pcfg)
       {
       U_TRACE_REGISTER_OBJECT(0, UClient<USSLSocket>, "%p", pcfg)
 
@@ -236,7 +236,7 @@ private:
 template <class Socket> class U_EXPORT UHttpClient : public UHttpClient_Base {
 public:
 
-   UHttpClient(UFileConfig* _cfg) : UHttpClient_Base(_cfg)
+   UHttpClient(UFileConfig* _cfg = U_NULLPTR) : UHttpClient_Base(_cfg)
       {
       U_TRACE_REGISTER_OBJECT(0, UHttpClient, "%p", _cfg)
 
@@ -262,7 +262,7 @@ private:
 template <> class U_EXPORT UHttpClient<USSLSocket> : public UHttpClient_Base {
 public:
 
-   UHttpClient(UFileConfig* _cfg) : UHttpClient_Base(_cfg)
+   UHttpClient(UFileConfig* _cfg = U_NULLPTR) : UHttpClient_Base(_cfg)
       {
       U_TRACE_REGISTER_OBJECT(0, UHttpClient<USSLSocket>, "%p", _cfg)
 
@@ -0,0 +1,192 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    pool.h - pool of keep-alive connections to the backends
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef U_CLIENT_POOL_H
+#define U_CLIENT_POOL_H 1
+
+#include <ulib/timer.h>
+#include <ulib/container/hash_map.h>
+#include <ulib/net/client/client.h>
+
+/**
+ * @class UClientPool
+ *
+ * @brief UClientPool keeps the connections to the backends (Ex: REDIS, upstream HTTP) that are not in use, so that a request
+ *        can take a warm connection instead of paying every time the TCP (and TLS) handshake.
+ *
+ * The connections are kept for backend (host:port) in a LIFO stack, so the most recently used (the one with more chance to be
+ * still alive) is given first. acquire() returns a connected client (U_NULLPTR if the connect fail or if for that backend there
+ * are already max_conn connections, in use + idle) and release() gives it back to the pool (or close it if the request is failed
+ * or there are already max_idle idle connections). With setHealthCheck() the idle connections are checked periodically by UTimer:
+ * a connection closed by the backend or idle since more than idle_timeout seconds is closed. The counters (hits, misses, full,
+ * errors, closed, time spent in acquire()) can be read with getStatistics() for monitoring...
+ *
+ * NB: the pool is for process (the connections are not shared between the preforked processes)...
+ */
+
+class U_EXPORT UClientPool_Base : public UEventTime {
+public:
+
+   uint32_t max_conn,     // max number of connections for backend (in use + idle), 0 => no limit
+            max_idle,     // max number of idle connections for backend
+            idle_timeout; // time (in seconds) after which an idle connection is closed, 0 => never
+
+   // SERVICES
+
+   uint32_t getNumBackend() const
+      {
+      U_TRACE_NO_PARAM(0, "UClientPool_Base::getNumBackend()")
+
+      U_RETURN(table.size());
+      }
+
+   void setHealthCheck(uint32_t sec); // check the idle connections every sec seconds (NB: UTimer must be initialized...)
+
+   typedef struct stats {
+      uint64_t hits, misses, full, errors, closed;
+      uint64_t wait_usec; // time spent in acquire() (connect on miss)
+      uint32_t active, idle;
+   } stats;
+
+   void getStatistics(stats& s);
+
+   UString getStatistics(); // as text, ex: "hits 10 misses 2 full 0 errors 0 closed 1 wait_usec 1200 active 1 idle 1"
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL;
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   class U_NO_EXPORT UClientPoolBackend {
+   public:
+
+      // Check for memory error
+      U_MEMORY_TEST
+
+      // Allocator e Deallocator
+      U_MEMORY_ALLOCATOR
+      U_MEMORY_DEALLOCATOR
+
+      UClient_Base** idle; // LIFO stack of the idle connections
+      long* last_use;      // time of release of the idle connections
+      uint32_t nidle, nactive, nslot;
+
+       UClientPoolBackend(uint32_t max_idle);
+      ~UClientPoolBackend();
+
+#  if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+      const char* dump(bool reset) const;
+#  endif
+   };
+
+   UHashMap<UClientPoolBackend*> table;
+   uint64_t hits, misses, full, errors, closed, wait_usec;
+
+   UClientPool_Base(uint32_t _max_conn, uint32_t _max_idle, uint32_t _idle_timeout);
+   virtual ~UClientPool_Base();
+
+   UClient_Base* acquireConnection(const UString& host, unsigned int port);
+   void          releaseConnection(UClient_Base* client, bool bkeep);
+
+   void clear(); // close all the idle connections (NB: the derived class must call it in the destructor...)
+
+   virtual UClient_Base* create(const UString& host, unsigned int port) = 0; // a connected client or U_NULLPTR
+   virtual void         destroy(UClient_Base* client) = 0;
+
+private:
+   UClientPoolBackend* getBackend(const UString& host, unsigned int port, bool binsert) U_NO_EXPORT;
+   void                closeConnection(UClient_Base* client) U_NO_EXPORT;
+
+   static bool isAlive(UClient_Base* client) U_NO_EXPORT;
+
+   U_DISALLOW_COPY_AND_ASSIGN(UClientPool_Base)
+};
+
+/**
+ * The class of the client must have a default constructor, ex:
+ *
+ * UClientPool<UREDISClient<UTCPSocket> > pool;
+ *
+ * UREDISClient<UTCPSocket>* rc = pool.acquire(U_STRING_FROM_CONSTANT("localhost"), 6379);
+ *
+ * if (rc)
+ *    {
+ *    bool ok = rc->get(U_CONSTANT_TO_PARAM("key"));
+ *
+ *    pool.release(rc, ok);
+ *    }
+ */
+
+template <class T> class U_EXPORT UClientPool : public UClientPool_Base {
+public:
+
+   UClientPool(uint32_t _max_conn = 64, uint32_t _max_idle = 16, uint32_t _idle_timeout = 60) : UClientPool_Base(_max_conn, _max_idle, _idle_timeout)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UClientPool<T>, "%u,%u,%u", _max_conn, _max_idle, _idle_timeout)
+      }
+
+   virtual ~UClientPool() U_DECL_FINAL
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UClientPool<T>)
+
+      clear();
+      }
+
+   // SERVICES
+
+   T* acquire(const UString& host, unsigned int port) { return (T*) acquireConnection(host, port); }
+
+   void release(T* client, bool bkeep = true) { releaseConnection(client, bkeep); } // bkeep == false => the connection is closed (Ex: error)
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UClientPool_Base::dump(_reset); }
+#endif
+
+protected:
+   virtual UClient_Base* create(const UString& host, unsigned int port) U_DECL_FINAL
+      {
+      U_TRACE(0, "UClientPool<T>::create(%V,%u)", host.rep, port)
+
+      T* client;
+
+      U_NEW(T, client, T);
+
+      (void) client->setHostPort(host, port);
+
+      if (client->UClient_Base::connect()) U_RETURN_POINTER(client, UClient_Base);
+
+      delete client;
+
+      U_RETURN_POINTER(U_NULLPTR, UClient_Base);
+      }
+
+   virtual void destroy(UClient_Base* client) U_DECL_FINAL
+      {
+      U_TRACE(0, "UClientPool<T>::destroy(%p)", client)
+
+      delete (T*)client;
+      }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UClientPool<T>)
+};
+
+#endif
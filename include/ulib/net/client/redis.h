@@ -14,6 +14,7 @@
 #ifndef ULIB_REDIS_H
 #define ULIB_REDIS_H 1
 
+#include <ulib/notifier.h>
 #include <ulib/net/client/client.h>
 
 /**
@@ -398,6 +399,20 @@ protected:
       U_TRACE_REGISTER_OBJECT(0, UREDISClient_Base, "", 0)
 
       err = 0;
+
+      // NB: the iovec for the requests are set here, so that a client connected with UClient_Base::connect() (Ex: UClientPool) can be used...
+
+      UClient_Base::iovcnt = 4;
+
+      UClient_Base::iov[1].iov_base =
+      UClient_Base::iov[4].iov_base = (caddr_t)" ";
+      UClient_Base::iov[1].iov_len  =
+      UClient_Base::iov[4].iov_len  = 1;
+
+      UClient_Base::iov[3].iov_base =
+      UClient_Base::iov[5].iov_base = (caddr_t)U_CRLF;
+      UClient_Base::iov[3].iov_len  =
+      UClient_Base::iov[5].iov_len  = 2;
       }
 
 private:
@@ -407,6 +422,116 @@ private:
    static char* getResponseItem(const UString& response, char* ptr, UVector<UString>& vec, uint32_t depth) U_NO_EXPORT;
 
    U_DISALLOW_COPY_AND_ASSIGN(UREDISClient_Base)
+
+   friend class UREDISPipeline;
+};
+
+/**
+ * @class UREDISPipeline
+ *
+ * @brief UREDISPipeline queues many commands for a REDIS connection, sends them with one writev() and reads all the replies
+ *        in one loop (@see http://redis.io/topics/pipelining).
+ *
+ * After exec() vitem has one item for command and vtype the type of each reply (Ex: U_RC_ERROR). A multi-bulk reply
+ * (Ex: MGET) is kept as it is in the response and we can get its elements with getArray(). With execAsync() the connection is registered with UNotifier and the function
+ * is called when all the replies are arrived, so that (Ex: from a USP page) we don't block the worker while waiting for them.
+ * NB: the connection must not be used for other requests until the replies of the pipeline are arrived...
+ */
+
+class U_EXPORT UREDISPipeline : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UVector<UString> vitem;
+   UString vtype;
+
+   UREDISPipeline(UREDISClient_Base* _client)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UREDISPipeline, "%p", _client)
+
+      U_INTERNAL_ASSERT_POINTER(_client)
+
+      client  = _client;
+      func    = U_NULLPTR;
+      arg     = U_NULLPTR;
+      nqueued = nsent = nreply = offset = 0;
+      }
+
+   ~UREDISPipeline();
+
+   // Queue a command (NB: the params are copied...)
+
+   void command(const char* p1, uint32_t len1, const char* p2 = U_NULLPTR, uint32_t len2 = 0, const char* p3 = U_NULLPTR, uint32_t len3 = 0);
+
+   void get( const char* key, uint32_t keylen) { command(U_CONSTANT_TO_PARAM("GET"),  key, keylen); }
+   void del( const char* key, uint32_t keylen) { command(U_CONSTANT_TO_PARAM("DEL"),  key, keylen); }
+   void incr(const char* key, uint32_t keylen) { command(U_CONSTANT_TO_PARAM("INCR"), key, keylen); }
+
+   void set(const char* key, uint32_t keylen, const char* value, uint32_t valuelen) { command(U_CONSTANT_TO_PARAM("SET"), key, keylen, value, valuelen); }
+   void publish(const char* channel, uint32_t channel_len, const char* msg, uint32_t msg_len) { command(U_CONSTANT_TO_PARAM("PUBLISH"), channel, channel_len, msg, msg_len); }
+
+   // SERVICES
+
+   uint32_t size() const
+      {
+      U_TRACE_NO_PARAM(0, "UREDISPipeline::size()")
+
+      U_RETURN(nqueued);
+      }
+
+   bool isRunning() const // NB: waiting for the replies of execAsync()...
+      {
+      U_TRACE_NO_PARAM(0, "UREDISPipeline::isRunning()")
+
+      if (nsent) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   bool isError(uint32_t i) const { return (vtype.c_char(i) == U_RC_ERROR); }
+
+   static bool getArray(const UString& item, UVector<UString>& vec); // elements of a multi-bulk reply
+
+   void clear();
+
+   // Send all the queued commands and wait for all the replies
+
+   bool exec();
+
+   // Send all the queued commands and return, func(arg, this) is called when all the replies are arrived (or on error, with vitem empty)
+
+   bool execAsync(vPFpvpv func, void* arg = U_NULLPTR);
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int handlerRead() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UString buffer; // the queued commands
+   UREDISClient_Base* client;
+   vPFpvpv func;
+   void* arg;
+   uint32_t nqueued, nsent, nreply, offset;
+
+private:
+   bool send() U_NO_EXPORT;
+   bool checkResponse() U_NO_EXPORT;
+   void processResponse() U_NO_EXPORT;
+
+   static const char* skipResponseItem(const char* ptr, const char* end) __pure U_NO_EXPORT;
+
+   U_DISALLOW_COPY_AND_ASSIGN(UREDISPipeline)
 };
 
 template <class Socket> class U_EXPORT UREDISClient : public UREDISClient_Base {
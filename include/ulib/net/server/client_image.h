@@ -146,7 +146,8 @@ public:
       NO_CACHE             = 0x0002,
       IN_FILE_CACHE        = 0x0004,
       ALREADY_PROCESSED    = 0x0008,
-      FILE_CACHE_PROCESSED = 0x0010
+      FILE_CACHE_PROCESSED = 0x0010,
+      SUSPENDED            = 0x0020
    };
 
    static bool isRequestNotFound()
@@ -283,6 +284,28 @@ public:
       U_RETURN(false);
       }
 
+   // A request can be suspended (Ex: a USP that execute a query with UOrmStatement::executeAsync()): the response is not written
+   // and the connection is not read until resumeRequest() is called, with the handle got by getRequestHandle() before suspending,
+   // then func() write the response on wbuffer as the USP would do. getRequestHandle() return U_NULLPTR if the request can't be
+   // suspended (pipeline, parallelization, HTTP/2), and the handle is no more valid if the connection is closed in the meanwhile (NB: the
+   // connection of a suspended request is closed if the response is not resumed in the read timeout)...
+
+   static void* getRequestHandle() __pure;
+   static void  resumeRequest(void* handle, vPF func);
+
+   static void setRequestSuspended(void* handle);
+
+   static bool isRequestSuspended()
+      {
+      U_TRACE_NO_PARAM(0, "UClientImage_Base::isRequestSuspended()")
+
+      U_INTERNAL_DUMP("U_ClientImage_request = %d %B", U_ClientImage_request, U_ClientImage_request)
+
+      if ((U_ClientImage_request & SUSPENDED) != 0) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
    static void setRequestNoCache()
       {
       U_TRACE_NO_PARAM(0, "UClientImage_Base::setRequestNoCache()")
@@ -361,6 +384,7 @@ protected:
    uint32_t min_limit, max_limit, started_at;
 #endif
    UString* data_pending;
+   UString* data_suspended; // handle, info and header of the response of the suspended request
    uint32_t start, count;
    int sfd;
    uucflag flag;
@@ -451,6 +475,7 @@ protected:
    static UTimeVal* chronometer;
    static uint32_t ncount, nrequest, resto;
    static long time_between_request, time_run;
+   static uintptr_t suspend_serial;
 
    static void   endRequest();
    static void startRequest();
@@ -473,6 +498,9 @@ protected:
 #endif
 
 private:
+   void suspendRequest() U_NO_EXPORT;
+   void resume(vPF func) U_NO_EXPORT;
+
    static inline bool handlerCache() U_NO_EXPORT;
    static inline bool isValidMethod(    const char* ptr) U_NO_EXPORT;
    static inline bool isValidRequest(   const char* ptr, uint32_t sz) U_NO_EXPORT;
@@ -16,6 +16,7 @@
 
 #include <ulib/net/tcpsocket.h>
 #include <ulib/net/client/http.h>
+#include <ulib/net/client/pool.h>
 #include <ulib/net/server/server_plugin.h>
 
 class U_EXPORT UProxyPlugIn : public UServerPlugIn {
@@ -45,7 +46,7 @@ public:
 #endif
 
 protected:
-   static UHttpClient<UTCPSocket>* client_http;
+   static UClientPool<UHttpClient<UTCPSocket> >* pool; // the keep-alive connections to the backends of the services
 
 private:
    U_DISALLOW_COPY_AND_ASSIGN(UProxyPlugIn)
@@ -32,6 +32,7 @@ public:
    // Server-wide hooks
 
    virtual int handlerConfig(UFileConfig& cfg) U_DECL_FINAL;
+   virtual int handlerInit() U_DECL_FINAL;
    virtual int handlerRun() U_DECL_FINAL;
 
    // Connection-wide hooks
@@ -47,6 +48,8 @@ public:
 protected:
    static vPFi on_message;
    static UCommand* command;
+   static bool bbroadcast;
+   static void* broadcast_ptr;
 
    static RETSIGTYPE handlerForSigTERM(int signo);
 
@@ -151,6 +151,8 @@ public:
    //
    // LISTEN_BACKLOG             max number of ready to be delivered connections to accept()
    // SET_REALTIME_PRIORITY      flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
+   // REUSEPORT_CPU_STEERING     flag indicating that every preforked process is pinned to a cpu and that the kernel steers (SO_REUSEPORT+BPF)
+   //                            the new connections to the listening socket of the process running on the cpu that received them
    //
    // CLIENT_THRESHOLD           min number of clients to active polling
    // CLIENT_FOR_PARALLELIZATION min number of clients to active parallelization 
@@ -277,6 +279,8 @@ public:
    //                                                                    >1 - pool of serialized processes plus monitoring process
    // ----------------------------------------------------------------------------------------------------------------------------
 
+#define U_SRV_MAX_KIDS 64 // max number of preforked children with per-child statistics
+
    typedef struct shared_data {
    // ---------------------------------
       uint32_t cnt_usr1;
@@ -311,7 +315,6 @@ public:
       sem_t lock_rdb_server;
       sem_t lock_data_session;
 #  ifdef USE_LIBSSL
-      sem_t lock_ssl_session;
    // ------------------------------------------------------------------------------
 #    if defined(ENABLE_THREAD) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
       uint32_t   len_ocsp_staple;
@@ -320,6 +323,11 @@ public:
 #    endif
    // ------------------------------------------------------------------------------
 #  endif
+   // ------------------------------------------------------------------------------
+      struct {
+         uint32_t value;
+         char pad[64 - sizeof(uint32_t)]; // NB: every child increments a counter on its own cache line...
+      } cnt_accept[U_SRV_MAX_KIDS];
    // ------------------------------------------------------------------------------
 #  if defined(U_LINUX) && defined(ENABLE_THREAD)
       ULog::log_date log_date_shared;
@@ -358,16 +366,17 @@ public:
 #define U_SRV_MIN_LOAD_REMOTE_IP    UServer_Base::ptr_shared_data->min_load_remote_ip
 #define U_SRV_TOT_CONNECTION        UServer_Base::ptr_shared_data->tot_connection
 #define U_SRV_CNT_PARALLELIZATION   UServer_Base::ptr_shared_data->cnt_parallelization
+#define U_SRV_CNT_ACCEPT(i)         UServer_Base::ptr_shared_data->cnt_accept[(i)].value
 #define U_SRV_LOCK_USER1          &(UServer_Base::ptr_shared_data->lock_user1)
 #define U_SRV_LOCK_USER2          &(UServer_Base::ptr_shared_data->lock_user2)
 #define U_SRV_LOCK_THROTTLING     &(UServer_Base::ptr_shared_data->lock_throttling)
 #define U_SRV_LOCK_RDB_SERVER     &(UServer_Base::ptr_shared_data->lock_rdb_server)
-#define U_SRV_LOCK_SSL_SESSION    &(UServer_Base::ptr_shared_data->lock_ssl_session)
 #define U_SRV_LOCK_DATA_SESSION   &(UServer_Base::ptr_shared_data->lock_data_session)
 
    static ULock* lock_user1;
    static ULock* lock_user2;
    static int preforked_num_kids; // keeping a pool of children and that they accept connections themselves
+   static int kid_index;          // slot of this process for the cpu affinity and the per-child statistics (0 ... U_SRV_MAX_KIDS-1, -1 => no slot)
    static shared_data* ptr_shared_data;
    static uint32_t shared_data_add, map_size;
    static bool update_date, update_date1, update_date2, update_date3;
@@ -668,7 +677,7 @@ protected:
    static USmtpClient* emailClient;
    static long last_time_email_crash;
    static UString* crashEmailAddress;
-   static bool monitoring_process, set_realtime_priority, public_address, binsert, set_tcp_keep_alive, called_from_handlerTime;
+   static bool monitoring_process, set_realtime_priority, reuseport_cpu_steering, public_address, binsert, set_tcp_keep_alive, called_from_handlerTime;
 
    static uint32_t                 vplugin_size;
    static UVector<UString>*        vplugin_name;
@@ -99,7 +99,8 @@ public:
       SK_RAW        = 0x002,
       SK_UNIX       = 0x004,
       SK_SSL        = 0x008,
-      SK_SSL_ACTIVE = 0x010
+      SK_SSL_ACTIVE = 0x010,
+      SK_KTLS       = 0x020  // the TLS records are encrypted by the kernel (kTLS) => we can use sendfile()
    };
 
    USocket(bool bSocketIsIPv6 = false);
@@ -209,6 +210,19 @@ public:
       U_RETURN(false);
       }
 
+   bool isKTLS() const
+      {
+      U_TRACE_NO_PARAM(0, "USocket::isKTLS()")
+
+      U_INTERNAL_DUMP("U_socket_Type = %d %B", U_socket_Type(this), U_socket_Type(this))
+
+#  ifdef USE_LIBSSL
+      if ((U_socket_Type(this) & SK_KTLS) != 0) U_RETURN(true);
+#  endif
+
+      U_RETURN(false);
+      }
+
    void setSSLActive(bool _flag)
       {
       U_TRACE(0, "USocket::setSSLActive(%b)", _flag)
@@ -217,7 +231,7 @@ public:
       U_ASSERT(isSSL())
 
       if (_flag) U_socket_Type(this) |=  SK_SSL_ACTIVE;
-      else       U_socket_Type(this) &= ~SK_SSL_ACTIVE;
+      else       U_socket_Type(this) &= ~(SK_SSL_ACTIVE | SK_KTLS);
 
       U_INTERNAL_DUMP("U_socket_Type = %d %B", U_socket_Type(this), U_socket_Type(this))
 #  endif
@@ -770,6 +784,9 @@ protected:
    static SocketAddress* cLocal;
    static bool breuseport, bincoming_cpu;
    static int iBackLog, incoming_cpu, accept4_flags; // If flags is 0, then accept4() is the same as accept()
+   static int reuseport_index, reuseport_map_fd, reuseport_prog_fd; // cpu steering of the SO_REUSEPORT group (reuseport_map_fd == -1 => disabled)
+
+   static bool setReusePortSteering(uint32_t num_socket, uint32_t num_cpu);
 
    /**
     * The _socket() function is called to create the socket of the specified type.
@@ -33,6 +33,27 @@
 #  endif
 #endif
 
+/**
+ * NB: with USE_IO_URING (configure --enable-io-uring) the readiness of the descriptors is asked to io_uring with poll request
+ * (IORING_OP_POLL_ADD: multishot for EPOLLET, oneshot rearmed after the dispatch for level-triggered, because IORING_POLL_ADD_LEVEL
+ * is refused by the recent kernel): the changes of the interest set are queued in the submission ring and flushed together with
+ * the wait of the completions, so each iteration of the event loop costs a single io_uring_enter()...
+ *
+ * NB: it is only the replacement of epoll, the I/O of the descriptors stay the syscall of USocket (read, writev, sendfile, SSL). We don't use
+ * multishot accept (the peer address is not given back, so we must pay a getpeername() for every connection in place of the accept4()) nor
+ * multishot recv with provided buffer rings and linked send (they bypass the read/write path of UClientImage_Base: SSL, sendfile, partial write)
+ */
+
+#include <ulib/event/event_fd.h> // NB: normalize USE_IO_URING...
+
+#ifdef USE_IO_URING
+#  include <linux/io_uring.h>
+#  ifdef HAVE_EPOLL_CTL_BATCH
+#  undef HAVE_EPOLL_CTL_BATCH
+#  endif
+#  define U_IO_URING_MAX_ENTRIES 4096
+#endif
+
 #ifndef EPOLLEXCLUSIVE // Provides exclusive wakeups when attaching multiple epoll fds to a shared wakeup source
 #  if !defined(U_LINUX) || LINUX_VERSION_CODE < KERNEL_VERSION(4,5,0)
 #     define EPOLLEXCLUSIVE 0
@@ -44,11 +65,10 @@
 #define EPOLLROUNDROBIN 0 // (1 << 27)
 #endif
 
-#if defined(HAVE_EPOLL_WAIT) && !defined(USE_LIBEVENT) && !defined(U_SERVER_CAPTIVE_PORTAL)
+#if defined(HAVE_EPOLL_WAIT) && !defined(USE_LIBEVENT) && !defined(USE_IO_URING) && !defined(U_SERVER_CAPTIVE_PORTAL)
 #  define U_EPOLLET_POSTPONE_STRATEGY
 #endif
 
-#include <ulib/event/event_fd.h>
 #include <ulib/event/event_time.h>
 
 class USocket;
@@ -59,7 +79,7 @@ class UServer_Base;
 class UClientImage_Base;
 class UClientThrottling;
 
-// interface to select() and epoll()
+// interface to select(), epoll() and io_uring()
 
 class U_EXPORT UNotifier {
 public:
@@ -102,6 +122,7 @@ public:
    static void modify(UEventFd* handler_event);
    static void callForAllEntryDynamic(bPFpv function);
    static void insert(UEventFd* handler_event, int op = 0);
+   static void erase( UEventFd* handler_event); // NB: after handlerDelete() for a fd that stay open (ex: a client connection that we keep)...
 
 #ifndef USE_LIBEVENT
    static void init();
@@ -208,7 +229,24 @@ protected:
    static uint32_t bepollet_threshold, lo_map_fd_len;
 
 #ifndef USE_LIBEVENT
-# ifdef HAVE_EPOLL_WAIT
+# ifdef USE_IO_URING
+   static int ring_fd;
+   static char* ring_ptr;
+   static struct io_uring_sqe* sqes;
+   static struct io_uring_cqe* cqes;
+   static uint32_t* sq_head;
+   static uint32_t* sq_tail;
+   static uint32_t* cq_head;
+   static uint32_t* cq_tail;
+   static uint32_t sq_mask, cq_mask, sq_entries, ring_len, ring_gen;
+
+   static void ringSetup() U_NO_EXPORT;
+   static void ringClose() U_NO_EXPORT;
+   static void pollAdd(UEventFd* item, uint32_t mask) U_NO_EXPORT;
+   static void pollRemove(UEventFd* item) U_NO_EXPORT;
+   static int  ringEnter(UEventTime* ptimeout) U_NO_EXPORT;
+   static struct io_uring_sqe* getSqe() U_NO_EXPORT;
+# elif defined(HAVE_EPOLL_WAIT)
    static int epollfd;
    static struct epoll_event*  events;
    static struct epoll_event* pevents;
@@ -34,6 +34,19 @@ extern "C" {
 #undef  PACKAGE_VERSION
 #define PACKAGE_VERSION ULIB_VERSION
 
+/**
+ * With libpq >= 14 (LIBPQ_HAS_PIPELINING) executeBatch() use the pipeline mode: the executions are sent without waiting the results
+ * and these are read after the sync. We sync every U_PGSQL_PIPELINE_DEPTH executions to avoid that both client and server block on
+ * write with the socket buffers full (the connection is blocking)...
+ *
+ * executeAsync() use the pipeline mode too (with the connection nonblocking): every execution is followed by a sync, so that its
+ * error don't abort the executions that follow, and the results are read when UNotifier report the socket readable...
+ */
+
+#ifndef U_PGSQL_PIPELINE_DEPTH
+#define U_PGSQL_PIPELINE_DEPTH 512
+#endif
+
 /**
  * .................
  * #define BOOLOID         16
@@ -384,6 +397,7 @@ public:
 
    UString stmt;
    PGresult* res;
+   uint32_t nreset;          // the number of resets of the connection when the statement was prepared
    char stmtName[13];
    bool resultFormat;        // is zero to obtain results in text format, or one to obtain results in binary format
 };
@@ -398,11 +412,17 @@ public:
       U_INTERNAL_ASSERT_POINTER(UString::str_pgsql_name)
 
       UOrmDriver::name = *UString::str_pgsql_name;
+
+      async_status = U_ORM_ASYNC_AGAIN;
+      nreset       = 0;
       }
 
    UOrmDriverPgSql(const UString& name_drv) : UOrmDriver(name_drv)
       {
       U_TRACE_REGISTER_OBJECT(0, UOrmDriverPgSql, "%V", name_drv.rep)
+
+      async_status = U_ORM_ASYNC_AGAIN;
+      nreset       = 0;
       }
 
    virtual ~UOrmDriverPgSql();
@@ -413,10 +433,17 @@ public:
    virtual void handlerDisConnect() U_DECL_FINAL;
    virtual void execute(USqlStatement* pstmt) U_DECL_FINAL;
    virtual bool nextRow(USqlStatement* pstmt) U_DECL_FINAL;
+   virtual bool executeBatch(USqlStatement* pstmt, uint32_t n, vPFpvu setParam, vPFpvu getResult, void* obj) U_DECL_FINAL;
    virtual void handlerStatementReset(USqlStatement* pstmt) U_DECL_FINAL;
    virtual void handlerStatementRemove(USqlStatement* pstmt) U_DECL_FINAL;
    virtual bool handlerQuery(const char* query, uint32_t query_len) U_DECL_FINAL;
 
+   virtual int  getFd() U_DECL_FINAL;
+   virtual bool asyncRead() U_DECL_FINAL;
+   virtual bool asyncSend(USqlStatement* pstmt) U_DECL_FINAL;
+   virtual int  asyncResult(USqlStatement* pstmt) U_DECL_FINAL;
+   virtual bool asyncReset() U_DECL_FINAL;
+
    virtual unsigned int cols(USqlStatement* pstmt) U_DECL_FINAL;
    virtual unsigned long long affected(USqlStatement* pstmt) U_DECL_FINAL;
    virtual unsigned long long last_insert_rowid(USqlStatement* pstmt, const char* sequence) U_DECL_FINAL;
@@ -509,8 +536,15 @@ public:
    const char* dump(bool reset) const;
 #endif
 
+protected:
+   int async_status; // the result of the execution in flight that we are reading (until the sync)
+   uint32_t nreset;  // the number of resets of the connection (NB: with a reset the statements prepared in the session are lost)
+
+   bool isPrepared(UPgSqlStatement* pstmt) const { return (pstmt->pHandle && pstmt->nreset == nreset); }
+
 private:
    bool checkExecution(PGresult* res);
+   bool getBatchResult(UPgSqlStatement* pstmt, uint32_t i, vPFpvu getResult, void* obj) U_NO_EXPORT;
 
    U_DISALLOW_COPY_AND_ASSIGN(UOrmDriverPgSql)
 
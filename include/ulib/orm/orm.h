@@ -216,6 +216,23 @@ public:
 
    void execute();
 
+   // Execute the statement n times in batch: before every execution setParam(obj, i) must update the values of the binding param
+   // registers and after it getResult(obj, i) can read the binding result registers (and nextRow()). With PostgreSQL the executions
+   // are sent in one flight (pipeline mode) and the results are collected afterwards, the other drivers execute them serially.
+   // Return false if some execution failed (with PostgreSQL getResult() is not called for that). NB: with pipelining setParam()
+   // is called for the following executions before getResult(), so this must not rely on the values of the binding param registers...
+
+   bool executeBatch(uint32_t n, vPFpvu setParam, vPFpvu getResult = U_NULLPTR, void* obj = U_NULLPTR);
+
+   // Execute the statement without waiting for the result: the connection is registered with UNotifier and func(arg, true) is
+   // called when the result is arrived, after the update of the binding result registers (func(arg, false) if the execution failed
+   // or the connection is lost). The executions in flight are kept in order and the binding param registers can be reused as soon
+   // as this return. Return false if it is not possible (only PostgreSQL with pipelining support it, too many executions in flight,
+   // ...), then the caller must use execute(). NB: a session used with it must not be used with execute() while there are executions
+   // in flight, so it is better to have a session dedicated to the asynchronous executions...
+
+   bool executeAsync(vPFpvb func, void* arg = U_NULLPTR);
+
    // This function returns the number of database rows that were changed
    // or inserted or deleted by the most recently completed SQL statement
 
@@ -14,6 +14,7 @@
 #ifndef U_ORM_DRIVER_H
 #define U_ORM_DRIVER_H 1
 
+#include <ulib/event/event_fd.h>
 #include <ulib/dynamic/plugin.h>
 #include <ulib/container/vector.h>
 
@@ -202,6 +203,63 @@ class UOrmSession;
 class UServer_Base;
 class UOrmStatement;
 
+/**
+ * With executeAsync() the execution is sent to the database and we return without waiting for the result: the connection is
+ * registered with UNotifier (UOrmAsync) and the function of the execution is called when its result is arrived, so that
+ * (Ex: from a USP page) one process can have many executions in flight instead of blocking on each of them...
+ */
+
+#define U_ORM_ASYNC_MAX  1024 // NB: must be a power of 2...
+
+#define U_ORM_ASYNC_AGAIN 0 // the result is not yet arrived
+#define U_ORM_ASYNC_OK    1
+#define U_ORM_ASYNC_ERROR 2
+
+typedef struct uormasync {
+   USqlStatement* pstmt;
+   vPFpvb func;
+   void* arg;
+} uormasync;
+
+class U_EXPORT UOrmAsync : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   UOrmAsync(UOrmDriver* _pdrv)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UOrmAsync, "%p", _pdrv)
+
+      pdrv   = _pdrv;
+      head   = num = 0;
+      breset = true;
+      }
+
+   ~UOrmAsync();
+
+   // SERVICES
+
+   void push(USqlStatement* pstmt, vPFpvb func, void* arg);
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int handlerRead() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+   UOrmDriver* pdrv;
+   uint32_t head, num;
+   uormasync queue[U_ORM_ASYNC_MAX]; // the executions in flight
+   bool breset; // false => the connection is going to be closed, there is no need to reset it after handlerDelete()
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UOrmAsync)
+};
+
 class U_EXPORT UOrmDriver {
 public:
 
@@ -214,8 +272,11 @@ public:
 
       errmsg     = errname = U_NULLPTR;
       errcode    = 0;
+      nerror     = 0;
       SQLSTATE   = U_NULLPTR;
       connection = U_NULLPTR;
+
+      pasync     = U_NULLPTR;
       }
 
    UOrmDriver(const UString& name_drv) : name(name_drv)
@@ -224,8 +285,11 @@ public:
 
       errmsg     = errname = U_NULLPTR;
       errcode    = 0;
+      nerror     = 0;
       SQLSTATE   = U_NULLPTR;
       connection = U_NULLPTR;
+
+      pasync     = U_NULLPTR;
       }
 
    virtual ~UOrmDriver();
@@ -409,6 +473,55 @@ public:
       U_TRACE(0, "UOrmDriver::execute(%p)", pstmt)
       }
 
+   // Executes n times the statement: before every execution setParam(obj, i) update the binding param registers and after it
+   // getResult(obj, i) read the binding result registers. The default is to execute them serially (one round trip for execution),
+   // a driver that support pipelining (PostgreSQL) override it to send all the executions in one flight...
+
+   virtual bool executeBatch(USqlStatement* pstmt, uint32_t n, vPFpvu setParam, vPFpvu getResult, void* obj);
+
+   // ASYNC
+
+   bool executeAsync(USqlStatement* pstmt, vPFpvb func, void* arg);
+
+   uint32_t getNumAsyncInFlight() const { return (pasync ? pasync->num : 0); }
+
+   // A driver that support asynchronous execution (PostgreSQL) override them: getFd() return the socket of the connection,
+   // asyncSend() send the execution without waiting for the result (false => not possible, the caller must use execute()),
+   // asyncRead() consume the input of the socket (false => connection lost) and asyncResult() return U_ORM_ASYNC_AGAIN until
+   // the result of the oldest execution in flight is arrived (and then the binding result registers are updated). asyncReset() is
+   // called when the connection is unregistered from UNotifier (Ex: connection lost), after the executions in flight are failed: it
+   // must leave the connection usable again by execute() and executeAsync() (false => the connection can't be restored)...
+
+   virtual int getFd() { return -1; }
+
+   virtual bool asyncSend(USqlStatement* pstmt)
+      {
+      U_TRACE(0, "UOrmDriver::asyncSend(%p)", pstmt)
+
+      U_RETURN(false);
+      }
+
+   virtual bool asyncRead()
+      {
+      U_TRACE_NO_PARAM(0, "UOrmDriver::asyncRead()")
+
+      U_RETURN(false);
+      }
+
+   virtual int asyncResult(USqlStatement* pstmt)
+      {
+      U_TRACE(0, "UOrmDriver::asyncResult(%p)", pstmt)
+
+      U_RETURN(U_ORM_ASYNC_ERROR);
+      }
+
+   virtual bool asyncReset()
+      {
+      U_TRACE_NO_PARAM(0, "UOrmDriver::asyncReset()")
+
+      U_RETURN(true);
+      }
+
    virtual bool nextRow(USqlStatement* pstmt)
       {
       U_TRACE(0, "UOrmDriver::nextRow(%p)", pstmt)
@@ -511,8 +624,11 @@ public:
    const char* errname;
    const char* SQLSTATE;
    int errcode;
+   uint32_t nerror; // the number of the errors reported with printError()
 
 protected:
+   UOrmAsync* pasync; // the connection registered with UNotifier (allocated at the first executeAsync())
+
    static bool                  bexit;
    static uint32_t              vdriver_size, env_driver_len;
    static const char*           env_driver;
@@ -529,6 +645,7 @@ private:
 
    U_DISALLOW_ASSIGN(UOrmDriver)
 
+   friend class UOrmAsync;
    friend class UOrmSession;
    friend class UServer_Base;
    friend class UOrmStatement;
@@ -0,0 +1,222 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    shared_cache.h - A sharded cache on shared memory with CLOCK/TTL eviction
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_SHARED_CACHE_H
+#define ULIB_SHARED_CACHE_H 1
+
+#include <ulib/cache.h>
+
+/**
+ * @class USharedCache
+ *
+ * @brief USharedCache is a cache on a mmap'd file (MAP_SHARED) that can be used at the same time by all the preforked processes.
+ *
+ * The file is split in N shards (N is a power of 2) each protected by its own spin lock, so that operations on keys that map
+ * to different shards never contend. Each shard is made of an open addressing index (linear probing with backward shift deletion)
+ * and a circular log of entries with the same structure of UCache:
+ *
+ * +------------+----------------------------+--------------------------+------------+
+ * | shard_info | s0 s1 ... snslot-1 (index) | entry0 entry1 ... entryn | free space |
+ * +------------+----------------------------+--------------------------+------------+
+ *
+ * x[      8....writer-1] consecutive entries, newest entry on the right.
+ * x[writer.....oldest-1] free space for new entries.
+ * x[oldest.....unused-1] consecutive entries, oldest entry on the left.
+ * x[unused.......size-1] unused.
+ *
+ * When the writer reach the oldest entry we apply the CLOCK algorithm instead of overwrite it regardless of its popularity:
+ * an entry read since it was written (referenced) gets a second chance and is moved to the head of the log, otherwise (or if expired)
+ * is evicted. An entry can be as big as the log of a shard (not limited by U_MAX_DATALEN). Each shard keeps counters (hits, misses,
+ * set, evictions, expired) that can be read with getStatistics() for monitoring...
+ */
+
+#define U_SHARED_CACHE_MAX_SHARD 256
+
+class U_EXPORT USharedCache {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   USharedCache()
+      {
+      U_TRACE_REGISTER_OBJECT(0, USharedCache, "", 0)
+
+      fd   = -1;
+      ttl  = 0;
+      info = U_NULLPTR;
+      }
+
+   ~USharedCache();
+
+   // OPEN/CREAT a cache file (NB: must be called before fork() to share the mapping with the children...)
+
+   bool open(const UString& path, uint32_t size, uint32_t nshard = 0, const UString* environment = U_NULLPTR, bool btemp = false);
+
+   // use a memory area already shared with the children (ex: UServer_Base::getOffsetToDataShare()), zeroed or formatted by a previous init()
+
+   void init(void* ptr, uint32_t size, uint32_t nshard = 0);
+
+   // OPERATION
+
+   bool set(const char* key, uint32_t keylen, const char* data, uint32_t datalen, uint32_t _ttl = 0);
+
+   bool set(const UString& key, const UString& data, uint32_t _ttl = 0) { return set(U_STRING_TO_PARAM(key), U_STRING_TO_PARAM(data), _ttl); }
+
+   UString get(const char* key, uint32_t keylen);
+   UString get(const UString& key) { return get(U_STRING_TO_PARAM(key)); }
+
+   bool remove(const char* key, uint32_t keylen);
+   bool remove(const UString& key) { return remove(U_STRING_TO_PARAM(key)); }
+
+   void clear();
+
+   // operator []
+
+   UString operator[](const UString& key) { return get(key); }
+
+   // SERVICES
+
+   uint32_t getTTL() const
+      {
+      U_TRACE_NO_PARAM(0, "USharedCache::getTTL()")
+
+      U_RETURN(ttl);
+      }
+
+   uint32_t getNumShard() const
+      {
+      U_TRACE_NO_PARAM(0, "USharedCache::getNumShard()")
+
+      U_INTERNAL_ASSERT_POINTER(info)
+
+      U_RETURN(info->nshard);
+      }
+
+   typedef struct stats {
+      uint64_t hits, misses, sets, evictions, expired;
+      uint32_t count;
+   } stats;
+
+   void getStatistics(stats& s); // sum of the counters of all the shards
+
+   UString getStatistics(); // as text, ex: "hits 10 misses 2 sets 5 evictions 0 expired 1 count 4"
+
+   // STREAM
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   typedef struct cache_info {
+      uint32_t magic;
+      uint32_t nshard;
+      uint32_t shard_size; // size of each shard (shard_info + index + log)
+      uint32_t nslot;      // number of slot of the index of each shard
+      } cache_info;
+
+   typedef struct shard_info {
+      uint32_t lock;       // pid of the owner of the spin lock
+      uint32_t count;      // number of entries in the index
+      uint32_t size;       // size of the log
+      uint32_t writer;     // pointer to free space
+      uint32_t oldest;     // pointer to oldest entries
+      uint32_t unused;     // pointer to unused space
+      uint64_t hits, misses, sets, evictions, expired;
+      } shard_info;
+
+   typedef struct shard_slot {
+      uint32_t hash;
+      uint32_t pos;        // 0 => empty slot
+      } shard_slot;
+
+   typedef struct shard_entry {
+      uint32_t hash;
+      uint32_t keylen;
+      uint32_t datalen;
+      uint32_t time_expire; // 0 => entry removed from the index (dead)
+      uint32_t referenced;  // CLOCK bit
+      uint32_t pad;
+   // ------> keylen  array of char...
+   // ------> datalen array of char...
+   } shard_entry;
+
+   int fd;
+   cache_info* info;
+   uint32_t ttl; // time to live of the last entry read
+
+   static uint32_t hash(const char* key, uint32_t keylen)
+      {
+      U_TRACE(0, "USharedCache::hash(%.*S,%u)", keylen, key, keylen)
+
+      // NB: u_hash() depend on a seed that can be different between processes...
+
+      uint32_t h = u_cdb_hash((unsigned char*)key, keylen, -1);
+
+      // finalizer of murmurhash3 (we need well spread bits both for the shard and the slot)
+
+      h ^= h >> 16;
+      h *= 0x85ebca6b;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35;
+      h ^= h >> 16;
+
+      U_RETURN(h);
+      }
+
+   shard_info* getShard(uint32_t keyhash) const
+      {
+      U_TRACE(0, "USharedCache::getShard(%u)", keyhash)
+
+      U_INTERNAL_ASSERT_POINTER(info)
+
+      shard_info* shard = (shard_info*)((char*)(info+1) + (keyhash >> 24) % info->nshard * info->shard_size);
+
+      U_RETURN_POINTER(shard, shard_info);
+      }
+
+   shard_slot* getSlot(shard_info* shard) const { return (shard_slot*)(shard+1); }
+
+   char* getLog(shard_info* shard) const { return (char*)(getSlot(shard) + info->nslot); }
+
+   shard_entry* entry(shard_info* shard, uint32_t pos) const
+      {
+      U_TRACE(0, "USharedCache::entry(%p,%u)", shard, pos)
+
+      U_INTERNAL_ASSERT(pos <= (shard->size - sizeof(shard_entry)))
+
+      shard_entry* e = (shard_entry*)(getLog(shard) + pos);
+
+      U_RETURN_POINTER(e, shard_entry);
+      }
+
+   static uint32_t getEntryLen(uint32_t keylen, uint32_t datalen) { return ((sizeof(shard_entry) + keylen + datalen + 7) & ~7); }
+
+   static void lock(shard_info* shard);
+   static void unlock(shard_info* shard);
+
+   uint32_t find(shard_info* shard, uint32_t keyhash, const char* key, uint32_t keylen) const __pure;
+   void     erase(shard_info* shard, uint32_t i);
+   bool     evict(shard_info* shard, bool bforce); // NB: return true if the entry get a second chance (CLOCK)...
+   void     resetShard(shard_info* shard);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(USharedCache)
+};
+
+#endif
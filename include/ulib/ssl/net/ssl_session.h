@@ -14,6 +14,7 @@
 #ifndef ULIB_SSL_SESSION_H
 #define ULIB_SSL_SESSION_H 1
 
+#include <ulib/shared_cache.h>
 #include <ulib/ssl/net/sslsocket.h>
 #include <ulib/utility/data_session.h>
 
@@ -21,8 +22,18 @@
  * SSL Session Information
  *
  * This class contains data about an SSL session
+ *
+ * With the preforked processes the sessions (resumption by session id) are kept in a USharedCache (a shard with its own spin lock
+ * for each slice of the id space) on the shared data of the server (UServer_Base::getOffsetToDataShare()), so that a client can resume
+ * the session with any child. The keys for the session tickets are in the same area: they are generated before the fork and rotated
+ * (every session timeout) by the first child that find them expired, the current key encrypt the new tickets and the previous one is
+ * still accepted (the ticket is renewed) so that a ticket is valid for at least a session timeout...
  */
 
+#ifndef U_SSL_SESSION_CACHE_SIZE
+#define U_SSL_SESSION_CACHE_SIZE (4U * 1024U * 1024U)
+#endif
+
 class UHTTP;
 class UHttpPlugIn;
 
@@ -46,10 +57,33 @@ public:
 
    // SERVICES
 
+   static void setDataShare(); // NB: must be called before UServer allocate the shared data (first step)...
+   static void init();
+   static void close();
+
+   static UString getStatistics(); // ex: "hits 10 misses 2 sets 5 evictions 0 expired 1 count 4 ticket key rotation 3"
+
 #if defined(DEBUG) && defined(U_STDCPP_ENABLE)
    const char* dump(bool reset) const { return UDataStorage::dump(reset); }
 #endif
 
+protected:
+   typedef struct ticket_key {
+      unsigned char name[16], aes_key[32], hmac_key[32];
+   } ticket_key;
+
+   typedef struct ticket_keys {
+      uint32_t rotate;  // time of the next rotation
+      uint32_t current; // number of the rotations (the current key is key[current % 3], the previous key[(current+2) % 3])
+      ticket_key key[3];
+   } ticket_keys;
+
+   static void* ptr_cache;
+   static ticket_keys* keys;
+   static USharedCache* cache;
+
+   static void rotateTicketKey(uint32_t n);
+
 private:
    static SSL_SESSION* sess;
 
@@ -58,6 +92,12 @@ private:
 
    static SSL_SESSION* getSession(SSL* ssl, unsigned char* id, int len, int* copy);
 
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   static int ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, EVP_MAC_CTX* hctx, int enc);
+#elif !defined(OPENSSL_NO_TLSEXT)
+   static int ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx,    HMAC_CTX* hctx, int enc);
+#endif
+
    U_DISALLOW_COPY_AND_ASSIGN(USSLSession)
 
    friend class UHTTP;
@@ -32,6 +32,10 @@
 #  define U_USE_NPN  1
 #endif
 
+#if defined(U_LINUX) && defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+#  define U_USE_KTLS 1
+#endif
+
 #if !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
 #  include <openssl/ocsp.h>
 #  ifndef U_OCSP_MAX_RESPONSE_SIZE
@@ -213,6 +217,17 @@ public:
       U_RETURN(0);
       }
 
+   /**
+    * kTLS (kernel TLS): after the handshake OpenSSL gives the keys of the connection to the kernel (TCP_ULP "tls", TLS_TX/TLS_RX)
+    * and the records are encrypted by the kernel, so that a file can be sent with sendfile() without copying it in user space.
+    * The offload happens only if the kernel (module tls) and the negotiated cipher (AES-GCM, CHACHA20-POLY1305) support it,
+    * otherwise the connection continues with the encryption in user space. USocket::isKTLS() tells if the connection has it...
+    */
+
+#ifdef U_USE_KTLS
+   static bool bktls;
+#endif
+
    // VIRTUAL METHOD
 
    virtual int send(const char* pData,   uint32_t iDataLen) U_DECL_FINAL;
@@ -336,6 +351,7 @@ private:
 
                       friend class UHTTP;
                       friend class USocket;
+                      friend class USSLSession;
                       friend class UHttpPlugIn;
                       friend class UClient_Base;
                       friend class UServer_Base;
@@ -123,6 +123,7 @@ class UREDISClient_Base;
 
 template <class T> class UVector;
 template <class T> class UHashMap;
+template <class T> class UFlatHashMap;
 template <class T> class UJsonTypeHandler;
 
 class U_EXPORT UStringRep {
@@ -1015,6 +1016,7 @@ private:
 
    template <class T> friend class UVector;
    template <class T> friend class UHashMap;
+   template <class T> friend class UFlatHashMap;
    template <class T> friend class UJsonTypeHandler;
    template <class T> friend void u_construct(const T*, uint32_t);
 };
@@ -1201,6 +1203,7 @@ protected:
 
    template <class T> friend class UVector;
    template <class T> friend class UHashMap;
+   template <class T> friend class UFlatHashMap;
 
    explicit UString(UStringRep** pr) : rep(*pr) // NB: for toUTF8() and fromUTF8()...
       {
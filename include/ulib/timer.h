@@ -20,7 +20,12 @@
 class UNotifier;
 class UServer_Base;
 
+#define U_TIMER_BATCH (U_NOT_FOUND-1) // UEventTime::timer_index of an expired alarm that wait in the batch of UTimer::run()
+
 // UNotifier use this class to notify a timeout from select()
+//
+// The active timers are kept in a 4-ary min-heap (ordered by time to expire) with the position of every
+// alarm stored in UEventTime::timer_index, so insert/erase/update are O(log4 n) and the next alarm is O(1)
 
 class U_EXPORT UTimer {
 public:
@@ -53,7 +58,7 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::empty()")
 
-      if (first == U_NULLPTR) U_RETURN(true);
+      if (num == 0) U_RETURN(true);
 
       U_RETURN(false);
       }
@@ -94,8 +99,6 @@ public:
       {
       U_TRACE(0, "UTimer::erase(%p)", item)
 
-      U_INTERNAL_ASSERT_POINTER(first)
-
       if (mode != NOSIGNAL) delete item;
       else
          {
@@ -108,6 +111,8 @@ public:
 
    static void erase(UEventTime* palarm);
 
+   static void updateTimeToExpire(UEventTime* ptime); // reschedule a pending timer from now (ex: keep-alive)
+
    // run the list of timers. Your main program needs to call this every so often, or as indicated by getTimeout()
 
    static void run();
@@ -117,10 +122,10 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::getTimeout()")
 
-      if (        first &&
-          (run(), first))
+      if (        num &&
+          (run(), num))
          {
-         UEventTime* a = first->alarm;
+         UEventTime* a = heap[0]->alarm;
 
          U_ASSERT(a->checkTolerance())
 
@@ -134,14 +139,14 @@ public:
       {
       U_TRACE(0, "UTimer::isHandler(%p)", palarm)
 
-      for (UTimer* item = first; item; item = item->next)
-         {
-         if (item->alarm == palarm)
-            {
-            U_INTERNAL_DUMP("item = %p", item)
+      uint32_t i = palarm->timer_index;
 
-            U_RETURN(true);
-            }
+      U_INTERNAL_DUMP("i = %u num = %u", i, num)
+
+      if (i < num &&
+          heap[i]->alarm == palarm)
+         {
+         U_RETURN(true);
          }
 
       U_RETURN(false);
@@ -176,11 +181,12 @@ protected:
    UEventTime* alarm;
 
    static int mode;
-   static UTimer* pool;  //   free list 
-   static UTimer* first; // active list 
+   static UTimer* pool;  // free list
+   static UTimer* batch; // expired timers in the course of dispatch by run()
+   static UTimer** heap; // active timers (4-ary min-heap)
+   static uint32_t num, capacity;
 
    static void callHandlerTimeout();
-   static void updateTimeToExpire(UEventTime* ptime);
 
 #ifdef DEBUG
    static bool invariant();
@@ -189,6 +195,11 @@ protected:
 private:
    void insertEntry() U_NO_EXPORT;
 
+   static void siftUp(  uint32_t i) U_NO_EXPORT;
+   static void siftDown(uint32_t i) U_NO_EXPORT;
+   static void removeEntry(uint32_t i) U_NO_EXPORT;
+   static void dispatch(UTimer* item) U_NO_EXPORT;
+
    bool operator< (const UTimer& t) const { return (*alarm < *t.alarm); }
    bool operator> (const UTimer& t) const { return  t.operator<(*this); }
    bool operator<=(const UTimer& t) const { return !t.operator<(*this); }
@@ -0,0 +1,288 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    binary_access_log.h - compact binary format for the apache like log
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_BINARY_ACCESS_LOG_H
+#define ULIB_BINARY_ACCESS_LOG_H 1
+
+#include <ulib/log.h>
+#include <ulib/container/vector.h>
+#include <ulib/container/flat_hash_map.h>
+
+/**
+ * UBinaryAccessLog writes the records of the apache like log (NCSA combined format) in a compact binary form, without the formatting
+ * of the text (date, response code, body length) for every request. UBinaryAccessLogReader decodes the file and gives back the fields
+ * of every record, to rebuild the line of the combined format or a JSON object (see the program userver_logdec of examples/userver).
+ *
+ * A record is: MAGIC (1 byte) - TYPE (1 byte) - length of the body (varint) - body. The numbers are unsigned LEB128 varint (the signed
+ * ones with zigzag), so the record of a request is a few bytes plus the strings never seen before. With more processes that write on
+ * the same file the records are interleaved, so every record carries the pid of the writer and the decoder keeps a state for every pid.
+ *
+ * The records of a process are grouped in segments. A segment starts with a record 'S' (pid, time, offset of the local time from UTC)
+ * and the time of every request is the delta from the previous record of the same pid. The host, the method, the path of the URI (the
+ * query is written as is), the protocol, the referer and the user agent are interned in a dictionary of the segment: the first time a
+ * string is written in full and it takes the next id, after that it is written as its id. The writer starts a new segment (and reset the
+ * dictionary) after a fork, when the dictionary is full or after U_BINARY_ACCESS_LOG_INTERVAL seconds.
+ *
+ * With the rotation of the memory mapped log (LOG_FILE_SZ) the first write of a process in the new file starts with the state of its
+ * segment: a record 'S' with the time of the last record and some records 'D' (pid and the strings of the dictionary, in order of id),
+ * so every file is decoded on its own. The state is the one of the records already written: the encoder keeps it for the writes made
+ * by the process that serve the requests, with the writer thread (ULog::startAsync()) it is rebuilt by the thread scanning in place the
+ * records written, in a buffer allocated before the thread starts (the thread must not allocate from the memory pool). To keep this
+ * state small the writer starts also a new segment after a rotation and when the strings of the dictionary are more than 1/8 of the file.
+ *
+ * The cost of the encoder is the lookup of up to six strings in the dictionary, so in front of it there is a small direct mapped cache
+ * indexed by the length and the ends of the string (no hash of the whole string)...
+ */
+
+#define U_BINARY_ACCESS_LOG_MAGIC      0xB1
+#define U_BINARY_ACCESS_LOG_VERSION    2     // 2: record 'D' (dictionary of a segment resumed after the log rotation)
+#define U_BINARY_ACCESS_LOG_INTERVAL   60    // max duration (sec) of a segment
+#define U_BINARY_ACCESS_LOG_MAX_ENTRY  4096  // max number of strings in the dictionary of a segment
+#define U_BINARY_ACCESS_LOG_MAX_STRING 1000  // the strings longer than this are truncated (like the text format)
+#define U_BINARY_ACCESS_LOG_MAX_RECORD (4 * (U_BINARY_ACCESS_LOG_MAX_STRING + 16) + 256)
+
+#define U_BINARY_ACCESS_LOG_CACHE      256   // entries of the cache in front of the dictionary (must be a power of 2)
+
+// the fields of a record
+
+typedef struct uaccesslogrecord {
+   const char* host;
+   const char* request; // "method target protocol"
+   const char* referer;
+   const char* agent;
+   uint32_t host_len, request_len, referer_len, agent_len, code, body_len;
+   time_t sec;
+   int adjust;          // offset of the local time from UTC (decoder)
+   pid_t pid;           // writer (decoder)
+} uaccesslogrecord;
+
+typedef struct ubinarylogcache {
+   const UStringRep* key; // NB: the reference is hold by the dictionary (the cache is reset with it)...
+   uint32_t id;
+} ubinarylogcache;
+
+// the state of the segment of the records written by the writer thread: the record 'S' and the records 'D' to write after a rotation
+
+typedef struct ubinarylogstate {
+   char* data;    // NB: the first 32 bytes are the room for the record 'S'...
+   time_t last;
+   uint32_t size, len, dstart, dcount; // dstart: offset of the record 'D' in progress, dcount: the strings in it
+   int adjust;
+   bool valid;    // false => the start of the segment is not written yet (or the dictionary don't fit)
+} ubinarylogstate;
+
+class U_EXPORT UBinaryAccessLog {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UBinaryAccessLog();
+   ~UBinaryAccessLog();
+
+   // SERVICES
+
+   void write(ULog* log, const uaccesslogrecord& r);
+
+   // log rotation (see ULog::writeInternal())
+
+   void setWriter(uint32_t log_file_sz);          // called before the start of the writer thread
+   void written(const struct iovec* iov, int n); // records written by the writer thread
+
+   const char* getResume(const struct iovec* iov, bool bwriter, uint32_t& len); // the state of the segment before the records of iov
+
+   uint32_t getNumRecord() const  { return nrecord; }
+   uint32_t getNumSegment() const { return nsegment; }
+
+   // varint
+
+   static char* putVarint(char* ptr, uint32_t n)
+      {
+      while (n >= 0x80)
+         {
+         *ptr++ = (char)(n | 0x80);
+
+         n >>= 7;
+         }
+
+      *ptr++ = (char)n;
+
+      return ptr;
+      }
+
+   static uint32_t zigzag(int n)        { return ((uint32_t)n << 1) ^ (uint32_t)(n >> 31); }
+   static int      unzigzag(uint32_t n) { return (int)(n >> 1) ^ -(int)(n & 1); }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UFlatHashMap<void*> dict; // string -> id
+   UVector<UString> vdict;   // id -> string
+   UString resume;
+   ubinarylogstate wstate; // the records written by the writer thread
+   ubinarylogcache* cache;
+   char* buffer;           // NB: U_BINARY_ACCESS_LOG_MAX_RECORD bytes, the object must fit in a block of the memory pool...
+   char* ptr;
+   time_t start, last, last_prev;
+   uint32_t nentry, nentry_prev, nrecord, nsegment, dict_sz, nrotate;
+   int adjust;
+   pid_t pid;
+   char segment[32];
+
+   static uint32_t cacheIndex(const char* s, uint32_t len)
+      {
+      uint64_t x = (len >= 8 ? u_get_unalignedp64(s) ^ (u_get_unalignedp64(s + len - 8) * 31)
+                             : (uint64_t)s[0] << 8 | (unsigned char)s[len-1]) ^ len;
+
+      return (uint32_t)((x * 0x9E3779B97F4A7C15ULL) >> 56) & (U_BINARY_ACCESS_LOG_CACHE - 1);
+      }
+
+   void clearDictionary();
+   uint32_t newSegment(time_t sec);
+
+   static void putResume(UString& buffer, pid_t pid, time_t sec, int adjust, const UVector<UString>& vec, uint32_t n);
+
+   void putString(const char* s, uint32_t len);
+   void putLiteral(const char* s, uint32_t len)
+      {
+      U_TRACE(0, "UBinaryAccessLog::putLiteral(%.*S,%u)", len, s, len)
+
+      ptr = putVarint(ptr, len);
+
+      if (len)
+         {
+         U_MEMCPY(ptr, s, len);
+
+         ptr += len;
+         }
+      }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UBinaryAccessLog)
+};
+
+class U_EXPORT UBinaryAccessLogReader {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UBinaryAccessLogReader();
+   ~UBinaryAccessLogReader();
+
+   // SERVICES
+
+   void setInput(const char* data, uint32_t len)
+      {
+      U_TRACE(0, "UBinaryAccessLogReader::setInput(%p,%u)", data, len)
+
+      pnext = data;
+      pend  = data + len;
+      }
+
+   bool next(uaccesslogrecord& r); // false at the end of the input
+
+   uint32_t getNumRecord() const  { return nrecord; }
+   uint32_t getNumSegment() const { return nsegment; }
+   uint32_t getNumSkipped() const { return nskipped; } // records that we can't decode (the start of the segment is not in the input)
+   uint32_t getNumGarbage() const { return ngarbage; } // bytes that are not records
+
+   // output: NCSA combined format or JSON (a line for record)
+
+   static void appendCombined(UString& buffer, const uaccesslogrecord& r);
+   static void appendJSON(UString& buffer, const uaccesslogrecord& r);
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   class UStream {
+   public:
+
+   U_MEMORY_TEST
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UVector<UString> dict;
+   time_t last;
+   int adjust;
+   pid_t pid;
+
+   UStream(pid_t _pid) : dict(256U)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UStream, "%d", _pid)
+
+      last   = 0;
+      adjust = 0;
+      pid    = _pid;
+      }
+
+   ~UStream()
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UStream)
+      }
+
+#  if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return dict.dump(_reset); }
+#  endif
+
+   private:
+      U_DISALLOW_ASSIGN(UStream)
+   };
+
+   UVector<UStream*> vstream;
+   UString request;
+   const char* pnext;
+   const char* pend;
+   uint32_t nrecord, nsegment, nskipped, ngarbage;
+
+   UStream* getStream(pid_t pid, bool create);
+
+   bool decodeSegment(const char* ptr, const char* end);
+   bool decodeDictionary(const char* ptr, const char* end);
+   bool decodeRequest(const char* ptr, const char* end, uaccesslogrecord& r);
+
+   static bool getVarint(const char*& ptr, const char* end, uint32_t& n)
+      {
+      uint32_t shift = 0;
+
+      for (n = 0; ptr < end && shift < 35; shift += 7)
+         {
+         unsigned char c = *ptr++;
+
+         n |= (uint32_t)(c & 0x7F) << shift;
+
+         if ((c & 0x80) == 0) return true;
+         }
+
+      return false;
+      }
+
+   static bool getString(UStream* s, const char*& ptr, const char* end, const char*& str, uint32_t& len);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UBinaryAccessLogReader)
+};
+
+#endif
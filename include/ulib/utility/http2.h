@@ -26,6 +26,7 @@
 #define HTTP2_DEFAULT_WINDOW_SIZE         65535 
 #define HTTP2_HEADER_TABLE_OFFSET            62
 #define HTTP2_MAX_CONCURRENT_STREAMS        128
+#define HTTP2_WRITE_BATCH                    64 // max number of frames for writev() of the write scheduler
 #define HTTP2_HEADER_TABLE_ENTRY_SIZE_OFFSET 32
 
 #define HTTP2_CONNECTION_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" // (24 bytes)
@@ -85,8 +86,14 @@ public:
    };
 
    struct Stream {
-      UString headers, body;
-      uint32_t id, state, clength;
+      UString headers, body;   // request
+      UString oheaders, obody; // response (waiting for the write scheduler)
+      uint32_t id, state, clength,
+               ooffset;        // bytes of obody already written
+      int32_t out_window;      // send flow control window of the stream
+      uint8_t urgency,         // RFC 9218: 0 (highest) - 7 (lowest), default 3
+              incremental,     // RFC 9218: the response can be interleaved with the others of the same urgency
+              bheaders;        // the header block is written
    };
 
    class Connection {
@@ -168,7 +175,8 @@ protected:
       PING          = 0x06,
       GOAWAY        = 0x07,
       WINDOW_UPDATE = 0x08,
-      CONTINUATION  = 0x09
+      CONTINUATION  = 0x09,
+      PRIORITY_UPDATE = 0x10 // RFC 9218
    };
 
    enum FrameFlagsId {
@@ -255,10 +263,17 @@ protected:
    static uint32_t wait_for_continuation;
    static bool bcontinue100, bsetting_ack, bsetting_send;
 
-   static uint8_t  priority_weight;     // 0 if not set
+   static uint32_t priority_weight;     // 0 if not set
    static bool     priority_exclusive;
    static uint32_t priority_dependency; // 0 if not set
 
+   // write scheduler: the header blocks are written in order of encoding (hpack), the DATA frames in order of urgency with the flow control
+
+   static Stream* vwrite[HTTP2_MAX_CONCURRENT_STREAMS];
+   static uint32_t nwrite, iov_batch_cnt, iov_batch_count;
+   static struct iovec iov_batch[HTTP2_WRITE_BATCH*2];
+   static char iov_batch_header[HTTP2_WRITE_BATCH][HTTP2_FRAME_HEADER_SIZE];
+
    static const HuffSym    huff_sym_table[];
    static const HuffDecode huff_decode_table[][16];
 
@@ -289,11 +304,21 @@ protected:
    static void sendWindowUpdate();
    static void sendGoAway(USocket* psocket);
 
+   static void writeStreams(bool bwait);
+   static void readPriorityUpdate();
    static void updateSetting(unsigned char* ptr, uint32_t len);
-   static void writeData(struct iovec* iov, bool bdata, bool flag);
+   static void setPriority(Stream* stream, const char* ptr, uint32_t len);
+
+   static bool flushFrames();
+   static bool addFrame(char type, char flags, const char* ptr, uint32_t len);
+
+   static Stream* getStream(uint32_t id) __pure;
    static void handlerDelete(UClientImage_Base* pclient, bool& bsocket_open);
 
-   static unsigned char* setHpackHeaders(unsigned char* dst, const UString& headers);
+   // HPACK encoding of the response headers: with dyntbl null (file cache) the headers are written as literal with incremental indexing
+   // without Huffman, the block is completed at the time of the response with the output dynamic table of the connection
+
+   static unsigned char* setHpackHeaders(unsigned char* dst, const UString& headers, HpackDynamicTable* dyntbl = U_NULLPTR);
 
    static void startRequest()
       {
@@ -324,20 +349,26 @@ protected:
       for (pStream = pConnection->streams; pStream <= pStreamEnd; ++pStream)
          {
          pStream->body.clear();
+         pStream->obody.clear();
          pStream->headers.clear();
+         pStream->oheaders.clear();
 
          pStream->id      =
          pStream->state   =
          pStream->clength = 0;
          }
 
+      nwrite = 0;
+
 #  ifdef DEBUG
       for (pStreamEnd = (pConnection->streams+HTTP2_MAX_CONCURRENT_STREAMS); pStream < pStreamEnd; ++pStream)
          {
       // U_INTERNAL_DUMP("pStream index = %u", pStream - pConnection->streams)
 
          U_ASSERT(pStream->body.empty())
+         U_ASSERT(pStream->obody.empty())
          U_ASSERT(pStream->headers.empty())
+         U_ASSERT(pStream->oheaders.empty())
 
          U_INTERNAL_ASSERT_EQUALS(pStream->clength, 0)
          }
@@ -361,6 +392,36 @@ protected:
       if (priority_dependency == frame.stream_id) nerror = PROTOCOL_ERROR;
       }
 
+   static void setUrgency(Stream* stream)
+      {
+      U_TRACE(0, "UHTTP2::setUrgency(%p)", stream)
+
+      // RFC 7540 weight => RFC 9218 urgency (the tree of the dependencies is not kept, it is deprecated by RFC 9113)
+
+      U_INTERNAL_ASSERT_RANGE(1, priority_weight, 256)
+
+      stream->urgency = (priority_weight > 128 ? ((256 - priority_weight) * 3) / 128 :     // 256-129 => 0-2 (ex: chrome 256 css, 220 script, 183 image)
+                         priority_weight >= 16 ? 3                                   :     //  128-16 => 3 (default weight 16)
+                                                 4 + (15 - priority_weight) / 4);          //    15-1 => 4-7
+
+      U_INTERNAL_DUMP("stream->urgency = %u", stream->urgency)
+      }
+
+   static bool isAcceptEncoding(const UString& x, const char* token, uint32_t len) // NB: like UHTTP::setAcceptEncoding() we honour ";q=0" after the token...
+      {
+      U_TRACE(0, "UHTTP2::isAcceptEncoding(%V,%.*S,%u)", x.rep, len, token, len)
+
+      const char* ptr = (const char*) u_find(U_STRING_TO_PARAM(x), token, len);
+
+      if (ptr &&
+          UHTTP::isQualityZero(ptr+len, x.pend()) == false)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
    static void setEncoding(const UString& x)
       {
       U_TRACE(0, "UHTTP2::setEncoding(%V)", x.rep)
@@ -369,11 +430,21 @@ protected:
 
       U_INTERNAL_DUMP("Accept-Encoding: = %V", x.rep)
 
-      U_INTERNAL_ASSERT(u_find(x.data(), 30, U_CONSTANT_TO_PARAM("gzip")))
+#  ifdef USE_LIBBROTLI
+      if (isAcceptEncoding(x, U_CONSTANT_TO_PARAM("br")))
+         {
+         U_http_encoding |= HTTP_IS_ACCEPT_BR;
+
+         U_INTERNAL_DUMP("U_http_is_accept_br = %b", U_http_is_accept_br)
+         }
+#  endif
 
-      U_http_flag |= HTTP_IS_ACCEPT_GZIP;
+      if (isAcceptEncoding(x, U_CONSTANT_TO_PARAM("gzip")))
+         {
+         U_http_flag |= HTTP_IS_ACCEPT_GZIP;
 
-      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b", U_http_is_accept_gzip)
+         U_INTERNAL_DUMP("U_http_is_accept_gzip = %b", U_http_is_accept_gzip)
+         }
       }
 
    static void setURI(const char* ptr, uint32_t len)
@@ -400,17 +471,17 @@ protected:
 
    static void updateSetting(const UString& data) { updateSetting((unsigned char*)U_STRING_TO_PARAM(data)); }
 
-   static bool writev(struct iovec* iov, int iovcnt, uint32_t count)
+   static bool writev(struct iovec* iov, int iovcnt, uint32_t count, int timeoutMS = 0)
       {
-      U_TRACE(0, "UHTTP2::writev(%p,%d,%u)", iov, iovcnt, count)
+      U_TRACE(0, "UHTTP2::writev(%p,%d,%u,%d)", iov, iovcnt, count, timeoutMS)
 
       U_DUMP_IOVEC(iov,iovcnt)
 
       int iBytesWrite =
 #  if defined(USE_LIBSSL) || defined(_MSWINDOWS_)
-      USocketExt::writev( UServer_Base::csocket, iov, iovcnt, count, 0);
+      USocketExt::writev( UServer_Base::csocket, iov, iovcnt, count, timeoutMS);
 #  else
-      USocketExt::_writev(UServer_Base::csocket, iov, iovcnt, count, 0);
+      USocketExt::_writev(UServer_Base::csocket, iov, iovcnt, count, timeoutMS);
 #  endif
 
       if (iBytesWrite == (int)count) U_RETURN(true);
@@ -747,7 +818,40 @@ protected:
    static bool isHeaderValue(const UString& s) { return isHeaderValue(U_STRING_TO_PARAM(s)); } 
 
    static    const char* getFrameErrorCodeDescription(uint32_t error);
-   static unsigned char* hpackEncodeHeader(unsigned char* dst, const UString& key, const UString& value);
+   static unsigned char* hpackEncodeHeader(unsigned char* dst, const UString& key, const UString& value, HpackDynamicTable* dyntbl = U_NULLPTR);
+
+   // the response headers that repeat on the connection are indexed in the output dynamic table (index: name on the static table, 0 => not found)
+
+   static bool isHpackIndexable(uint32_t index)
+      {
+      U_TRACE(0, "UHTTP2::isHpackIndexable(%u)", index)
+
+      switch (index)
+         {
+         case  0: // not on the static table (ex: x-frame-options)
+         case 18: // accept-ranges
+         case 20: // access-control-allow-origin
+         case 24: // cache-control
+         case 26: // content-encoding
+         case 27: // content-language
+         case 31: // content-type
+         case 56: // strict-transport-security
+         case 59: // vary
+         case 60: // via
+            U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   static int32_t findHpackDynTblEntry(HpackDynamicTable* dyntbl, const UString& name, const char* value, uint32_t len) __pure;
+
+   static unsigned char* hpackEncodeIndexable(      unsigned char* dst, HpackDynamicTable* dyntbl, uint32_t index, const UString& name, const UString& value);
+   static unsigned char* hpackEncodeLiteralIndexing(unsigned char* dst, HpackDynamicTable* dyntbl, uint32_t index, const UString& name, const UString& value);
+   static unsigned char* hpackEncodeCacheHeaders(   unsigned char* dst, HpackDynamicTable* dyntbl, const UString& hpack);
+
+   static unsigned char* hpackEncodeStringShortest(unsigned char* dst, const char* src, uint32_t len); // Huffman only if shorter
+   static unsigned char* hpackEncodeStringShortest(unsigned char* dst, const UString& value) { return hpackEncodeStringShortest(dst, U_STRING_TO_PARAM(value)); }
 
    static void decodeHeaders(UHashMap<UString>* itable, HpackDynamicTable* dyntbl, unsigned char* ptr, unsigned char* endptr);
 
@@ -864,5 +968,9 @@ private:
    friend class UHTTP;
    friend class Application;
    friend class UClientImage_Base;
+
+#ifdef U_STDCPP_ENABLE
+   friend istream& operator>>(istream& is, UHTTP::UFileCacheData& d); // NB: the HPACK headers are rebuilt when a snapshot of the file cache is loaded...
+#endif
 };
 #endif
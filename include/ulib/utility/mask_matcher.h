@@ -0,0 +1,95 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    mask_matcher.h - compiled DOS regexp (multiple patterns separated by '|')
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_MASK_MATCHER_H
+#define ULIB_MASK_MATCHER_H 1
+
+#include <ulib/container/vector.h>
+
+/**
+ * UMaskMatcher compiles once a mask as accepted by UServices::dosMatchWithOR() ('?' matches any single character, '*' any string,
+ * alternatives separated by '|') in a DFA on the union of the patterns, so that the check of a string is a single pass of table
+ * lookup over its bytes, whatever the number of patterns. The literal parts of the patterns become chains of states of the DFA
+ * (so the common prefixes are shared like in a trie), the bytes that don't appear in any pattern share a single column of the table.
+ *
+ * match() returns the set of the patterns that match (bit n for the n-th alternative of the mask). The scan stops as soon as the
+ * DFA reaches a state from which the result can't change (no pattern can match, or "prefix*" already matched). If the mask has
+ * more than 64 patterns or the DFA would be too large we keep the patterns and match them one at a time with u_dosmatch()...
+ * NB: an empty string match only the patterns made only of '*' (u_dosmatch() don't accept it, so we check this case by ourselves)
+ */
+
+#define U_MASK_MATCHER_MAX_PATTERN 64
+#define U_MASK_MATCHER_MAX_STATE 4096
+
+class U_EXPORT UMaskMatcher {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UMaskMatcher(const UString& mask, int flags = 0); // flags: FNM_IGNORECASE
+
+   ~UMaskMatcher();
+
+   // SERVICES
+
+   uint32_t getNumPattern() const { return vpattern.size(); }
+   uint32_t getNumState() const   { return nstate; }
+
+   bool isCompiled() const
+      {
+      U_TRACE_NO_PARAM(0, "UMaskMatcher::isCompiled()")
+
+      if (table) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   uint64_t match(const char* s, uint32_t len) const;
+
+   bool isMatch(const char* s, uint32_t len) const
+      {
+      U_TRACE(0, "UMaskMatcher::isMatch(%.*S,%u)", len, s, len)
+
+      if (match(s, len)) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   bool isMatch(const UString& s) const { return isMatch(U_STRING_TO_PARAM(s)); }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UVector<UString> vpattern;
+   uint64_t* accept;       // for every state, the set of the patterns that match
+   uint16_t* table;        // transition table [nstate][nclass]
+   uint8_t* bfinal;        // for every state, true if the result can't change anymore
+   uint32_t nstate, nclass;
+   int flags;
+   uint8_t cls[256];       // byte -> column of the table
+
+   bool compile();
+   bool matchPattern(const char* s, uint32_t len, const UString& pattern) const __pure;
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UMaskMatcher)
+};
+
+#endif
@@ -75,6 +75,14 @@ public:
    static UString deflate(const UString& s, int type)             { return deflate(U_STRING_TO_PARAM(s), type); }
    static UString  gunzip(const UString& s, uint32_t sz_orig = 0) { return  gunzip(U_STRING_TO_PARAM(s), sz_orig); }
 
+   // BROTLI method (the format has no magic number...)
+
+   static UString   brotli(const char* s, uint32_t n, int quality = 11); // .br compress (quality: 0-11)
+   static UString unbrotli(const char* s, uint32_t n);                   // .br uncompress
+
+   static UString   brotli(const UString& s, int quality = 11) { return   brotli(U_STRING_TO_PARAM(s), quality); }
+   static UString unbrotli(const UString& s)                   { return unbrotli(U_STRING_TO_PARAM(s)); }
+
    // Convert numeric to string
 
    static UString printSize(off_t n)
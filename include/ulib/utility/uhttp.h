@@ -44,6 +44,8 @@ class UPageSpeed;
 class USSIPlugIn;
 class UHttpPlugIn;
 class USSLSession;
+class UMaskMatcher;
+class UBinaryAccessLog;
 class UMimeMultipart;
 class UModProxyService;
 class UClientImage_Base;
@@ -336,7 +338,13 @@ public:
       {
       if (sz >= UServer_Base::min_size_for_sendfile)
          {
-         U_INTERNAL_ASSERT_EQUALS(UServer_Base::bssl, false) // NB: we can't use sendfile with SSL...
+#     ifdef USE_LIBSSL
+         if (UServer_Base::bssl &&
+             UServer_Base::pClientImage->socket->isKTLS() == false) // NB: we can't use sendfile with SSL without kTLS...
+            {
+            U_RETURN(false);
+            }
+#     endif
 
          U_RETURN(true);
          }
@@ -547,6 +555,8 @@ public:
    static UString* uri_protected_mask;
    static UVector<UIPAllow*>* vallow_IP;
    static UString* uri_request_cert_mask;
+   static UMaskMatcher* uri_protected_matcher;
+   static UMaskMatcher* uri_request_cert_matcher;
 
    static bool checkUriProtected();
    static bool isUriRequestProtected() __pure;
@@ -673,14 +683,6 @@ public:
    static UString getSessionCreationTime()     { return data_session->getSessionCreationTime(); }
    static UString getSessionLastAccessedTime() { return data_session->getSessionLastAccessedTime(); }
 
-#ifdef USE_LIBSSL
-   static USSLSession* data_session_ssl;
-   static URDBObjectHandler<UDataStorage*>* db_session_ssl;
-
-   static void  initSessionSSL();
-   static void clearSessionSSL();
-#endif
-
    static UString getKeyIdDataSession()
       {
       U_TRACE_NO_PARAM(0, "UHTTP::getKeyIdDataSession()")
@@ -802,12 +804,15 @@ public:
 #ifndef U_LOG_DISABLE
    static char iov_buffer[20];
    static struct iovec iov_vec[10];
+   static UBinaryAccessLog* apache_like_log_binary; // APACHE_LIKE_LOG_BINARY: the records are written in binary form (see userver_logdec)
+   static uint32_t log_response_code, log_body_len;
 # if !defined(U_CACHE_REQUEST_DISABLE) || defined(U_SERVER_CHECK_TIME_BETWEEN_REQUEST)
    static uint32_t request_offset, referer_offset, agent_offset;
 # endif
 
    static void    initApacheLikeLog();
    static void prepareApacheLikeLog();
+   static void writeApacheLikeLogBinary();
    static void   resetApacheLikeLog()
       {
       U_TRACE_NO_PARAM(0, "UHTTP::resetApacheLikeLog()")
@@ -1125,9 +1130,9 @@ public:
    U_MEMORY_DEALLOCATOR
 
    void* ptr;               // data
-   UVector<UString>* array; // content, header, gzip(content, header)
+   UVector<UString>* array; // content, header, gzip(content, header), brotli(content, header)
 #ifndef U_HTTP2_DISABLE
-   UVector<UString>* http2; //          header, gzip(header)
+   UVector<UString>* http2; //          header, gzip(header), brotli(header)
 #endif
    time_t mtime;            // time of last modification
    time_t expire;           // expire time of the entry
@@ -1163,6 +1168,8 @@ public:
    static UString* cache_avoid_mask;
    static UString* cache_file_store;
    static UString* nocache_file_mask;
+   static UMaskMatcher* cache_file_matcher;
+   static UMaskMatcher* nocache_file_matcher;
    static UFileCacheData* file_data;
    static UFileCacheData* file_gzip_bomb;
    static UHashMap<UFileCacheData*>* cache_file;
@@ -1193,6 +1200,18 @@ public:
       U_RETURN(false);
       }
 
+   static bool isDataBrotliFromCache()
+      {
+      U_TRACE_NO_PARAM(0, "UHTTP::isDataBrotliFromCache()")
+
+      U_INTERNAL_ASSERT_POINTER(file_data)
+      U_INTERNAL_ASSERT_POINTER(file_data->array)
+
+      if (file_data->array->size() > 4) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
    static void checkFileForCache();
    static void renewFileDataInCache();
 
@@ -1243,10 +1262,12 @@ public:
 
    static UString getBodyFromCache()         { return getDataFromCache(0); }
    static UString getBodyCompressFromCache() { return getDataFromCache(2); }
+   static UString getBodyBrotliFromCache()   { return getDataFromCache(4); }
 
 #ifdef U_HTTP2_DISABLE
    static UString getHeaderFromCache()         { return getDataFromCache(1); };
    static UString getHeaderCompressFromCache() { return getDataFromCache(3); };
+   static UString getHeaderBrotliFromCache()   { return getDataFromCache(5); };
 #else
    static UString getHeaderFromCache()
       {
@@ -1273,6 +1294,20 @@ public:
            if (U_http_version != '2') result = getDataFromCache(3);
       else if (file_data->http2)      result = file_data->http2->operator[](1);
 
+      U_RETURN_STRING(result);
+      }
+
+   static UString getHeaderBrotliFromCache()
+      {
+      U_TRACE_NO_PARAM(0, "UHTTP::getHeaderBrotliFromCache()")
+
+      UString result;
+
+      U_INTERNAL_DUMP("U_http_version = %C", U_http_version)
+
+           if (U_http_version != '2') result = getDataFromCache(5);
+      else if (file_data->http2)      result = file_data->http2->operator[](2);
+
       U_RETURN_STRING(result);
       }
 #endif
@@ -1398,6 +1433,7 @@ private:
    static bool readBodyRequest() U_NO_EXPORT;
    static bool processFileCache() U_NO_EXPORT;
    static bool readHeaderRequest() U_NO_EXPORT;
+   static const char* skipURI(const char* ptr, const char* endptr) U_NO_EXPORT __pure;
    static bool processGetRequest() U_NO_EXPORT;
    static bool processAuthorization() U_NO_EXPORT;
    static bool checkRequestForHeader() U_NO_EXPORT;
@@ -1436,6 +1472,28 @@ private:
    static inline void setXForwardedFor(const char* ptr, uint32_t len) U_NO_EXPORT;
    static inline void setXHttpForwardedFor(const char* ptr, uint32_t len) U_NO_EXPORT;
 
+   static bool isQualityZero(const char* ptr, const char* end) // NB: ";q=0" (or ";q=0.000") after the token of Accept-Encoding...
+      {
+      U_TRACE(0, "UHTTP::isQualityZero(%.*S,%p)", (int)(end-ptr), ptr, end)
+
+      if ((end - ptr) < 4 ||
+          u_get_unalignedp32(ptr) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+         {
+         U_RETURN(false);
+         }
+
+      for (ptr += 4; ptr < end && *ptr != ','; ++ptr)
+         {
+         if (u__isdigit(*ptr) &&
+                        *ptr != '0')
+            {
+            U_RETURN(false);
+            }
+         }
+
+      U_RETURN(true);
+      }
+
    U_DISALLOW_COPY_AND_ASSIGN(UHTTP)
 
    friend class UHTTP2;
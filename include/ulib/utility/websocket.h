@@ -15,6 +15,7 @@
 #define ULIB_WEBSOCKET_H 1
 
 #include <ulib/string.h>
+#include <ulib/utility/lock.h>
 
 #define MESSAGE_TYPE_INVALID  -1
 #define MESSAGE_TYPE_TEXT      0
@@ -37,6 +38,23 @@
 #define STATUS_CODE_INTERNAL_ERROR    1011
 #define STATUS_CODE_RESERVED4         1015
 
+/**
+ * permessage-deflate (RFC 7692): the extension is negotiated by sendAccept() if the client offers it. The messages (not the control frames)
+ * are compressed with a raw deflate stream flushed with Z_SYNC_FLUSH, without the tail 0x00 0x00 0xff 0xff, and marked with the bit RSV1.
+ * With context takeover the LZ77 window is preserved between the messages of the same direction, otherwise the stream is reset after each one
+ *
+ * broadcast: the message is framed (and compressed) only once and written on a ring in the memory shared by the processes of the server,
+ * every subscribed connection (the process that serve it) copy the frames from the ring (checking after the copy that the publisher has not
+ * overwritten them) and write the copy to its socket. The publisher never wait for the subscribers: a subscriber that fall behind of more
+ * than the size of the ring (or that don't drain its socket in timeoutMS) is a slow consumer and it is disconnected (STATUS_CODE_POLICY_VIOLATION).
+ * NB: the frames on the ring are compressed without context takeover, so with broadcast the server always negotiate server_no_context_takeover...
+ */
+
+#define U_WEBSOCKET_DEFLATE_MIN_SIZE     64                  // the messages shorter are not compressed
+#define U_WEBSOCKET_BROADCAST_SIZE       (4U * 1024U * 1024U) // size of the ring of the broadcast messages
+#define U_WEBSOCKET_BROADCAST_POLL_MS    10                  // max latency of a broadcast message for a subscriber that is waiting for data
+#define U_WEBSOCKET_BROADCAST_MAX_BATCH  (64U * 1024U)       // max bytes of the frames copied from the ring for a single write
+
 class USocket;
 
 class U_EXPORT UWebSocket {
@@ -49,6 +67,24 @@ public:
    static const char* upgrade_settings;
    static int message_type, status_code;
 
+   // permessage-deflate
+
+   static bool enable_deflate, bdeflate, server_no_context_takeover, client_no_context_takeover;
+   static int  server_max_window_bits;
+
+   // broadcast
+
+   typedef struct ws_broadcast {
+      sem_t lock_writer;
+      uint64_t wpos,  // number of bytes written on the ring from the start (NB: the frames before are complete)
+               wnext; // number of bytes written on the ring from the start when the writer will have finished
+      sig_atomic_t nsubscriber;
+      char data[U_WEBSOCKET_BROADCAST_SIZE];
+   } ws_broadcast;
+
+   static uint64_t broadcast_rpos; // position on the ring of the next frame to write for this subscriber
+   static ws_broadcast* broadcast_data;
+
    typedef struct _WebSocketFrameData {
       unsigned char* application_data;
       uint32_t       application_data_offset;
@@ -65,6 +101,25 @@ public:
    static int  handleDataFraming(USocket* socket);
    static bool sendData(int type, const unsigned char* buffer, uint32_t buffer_size);
 
+   static void initBroadcast(); // NB: the ring must be allocated before with UServer_Base::getOffsetToDataShare()...
+   static void subscribe();
+   static void unsubscribe();
+   static bool broadcast(int type, const unsigned char* buffer, uint32_t buffer_size);
+   static bool writeBroadcast(); // write the pending frames of the ring, return false if this subscriber is a slow consumer
+
+   static bool isBroadcastPending()
+      {
+      U_TRACE_NO_PARAM(0, "UWebSocket::isBroadcastPending()")
+
+      U_INTERNAL_ASSERT_POINTER(broadcast_data)
+
+      U_INTERNAL_DUMP("broadcast_rpos = %llu wpos = %llu", broadcast_rpos, broadcast_data->wpos)
+
+      if (broadcast_data->wpos != broadcast_rpos) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
    static bool sendClose()
       {
       U_TRACE_NO_PARAM(0, "UWebSocket::sendClose()")
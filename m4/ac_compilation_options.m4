@@ -119,6 +119,20 @@ AC_DEFUN([AC_COMPILATION_OPTIONS],[
 	fi
 	AC_MSG_RESULT([$enable_captive_portal])
 
+	AC_MSG_CHECKING(if you want to enable io_uring as event notification backend)
+	AC_ARG_ENABLE(io-uring,
+				[  --enable-io-uring         enable io_uring (Linux >= 5.19) as event notification backend [[default=no]]])
+	if test -z "$enable_io_uring"; then
+		enable_io_uring="no"
+	fi
+	if test "$enable_io_uring" = "yes"; then
+		AC_CHECK_HEADERS([linux/io_uring.h], [], [enable_io_uring="no"])
+	fi
+	if test "$enable_io_uring" = "yes"; then
+		AC_DEFINE(USE_IO_URING, 1, [Define if enable io_uring support])
+	fi
+	AC_MSG_RESULT([$enable_io_uring])
+
 	AC_MSG_CHECKING(if you want to enable server thread approach support)
 	AC_ARG_ENABLE(thread-approach,
 				[  --enable-thread-approach  enable server thread approach support [[default=no]]])
@@ -188,3 +188,136 @@ public:
 };
 
 REGISTER_TEST(ULibTest);
+
+// the same with the two stage parser on a flat tape (@see ulib/json/tape.h)
+
+static void GenStat(Stat& stat, const UJsonTape& tape, uint32_t pos)
+{
+	U_TRACE(5, "::GenStat(%p,%p,%u)", &stat, &tape, pos)
+
+	switch (tape.getTag(pos))
+		{
+		case U_REAL_VALUE:
+		case U_INT_VALUE:
+		case U_UINT_VALUE:  stat.numberCount++; break;
+		case U_TRUE_VALUE:  stat.trueCount++;   break;
+		case U_FALSE_VALUE: stat.falseCount++;  break;
+		case U_NULL_VALUE:  stat.nullCount++;   break;
+
+		case U_STRING_VALUE:
+			{
+			stat.stringCount++;
+
+			stat.stringLength += tape.getString(pos).size();
+			}
+		break;
+
+		case U_ARRAY_VALUE:
+			{
+			stat.arrayCount++;
+
+			for (uint32_t i = tape.first(pos); i != U_NOT_FOUND; i = tape.next(i))
+				{
+				stat.elementCount++;
+
+				GenStat(stat, tape, i);
+				}
+			}
+		break;
+
+		case U_OBJECT_VALUE:
+			{
+			stat.objectCount++;
+
+			for (uint32_t i = tape.first(pos); i != U_NOT_FOUND; i = tape.next(tape.value(i)))
+				{
+				stat.memberCount++;
+				stat.stringCount++; // Key
+				stat.stringLength += tape.getString(i).size();
+
+				GenStat(stat, tape, tape.value(i));
+				}
+			}
+		break;
+		}
+}
+
+class ULibTapeParseResult : public ParseResultBase {
+public:
+	UJsonTape tape;
+};
+
+class ULibTapeTest : public TestBase {
+public:
+#if TEST_INFO
+	virtual const char* GetName() const { return "ULib tape (C++)"; }
+	virtual const char* GetFilename() const { return __FILE__; }
+#endif
+
+#if TEST_PARSE
+	virtual ParseResultBase* Parse(const char* json, size_t length) const
+		{
+		ULibTapeParseResult* pr = new ULibTapeParseResult;
+
+		return (pr->tape.parse(UString(json, length)) ? pr : (delete pr, (ULibTapeParseResult*)0));
+		}
+#endif
+
+#if TEST_STRINGIFY
+	virtual StringResultBase* Stringify(const ParseResultBase* parseResult) const
+		{
+		ULibStringResult* sr = new ULibStringResult;
+
+		((const ULibTapeParseResult*)parseResult)->tape.stringify(sr->s);
+
+		return sr;
+		}
+#endif
+
+#if TEST_STATISTICS
+	virtual bool Statistics(const ParseResultBase* parseResult, Stat* stat) const
+		{
+		(void) memset(stat, 0, sizeof(Stat));
+
+		const ULibTapeParseResult* pr = static_cast<const ULibTapeParseResult*>(parseResult);
+
+		GenStat(*stat, pr->tape, 0);
+
+		return true;
+		}
+#endif
+
+#if TEST_CONFORMANCE
+	virtual bool ParseDouble(const char* json, double* d) const
+		{
+		UJsonTape tape;
+
+		if (tape.parse(UString(json)))
+			{
+			*d = tape.getDouble(tape.at(0, 0U));
+
+			return true;
+			}
+
+		return false;
+		}
+
+	virtual bool ParseString(const char* json, std::string& s) const
+		{
+		UJsonTape tape;
+
+		if (tape.parse(UString(json)))
+			{
+			UString result = tape.getString(tape.at(0, 0U));
+
+			(void) s.assign(U_STRING_TO_PARAM(result));
+
+			return true;
+			}
+
+		return false;
+		}
+#endif
+};
+
+REGISTER_TEST(ULibTapeTest);
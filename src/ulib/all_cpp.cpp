@@ -29,6 +29,7 @@
 #include "mime/multipart.cpp"
 #include "container/vector.cpp"
 #include "container/hash_map.cpp"
+#include "container/flat_hash_map.cpp"
 #include "container/tree.cpp"
 #include "event/event_time.cpp"
 #include "net/socket.cpp"
@@ -40,12 +41,15 @@
 #include "net/server/plugin/mod_proxy_service.cpp"
 #include "orm/orm_driver.cpp"
 #include "json/value.cpp"
+#include "json/tape.cpp"
 #include "utility/lock.cpp"
 #include "utility/uhttp.cpp"
 #include "utility/base64.cpp"
 #include "utility/dir_walk.cpp"
 #include "utility/interrupt.cpp"
 #include "utility/services.cpp"
+#include "utility/mask_matcher.cpp"
+#include "utility/binary_access_log.cpp"
 #include "utility/semaphore.cpp"
 #include "utility/websocket.cpp"
 #include "utility/string_ext.cpp"
@@ -73,6 +77,7 @@
 
 #ifdef HAVE_CONFIG_H
 #  include "cache.cpp"
+#  include "shared_cache.cpp"
 #  include "options.cpp"
 #  include "application.cpp"
 #  include "ui/dialog.cpp"
@@ -83,6 +88,7 @@
 #  include "net/client/smtp.cpp"
 #  include "net/client/ftp.cpp"
 #  include "net/client/redis.cpp"
+#  include "net/client/pool.cpp"
 #  include "net/client/elasticsearch.cpp"
 #  include "net/rpc/rpc.cpp"
 #  include "net/rpc/rpc_client.cpp"
@@ -1990,9 +1990,15 @@ __pure bool u_match_with_OR(bPFpcupcud pfn_match, const char* restrict s, uint32
       {
       p_or = (const char* restrict) memchr(pattern, '|', n2);
 
-      if (p_or == 0) return pfn_match(s, n1, pattern, n2, flags);
+      /* NB: an empty alternative match nothing (the match functions assert that the pattern is not empty)... */
 
-      if (pfn_match(s, n1, pattern, (p_or - pattern), (flags & ~FNM_INVERT))) return ((flags & FNM_INVERT) == 0);
+      if (p_or == 0) return (n2 ? pfn_match(s, n1, pattern, n2, flags) : ((flags & FNM_INVERT) != 0));
+
+      if (p_or != pattern &&
+          pfn_match(s, n1, pattern, (p_or - pattern), (flags & ~FNM_INVERT)))
+         {
+         return ((flags & FNM_INVERT) == 0);
+         }
 
       pattern = p_or + 1;
          n2   = end - pattern;
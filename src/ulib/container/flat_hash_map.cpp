@@ -0,0 +1,544 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    flat_hash_map.cpp - open addressing variant of UHashMap
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/container/flat_hash_map.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+// Compare the U_FLAT_HASH_MAP_GROUP control bytes starting at ptr, in the masks there is 1 bit for byte
+
+static inline uint32_t u_flat_match(const int8_t* ptr, int8_t h)
+{
+#ifdef __SSE2__
+   return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)ptr), _mm_set1_epi8(h)));
+#else
+   uint32_t bmatch = 0;
+
+   for (uint32_t i = 0; i < U_FLAT_HASH_MAP_GROUP; ++i)
+      {
+      if (ptr[i] == h) bmatch |= 1U << i;
+      }
+
+   return bmatch;
+#endif
+}
+
+static inline uint32_t u_flat_match_free(const int8_t* ptr) // EMPTY or DELETED (the only control bytes with the sign bit)
+{
+#ifdef __SSE2__
+   return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ptr));
+#else
+   uint32_t bfree = 0;
+
+   for (uint32_t i = 0; i < U_FLAT_HASH_MAP_GROUP; ++i)
+      {
+      if (ptr[i] < 0) bfree |= 1U << i;
+      }
+
+   return bfree;
+#endif
+}
+
+// NB: the low bits of the hash give the start of the probe sequence, the high 7 bits the fingerprint...
+
+#define U_FLAT_H2(hash) ((int8_t)((hash) >> 25))
+
+UFlatHashMap<void*>::UFlatHashMap(uint32_t n, bool ignore_case)
+{
+   U_TRACE_REGISTER_OBJECT(0, UFlatHashMap<void*>, "%u,%b", n, ignore_case)
+
+   slot         = U_NULLPTR;
+   bignore_case = ignore_case;
+
+   _length  =
+   ndeleted =
+   hash     =
+   index    = 0;
+
+   _allocate(n <= U_FLAT_HASH_MAP_GROUP ? U_FLAT_HASH_MAP_GROUP : (uint32_t)u_nextPowerOfTwo(n));
+}
+
+void UFlatHashMap<void*>::_allocate(uint32_t n)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::_allocate(%u)", n)
+
+   U_CHECK_MEMORY
+
+   // Must be a power of 2, It's done this way because bitwise-and is an inexpensive operation, whereas integer modulo (%) is quite heavy
+
+   U_INTERNAL_ASSERT_EQUALS(n & (n-1), 0)
+   U_INTERNAL_ASSERT(n >= U_FLAT_HASH_MAP_GROUP)
+
+   slots = (uflathashmapslot*) UMemoryPool::_malloc(n, sizeof(uflathashmapslot));
+   ctrl  = (int8_t*)           UMemoryPool::_malloc(n + U_FLAT_HASH_MAP_GROUP);
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", ctrl, U_FLAT_HASH_MAP_EMPTY, n + U_FLAT_HASH_MAP_GROUP);
+
+   _capacity = n;
+}
+
+void UFlatHashMap<void*>::_deallocate()
+{
+   U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::_deallocate()")
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_MAJOR(_capacity, 1)
+
+   UMemoryPool::_free(slots, _capacity, sizeof(uflathashmapslot));
+   UMemoryPool::_free(ctrl,  _capacity + U_FLAT_HASH_MAP_GROUP);
+}
+
+void UFlatHashMap<void*>::lookup(const char* _key, uint32_t keylen)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::lookup(%.*S,%u)", keylen, _key, keylen)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_MAJOR(keylen, 0)
+   U_INTERNAL_ASSERT_MAJOR(_capacity, 0)
+
+   hash = (bignore_case ? u_hash_ignore_case((unsigned char*)_key, keylen)
+                        : u_hash(            (unsigned char*)_key, keylen));
+
+   int8_t h2 = U_FLAT_H2(hash);
+   uflathashmapslot* pslot;
+   uint32_t i, bmatch, bfree, mask = _capacity-1, pos = hash & mask, step = 0;
+
+   index = U_NOT_FOUND;
+
+   // Probe the table by groups (triangular sequence), we read only the slots whose fingerprint match.
+   // NB: for an insert after the lookup we remember the first free slot (EMPTY or DELETED) of the probe sequence...
+
+   while (true)
+      {
+      bmatch = u_flat_match(ctrl + pos, h2);
+
+      while (bmatch)
+         {
+         i     = (pos + __builtin_ctz(bmatch)) & mask;
+         pslot = slots + i;
+
+         if (pslot->hash == hash &&
+             UStringRep::equal_lookup((UStringRep*)pslot->key, _key, keylen, bignore_case))
+            {
+            slot  = pslot;
+            index = i;
+
+            U_INTERNAL_DUMP("index = %u slot = %p", index, slot)
+
+            return;
+            }
+
+         bmatch &= bmatch-1;
+         }
+
+      bfree = u_flat_match_free(ctrl + pos);
+
+      if (bfree)
+         {
+         if (index == U_NOT_FOUND) index = (pos + __builtin_ctz(bfree)) & mask;
+
+         if (u_flat_match(ctrl + pos, U_FLAT_HASH_MAP_EMPTY)) break;
+         }
+
+      step += U_FLAT_HASH_MAP_GROUP;
+      pos   = (pos + step) & mask;
+
+      U_INTERNAL_ASSERT(step <= _capacity)
+      }
+
+   slot = U_NULLPTR;
+
+   U_INTERNAL_DUMP("index = %u slot = %p", index, slot)
+}
+
+__pure uint32_t UFlatHashMap<void*>::findFree(uint32_t _hash) const
+{
+   U_TRACE(0, "UFlatHashMap<void*>::findFree(%u)", _hash)
+
+   uint32_t bfree, mask = _capacity-1, pos = _hash & mask, step = 0;
+
+   while ((bfree = u_flat_match_free(ctrl + pos)) == 0)
+      {
+      step += U_FLAT_HASH_MAP_GROUP;
+      pos   = (pos + step) & mask;
+      }
+
+   pos = (pos + __builtin_ctz(bfree)) & mask;
+
+   U_RETURN(pos);
+}
+
+void UFlatHashMap<void*>::rehash(uint32_t n)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::rehash(%u)", n)
+
+   U_INTERNAL_DUMP("_capacity = %u _length = %u ndeleted = %u", _capacity, _length, ndeleted)
+
+   int8_t*           old_ctrl     = ctrl;
+   uflathashmapslot* old_slots    = slots;
+   uint32_t          old_capacity = _capacity, i, pos;
+
+   _allocate(n);
+
+   // we insert the old elements (we have the hash, so we don't need to compare the keys)
+
+   for (i = 0; i < old_capacity; ++i)
+      {
+      if (old_ctrl[i] >= 0) // full
+         {
+         pos = findFree(old_slots[i].hash);
+
+         slots[pos] = old_slots[i];
+
+         setCtrl(pos, old_ctrl[i]);
+         }
+      }
+
+   UMemoryPool::_free(old_slots, old_capacity, sizeof(uflathashmapslot));
+   UMemoryPool::_free(old_ctrl,  old_capacity + U_FLAT_HASH_MAP_GROUP);
+
+   ndeleted = 0;
+   slot     = U_NULLPTR;
+}
+
+void UFlatHashMap<void*>::reserve(uint32_t n)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::reserve(%u)", n)
+
+   uint32_t new_capacity = capacityFor(n);
+
+   if (new_capacity > _capacity) rehash(new_capacity);
+}
+
+void UFlatHashMap<void*>::insertAfterFind(const UStringRep* _key, const void* _elem)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::insertAfterFind(%V,%p)", _key, _elem)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_EQUALS(slot, U_NULLPTR)
+   U_INTERNAL_ASSERT_DIFFERS(index, U_NOT_FOUND)
+
+   U_INTERNAL_DUMP("index = %u hash = %u", index, hash)
+
+   if (ctrl[index] == U_FLAT_HASH_MAP_DELETED) --ndeleted;
+   else if ((_length + ndeleted) >= growthLimit())
+      {
+      // NB: if the tombstones are many we only purge them, otherwise we double the table...
+
+      rehash(_length >= (growthLimit() / 2) ? _capacity * 2 : _capacity);
+
+      index = findFree(hash);
+      }
+
+   slot = slots + index;
+
+   slot->key  = _key;
+   slot->elem = _elem;
+   slot->hash = hash;
+
+   ((UStringRep*)_key)->hold(); // NB: we increases the reference string...
+
+   setCtrl(index, U_FLAT_H2(hash));
+
+   ++_length;
+
+   U_INTERNAL_DUMP("_length = %u", _length)
+}
+
+void UFlatHashMap<void*>::eraseAfterFind()
+{
+   U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::eraseAfterFind()")
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(slot)
+   U_INTERNAL_ASSERT_EQUALS(slot, slots + index)
+
+   ((UStringRep*)slot->key)->release(); // NB: we decreases the reference string...
+
+   /**
+    * If the run of non empty slots around the slot is shorter than a group, no probe sequence can have crossed
+    * the slot without find an empty slot in the same group, so the slot can become EMPTY instead of DELETED
+    */
+
+   uint32_t mask        = _capacity-1,
+            empty_after = u_flat_match(ctrl +   index,                                   U_FLAT_HASH_MAP_EMPTY),
+           empty_before = u_flat_match(ctrl + ((index - U_FLAT_HASH_MAP_GROUP) & mask), U_FLAT_HASH_MAP_EMPTY);
+
+   if (empty_after  &&
+       empty_before &&
+       (__builtin_ctz(empty_after) + (__builtin_clz(empty_before) - (32 - U_FLAT_HASH_MAP_GROUP))) < U_FLAT_HASH_MAP_GROUP)
+      {
+      setCtrl(index, U_FLAT_HASH_MAP_EMPTY);
+      }
+   else
+      {
+      setCtrl(index, U_FLAT_HASH_MAP_DELETED);
+
+      ++ndeleted;
+      }
+
+   slot = U_NULLPTR;
+
+   --_length;
+
+   U_INTERNAL_DUMP("_length = %u ndeleted = %u", _length, ndeleted)
+}
+
+void* UFlatHashMap<void*>::erase(const UStringRep* _key)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::erase(%V)", _key)
+
+   lookup(_key);
+
+   if (slot)
+      {
+      const void* _elem = slot->elem;
+
+      eraseAfterFind();
+
+      U_RETURN((void*)_elem);
+      }
+
+   U_RETURN((void*)U_NULLPTR);
+}
+
+void* UFlatHashMap<void*>::erase(const char* _key)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::erase(%S)", _key)
+
+   lookup(_key, u__strlen(_key, __PRETTY_FUNCTION__));
+
+   if (slot)
+      {
+      const void* _elem = slot->elem;
+
+      eraseAfterFind();
+
+      U_RETURN((void*)_elem);
+      }
+
+   U_RETURN((void*)U_NULLPTR);
+}
+
+uflathashmapslot* UFlatHashMap<void*>::first()
+{
+   U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::first()")
+
+   U_INTERNAL_DUMP("_length = %u", _length)
+
+   for (index = 0; index < _capacity; ++index)
+      {
+      if (ctrl[index] >= 0) // full
+         {
+         slot = slots + index;
+
+         U_RETURN_POINTER(slot, uflathashmapslot);
+         }
+      }
+
+   slot = U_NULLPTR;
+
+   U_RETURN_POINTER(U_NULLPTR, uflathashmapslot);
+}
+
+bool UFlatHashMap<void*>::next()
+{
+   U_TRACE_NO_PARAM(0, "UFlatHashMap<void*>::next()")
+
+   U_INTERNAL_DUMP("index = %u", index)
+
+   for (++index; index < _capacity; ++index)
+      {
+      if (ctrl[index] >= 0) // full
+         {
+         slot = slots + index;
+
+         U_RETURN(true);
+         }
+      }
+
+   slot = U_NULLPTR;
+
+   U_RETURN(false);
+}
+
+void UFlatHashMap<void*>::callForAllEntry(bPFprpv function)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::callForAllEntry(%p)", function)
+
+   U_INTERNAL_DUMP("_length = %u", _length)
+
+   uint32_t i, bfull;
+
+   // NB: we scan the control bytes by group, the table is traversed by the index (the function can erase the current entry)...
+
+   for (uint32_t pos = 0; pos < _capacity; pos += U_FLAT_HASH_MAP_GROUP)
+      {
+      bfull = ~u_flat_match_free(ctrl + pos) & 0xFFFF;
+
+      while (bfull)
+         {
+         i = pos + __builtin_ctz(bfull);
+
+         if (function((UStringRep*)slots[i].key, (void*)slots[i].elem) == false) return;
+
+         bfull &= bfull-1;
+         }
+      }
+}
+
+void UFlatHashMap<void*>::getKeys(UVector<UString>& vec)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::getKeys(%p)", &vec)
+
+   for (uint32_t i = 0; i < _capacity; ++i)
+      {
+      if (ctrl[i] >= 0) vec.UVector<UStringRep*>::push(slots[i].key);
+      }
+}
+
+void UFlatHashMap<void*>::_callForAllEntrySorted(bPFprpv function)
+{
+   U_TRACE(0, "UFlatHashMap<void*>::_callForAllEntrySorted(%p)", function)
+
+   U_INTERNAL_ASSERT_MAJOR(_length, 1)
+
+   UVector<UString> vkey(_length);
+
+   getKeys(vkey);
+
+   U_ASSERT_EQUALS(_length, vkey.size())
+
+   vkey.sort(ignoreCase());
+
+   U_INTERNAL_ASSERT(check_memory())
+
+   for (uint32_t i = 0, n = _length; i < n; ++i)
+      {
+      UStringRep* r = vkey.UVector<UStringRep*>::at(i);
+
+      lookup(r);
+
+      U_INTERNAL_ASSERT_POINTER(slot)
+
+      if (function(r, (void*)slot->elem) == false) return;
+      }
+}
+
+UString UFlatHashMap<UString>::erase(const UString& _key)
+{
+   U_TRACE(0, "UFlatHashMap<UString>::erase(%V)", _key.rep)
+
+   UFlatHashMap<void*>::lookup(_key.rep);
+
+   if (slot)
+      {
+      UString str(elem());
+
+      eraseAfterFind();
+
+      U_RETURN_STRING(str);
+      }
+
+   return UString::getStringNull();
+}
+
+UString UFlatHashMap<UString>::at(const UStringRep* _key)
+{
+   U_TRACE(0, "UFlatHashMap<UString>::at(%V)", _key)
+
+   UFlatHashMap<void*>::lookup(_key);
+
+   if (slot)
+      {
+      UString str(elem());
+
+      U_RETURN_STRING(str);
+      }
+
+   return UString::getStringNull();
+}
+
+UString UFlatHashMap<UString>::at(const char* _key, uint32_t keylen)
+{
+   U_TRACE(0, "UFlatHashMap<UString>::at(%.*S,%u)", keylen, _key, keylen)
+
+   UFlatHashMap<void*>::lookup(_key, keylen);
+
+   if (slot)
+      {
+      UString str(elem());
+
+      U_RETURN_STRING(str);
+      }
+
+   return UString::getStringNull();
+}
+
+#ifdef DEBUG
+bool UFlatHashMap<void*>::check_memory() const // check all element
+{
+   U_TRACE_NO_PARAM(0+256, "UFlatHashMap<void*>::check_memory()")
+
+   U_CHECK_MEMORY
+
+   uint32_t i, n = 0;
+
+   for (i = 0; i < _capacity; ++i)
+      {
+      if (i < U_FLAT_HASH_MAP_GROUP) U_INTERNAL_ASSERT_EQUALS(ctrl[i], ctrl[_capacity + i])
+
+      if (ctrl[i] >= 0)
+         {
+         ++n;
+
+         U_INTERNAL_ASSERT_EQUALS(ctrl[i], U_FLAT_H2(slots[i].hash))
+         U_INTERNAL_ASSERT_MAJOR(slots[i].key->size(), 0)
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(n, _length)
+
+   U_RETURN(true);
+}
+
+#  ifdef U_STDCPP_ENABLE
+const char* UFlatHashMap<void*>::dump(bool reset) const
+{
+   *UObjectIO::os << "hash                    " << hash         << '\n'
+                  << "index                   " << index        << '\n'
+                  << "ctrl                    " << (void*)ctrl  << '\n'
+                  << "slots                   " << (void*)slots << '\n'
+                  << "_length                 " << _length      << '\n'
+                  << "ndeleted                " << ndeleted     << '\n'
+                  << "_capacity               " << _capacity    << '\n'
+                  << "bignore_case            " << bignore_case << '\n'
+                  << "slot (uflathashmapslot  " << (void*)slot  << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#  endif
+#endif
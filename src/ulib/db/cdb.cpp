@@ -14,6 +14,45 @@
 #include <ulib/db/cdb.h>
 #include <ulib/utility/services.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+#ifdef __AVX2__
+#  define U_CDB_FP_LANES 16
+#elif defined(__SSE2__)
+#  define U_CDB_FP_LANES  8
+#else
+#  define U_CDB_FP_LANES  4
+#endif
+
+#define U_CDB_BATCH 16
+
+// Compare U_CDB_FP_LANES fingerprints at once: in the masks there are 2 bits for lane (as given by movemask on 16-bit lanes)
+
+static inline void u_cdb_scan(const uint16_t* ptr, uint16_t fingerprint, uint32_t& bmatch, uint32_t& bempty)
+{
+#ifdef __AVX2__
+   __m256i v = _mm256_loadu_si256((const __m256i*)ptr);
+
+   bmatch = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, _mm256_set1_epi16((short)fingerprint)));
+   bempty = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, _mm256_setzero_si256()));
+#elif defined(__SSE2__)
+   __m128i v = _mm_loadu_si128((const __m128i*)ptr);
+
+   bmatch = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_set1_epi16((short)fingerprint)));
+   bempty = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_setzero_si128()));
+#else
+   bmatch = bempty = 0;
+
+   for (uint32_t i = 0; i < U_CDB_FP_LANES; ++i)
+      {
+      if (ptr[i] == fingerprint) bmatch |= 3U << (i * 2);
+      if (ptr[i] == 0)           bempty |= 3U << (i * 2);
+      }
+#endif
+}
+
 void UCDB::init_internal(int ignore_case)
 {
    U_TRACE(0, "UCDB::init_internal(%d)", ignore_case)
@@ -24,6 +63,9 @@ void UCDB::init_internal(int ignore_case)
    hr   = U_NULLPTR;
    slot = U_NULLPTR;
    hp   = U_NULLPTR;
+   fp   = U_NULLPTR;
+
+   bfingerprint = false;
 
    pattern                 = U_NULLPTR;
    pbuffer                 = U_NULLPTR;
@@ -59,6 +101,7 @@ bool UCDB::open(bool brdonly)
 {
    U_TRACE(0, "UCDB::open(%b)", brdonly)
 
+   fp      = U_NULLPTR;
    nrecord = start_hash_table_slot = 0;
 
    if (UFile::isOpen() ||
@@ -87,7 +130,7 @@ bool UCDB::open(bool brdonly)
             start_hash_table_slot = *(uint32_t*)UFile::map;
             }
 
-         nrecord = (UFile::st_size - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
+         if (checkFingerprint() == false) nrecord = (UFile::st_size - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
          }
 
       U_INTERNAL_DUMP("nrecord = %u", nrecord)
@@ -128,6 +171,13 @@ bool UCDB::find()
       if (UFile::map == MAP_FAILED) (void) UFile::pread(&slot_buf, sizeof(cdb_hash_table_slot), offset);
       else                          slot = (cdb_hash_table_slot*) (UFile::map + offset);
 
+      if (fp)
+         {
+         loop = 0;
+
+         return findFingerprint();
+         }
+
       U_INTERNAL_DUMP("slot[%d] = { %u, %u }", nslot, u_get_unaligned32(slot->hash), u_get_unaligned32(slot->pos))
 
       // Each hash table slot states a hash value and a byte position.
@@ -200,6 +250,8 @@ bool UCDB::findNext()
 {
    U_TRACE_NO_PARAM(0, "UCDB::findNext()")
 
+   if (fp) return findFingerprint();
+
    uint32_t pos;
 
    // Probe that slot, the next higher slot, and so on, until you find the record or run into an empty slot
@@ -258,6 +310,195 @@ bool UCDB::findNext()
    U_RETURN(false);
 }
 
+// Fingerprint variant
+
+bool UCDB::checkFingerprint()
+{
+   U_TRACE_NO_PARAM(0, "UCDB::checkFingerprint()")
+
+   fp = U_NULLPTR;
+
+   if (UFile::st_size < (off_t)(CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer) + sizeof(cdb_fingerprint_trailer))) U_RETURN(false);
+
+   cdb_fingerprint_trailer trailer;
+   cdb_hash_table_pointer last;
+   uint32_t sz = UFile::st_size - sizeof(cdb_fingerprint_trailer);
+
+   if (UFile::map == MAP_FAILED)
+      {
+      if (UFile::pread(&trailer, sizeof(cdb_fingerprint_trailer), sz)                                                                     == false ||
+          UFile::pread(&last,    sizeof(cdb_hash_table_pointer),  (CDB_NUM_HASH_TABLE_POINTER-1) * sizeof(cdb_hash_table_pointer)) == false)
+         {
+         U_RETURN(false);
+         }
+      }
+   else
+      {
+      U_MEMCPY(&trailer, UFile::map + sz, sizeof(cdb_fingerprint_trailer));
+      U_MEMCPY(&last,    UFile::map + (CDB_NUM_HASH_TABLE_POINTER-1) * sizeof(cdb_hash_table_pointer), sizeof(cdb_hash_table_pointer));
+      }
+
+   U_INTERNAL_DUMP("trailer = { %u, %u, %u } last = { %u, %u }", trailer.nrecord, trailer.pos, trailer.magic, last.pos, last.slots)
+
+   if (trailer.magic != CDB_FINGERPRINT_MAGIC) U_RETURN(false);
+
+   uint32_t eot = last.pos + last.slots * sizeof(cdb_hash_table_slot); // END OF TABLES
+
+   if (eot < start_hash_table_slot                       ||
+       trailer.pos != ((eot + 63) & ~63)                 ||
+       (trailer.pos + (eot - start_hash_table_slot) / sizeof(cdb_hash_table_slot) * sizeof(uint16_t) + 32) != sz)
+      {
+      U_RETURN(false);
+      }
+
+   nrecord = trailer.nrecord;
+
+   if (UFile::map != MAP_FAILED) fp = (uint16_t*)(UFile::map + trailer.pos); // NB: without mmap we search only through the hash tables...
+
+   U_RETURN(true);
+}
+
+bool UCDB::findFingerprint()
+{
+   U_TRACE_NO_PARAM(0, "UCDB::findFingerprint()")
+
+   U_INTERNAL_ASSERT_POINTER(fp)
+   U_INTERNAL_ASSERT_MAJOR(hp->slots, 0)
+
+   uint16_t f = fingerprint(khash);
+   uint16_t* pfp = fp + (hp->pos - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
+   cdb_hash_table_slot* pslot = (cdb_hash_table_slot*)(UFile::map + hp->pos);
+   uint32_t i, n, pos, bmatch, bempty, slots = hp->slots;
+
+   // Probe a block of slots (until the end of the table) comparing the fingerprints, we read only the slots that match.
+   // NB: here nslot is the next slot to probe, so that findNext() can continue from it (handles repeated keys)...
+
+   while (loop < slots)
+      {
+      n = U_min(slots - nslot, slots - loop);
+
+      if (n > U_CDB_FP_LANES) n = U_CDB_FP_LANES;
+
+      u_cdb_scan(pfp + nslot, f, bmatch, bempty);
+
+      if (n < U_CDB_FP_LANES)
+         {
+         bmatch &= (1U << (n * 2)) - 1;
+         bempty &= (1U << (n * 2)) - 1;
+         }
+
+      if (bempty) bmatch &= (bempty & (0U - bempty)) - 1; // only the slots before the first empty slot...
+
+      U_INTERNAL_DUMP("loop = %u nslot = %u n = %u bmatch = %B bempty = %B", loop, nslot, n, bmatch, bempty)
+
+      for (i = 0; bmatch; ++i, bmatch >>= 2)
+         {
+         if ((bmatch & 3) == 0) continue;
+
+         slot = pslot + nslot + i;
+
+         if (u_get_unaligned32(slot->hash) == khash)
+            {
+            pos = u_get_unaligned32(slot->pos);
+            hr  = (cdb_record_header*)(UFile::map + pos);
+
+            U_INTERNAL_DUMP("slot[%u] = { %u, %u } hr = { %u, %u }", nslot + i, khash, pos, u_get_unaligned32(hr->klen), u_get_unaligned32(hr->dlen))
+
+            if (u_get_unaligned32(hr->klen) == key.dsize &&
+                u_equal(key.dptr, hr+1, key.dsize, ignoreCase()) == 0) // NB: as match() with mmap...
+               {
+               data.dsize = u_get_unaligned32(hr->dlen);
+               data.dptr  = (char*)(++hr) + key.dsize;
+
+               loop += i + 1;
+
+               if ((nslot += i + 1) == slots) nslot = 0;
+
+               U_RETURN(true);
+               }
+            }
+         }
+
+      if (bempty) break;
+
+      loop += n;
+
+      if ((nslot += n) == slots) nslot = 0;
+      }
+
+   loop = slots;
+
+   U_RETURN(false);
+}
+
+uint32_t UCDB::findMany(const UString* keys, uint32_t n, UString* values)
+{
+   U_TRACE(0, "UCDB::findMany(%p,%u,%p)", keys, n, values)
+
+   uint32_t i, j, k, ns, nfound = 0, hash[U_CDB_BATCH];
+
+   for (i = 0; i < n; i += U_CDB_BATCH)
+      {
+      k = U_min(n - i, U_CDB_BATCH);
+
+      if (UFile::st_size == 0)
+         {
+         for (j = 0; j < k; ++j) values[i+j].clear();
+
+         continue;
+         }
+
+      // 1) the hash of the keys of the batch, prefetching the pointers of their hash tables...
+
+      for (j = 0; j < k; ++j)
+         {
+         hash[j] = cdb_hash(U_STRING_TO_PARAM(keys[i+j]));
+
+         if (UFile::map != MAP_FAILED) PREFETCH_ATTRIBUTE(UFile::map + (hash[j] % CDB_NUM_HASH_TABLE_POINTER) * sizeof(cdb_hash_table_pointer), 0)
+         }
+
+      // 2) ...prefetching the first slot to probe (and its fingerprints) while the others are coming...
+
+      if (UFile::map != MAP_FAILED)
+         {
+         for (j = 0; j < k; ++j)
+            {
+            hp = (cdb_hash_table_pointer*)UFile::map + (hash[j] % CDB_NUM_HASH_TABLE_POINTER);
+
+            if (hp->slots)
+               {
+               ns = (hash[j] / CDB_NUM_HASH_TABLE_POINTER) % hp->slots;
+
+               if (fp) PREFETCH_ATTRIBUTE(fp + (hp->pos - start_hash_table_slot) / sizeof(cdb_hash_table_slot) + ns, 0)
+
+               PREFETCH_ATTRIBUTE(UFile::map + hp->pos + ns * sizeof(cdb_hash_table_slot), 0)
+               }
+            }
+         }
+
+      // 3) ...and the lookups
+
+      for (j = 0; j < k; ++j)
+         {
+         setKey(keys[i+j]);
+         setHash(hash[j]);
+
+         if (find() == false) values[i+j].clear();
+         else
+            {
+            ++nfound;
+
+            // NB: without mmap the data is in a buffer reused by the next lookup...
+
+            if (UFile::map != MAP_FAILED) values[i+j] = elem();
+            else                          values[i+j] = UString((const void*)data.dptr, data.dsize);
+            }
+         }
+      }
+
+   U_RETURN(nfound);
+}
+
 UString UCDB::at()
 {
    U_TRACE_NO_PARAM(0, "UCDB::at()")
@@ -338,6 +579,8 @@ uint32_t UCDB::makeFinish(bool _reset)
          {
          hp[i].pos = pos;
 
+         if (bfingerprint) hp[i].slots *= 2; // NB: load factor 0.5, so that the probe sequences are short...
+
          pos += hp[i].slots * sizeof(cdb_hash_table_slot);
 
          /*
@@ -353,6 +596,22 @@ uint32_t UCDB::makeFinish(bool _reset)
 
       if (_reset) (void) U_SYSCALL(memset, "%p,%d,%u", eod, 0, pos - start_hash_table_slot);
 
+      uint16_t* pfp = U_NULLPTR;
+      uint32_t fp_pos = 0, num_slot = (pos - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
+
+      if (bfingerprint)
+         {
+         // the fingerprints of the slots aligned on a cache line, with a padding for the loads of the last ones...
+
+         fp_pos = (pos + 63) & ~63;
+
+         U_INTERNAL_ASSERT((fp_pos + num_slot * sizeof(uint16_t) + 32 + sizeof(cdb_fingerprint_trailer)) <= (uint32_t)st_size)
+
+         (void) U_SYSCALL(memset, "%p,%d,%u", UFile::map + pos, 0, fp_pos - pos + num_slot * sizeof(uint16_t) + 32);
+
+         pfp = (uint16_t*)(UFile::map + fp_pos);
+         }
+
       for (i = 0; i < nrecord; ++i)
          {
          slot = (cdb_hash_table_slot*)(UFile::map + hp[tmp[i].index].pos);
@@ -379,10 +638,23 @@ uint32_t UCDB::makeFinish(bool _reset)
          u_put_unaligned32(pslot->hash, tmp[i].hash);
          u_put_unaligned32(pslot->pos,  tmp[i].pos);
 
+         if (pfp) pfp[((char*)pslot - eod) / sizeof(cdb_hash_table_slot)] = fingerprint(tmp[i].hash);
+
       // U_INTERNAL_DUMP("slot[%u] = { %u, %u }", nslot, tmp[i].hash, tmp[i].pos)
          }
 
       UMemoryPool::_free(tmp, nrecord, sizeof(cdb_tmp));
+
+      if (pfp)
+         {
+         cdb_fingerprint_trailer* trailer = (cdb_fingerprint_trailer*)(UFile::map + fp_pos + num_slot * sizeof(uint16_t) + 32);
+
+         u_put_unaligned32(trailer->nrecord, nrecord);
+         u_put_unaligned32(trailer->pos,     fp_pos);
+         u_put_unaligned32(trailer->magic,   CDB_FINGERPRINT_MAGIC);
+
+         pos = (char*)(trailer+1) - UFile::map;
+         }
       }
 
    U_RETURN(pos);
@@ -746,7 +1018,7 @@ bool UCDB::writeTo(UCDB& cdb, UHashMap<void*>* table, uint32_t tbl_space, pvPFpv
                        : table->size());
 
    bool result = cdb.creat(O_RDWR) &&
-                 cdb.ftruncate(sizeFor(cdb.nrecord) + tbl_space);
+                 cdb.ftruncate(sizeFor(cdb.nrecord) + tbl_space + (cdb.bfingerprint ? sizeFor(table->size(), true) - sizeFor(table->size()) : 0));
 
    if (result)
       {
@@ -882,10 +1154,10 @@ U_NO_EXPORT void UCDB::checkForAllEntry()
    U_INTERNAL_ASSERT_DIFFERS(UFile::map, MAP_FAILED)
 
    char* ptr;
-   char* _eof = UFile::map + (ptrdiff_t)UFile::st_size;
+   char* _eos = eos();
    slot       = (cdb_hash_table_slot*) end();
 
-   while ((char*)slot < _eof)
+   while ((char*)slot < _eos)
       {
       uint32_t pos = u_get_unaligned32(slot->pos);
 
@@ -1040,12 +1312,14 @@ const char* UCDB::dump(bool _reset) const
                   << "data                      " << "{ "           << data.dptr
                                                   << ' '            << data.dsize
                                                                     << " }\n"
+                  << "fp                        " << (void*)fp      << '\n'
                   << "slot                      " << (void*)slot    << '\n'
                   << "loop                      " << loop           << '\n'
                   << "nslot                     " << nslot          << '\n'
                   << "khash                     " << khash          << '\n'
                   << "offset                    " << offset         << '\n'
                   << "nrecord                   " << nrecord        << '\n'
+                  << "bfingerprint              " << bfingerprint   << '\n'
                   << "start_hash_table_slot     " << start_hash_table_slot;
 
    if (_reset)
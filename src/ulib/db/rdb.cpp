@@ -14,6 +14,10 @@
 #include <ulib/db/rdb.h>
 #include <ulib/net/server/server.h>
 
+#ifndef MREMAP_MAYMOVE
+#define MREMAP_MAYMOVE 1
+#endif
+
 sem_t    URDB::nolock;
 ULock*   URDB::preclock;
 uint32_t URDB::nerror;
@@ -170,6 +174,79 @@ invalid_entry:
    U_RETURN(false);
 }
 
+// Search one key/data pair in the cache without lock (read only, called by the read side of the seqlock).
+// Every offset is checked against the journal because a concurrent writer can show us a partial update...
+// ---------------------------------------------------------------------------------------------------------
+// RETURN VALUE
+// ---------------------------------------------------------------------------------------------------------
+//  1: found (UCDB::data point to the data on the journal)
+//  0: not found in the cache
+// -1: found but marked deleted
+// -2: inconsistent view of the hash tree (we must retry)
+// ---------------------------------------------------------------------------------------------------------
+
+U_NO_EXPORT int URDB::htFind(URDB* prdb)
+{
+   U_TRACE(0, "URDB::htFind(%p)", prdb)
+
+   U_INTERNAL_ASSERT_POINTER(prdb->UCDB::key.dptr)
+   U_INTERNAL_ASSERT_MAJOR(prdb->UCDB::key.dsize, 0)
+
+   int result;
+   URDB::cache_node* n;
+   uint32_t len, ptr, loop = 0,
+            limit = U_min(RDB_off(prdb), prdb->journal.map_size),
+            _node = RDB_hashtab(prdb)[prdb->UCDB::khash % CACHE_HASHTAB_LEN];
+
+   while (_node)
+      {
+      if (++loop > 4096U                               ||
+          _node < sizeof(URDB::cache_struct)           ||
+          (_node + sizeof(URDB::cache_node)) > limit)
+         {
+         U_RETURN(-2);
+         }
+
+      n = RDB_ptr_node(prdb, _node);
+
+      ptr = RDB_cache_node(n, key.dptr);
+      len = RDB_cache_node(n, key.dsize);
+
+      if (len == 0                           ||
+          ptr < sizeof(URDB::cache_struct)   ||
+          (ptr + len) > limit)
+         {
+         U_RETURN(-2);
+         }
+
+      result = u_equal(prdb->UCDB::key.dptr, prdb->journal.map + ptr, U_min(prdb->UCDB::key.dsize, len), UCDB::ignoreCase(prdb));
+
+      if (result < 0) _node = RDB_cache_node(n, left);
+      else
+         {
+         if (result == 0 &&
+             len    == prdb->UCDB::key.dsize)
+            {
+            ptr = RDB_cache_node(n, data.dptr);
+            len = RDB_cache_node(n, data.dsize);
+
+            if (ptr == 0) U_RETURN(-1);
+
+            if ((ptr + len) > limit) U_RETURN(-2);
+
+            prdb->UCDB::data.dptr  = prdb->journal.map + ptr;
+            prdb->UCDB::data.dsize = len;
+
+            U_RETURN(1);
+            }
+
+         _node = RDB_cache_node(n, right);
+         }
+      }
+
+   U_RETURN(0);
+}
+
 // Alloc one node for the hash tree
 
 U_NO_EXPORT void URDB::htAlloc(URDB* prdb)
@@ -529,6 +606,96 @@ U_NO_EXPORT void URDB::copy1(URDB* prdb, uint32_t _offset) // entry present on c
 #  endif
 }
 
+U_NO_EXPORT void URDB::copy2(URDB* prdb, uint32_t _offset) // entry changed during the background reorganize...
+{
+   U_TRACE(0, "URDB::copy2(%p,%u)", prdb, _offset)
+
+   U_INTERNAL_ASSERT_POINTER(pinfo)
+
+   URDB::cache_node* n = RDB_ptr_node(this, _offset);
+
+   if (RDB_cache_node(n,left))  copy2(prdb, RDB_cache_node(n,left));
+   if (RDB_cache_node(n,right)) copy2(prdb, RDB_cache_node(n,right));
+
+   // NB: every write (store, remove, substitute) log again the key on the journal, so an entry with the key before the cut
+   //     has not changed after the start of the background reorganize and it is already (or not, if deleted) in the new cdb...
+
+   uint32_t offset_key = RDB_cache_node(n,key.dptr);
+
+   U_INTERNAL_DUMP("offset_key = %u cut = %u", offset_key, pinfo->cut)
+
+   if (offset_key < pinfo->cut) return;
+
+   uint32_t size_key    = RDB_cache_node(n, key.dsize),
+            offset_data = RDB_cache_node(n,data.dptr),
+            size_data   = (offset_data ? RDB_cache_node(n,data.dsize) : U_NOT_FOUND);
+
+   const char* ptr_key = journal.map + offset_key;
+
+   // check if the entry is present in the new cdb (to update the number of records of the journal)...
+
+   UCDB::setKey(ptr_key, size_key);
+
+   UCDB::cdb_hash();
+
+   bool bcdb = cdbLookup();
+
+   U_INTERNAL_DUMP("offset_data = %u bcdb = %b", offset_data, bcdb)
+
+   if (offset_data == 0 &&
+       bcdb == false)
+      {
+      return; // NB: deleted and not present in the new cdb...
+      }
+
+   prdb->UCDB::setKey(ptr_key, size_key);
+
+   prdb->UCDB::khash = UCDB::khash;
+
+   (void) htLookup(prdb);
+
+   htAlloc(prdb);
+
+   UCDB::cdb_record_header hrec = { size_key, size_data };
+
+   char* journal_ptr = prdb->journal.map + RDB_off(prdb);
+
+   U_MEMCPY(journal_ptr, &hrec, sizeof(UCDB::cdb_record_header));
+
+   journal_ptr += sizeof(UCDB::cdb_record_header);
+
+   U_MEMCPY(journal_ptr, ptr_key, size_key);
+
+   prdb->UCDB::key.dptr = journal_ptr;
+
+   journal_ptr += size_key;
+
+   if (offset_data == 0)
+      {
+      prdb->UCDB::data.dptr  = U_NULLPTR;
+      prdb->UCDB::data.dsize = U_NOT_FOUND;
+
+      RDB_nrecord(prdb)--;
+      }
+   else
+      {
+      U_MEMCPY(journal_ptr, journal.map + offset_data, size_data);
+
+      prdb->UCDB::data.dptr  = journal_ptr;
+      prdb->UCDB::data.dsize = size_data;
+
+      journal_ptr += size_data;
+
+      if (bcdb == false) RDB_nrecord(prdb)++;
+      }
+
+   RDB_off(prdb) = (journal_ptr - prdb->journal.map);
+
+   // NB: the reference at memory in the cache data must point to memory mapped...
+
+   htInsert(prdb); // Insertion of new entry in the cache
+}
+
 void URDB::initRecordLock()
 {
    U_TRACE_NO_PARAM(0+256, "URDB::initRecordLock()")
@@ -553,13 +720,18 @@ void URDB::lockRecord()
    (plock = (preclock+(UCDB::khash & (U_SHM_LOCK_NENTRY-1))))->lock();
 }
 
-bool URDB::compactionJournal()
+bool URDB::compactionJournal(bool bchanged)
 {
-   U_TRACE_NO_PARAM(0, "URDB::compactionJournal()")
+   U_TRACE(0, "URDB::compactionJournal(%b)", bchanged)
 
    U_CHECK_MEMORY
 
-   U_ASSERT_EQUALS(UFile::isOpen(), false) // NB: no cdb file, Ex: ssl session cache...
+   if (bchanged == false)
+      {
+      U_ASSERT_EQUALS(UFile::isOpen(), false) // NB: no cdb file, Ex: ssl session cache...
+
+      if (isReorganizeRunning()) (void) endReorganize(true);
+      }
 
    U_INTERNAL_DUMP("RDB_off = %u RDB_reference = %u", RDB_off(this), RDB_reference(this))
 
@@ -577,6 +749,7 @@ bool URDB::compactionJournal()
       rdb.UCDB::nrecord   = 0;
 
       RDB_off(&rdb)       = sizeof(URDB::cache_struct);
+      RDB_version(&rdb)   = U_RDB_JOURNAL_VERSION;
       RDB_reference(&rdb) = 1;
 
       U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u",
@@ -588,7 +761,14 @@ bool URDB::compactionJournal()
       nerror = 0;
 #  endif
 
-      U_FOR_EACH_ENTRY1(&rdb, copy1)
+      if (bchanged)
+         {
+         U_FOR_EACH_ENTRY1(&rdb, copy2)
+         }
+      else
+         {
+         U_FOR_EACH_ENTRY1(&rdb, copy1)
+         }
 
 #  if defined(_MSWINDOWS_) || defined(__CYGWIN__)
       journal.UFile::munmap(); // for rename()...
@@ -610,7 +790,7 @@ bool URDB::compactionJournal()
       uint32_t sz1 =     getCapacity(),
                sz2 = rdb.getCapacity();
 
-      U_DEBUG("URDB::compactionJournal() - nrecords (%u => %u) capacity (%.2fM (%u bytes) => %.2fM (%u bytes)) nerror=%u",
+      U_DEBUG("URDB::compactionJournal(%b) - nrecords (%u => %u) capacity (%.2fM (%u bytes) => %.2fM (%u bytes)) nerror=%u", bchanged,
                         size(), rdb.size(),
                         (double)sz1 / (1024.0 * 1024.0), sz1,
                         (double)sz2 / (1024.0 * 1024.0), sz2, nerror)
@@ -618,6 +798,8 @@ bool URDB::compactionJournal()
       nerror = 0;
 #  endif
 
+      RDB_sequence(&rdb) = RDB_sequence(this); // NB: the new journal continue the seqlock (we are on the write side)...
+
       journal.UFile::substitute(rdb.journal);
 
       unlock();
@@ -671,10 +853,31 @@ bool URDB::open(uint32_t log_size, bool btruncate, bool cdb_brdonly, bool brefer
 
          if (journal.memmap(PROT_READ | PROT_WRITE, U_NULLPTR, 0, journal_sz_new))
             {
-            if (RDB_off(this) == 0) RDB_off(this) = sizeof(URDB::cache_struct);
+            if (RDB_off(this) == 0)
+               {
+               RDB_off(this)     = sizeof(URDB::cache_struct);
+               RDB_version(this) = U_RDB_JOURNAL_VERSION;
+               }
+
+            U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u RDB_version = %u",
+                             RDB_off(this), RDB_sync(this), RDB_capacity(this), RDB_nrecord(this), RDB_reference(this), RDB_version(this))
 
-            U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u",
-                             RDB_off(this), RDB_sync(this), RDB_capacity(this), RDB_nrecord(this), RDB_reference(this))
+            /**
+             * NB: a journal written with the previous layout (without version and sequence) have here the first slot of the hash table,
+             * that is 0 or the offset of a node (>= the old sizeof(cache_struct)), so it can't be confused with U_RDB_JOURNAL_VERSION.
+             * The offsets inside the journal are relative to the start of the mapping, so we can't use it with the new layout...
+             */
+
+            if (RDB_version(this) != U_RDB_JOURNAL_VERSION)
+               {
+               U_WARNING("URDB::open(%u,%b,%b,%b) - the journal %.*S has a different layout (version %u, expected %u), apply it with the previous version or remove it",
+                          log_size, btruncate, cdb_brdonly, breference, U_FILE_TO_TRACE(journal), RDB_version(this), U_RDB_JOURNAL_VERSION);
+
+               journal.munmap();
+               journal.close();
+
+               U_RETURN(false);
+               }
 
 #        ifdef DEBUG
             if (RDB_capacity(this) < sizeof(URDB::cache_node))
@@ -688,6 +891,12 @@ bool URDB::open(uint32_t log_size, bool btruncate, bool cdb_brdonly, bool brefer
 
             if (breference) RDB_reference(this)++;
 
+            if ((RDB_sequence(this) & 1) != 0 &&
+                 RDB_reference(this) <= 1)
+               {
+               RDB_sequence(this)++; // NB: a writer died inside the write side of the seqlock...
+               }
+
             if (psem != &nolock)
                {
                if (psem == U_NULLPTR)
@@ -724,6 +933,8 @@ void URDB::close(bool breference)
 
    U_CHECK_MEMORY
 
+   if (isReorganizeRunning()) (void) endReorganize(true);
+
    if (UFile::map_size) UFile::munmap(); // Constant DB
 
    if (breference == false) journal.munmap();
@@ -739,6 +950,8 @@ void URDB::close(bool breference)
 
       uint32_t sz = RDB_sync(this) = RDB_off(this);
 
+      if (_lock.sem) RDB_sequence(this)++; // NB: end of the write side of the seqlock (we unmap before unlock)...
+
       journal.munmap();
 
       if (reference == 0) (void) journal.ftruncate(sz);
@@ -763,6 +976,7 @@ void URDB::reset()
 
    RDB_off(this)     = sizeof(URDB::cache_struct);
    RDB_sync(this)    = 0;
+   RDB_version(this) = U_RDB_JOURNAL_VERSION;
    RDB_nrecord(this) = 0;
 
    // Initialize the cache to contain no entries
@@ -841,6 +1055,316 @@ bool URDB::closeReorganize()
    U_RETURN(false);
 }
 
+// BACKGROUND REORGANIZE
+
+bool URDB::startReorganize()
+{
+   U_TRACE_NO_PARAM(0, "URDB::startReorganize()")
+
+   U_CHECK_MEMORY
+
+   if (isReorganizeRunning()) U_RETURN(false);
+
+   // NB: without the semaphore we can't share the journal with the child, and with the lock held the child would see it as its own...
+
+   if (_lock.sem == 0 ||
+       _lock.isLocked())
+      {
+      U_RETURN(reorganize());
+      }
+
+   if (pinfo == U_NULLPTR)
+      {
+      uint32_t sz = sizeof(reorganize_info);
+
+      pinfo = (reorganize_info*) UFile::mmap(&sz, -1, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, 0);
+
+      if (pinfo == (reorganize_info*)MAP_FAILED)
+         {
+         pinfo = U_NULLPTR;
+
+         U_RETURN(false);
+         }
+      }
+
+   lock();
+
+   U_INTERNAL_DUMP("RDB_off = %u RDB_reference = %u", RDB_off(this), RDB_reference(this))
+
+   if (RDB_reference(this) > 1) // NB: the other processes that have opened the db would keep the old journal and the old cdb...
+      {
+      unlock();
+
+      U_WARNING("URDB::startReorganize() - db(%.*S) is opened by %u processes, background reorganize refused", U_FILE_TO_TRACE(*this), RDB_reference(this));
+
+      U_RETURN(false);
+      }
+
+   bool bfp    = (UCDB::fp || UCDB::bfingerprint); // NB: once written the fingerprint variant is kept...
+   uint32_t n  = UCDB::nrecord + RDB_nrecord(this),
+            sz = UFile::st_size + RDB_off(this) + UCDB::sizeFor(4096);
+
+   if (bfp) sz += UCDB::sizeFor(n, true) - UCDB::sizeFor(n);
+
+   pinfo->result = -1;
+   pinfo->cut    = RDB_off(this);
+   pinfo->ndone  = 0;
+   pinfo->ntotal = UCDB::nrecord + RDB_nrecord(this);
+
+   pinfo->duration_build =
+   pinfo->duration_swap  = 0;
+
+   unlock();
+
+   UProcess p;
+
+   if (p.fork() &&
+       p.parent())
+      {
+      pinfo->pid = p.pid();
+
+      U_RETURN(true);
+      }
+
+   if (p.child())
+      {
+      UCDB cdb(UCDB::ignoreCase());
+      UTimeVal chrono;
+      char cdb_buffer_path[MAX_FILENAME_LEN];
+
+      chrono.start();
+
+      cdb.setPath(*(const UFile*)this, cdb_buffer_path, U_CONSTANT_TO_PARAM(".tmp"));
+      cdb.setFingerprint(bfp);
+
+      bool result = (cdb.creat(O_RDWR)                        &&
+                     cdb.ftruncate(sz)                        &&
+                     cdb.memmap(PROT_READ | PROT_WRITE)       &&
+                     makeReorganize(cdb));
+
+      pinfo->duration_build = chrono.stop();
+
+      __sync_synchronize();
+
+      pinfo->result = result;
+
+      ::_exit(result ? 0 : 1); // NB: without destructors (the journal is shared with the parent)...
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool URDB::checkReorganize(UCDB& cdb, uint32_t space)
+{
+   U_TRACE(0, "URDB::checkReorganize(%p,%u)", &cdb, space)
+
+   // NB: the journal can be grown (mremap) by the parent after the fork...
+
+   if (RDB_off(this) > journal.map_size)
+      {
+      uint32_t _map_size = RDB_off(this) * 2;
+         char* _map      = UFile::mremap(journal.map, journal.map_size, _map_size, MREMAP_MAYMOVE);
+
+      if (_map == (char*)MAP_FAILED) U_RETURN(false);
+
+      journal.map      = _map;
+      journal.map_size = _map_size;
+      }
+
+   uint32_t used = (char*)cdb.hr - cdb.UFile::map;
+
+   U_INTERNAL_DUMP("used = %u space = %u cdb.st_size = %I", used, space, cdb.st_size)
+
+   if ((used + space) > (uint32_t)cdb.st_size)
+      {
+      if (cdb.ftruncate(used + space * 2) == false) U_RETURN(false);
+
+      cdb.hr = (UCDB::cdb_record_header*)(cdb.UFile::map + used); // NB: ftruncate() can move the mapping...
+      }
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT bool URDB::makeReorganize(UCDB& cdb)
+{
+   U_TRACE(0, "URDB::makeReorganize(%p)", &cdb)
+
+   cdb.makeStart();
+
+   // 1) first the entries in the cache, one slot of the hash table at a time... (NB: we don't change the cache, so we don't touch the seqlock)
+
+   uint32_t i, _offset;
+
+   for (i = 0; i < CACHE_HASHTAB_LEN; ++i)
+      {
+      _lock.lock();
+
+      if (checkReorganize(cdb, RDB_off(this)) == false)
+         {
+         _lock.unlock();
+
+         U_RETURN(false);
+         }
+
+      if ((_offset = RDB_hashtab(this)[i])) makeAdd1(&cdb, _offset);
+
+      _lock.unlock();
+
+      pinfo->ndone = cdb.nrecord;
+      }
+
+   // 2) ...after the entries of the old cdb not present in the cache, one block of slot at a time
+
+   if (UFile::st_size)
+      {
+      char* ptr;
+      uint32_t pos;
+      char* _eof = UCDB::eos(); // NB: end of the hash table slots...
+
+      UCDB::slot = (UCDB::cdb_hash_table_slot*) UCDB::end();
+
+      while ((char*)UCDB::slot < _eof)
+         {
+         _lock.lock();
+
+         if (checkReorganize(cdb, UFile::st_size) == false)
+            {
+            _lock.unlock();
+
+            U_RETURN(false);
+            }
+
+         for (i = 0; i < 1024 && (char*)UCDB::slot < _eof; ++i, ++UCDB::slot)
+            {
+            if ((pos = u_get_unaligned32(UCDB::slot->pos)))
+               {
+               ptr      = UFile::map + pos;
+               UCDB::hr = (UCDB::cdb_record_header*) ptr;
+
+               UCDB::khash     = u_get_unaligned32(UCDB::slot->hash);
+               UCDB::key.dsize = u_get_unaligned32(UCDB::hr->klen);
+               UCDB::key.dptr  = ptr + sizeof(UCDB::cdb_record_header);
+
+               if (htLookup(this) == false) UCDB::makeAdd2(&cdb, ptr); // NB: entry NOT present in the cache...
+               }
+            }
+
+         _lock.unlock();
+
+         pinfo->ndone = cdb.nrecord;
+         }
+      }
+
+   if (checkReorganize(cdb, UCDB::sizeFor(cdb.nrecord, cdb.bfingerprint)) == false) U_RETURN(false);
+
+   uint32_t sz = cdb.makeFinish(false);
+
+   U_INTERNAL_ASSERT(sz <= (uint32_t)cdb.st_size)
+
+   if (cdb.ftruncate(sz) == false) U_RETURN(false);
+
+   pinfo->nrecord               = cdb.nrecord;
+   pinfo->start_hash_table_slot = cdb.start_hash_table_slot;
+
+   U_RETURN(true);
+}
+
+bool URDB::endReorganize(bool bwait)
+{
+   U_TRACE(0, "URDB::endReorganize(%b)", bwait)
+
+   U_CHECK_MEMORY
+
+   if (isReorganizeRunning() == false) U_RETURN(false);
+
+   pid_t pid = pinfo->pid;
+
+   if (pinfo->result == -1)
+      {
+      if (bwait &&
+          _lock.isLocked())
+         {
+         // NB: the child need the lock to progress, so we abort it (Ex: reorganize() called by resizeJournal())...
+
+         (void) U_SYSCALL(kill, "%d,%d", pid, SIGTERM);
+         }
+      else if (UProcess::waitpid(pid, U_NULLPTR, (bwait ? 0 : WNOHANG)) == 0)
+         {
+         U_RETURN(false); // still running...
+         }
+      }
+
+   (void) UProcess::waitpid(pid, U_NULLPTR, 0); // NB: can fail with ECHILD if the child was already reaped (Ex: SIGCHLD handler)...
+
+   pinfo->pid = 0;
+
+   char cdb_buffer_path[MAX_FILENAME_LEN];
+   UCDB cdb(UCDB::ignoreCase());
+
+   cdb.setPath(*(const UFile*)this, cdb_buffer_path, U_CONSTANT_TO_PARAM(".tmp"));
+
+   if (pinfo->result != 1)
+      {
+      U_WARNING("URDB::endReorganize(%b) - background reorganize of db(%.*S) failed", bwait, U_FILE_TO_TRACE(*this));
+
+      (void) cdb._unlink();
+
+      U_RETURN(false);
+      }
+
+   UTimeVal chrono;
+
+   chrono.start();
+
+   lock();
+
+   bool result = false;
+
+   U_INTERNAL_DUMP("RDB_reference = %u", RDB_reference(this))
+
+   if (RDB_reference(this) <= 1 && // NB: if the db has been opened by other processes after the start the new cdb is discarded (they would lose the journal)...
+       cdb.UFile::open())
+      {
+      cdb.readSize();
+
+      if (cdb.UFile::memmap() && // read only...
+          cdb._rename(UFile::path_relativ))
+         {
+         cdb.UFile::close();
+
+         UFile::substitute(cdb);
+
+         UCDB::nrecord               = pinfo->nrecord;
+         UCDB::start_hash_table_slot = pinfo->start_hash_table_slot;
+
+         (void) UCDB::checkFingerprint();
+
+         // NB: the journal keeps only the entries changed after the start (compactionJournal() release the lock)...
+
+         result = compactionJournal(true);
+         }
+      }
+
+   unlock();
+
+   if (cdb.UFile::map_size) cdb.UFile::munmap();
+   if (cdb.UFile::isOpen()) cdb.UFile::close();
+
+   pinfo->duration_swap = chrono.stop();
+
+   if (result) pinfo->nreorganize++;
+   else
+      {
+      U_WARNING("URDB::endReorganize(%b) - substitution of the cdb of db(%.*S) failed", bwait, U_FILE_TO_TRACE(*this));
+
+      (void) cdb._unlink();
+      }
+
+   U_DEBUG("URDB::endReorganize(%b) - nrecords %u build %u ms swap %u ms", bwait, size(), pinfo->duration_build, pinfo->duration_swap)
+
+   U_RETURN(result);
+}
+
 // Call function for all entry
 
 U_NO_EXPORT void URDB::callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2)
@@ -853,7 +1377,7 @@ U_NO_EXPORT void URDB::callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2)
    U_INTERNAL_ASSERT_DIFFERS(UFile::map, MAP_FAILED)
 
    char* ptr;
-   char* _eof = UFile::map + (ptrdiff_t)UFile::st_size;
+   char* _eof = UCDB::eos(); // NB: end of the hash table slots...
    UCDB::slot = (UCDB::cdb_hash_table_slot*) UCDB::end();
 
    U_cdb_result_call(pcdb) = 1;
@@ -1062,6 +1586,8 @@ bool URDB::reorganize()
 
    U_CHECK_MEMORY
 
+   if (isReorganizeRunning()) (void) endReorganize(true);
+
    bool result = true;
 
    lock();
@@ -1077,10 +1603,21 @@ bool URDB::reorganize()
       UCDB cdb(UCDB::ignoreCase());
       char cdb_buffer_path[MAX_FILENAME_LEN];
 
+      uint32_t n  = UCDB::nrecord + RDB_nrecord(this),
+               sz = UFile::st_size + journal.st_size + UCDB::sizeFor(4096);
+
       cdb.setPath(*(const UFile*)this, cdb_buffer_path, U_CONSTANT_TO_PARAM(".tmp"));
 
+      if (UCDB::fp ||
+          UCDB::bfingerprint)
+         {
+         cdb.setFingerprint(); // NB: once written the fingerprint variant is kept...
+
+         sz += UCDB::sizeFor(n, true) - UCDB::sizeFor(n);
+         }
+
       result = cdb.creat(O_RDWR) &&
-               cdb.ftruncate(UFile::st_size + journal.st_size + UCDB::sizeFor(4096));
+               cdb.ftruncate(sz);
 
       if (result)
          {
@@ -1126,6 +1663,8 @@ bool URDB::reorganize()
          UCDB::nrecord               = cdb.nrecord;
          UCDB::start_hash_table_slot = cdb.start_hash_table_slot;
 
+         (void) UCDB::checkFingerprint();
+
          U_INTERNAL_DUMP("UCDB::nrecord = %u RDB_nrecord = %u", UCDB::nrecord, RDB_nrecord(this))
          }
       }
@@ -1417,6 +1956,61 @@ bool URDB::_fetch()
    U_RETURN(true);
 }
 
+// Read side of the seqlock: search one key/data pair in the cache or in the cdb without lock
+// -------------------------------------------------------------------------------------------
+// RETURN VALUE
+// -------------------------------------------------------------------------------------------
+//  1: found
+//  0: not found
+// -1: too many writer (the caller must take the lock)
+// -------------------------------------------------------------------------------------------
+
+int URDB::fetchWithoutLock()
+{
+   U_TRACE_NO_PARAM(0, "URDB::fetchWithoutLock()")
+
+   U_INTERNAL_ASSERT_POINTER(_lock.sem)
+   U_INTERNAL_ASSERT_EQUALS(_lock.isLocked(), false)
+
+   int result;
+   uint32_t seq;
+   volatile uint32_t* psequence = &RDB_sequence(this);
+
+   for (uint32_t i = 0; i < 16; ++i)
+      {
+      seq = *psequence;
+
+      if ((seq & 1) != 0) // a writer is changing the cache...
+         {
+         if (i > 2) (void) U_SYSCALL_NO_PARAM(sched_yield);
+
+         continue;
+         }
+
+      __sync_synchronize();
+
+      result = htFind(this);
+
+      __sync_synchronize();
+
+      if (*psequence != seq) continue;
+
+      if (result == -2) U_RETURN(-1); // NB: the view is consistent but invalid (journal corrupted?), we use the slow path...
+
+      if (result == 1) U_RETURN(1);
+
+      if (result == 0 && // NB: the cdb is constant...
+          cdbLookup())
+         {
+         U_RETURN(1);
+         }
+
+      U_RETURN(0);
+      }
+
+   U_RETURN(-1);
+}
+
 // --------------------------------------------------------------------
 // Fetch the value for a given key from the database.
 // --------------------------------------------------------------------
@@ -1430,10 +2024,29 @@ bool URDB::fetch()
 
    bool result;
 
-   lock();
-
    UCDB::cdb_hash();
 
+   if (_lock.sem)
+      {
+      if (_lock.isLocked()) // NB: we are the writer (the sequence is odd), the read side of the seqlock would spin on ourself...
+         {
+         result = _fetch();
+
+         U_RETURN(result);
+         }
+
+      int ret = fetchWithoutLock();
+
+      if (ret >= 0)
+         {
+         result = (ret == 1);
+
+         U_RETURN(result);
+         }
+      }
+
+   lock();
+
    // Search one key/data pair in the cache or in the cdb
 
    result = _fetch();
@@ -1449,13 +2062,7 @@ UString URDB::at()
 
    UString result;
 
-   lock();
-
-   UCDB::cdb_hash();
-
-   if (_fetch()) result = UCDB::elem();
-
-   unlock();
+   if (fetch()) result = UCDB::elem();
 
    U_RETURN_STRING(result);
 }
@@ -1553,6 +2160,8 @@ int URDB::store(int _flag)
 
    int result;
 
+   checkForReorganize();
+
    lock();
 
    UCDB::cdb_hash();
@@ -1582,6 +2191,8 @@ int URDB::remove()
    int result = 0;
    bool record_cache_deleted = false;
 
+   checkForReorganize();
+
    lock();
 
    UCDB::cdb_hash();
@@ -1659,6 +2270,8 @@ int URDB::substitute(UCDB::datum* key2, int _flag)
    int result        = 0;
    UCDB::datum data2 = UCDB::data;
 
+   checkForReorganize();
+
    lock();
 
    UCDB::cdb_hash();
@@ -1761,17 +2374,9 @@ bool URDB::find(const char* _key, uint32_t keylen)
 {
    U_TRACE(0, "URDB::find(%.*S,%u)", keylen, _key, keylen)
 
-   bool result;
-
-   lock();
-
    UCDB::setKey(_key, keylen);
 
-   UCDB::cdb_hash();
-
-   result = _fetch(); // Fetch the value for a given key from the database
-
-   unlock();
+   bool result = fetch(); // Fetch the value for a given key from the database
 
    U_RETURN(result);
 }
@@ -1780,6 +2385,8 @@ int URDB::store(const char* _key, uint32_t keylen, const char* _data, uint32_t d
 {
    U_TRACE(0, "URDB::store(%.*S,%u,%.*S,%u,%d)", keylen, _key, keylen, datalen, _data, datalen, _flag)
 
+   checkForReorganize();
+
    lock();
 
    UCDB::setKey(  _key,  keylen);
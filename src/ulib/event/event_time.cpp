@@ -28,6 +28,8 @@ UEventTime::UEventTime(long sec, long micro_sec) : UTimeVal(sec, micro_sec)
 
    setTolerance();
 
+   timer_index = U_NOT_FOUND;
+
    xtime.tv_sec =
    xtime.tv_usec = 0L;
 
@@ -105,9 +107,10 @@ const char* UEventTime::dump(bool _reset) const
    UTimeVal::dump(false);
 
    *UObjectIO::os << '\n'
-                  << "xtime   " << "{ " << xtime.tv_sec
-                                << " "  << xtime.tv_usec
-                                << " }";
+                  << "xtime       " << "{ " << xtime.tv_sec
+                                    << " "  << xtime.tv_usec
+                                    << " }\n"
+                  << "timer_index " << timer_index;
 
    if (_reset)
       {
@@ -32,6 +32,26 @@
                           U_STACK_TYPE_9  * U_NUM_ENTRY_MEM_BLOCK)
 // --------------------------------------------------------------------------------------
 
+/**
+ * With thread support every thread takes and gives back the memory through its own magazine (U_MAGAZINE_SIZE * 2 pointers for each
+ * 'type' stack) without any lock, while the global 'type' stacks act as a depot: the magazine is refilled from (or flushed to) the depot
+ * with batch of U_MAGAZINE_SIZE pointers, so the (spin) lock of the depot is taken at most once every U_MAGAZINE_SIZE pop()/push()...
+ */
+
+#if defined(ENABLE_MEMPOOL) && defined(ENABLE_THREAD) && defined(HAVE_GCC_ATOMICS) && !defined(_MSWINDOWS_)
+#  define U_MEMORY_POOL_MAGAZINE
+#  define U_MAGAZINE_SIZE U_NUM_ENTRY_MEM_BLOCK
+
+typedef struct umagazine {
+   uint32_t len[U_NUM_STACK_TYPE];
+   void* pointer_block[U_NUM_STACK_TYPE][U_MAGAZINE_SIZE * 2];
+} umagazine;
+
+static pthread_key_t  magazine_key;
+static pthread_once_t magazine_once = PTHREAD_ONCE_INIT;
+static __thread umagazine* magazine __attribute__((tls_model("initial-exec")));
+#endif
+
 #ifdef DEBUG
 const char* UMemoryPool::obj_class;
 const char* UMemoryPool::func_call;
@@ -102,11 +122,60 @@ public:
       if (pointer_block < &mem_pointer_block[0] ||
           pointer_block > &mem_pointer_block[U_NUM_STACK_TYPE * U_NUM_ENTRY_MEM_BLOCK * 2])
          {
-         UMemoryPool::deallocate(pointer_block, space * sizeof(void*));
+         UMemoryPool::__deallocate(pointer_block, space * sizeof(void*));
          }
 #  endif
       }
 
+   // NB: like UMemoryPool::_malloc() but serviced directly by the depot (with thread support the caller must hold the lock)...
+
+   static void* depotMalloc(uint32_t* pnum, uint32_t type_size)
+      {
+      U_TRACE(0, "UStackMemoryPool::depotMalloc(%p,%u)", pnum, type_size)
+
+      void* ptr;
+      uint32_t length = (*pnum * type_size); // in bytes
+
+      if (length > U_MAX_SIZE_PREALLOCATE) ptr = UFile::mmap(&length, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | U_MAP_ANON, 0);
+      else
+         {
+         int stack_index = U_SIZE_TO_STACK_INDEX(length);
+
+         ptr    = ((UStackMemoryPool*)(mem_stack+stack_index))->pop();
+         length = UMemoryPool::U_STACK_INDEX_TO_SIZE[stack_index];
+         }
+
+      *pnum = length / type_size;
+
+      U_INTERNAL_DUMP("*pnum = %u length = %u", *pnum, length)
+
+      return ptr;
+      }
+
+#ifdef U_MEMORY_POOL_MAGAZINE
+   static char lock_depot;
+
+   static void lock()
+      {
+      while (__sync_lock_test_and_set(&lock_depot, 1))
+         {
+         do { (void) sched_yield(); } while (*(volatile char*)&lock_depot);
+         }
+      }
+
+   static void unlock() { __sync_lock_release(&lock_depot); }
+
+   static void createMagazineKey();
+   static void deleteMagazine(void* pmagazine);
+   static umagazine* createMagazine();
+
+   static void  refill(umagazine* pmagazine, int stack_index);
+   static void   flush(umagazine* pmagazine, int stack_index);
+#else
+   static void   lock() {}
+   static void unlock() {}
+#endif
+
    void growPointerBlock(uint32_t new_space)
       {
       U_TRACE(0, "UStackMemoryPool::growPointerBlock(%u)", new_space)
@@ -156,7 +225,7 @@ public:
          }
       else
          {
-         char* pblock = (char*) UMemoryPool::_malloc(&num_entry, type);
+         char* pblock = (char*) depotMalloc(&num_entry, type);
 
          uint32_t new_len = len + num_entry;
 
@@ -262,7 +331,11 @@ void UMemoryPool::allocateMemoryBlocks(int stack_index, uint32_t n)
                         pstack->pop_cnt, pstack->push_cnt,
                         pstack->num_call_allocateMemoryBlocks);
 
+   UStackMemoryPool::lock();
+
    if (n > pstack->len) pstack->allocateMemoryBlocks(n);
+
+   UStackMemoryPool::unlock();
 }
 
 void UMemoryPool::allocateMemoryBlocks(const char* ptr)
@@ -330,6 +403,8 @@ void UMemoryPool::allocateMemoryBlocks(const char* ptr)
 
          if (i < (U_NUM_STACK_TYPE-1))
             {
+            UStackMemoryPool::lock();
+
             do {
                addr = (pstack->pop(),
                        pstack->pop());
@@ -342,6 +417,8 @@ void UMemoryPool::allocateMemoryBlocks(const char* ptr)
                }
             while (memblock[i] < 0);
 
+            UStackMemoryPool::unlock();
+
             U_INTERNAL_ASSERT_EQUALS(memblock[i], 0)
             }
          }
@@ -355,7 +432,18 @@ void UMemoryPool::push(void* ptr, int stack_index)
    U_INTERNAL_ASSERT_POINTER(ptr)
    U_INTERNAL_ASSERT_MINOR(stack_index, U_NUM_STACK_TYPE) // 10
 
-   if (stack_index) ((UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index))->push(ptr);
+   if (stack_index)
+      {
+#  ifdef U_MEMORY_POOL_MAGAZINE
+      umagazine* pmagazine = (magazine ? magazine : UStackMemoryPool::createMagazine());
+
+      if (pmagazine->len[stack_index] == U_MAGAZINE_SIZE * 2) UStackMemoryPool::flush(pmagazine, stack_index);
+
+      pmagazine->pointer_block[stack_index][pmagazine->len[stack_index]++] = ptr;
+#  else
+      ((UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index))->push(ptr);
+#  endif
+      }
 }
 
 void UMemoryPool::_free(void* ptr, uint32_t num, uint32_t type_size)
@@ -380,9 +468,16 @@ void* UMemoryPool::pop(int stack_index)
 
    U_INTERNAL_ASSERT_MINOR(stack_index, U_NUM_STACK_TYPE) // 10
 
+#ifdef U_MEMORY_POOL_MAGAZINE
+   umagazine* pmagazine = (magazine ? magazine : UStackMemoryPool::createMagazine());
+
+   if (pmagazine->len[stack_index] == 0) UStackMemoryPool::refill(pmagazine, stack_index);
+
+   return pmagazine->pointer_block[stack_index][--pmagazine->len[stack_index]];
+#else
    UStackMemoryPool* pstack = (UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index);
 
-#ifdef DEBUG
+# ifdef DEBUG
    if (pstack->index &&
        pstack->len == 0)
       {
@@ -391,11 +486,126 @@ void* UMemoryPool::pop(int stack_index)
                   obj_class, func_call, pstack->index, pstack->type, pstack->len, pstack->space, pstack->depth,
                   pstack->max_depth, pstack->num_call_allocateMemoryBlocks, pstack->pop_cnt, pstack->push_cnt);
       }
-#endif
+# endif
 
    return pstack->pop();
+#endif
+}
+
+#ifdef U_MEMORY_POOL_MAGAZINE
+char UStackMemoryPool::lock_depot;
+
+void UStackMemoryPool::createMagazineKey()
+{
+   U_TRACE_NO_PARAM(1, "UStackMemoryPool::createMagazineKey()")
+
+   (void) U_SYSCALL(pthread_key_create, "%p,%p", &magazine_key, deleteMagazine);
 }
 
+umagazine* UStackMemoryPool::createMagazine()
+{
+   U_TRACE_NO_PARAM(1, "UStackMemoryPool::createMagazine()")
+
+   U_INTERNAL_ASSERT_EQUALS(magazine, U_NULLPTR)
+
+   (void) U_SYSCALL(pthread_once, "%p,%p", &magazine_once, createMagazineKey);
+
+   lock();
+
+   uint32_t size = sizeof(umagazine);
+
+   magazine = (umagazine*) depotMalloc(&size, 1);
+
+   unlock();
+
+   (void) memset(magazine, 0, sizeof(umagazine));
+
+   // NB: the destructor of the key give back to the depot the content of the magazine when the thread exit...
+
+   (void) U_SYSCALL(pthread_setspecific, "%u,%p", magazine_key, magazine);
+
+   U_RETURN_POINTER(magazine, umagazine);
+}
+
+void UStackMemoryPool::deleteMagazine(void* ptr)
+{
+   U_TRACE(1, "UStackMemoryPool::deleteMagazine(%p)", ptr)
+
+   umagazine* pmagazine = (umagazine*)ptr;
+
+   lock();
+
+   // NB: the stack 0 is serviced without push (the memory is never given back)...
+
+   for (int stack_index = 1; stack_index < U_NUM_STACK_TYPE; ++stack_index)
+      {
+      UStackMemoryPool* pstack = (UStackMemoryPool*)(mem_stack+stack_index);
+
+      for (uint32_t i = 0; i < pmagazine->len[stack_index]; ++i) pstack->push(pmagazine->pointer_block[stack_index][i]);
+      }
+
+   UMemoryPool::__deallocate(pmagazine, UFile::getSizeAligned(sizeof(umagazine)));
+
+   unlock();
+
+   if (magazine == pmagazine) magazine = U_NULLPTR;
+}
+
+void UStackMemoryPool::refill(umagazine* pmagazine, int stack_index)
+{
+   U_TRACE(0, "UStackMemoryPool::refill(%p,%d)", pmagazine, stack_index)
+
+   U_INTERNAL_ASSERT_EQUALS(pmagazine->len[stack_index], 0)
+
+   UStackMemoryPool* pstack = (UStackMemoryPool*)(mem_stack+stack_index);
+
+   lock();
+
+#ifdef DEBUG
+   if (pstack->index &&
+       pstack->len < U_MAGAZINE_SIZE)
+      {
+      U_WARNING("We are going to call allocateMemoryBlocks() (pid %P) - object = %S func = %S"
+                " index = %u type = %u len = %u space = %u depth = %u max_depth = %u num_call_allocateMemoryBlocks = %u pop_cnt = %u push_cnt = %u",
+                  UMemoryPool::obj_class, UMemoryPool::func_call, pstack->index, pstack->type, pstack->len, pstack->space, pstack->depth,
+                  pstack->max_depth, pstack->num_call_allocateMemoryBlocks, pstack->pop_cnt, pstack->push_cnt);
+      }
+#endif
+
+   void** pblock = pmagazine->pointer_block[stack_index];
+
+   for (uint32_t i = 0; i < U_MAGAZINE_SIZE; ++i) pblock[i] = pstack->pop();
+
+   unlock();
+
+   pmagazine->len[stack_index] = U_MAGAZINE_SIZE;
+}
+
+void UStackMemoryPool::flush(umagazine* pmagazine, int stack_index)
+{
+   U_TRACE(0, "UStackMemoryPool::flush(%p,%d)", pmagazine, stack_index)
+
+   U_INTERNAL_ASSERT_MAJOR(stack_index, 0)
+   U_INTERNAL_ASSERT_EQUALS(pmagazine->len[stack_index], U_MAGAZINE_SIZE * 2)
+
+   UStackMemoryPool* pstack = (UStackMemoryPool*)(mem_stack+stack_index);
+
+   // NB: we give back the older half of the magazine, the newer half is probably still hot in cache...
+
+   void** pblock = pmagazine->pointer_block[stack_index];
+
+   lock();
+
+   for (uint32_t i = 0; i < U_MAGAZINE_SIZE; ++i) pstack->push(pblock[i]);
+
+   unlock();
+
+   U_MEMCPY(pblock, pblock + U_MAGAZINE_SIZE, U_MAGAZINE_SIZE * sizeof(void*));
+
+   pmagazine->len[stack_index] = U_MAGAZINE_SIZE;
+}
+#endif
+
 #  ifdef DEBUG
 bool UMemoryPool::check(void* ptr)
 {
@@ -426,6 +636,21 @@ bool UMemoryPool::check(void* ptr)
                        stack_index, i, pstack->pointer_block[i]);
             }
          }
+
+#  ifdef U_MEMORY_POOL_MAGAZINE
+      if (magazine)
+         {
+         for (uint32_t i = 0; i < magazine->len[stack_index]; ++i)
+            {
+            if (ptr == magazine->pointer_block[stack_index][i])
+               {
+               U_ERROR("Duplicate entry on memory pool: magazine[%u].len = %u magazine[%u].pointer_block[%u] = %p",
+                          stack_index,    magazine->len[stack_index],
+                          stack_index, i, magazine->pointer_block[stack_index][i]);
+               }
+            }
+         }
+#  endif
       }
 
    U_RETURN(true);
@@ -433,6 +658,25 @@ bool UMemoryPool::check(void* ptr)
 #  endif
 #endif
 
+#ifdef ENABLE_MEMPOOL
+char* UMemoryPool::mmap(uint32_t* plength)
+{
+   U_TRACE(0, "UMemoryPool::mmap(%p)", plength)
+
+   U_INTERNAL_ASSERT_MAJOR(*plength, U_CAPACITY)
+
+   // NB: the arena of UFile::mmap() (UFile::pfree, UFile::nfree) is shared with UMemoryPool::deallocate()...
+
+   UStackMemoryPool::lock();
+
+   char* ptr = UFile::mmap(plength, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | U_MAP_ANON, 0);
+
+   UStackMemoryPool::unlock();
+
+   U_RETURN_POINTER(ptr, char);
+}
+#endif
+
 void* UMemoryPool::_malloc(uint32_t num, uint32_t type_size, bool bzero)
 {
    U_TRACE(0, "UMemoryPool::_malloc(%u,%u,%b)", num, type_size, bzero)
@@ -460,7 +704,7 @@ void* UMemoryPool::_malloc(uint32_t num, uint32_t type_size, bool bzero)
       }
    else
       {
-      ptr = UFile::mmap(&length, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | U_MAP_ANON, 0);
+      ptr = mmap(&length);
 
       U_INTERNAL_DUMP("length = %u", length)
       }
@@ -491,7 +735,7 @@ void* UMemoryPool::_malloc(uint32_t* pnum, uint32_t type_size, bool bzero)
 
    ptr = U_SYSCALL(malloc, "%u", length);
 #else
-   if (length > U_MAX_SIZE_PREALLOCATE) ptr = UFile::mmap(&length, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | U_MAP_ANON, 0);
+   if (length > U_MAX_SIZE_PREALLOCATE) ptr = mmap(&length);
    else
       {
       int stack_index = U_SIZE_TO_STACK_INDEX(length);
@@ -513,7 +757,18 @@ void* UMemoryPool::_malloc(uint32_t* pnum, uint32_t type_size, bool bzero)
 #if defined(ENABLE_MEMPOOL) && (!defined(U_SERVER_CAPTIVE_PORTAL) || defined(ENABLE_THREAD))
 void UMemoryPool::deallocate(void* ptr, uint32_t length)
 {
-   U_TRACE(1, "UMemoryPool::deallocate(%p,%u)", ptr, length)
+   U_TRACE(0, "UMemoryPool::deallocate(%p,%u)", ptr, length)
+
+   UStackMemoryPool::lock();
+
+   __deallocate(ptr, length);
+
+   UStackMemoryPool::unlock();
+}
+
+void UMemoryPool::__deallocate(void* ptr, uint32_t length)
+{
+   U_TRACE(1, "UMemoryPool::__deallocate(%p,%u)", ptr, length)
 
    if (UFile::isLastAllocation(ptr, length))
       {
@@ -0,0 +1,881 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    tape.cpp - JSON parser on a flat tape with a SIMD structural index
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/json/value.h>
+#include <ulib/utility/escape.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+#ifdef __AVX2__
+#  define U_JSON_LANE 32
+typedef __m256i u_json_vector;
+#  define U_JSON_LOAD(p)     _mm256_loadu_si256((const __m256i*)(p))
+#  define U_JSON_SET1(c)     _mm256_set1_epi8(c)
+#  define U_JSON_EQ(a,b)     _mm256_cmpeq_epi8(a,b)
+#  define U_JSON_OR(a,b)     _mm256_or_si256(a,b)
+#  define U_JSON_MAX(a,b)    _mm256_max_epu8(a,b)
+#  define U_JSON_MOVEMASK(a) (uint32_t)_mm256_movemask_epi8(a)
+#elif defined(__SSE2__)
+#  define U_JSON_LANE 16
+typedef __m128i u_json_vector;
+#  define U_JSON_LOAD(p)     _mm_loadu_si128((const __m128i*)(p))
+#  define U_JSON_SET1(c)     _mm_set1_epi8(c)
+#  define U_JSON_EQ(a,b)     _mm_cmpeq_epi8(a,b)
+#  define U_JSON_OR(a,b)     _mm_or_si128(a,b)
+#  define U_JSON_MAX(a,b)    _mm_max_epu8(a,b)
+#  define U_JSON_MOVEMASK(a) (uint32_t)_mm_movemask_epi8(a)
+#endif
+
+#define U_JSON_EVEN_BITS 0x5555555555555555ULL
+
+typedef struct u_json_block {
+   uint64_t quote, backslash, op, space, control;
+} u_json_block;
+
+// the bitmasks of a block of 64 bytes
+
+static inline void u_json_classify(const char* p, u_json_block& b)
+{
+   U_INTERNAL_TRACE("u_json_classify(%p,%p)", p, &b)
+
+   b.quote = b.backslash = b.op = b.space = b.control = 0;
+
+#ifdef U_JSON_LANE
+   const u_json_vector quote     = U_JSON_SET1('"'),
+                       backslash = U_JSON_SET1('\\'),
+                       lbrace    = U_JSON_SET1('{'),
+                       rbrace    = U_JSON_SET1('}'),
+                       colon     = U_JSON_SET1(':'),
+                       comma     = U_JSON_SET1(','),
+                       blank     = U_JSON_SET1(' '),
+                       tab       = U_JSON_SET1('\t'),
+                       nl        = U_JSON_SET1('\n'),
+                       cr        = U_JSON_SET1('\r'),
+                       x20       = U_JSON_SET1(0x20),
+                       x1f       = U_JSON_SET1(0x1F);
+
+   for (uint32_t i = 0; i < 64; i += U_JSON_LANE)
+      {
+      u_json_vector v = U_JSON_LOAD(p+i),
+                    l = U_JSON_OR(v, x20); // NB: '[' | 0x20 == '{' and ']' | 0x20 == '}'...
+
+      b.quote     |= (uint64_t)U_JSON_MOVEMASK(U_JSON_EQ(v, quote))     << i;
+      b.backslash |= (uint64_t)U_JSON_MOVEMASK(U_JSON_EQ(v, backslash)) << i;
+      b.op        |= (uint64_t)U_JSON_MOVEMASK(U_JSON_OR(U_JSON_OR(U_JSON_EQ(l, lbrace), U_JSON_EQ(l, rbrace)),
+                                                         U_JSON_OR(U_JSON_EQ(v, colon),  U_JSON_EQ(v, comma)))) << i;
+      b.space     |= (uint64_t)U_JSON_MOVEMASK(U_JSON_OR(U_JSON_OR(U_JSON_EQ(v, blank), U_JSON_EQ(v, tab)),
+                                                         U_JSON_OR(U_JSON_EQ(v, nl),    U_JSON_EQ(v, cr)))) << i;
+      b.control   |= (uint64_t)U_JSON_MOVEMASK(U_JSON_EQ(U_JSON_MAX(v, x1f), x1f)) << i; // 00..1F
+      }
+#else
+   for (uint32_t i = 0; i < 64; ++i)
+      {
+      uint64_t bit = 1ULL << i;
+
+      switch ((unsigned char)p[i])
+         {
+         case '"':  b.quote     |= bit; break;
+         case '\\': b.backslash |= bit; break;
+
+         case '{':
+         case '}':
+         case '[':
+         case ']':
+         case ':':
+         case ',':  b.op        |= bit; break;
+
+         case '\t':
+         case '\n':
+         case '\r': b.control   |= bit; /* FALLTHRU */
+         case ' ':  b.space     |= bit; break;
+
+         default: if ((unsigned char)p[i] <= 0x1F) b.control |= bit;
+         }
+      }
+#endif
+}
+
+// @see http://branchfree.org/2019/03/06/code-fragment-finding-quote-pairs-with-carry-less-multiply-pclmulqdq/ (here without PCLMULQDQ)
+
+static inline uint64_t u_json_prefix_xor(uint64_t x)
+{
+   x ^= x <<  1;
+   x ^= x <<  2;
+   x ^= x <<  4;
+   x ^= x <<  8;
+   x ^= x << 16;
+   x ^= x << 32;
+
+   return x;
+}
+
+static inline bool u_json_terminator(unsigned char c)
+{
+   switch (c)
+      {
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+      case ',':
+      case ':':
+      case '[':
+      case ']':
+      case '{':
+      case '}': return true;
+      }
+
+   return false;
+}
+
+UJsonTape::~UJsonTape()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UJsonTape)
+
+   if (tape)  UMemoryPool::_free(tape,  tape_max,  sizeof(uint64_t));
+   if (index) UMemoryPool::_free(index, index_max, sizeof(uint32_t));
+}
+
+bool UJsonTape::parse(const UString& _document)
+{
+   U_TRACE(0, "UJsonTape::parse(%V)", _document.rep)
+
+   uint32_t len = _document.size();
+
+   document = _document;
+
+   tape_len = index_len = 0;
+
+   if (len == 0) U_RETURN(false);
+
+   if (index_max < len) // NB: every char can be a structural char...
+      {
+      if (index) UMemoryPool::_free(index, index_max, sizeof(uint32_t));
+
+      index = (uint32_t*) UMemoryPool::_malloc(&(index_max = len), sizeof(uint32_t));
+      }
+
+   if (buildIndex() == false) U_RETURN(false);
+
+   if (tape_max < (index_len * 2)) // NB: a string use two entries of the index and two words, a real one entry and two words...
+      {
+      if (tape) UMemoryPool::_free(tape, tape_max, sizeof(uint64_t));
+
+      tape = (uint64_t*) UMemoryPool::_malloc(&(tape_max = index_len * 2), sizeof(uint64_t));
+      }
+
+   if (buildTape()) U_RETURN(true);
+
+   tape_len = 0;
+
+   U_RETURN(false);
+}
+
+// stage 1: structural index
+
+U_NO_EXPORT bool UJsonTape::buildIndex()
+{
+   U_TRACE_NO_PARAM(0, "UJsonTape::buildIndex()")
+
+   u_json_block b;
+   char block[64];
+   const char* ptr = document.data();
+   uint32_t i, j, n = 0, len = document.size();
+   uint64_t carry, start_edges, even_start_mask, even_starts, odd_starts, even_carries, odd_carries, escaped, quote, in_string, string_tail, scalar, structural,
+            prev_escaped = 0, prev_in_string = 0, prev_scalar = 0, error = 0;
+
+   for (i = 0; i < len; i += 64)
+      {
+      if ((len - i) >= 64) u_json_classify(ptr+i, b);
+      else
+         {
+         (void) memset(block, ' ', sizeof(block));
+
+         U_MEMCPY(block, ptr+i, len-i);
+
+         u_json_classify(block, b);
+         }
+
+      // the chars escaped by an odd sequence of backslashes (@see https://github.com/simdjson/simdjson - find_odd_backslash_sequences())
+
+      start_edges     = b.backslash & ~(b.backslash << 1);
+      even_start_mask = U_JSON_EVEN_BITS ^ prev_escaped;
+      even_starts     = start_edges &  even_start_mask;
+      odd_starts      = start_edges & ~even_start_mask;
+      even_carries    = b.backslash + even_starts;
+      odd_carries     = b.backslash + odd_starts;
+      carry           = (odd_carries < b.backslash); // the block end with an odd sequence of backslashes
+
+      odd_carries |= prev_escaped;
+      prev_escaped = carry;
+
+      escaped = (( even_carries & ~b.backslash & ~U_JSON_EVEN_BITS) |
+                 (  odd_carries & ~b.backslash &  U_JSON_EVEN_BITS));
+
+      // the escape sequences are checked only for the blocks with backslashes
+
+      for (carry = escaped; carry; carry &= carry - 1)
+         {
+         j = i + __builtin_ctzll(carry);
+
+         if (j >= len) error = 1;
+         else
+            {
+            switch (ptr[j])
+               {
+               case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': break;
+
+               case 'u':
+                  {
+                  if ((len - j) <= 4              ||
+                      u__isxdigit(ptr[j+1]) == false ||
+                      u__isxdigit(ptr[j+2]) == false ||
+                      u__isxdigit(ptr[j+3]) == false ||
+                      u__isxdigit(ptr[j+4]) == false)
+                     {
+                     error = 1;
+                     }
+                  }
+               break;
+
+               default: error = 1;
+               }
+            }
+         }
+
+      // the strings: from the opening quote (included) to the closing quote (excluded)
+
+      quote          = b.quote & ~escaped;
+      in_string      = u_json_prefix_xor(quote) ^ prev_in_string;
+      prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+      error |= (b.control & in_string); // NB: the control chars must be escaped...
+
+      string_tail = in_string ^ quote;
+      b.op       &= ~in_string;
+      scalar      = ~(b.op | b.space | string_tail);
+      structural  = b.op | (scalar & ~((scalar << 1) | prev_scalar)) | (quote & ~in_string);
+      prev_scalar = scalar >> 63;
+
+      while (structural)
+         {
+         index[n++] = i + __builtin_ctzll(structural);
+
+         structural &= structural - 1;
+         }
+      }
+
+   index_len = n;
+
+   U_INTERNAL_DUMP("index_len = %u error = %#llx prev_in_string = %#llx", index_len, error, prev_in_string)
+
+   if (error          ||
+       prev_in_string || // NB: string not closed...
+       index_len == 0)
+      {
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+// stage 2: the grammar is validated and we write the tape
+
+U_NO_EXPORT bool UJsonTape::addNumber(const char* start, const char* end)
+{
+   U_TRACE(0, "UJsonTape::addNumber(%.*S,%p)", (int)U_min(end-start,32), start, end)
+
+   const char* s = start;
+   uint64_t integerPart = 0;
+   bool minus = (*s == '-'), integer = true;
+
+   if (minus &&
+       ++s >= end)
+      {
+      U_RETURN(false);
+      }
+
+   if (*s == '0') ++s; // NB: json numbers cannot have leading zeroes...
+   else
+      {
+      if (u__isdigit(*s) == false) U_RETURN(false);
+
+      do { integerPart = (integerPart << 3) + (integerPart << 1) + (*s - '0'); } while (++s < end && u__isdigit(*s));
+      }
+
+   if ((s - start - minus) > 10) integer = false; // NB: we check only the integers that can be 32 bit...
+
+   if (s < end &&
+       *s == '.')
+      {
+      integer = false;
+
+      if (++s >= end ||
+          u__isdigit(*s) == false)
+         {
+         U_RETURN(false);
+         }
+
+      while (++s < end && u__isdigit(*s)) {}
+      }
+
+   if (s < end &&
+       (*s | 0x20) == 'e') // scientific notation (Ex: 1.45e-10)
+      {
+      integer = false;
+
+      if (++s < end &&
+          u__issign(*s))
+         {
+         ++s;
+         }
+
+      if (s >= end ||
+          u__isdigit(*s) == false)
+         {
+         U_RETURN(false);
+         }
+
+      while (++s < end && u__isdigit(*s)) {}
+      }
+
+   if (s < end &&
+       u_json_terminator(*s) == false)
+      {
+      U_RETURN(false);
+      }
+
+   if (integer)
+      {
+      if (minus == false)
+         {
+         if (integerPart <= UINT_MAX) // UINT_MAX => 4294967295
+            {
+            tape[tape_len++] = getWord(U_UINT_VALUE, integerPart);
+
+            U_RETURN(true);
+            }
+         }
+      else if (integerPart <= 2147483648ULL) // INT_MIN => -2147483648
+         {
+         tape[tape_len++] = (integerPart ? getWord(U_INT_VALUE, (uint32_t)-(int64_t)integerPart)
+                                         : getWord(U_UINT_VALUE, 0)); // NB: -0 is 0 as in UValue...
+
+         U_RETURN(true);
+         }
+      }
+
+   tape[tape_len++] = getWord(U_REAL_VALUE, start - document.data());
+   tape[tape_len++] = s - start;
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT bool UJsonTape::buildTape()
+{
+   U_TRACE_NO_PARAM(0, "UJsonTape::buildTape()")
+
+   const char* s   = document.data();
+   const char* end = s + document.size();
+   uint32_t start, i = 0, depth = 0, stack[U_JSON_PARSE_STACK_SIZE]; // position on the tape of the open containers
+
+   tape_len = 0;
+
+value:
+   if (i >= index_len) U_RETURN(false);
+
+   start = index[i++];
+
+   U_INTERNAL_DUMP("value: i = %u depth = %u s[%u] = %C", i, depth, start, s[start])
+
+   switch (s[start])
+      {
+      case '{':
+         {
+         if (depth == U_JSON_PARSE_STACK_SIZE) U_RETURN(false);
+
+         stack[depth++] = tape_len;
+
+         tape[tape_len++] = getWord(U_OBJECT_VALUE, 0);
+
+         if (i < index_len &&
+             s[index[i]] == '}')
+            {
+            ++i;
+
+            goto close;
+            }
+         }
+      goto key;
+
+      case '[':
+         {
+         if (depth == U_JSON_PARSE_STACK_SIZE) U_RETURN(false);
+
+         stack[depth++] = tape_len;
+
+         tape[tape_len++] = getWord(U_ARRAY_VALUE, 0);
+
+         if (i < index_len &&
+             s[index[i]] == ']')
+            {
+            ++i;
+
+            goto close;
+            }
+         }
+      goto value;
+
+      case '"': // NB: the next entry of the index is the closing quote...
+         {
+         tape[tape_len++] = getWord(U_STRING_VALUE, start+1);
+         tape[tape_len++] = index[i++] - start - 1;
+         }
+      break;
+
+      case 't':
+         {
+         if ((end - (s+start)) < 4 ||
+             u_get_unalignedp32(s+start) != U_MULTICHAR_CONSTANT32('t','r','u','e') ||
+             ((s+start+4) < end && u_json_terminator(s[start+4]) == false))
+            {
+            U_RETURN(false);
+            }
+
+         tape[tape_len++] = getWord(U_TRUE_VALUE, 0);
+         }
+      break;
+
+      case 'f':
+         {
+         if ((end - (s+start)) < 5 ||
+             u_get_unalignedp32(s+start+1) != U_MULTICHAR_CONSTANT32('a','l','s','e') ||
+             ((s+start+5) < end && u_json_terminator(s[start+5]) == false))
+            {
+            U_RETURN(false);
+            }
+
+         tape[tape_len++] = getWord(U_FALSE_VALUE, 0);
+         }
+      break;
+
+      case 'n':
+         {
+         if ((end - (s+start)) < 4 ||
+             u_get_unalignedp32(s+start) != U_MULTICHAR_CONSTANT32('n','u','l','l') ||
+             ((s+start+4) < end && u_json_terminator(s[start+4]) == false))
+            {
+            U_RETURN(false);
+            }
+
+         tape[tape_len++] = getWord(U_NULL_VALUE, 0);
+         }
+      break;
+
+      default:
+         {
+         if (addNumber(s+start, end) == false) U_RETURN(false);
+         }
+      }
+
+next:
+   U_INTERNAL_DUMP("next: i = %u depth = %u", i, depth)
+
+   if (depth == 0)
+      {
+      if (i == index_len) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   if (i >= index_len) U_RETURN(false);
+
+   start = index[i++];
+
+   if (getWordTag(tape[stack[depth-1]]) == U_OBJECT_VALUE)
+      {
+      if (s[start] == ',') goto key;
+      if (s[start] != '}') U_RETURN(false);
+      }
+   else
+      {
+      if (s[start] == ',') goto value;
+      if (s[start] != ']') U_RETURN(false);
+      }
+
+close:
+   start = stack[--depth];
+
+   tape[start]     |= tape_len;
+   tape[tape_len++] = getWord(getWordTag(tape[start]) | U_JSON_TAPE_END, start);
+
+   goto next;
+
+key:
+   if ((i+2) >= index_len ||
+       s[start = index[i]] != '"')
+      {
+      U_RETURN(false);
+      }
+
+   tape[tape_len++] = getWord(U_STRING_VALUE, start+1);
+   tape[tape_len++] = index[i+1] - start - 1;
+
+   if (s[index[i+2]] != ':') U_RETURN(false);
+
+   i += 3;
+
+   goto value;
+}
+
+// CURSOR
+
+uint32_t UJsonTape::getSize(uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::getSize(%u)", pos)
+
+   uint32_t n = 0;
+   bool bobject = (getTag(pos) == U_OBJECT_VALUE);
+
+   for (pos = first(pos); pos != U_NOT_FOUND; pos = next(bobject ? value(pos) : pos)) ++n;
+
+   U_RETURN(n);
+}
+
+uint32_t UJsonTape::at(uint32_t pos, uint32_t idx) const
+{
+   U_TRACE(0, "UJsonTape::at(%u,%u)", pos, idx)
+
+   if (getTag(pos) == U_ARRAY_VALUE)
+      {
+      for (pos = first(pos); pos != U_NOT_FOUND; pos = next(pos))
+         {
+         if (idx-- == 0) U_RETURN(pos);
+         }
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+uint32_t UJsonTape::at(uint32_t pos, const char* key, uint32_t key_len) const
+{
+   U_TRACE(0, "UJsonTape::at(%u,%.*S,%u)", pos, key_len, key, key_len)
+
+   if (getTag(pos) == U_OBJECT_VALUE)
+      {
+      for (pos = first(pos); pos != U_NOT_FOUND; pos = next(value(pos)))
+         {
+         if (getLen(pos) == key_len &&
+             memcmp(getPtr(pos), key, key_len) == 0)
+            {
+            U_RETURN(value(pos));
+            }
+         }
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+int UJsonTape::getInt(uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::getInt(%u)", pos)
+
+   uint64_t word = tape[pos];
+
+   switch (getWordTag(word))
+      {
+      case U_INT_VALUE:
+      case U_UINT_VALUE: U_RETURN((int)(uint32_t)getWordPayload(word));
+      case U_REAL_VALUE: U_RETURN((int)getDouble(pos));
+      case U_TRUE_VALUE: U_RETURN(1);
+      }
+
+   U_RETURN(0);
+}
+
+unsigned UJsonTape::getUInt(uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::getUInt(%u)", pos)
+
+   uint64_t word = tape[pos];
+
+   switch (getWordTag(word))
+      {
+      case U_INT_VALUE:
+      case U_UINT_VALUE: U_RETURN((uint32_t)getWordPayload(word));
+      case U_REAL_VALUE: U_RETURN((unsigned)getDouble(pos));
+      case U_TRUE_VALUE: U_RETURN(1);
+      }
+
+   U_RETURN(0);
+}
+
+double UJsonTape::getDouble(uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::getDouble(%u)", pos)
+
+   uint64_t word = tape[pos];
+
+   switch (getWordTag(word))
+      {
+      case U_INT_VALUE:  U_RETURN((double)(int32_t)(uint32_t)getWordPayload(word));
+      case U_UINT_VALUE: U_RETURN((double)        (uint32_t)getWordPayload(word));
+      case U_REAL_VALUE: break;
+      default:           U_RETURN(0.0);
+      }
+
+   double val;
+   uint64_t integerPart = 0;
+   const char* start = getPtr(pos);
+   const char* s = start;
+   const char* end = s + getLen(pos);
+   bool minus = (*s == '-');
+   uint32_t c, exponent, significandDigit = 0;
+   int gexponent = 0;
+
+   if (minus) ++s;
+
+   for (; s < end && u__isdigit(*s); ++s)
+      {
+      c = *s - '0';
+
+      if ((integerPart | c) != 0 &&
+          ++significandDigit <= 19)
+         {
+         integerPart = (integerPart << 3) + (integerPart << 1) + c;
+         }
+      }
+
+   if (s < end &&
+       *s == '.')
+      {
+      while (++s < end && u__isdigit(*s))
+         {
+         c = *s - '0';
+
+         if ((integerPart | c) != 0 &&
+             ++significandDigit <= 19)
+            {
+            integerPart = (integerPart << 3) + (integerPart << 1) + c;
+            }
+
+         --gexponent;
+         }
+      }
+
+   if (s < end) // scientific notation (Ex: 1.45e-10)
+      {
+      bool eminus = (*++s == '-');
+
+      if (u__issign(*s)) ++s;
+
+      for (exponent = 0; s < end; ++s) if (exponent < 100000) exponent = (exponent * 10) + (*s - '0');
+
+      gexponent += (eminus ? -(int)exponent : (int)exponent);
+      }
+
+   U_INTERNAL_DUMP("integerPart = %llu significandDigit = %u gexponent = %d", integerPart, significandDigit, gexponent)
+
+   // Use fast path for string-to-double conversion if possible
+   // @see http://www.exploringbinary.com/fast-path-decimal-to-floating-point-conversion/
+
+   if (significandDigit <= 15 &&
+       gexponent >= -22       &&
+       gexponent <=  22)
+      {
+      val = (gexponent >= 0 ? (double)integerPart * u_pow10[ gexponent]
+                            : (double)integerPart / u_pow10[-gexponent]);
+
+      if (minus) val = -val;
+      }
+   else
+      {
+      char buffer[64];
+      uint32_t len = end - start;
+
+      if (len < sizeof(buffer))
+         {
+         U_MEMCPY(buffer, start, len);
+
+         buffer[len] = '\0';
+
+         val = ::strtod(buffer, U_NULLPTR);
+         }
+      else
+         {
+         UString tmp((void*)start, len);
+
+         val = ::strtod(tmp.c_str(), U_NULLPTR);
+         }
+      }
+
+   U_RETURN(val);
+}
+
+UString UJsonTape::getString(uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::getString(%u)", pos)
+
+   U_INTERNAL_ASSERT_EQUALS(getTag(pos), U_STRING_VALUE)
+
+   const char* ptr = getPtr(pos);
+   uint32_t    len = getLen(pos);
+
+   if (len &&
+       memchr(ptr, '\\', len))
+      {
+      UString str(len);
+
+      UEscape::decode(ptr, len, str);
+
+      U_RETURN_STRING(str);
+      }
+
+   UString str = document.substr(ptr, len);
+
+   U_RETURN_STRING(str);
+}
+
+U_NO_EXPORT void UJsonTape::stringify(char*& ptr, uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::stringify(%p,%u)", ptr, pos)
+
+   uint32_t len, elem;
+   uint64_t word = tape[pos];
+
+   switch (getWordTag(word))
+      {
+      case U_REAL_VALUE:
+         {
+         U_MEMCPY(ptr, getPtr(pos), len = getLen(pos));
+                  ptr +=                  len;
+         }
+      break;
+
+      case U_INT_VALUE:  ptr = u_num2str32s((int32_t)(uint32_t)getWordPayload(word), ptr); break;
+      case U_UINT_VALUE: ptr = u_num2str32(          (uint32_t)getWordPayload(word), ptr); break;
+
+      case U_TRUE_VALUE:
+         {
+         u_put_unalignedp32(ptr, U_MULTICHAR_CONSTANT32('t','r','u','e'));
+
+         ptr += U_CONSTANT_SIZE("true");
+         }
+      break;
+
+      case U_FALSE_VALUE:
+         {
+         u_put_unalignedp32(ptr, U_MULTICHAR_CONSTANT32('f','a','l','s'));
+
+         ptr[4] = 'e';
+         ptr   += U_CONSTANT_SIZE("false");
+         }
+      break;
+
+      case U_NULL_VALUE:
+         {
+         u_put_unalignedp32(ptr, U_MULTICHAR_CONSTANT32('n','u','l','l'));
+
+         ptr += U_CONSTANT_SIZE("null");
+         }
+      break;
+
+      case U_STRING_VALUE:
+         {
+         *ptr++ = '"';
+
+         U_MEMCPY(ptr, getPtr(pos), len = getLen(pos));
+                  ptr +=                  len;
+
+         *ptr++ = '"';
+         }
+      break;
+
+      case U_ARRAY_VALUE:
+         {
+         *ptr++ = '[';
+
+         for (elem = first(pos); elem != U_NOT_FOUND; elem = next(elem))
+            {
+            if (elem != pos+1) *ptr++ = ',';
+
+            stringify(ptr, elem);
+            }
+
+         *ptr++ = ']';
+         }
+      break;
+
+      case U_OBJECT_VALUE:
+         {
+         *ptr++ = '{';
+
+         for (elem = first(pos); elem != U_NOT_FOUND; elem = next(value(elem)))
+            {
+            if (elem != pos+1) *ptr++ = ',';
+
+            stringify(ptr, elem);
+
+            *ptr++ = ':';
+
+            stringify(ptr, value(elem));
+            }
+
+         *ptr++ = '}';
+         }
+      break;
+      }
+}
+
+void UJsonTape::stringify(UString& result, uint32_t pos) const
+{
+   U_TRACE(0, "UJsonTape::stringify(%V,%u)", result.rep, pos)
+
+   U_INTERNAL_ASSERT_MINOR(pos, tape_len)
+
+   (void) result.reserve(result.size() + document.size() + 32U); // NB: the minified json cannot be longer than the document...
+
+   char* ptr = result.pend();
+
+   stringify(ptr, pos);
+
+   result.size_adjust(ptr);
+
+   U_INTERNAL_DUMP("result(%u) = %V", result.size(), result.rep)
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UJsonTape::dump(bool _reset) const
+{
+   *UObjectIO::os << "tape                      " << (void*)tape      << '\n'
+                  << "index                     " << (void*)index     << '\n'
+                  << "tape_len                  " << tape_len         << '\n'
+                  << "tape_max                  " << tape_max         << '\n'
+                  << "index_len                 " << index_len        << '\n'
+                  << "index_max                 " << index_max        << '\n'
+                  << "document (UString         " << (void*)&document << ')';
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#endif
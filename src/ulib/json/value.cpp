@@ -21,6 +21,7 @@ char*                     UValue::pstringify;
 uint32_t                  UValue::size;
 UValue::jval              UValue::o;
 UValue::parser_stack_data UValue::sd[U_JSON_PARSE_STACK_SIZE];
+UJsonTape*                UValue::ptape;
 
 #ifdef DEBUG
 uint32_t UValue::cnt_real;
@@ -1443,6 +1444,138 @@ cdefault:
    U_RETURN(false);
 }
 
+// on demand (@see JSON_parse())
+
+uint64_t UValue::tapeToString(const UJsonTape& tape, uint32_t _pos)
+{
+   U_TRACE(0, "UValue::tapeToString(%p,%u)", &tape, _pos)
+
+   uint32_t sz = tape.getLen(_pos);
+
+   if (sz == 0)
+      {
+      UStringRep::string_rep_null->hold();
+
+      return getValue(U_STRING_VALUE, UStringRep::string_rep_null);
+      }
+
+   uint32_t type = U_STRING_VALUE;
+   const char* start = tape.getPtr(_pos);
+
+   if ((jsonParseFlags & CHECK_FOR_UTF) != 0)
+      {
+      for (uint32_t i = 0; i < sz; ++i)
+         {
+         if ((unsigned char)start[i] > 0x7F ||
+                            start[i] == '\\')
+            {
+            type = U_UTF_VALUE;
+
+            break;
+            }
+         }
+      }
+
+   UString str = tape.document.substr(start, sz); // NB: zero copy...
+
+   str.hold();
+
+   return getValue(type, str.rep);
+}
+
+uint64_t UValue::tapeToValue(const UJsonTape& tape, uint32_t _pos, int mode)
+{
+   U_TRACE(0, "UValue::tapeToValue(%p,%u,%d)", &tape, _pos, mode)
+
+   uint32_t elem;
+   union jval val;
+   UValue* tail = U_NULLPTR;
+   uint64_t word = tape.tape[_pos];
+   uint32_t type = UJsonTape::getWordTag(word);
+
+   switch (type)
+      {
+      case U_INT_VALUE:
+      case U_UINT_VALUE: return getValue(type, (void*)(long)UJsonTape::getWordPayload(word));
+
+      case U_TRUE_VALUE:
+      case U_FALSE_VALUE:
+      case U_NULL_VALUE: return getValue(type, U_NULLPTR);
+
+      case U_STRING_VALUE: return tapeToString(tape, _pos);
+
+      case U_REAL_VALUE:
+         {
+         val.real = tape.getDouble(_pos);
+
+         return val.ival;
+         }
+
+      case U_ARRAY_VALUE:
+         {
+         for (elem = tape.first(_pos); elem != U_NOT_FOUND; elem = tape.next(elem))
+            {
+            if (mode == 2 &&
+                tape.getTag(elem) == U_OBJECT_VALUE)
+               {
+               tail = insertAfter(tail, getValue(U_OBJECT_VALUE, U_NULLPTR));
+
+               tail->pkey.ival = getValue(U_OBJECT_VALUE, (void*)(long)elem);
+               }
+            else
+               {
+               tail = insertAfter(tail, tapeToValue(tape, elem, 0));
+
+               tail->pkey.ival = 0ULL;
+               }
+            }
+
+         return listToValue(U_ARRAY_VALUE, tail);
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(type, U_OBJECT_VALUE)
+
+   for (elem = tape.first(_pos); elem != U_NOT_FOUND; elem = tape.next(tape.value(elem)))
+      {
+      tail = insertAfter(tail, tapeToValue(tape, tape.value(elem), 0));
+
+      tail->pkey.ival = tapeToString(tape, elem);
+      }
+
+   return listToValue(U_OBJECT_VALUE, tail);
+}
+
+void UValue::setTape(uint32_t _pos, int mode)
+{
+   U_TRACE(0, "UValue::setTape(%u,%d)", _pos, mode)
+
+   U_INTERNAL_ASSERT_POINTER(ptape)
+
+   if (mode == 1 &&
+       ptape->getTag(_pos) == U_OBJECT_VALUE)
+      {
+      value.ival = getValue(U_OBJECT_VALUE, U_NULLPTR);
+       pkey.ival = getValue(U_OBJECT_VALUE, (void*)(long)_pos);
+
+      return;
+      }
+
+   value.ival = tapeToValue(*ptape, _pos, mode);
+    pkey.ival = 0ULL;
+}
+
+void UValue::fromTape(const UJsonTape& tape, uint32_t _pos)
+{
+   U_TRACE(0, "UValue::fromTape(%p,%u)", &tape, _pos)
+
+   clear();
+
+   size = tape.document.size();
+
+   value.ival = tapeToValue(tape, _pos, 0);
+}
+
 void UValue::nextParser()
 {
    U_TRACE_NO_PARAM(0, "UValue::nextParser()")
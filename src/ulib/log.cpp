@@ -13,6 +13,7 @@
 
 #include <ulib/date.h>
 #include <ulib/net/server/server.h>
+#include <ulib/utility/binary_access_log.h>
 
 #ifndef _MSWINDOWS_
 #  ifdef __clang__
@@ -44,6 +45,349 @@ ULog::log_date*   ULog::ptr_shared_date;
 pthread_rwlock_t* ULog::prwlock;
 #endif
 
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+#  include <ulib/thread.h>
+
+#  define U_LOG_ASYNC_INTERVAL 100 // ms, max time a record stay in the ring buffer (if the ring is not half full)
+
+/**
+ * The ring buffer of a log in async mode is a sequence of bytes with a single producer (the process that serve the requests) and a
+ * single consumer (the writer thread). head and tail are free running counters (the ring size is a power of 2), the producer copy the
+ * whole record and only after publish it moving head, so the consumer always find complete lines and write them (at most two iovec
+ * because the ring can wrap) with a single syscall. The producer never wait: if the record don't fit it is dropped and counted, and
+ * it wakes up the consumer (if it is sleeping) only when the ring is half full...
+ */
+
+class ULogWriter : public UThread {
+public:
+
+   ULogWriter(ULog* _plog, uint32_t sz) : UThread(PTHREAD_CREATE_JOINABLE)
+      {
+      U_TRACE(0, "ULogWriter::ULogWriter(%p,%u)", _plog, sz)
+
+      plog    = _plog;
+      size    = sz;
+      buffer  = UFile::mmap(&size, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
+      head    =
+      tail    =
+      dropped = 0;
+      pid     = u_pid;
+      bstop   =
+      bwait   = false;
+
+      U_INTERNAL_ASSERT_EQUALS(size, sz)
+
+      (void) U_SYSCALL(pthread_mutex_init, "%p,%p", &mutex, U_NULLPTR);
+      (void) U_SYSCALL(pthread_cond_init,  "%p,%p", &cond,  U_NULLPTR);
+      }
+
+   ~ULogWriter()
+      {
+      U_TRACE_NO_PARAM(0, "ULogWriter::~ULogWriter()")
+
+      if (buffer) UFile::munmap(buffer, size);
+
+      (void) U_SYSCALL(pthread_mutex_destroy, "%p", &mutex);
+      (void) U_SYSCALL(pthread_cond_destroy,  "%p", &cond);
+      }
+
+   bool push(const struct iovec* iov, int n) // producer
+      {
+      U_TRACE(0, "ULogWriter::push(%p,%d)", iov, n)
+
+      int i;
+      uint32_t len = 0, used = head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+
+      for (i = 0; i < n; ++i) len += iov[i].iov_len;
+
+      U_INTERNAL_DUMP("len = %u used = %u size = %u", len, used, size)
+
+      if (len > (size - used))
+         {
+         ++dropped;
+
+         wakeup();
+
+         U_RETURN(false);
+         }
+
+      uint32_t off = head & (size - 1), sz;
+
+      for (i = 0; i < n; ++i)
+         {
+         if ((sz = iov[i].iov_len))
+            {
+            const char* ptr = (const char*)iov[i].iov_base;
+
+            if ((off + sz) <= size)
+               {
+               U_MEMCPY(buffer + off, ptr, sz);
+               }
+            else
+               {
+               uint32_t sz1 = size - off;
+
+               U_MEMCPY(buffer + off, ptr,       sz1);
+               U_MEMCPY(buffer,       ptr + sz1, sz - sz1);
+               }
+
+            off = (off + sz) & (size - 1);
+            }
+         }
+
+      __atomic_store_n(&head, head + len, __ATOMIC_RELEASE);
+
+      if ((used + len) >= (size / 2)) wakeup(); // NB: the ring is half full...
+
+      U_RETURN(true);
+      }
+
+   void drain() // consumer
+      {
+      U_TRACE_NO_PARAM(0, "ULogWriter::drain()")
+
+      uint32_t _tail = tail, len = __atomic_load_n(&head, __ATOMIC_ACQUIRE) - _tail, n,
+               max_batch = (plog->log_file_sz ? plog->log_file_sz / 4 : size); // NB: with the memory mapped log a batch must fit in the file...
+
+      U_INTERNAL_DUMP("len = %u max_batch = %u", len, max_batch)
+
+      while (len)
+         {
+         n = (len <= max_batch ? len : plog->binary ? getEndOfLastRecord(_tail, max_batch) : getEndOfLastLine(_tail, max_batch));
+
+         uint32_t off = _tail & (size - 1), n1 = U_min(n, size - off);
+
+         struct iovec iov[2] = { { (caddr_t)buffer + off, n1 },
+                                 { (caddr_t)buffer,       n - n1 } };
+
+         plog->writeInternal(iov, (n > n1 ? 2 : 1), true);
+
+         if (plog->binary &&
+             plog->log_file_sz)
+            {
+            plog->binary->written(iov, (n > n1 ? 2 : 1)); // NB: the state of the segment of the records written, to resume it after the rotation...
+            }
+
+         _tail += n;
+           len -= n;
+
+         __atomic_store_n(&tail, _tail, __ATOMIC_RELEASE); // NB: from now the producer can reuse the space...
+         }
+      }
+
+   virtual void run() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "ULogWriter::run()")
+
+      bool _stop;
+      struct timespec ts;
+
+      do {
+         UThread::lock(&mutex);
+
+         __atomic_store_n(&bwait, true, __ATOMIC_SEQ_CST);
+
+         if (bstop == false &&
+             (__atomic_load_n(&head, __ATOMIC_SEQ_CST) - tail) < (size / 2)) // NB: the producer can have missed bwait...
+            {
+            (void) U_SYSCALL(clock_gettime, "%d,%p", CLOCK_REALTIME, &ts);
+
+            ts.tv_nsec += U_LOG_ASYNC_INTERVAL * 1000000L;
+
+            if (ts.tv_nsec >= 1000000000L)
+               {
+               ts.tv_sec  += 1;
+               ts.tv_nsec -= 1000000000L;
+               }
+
+            (void) U_SYSCALL(pthread_cond_timedwait, "%p,%p,%p", &cond, &mutex, &ts);
+            }
+
+         _stop = bstop;
+
+         __atomic_store_n(&bwait, false, __ATOMIC_RELAXED);
+
+         UThread::unlock(&mutex);
+
+         drain();
+         }
+      while (_stop == false);
+      }
+
+   void stop()
+      {
+      U_TRACE_NO_PARAM(0, "ULogWriter::stop()")
+
+      pthread_t _tid = tid; // NB: it is reset by UThread::close() when run() return...
+
+      UThread::lock(&mutex);
+
+      bstop = true;
+
+      UThread::signal(&cond);
+      UThread::unlock(&mutex);
+
+      if (_tid) (void) U_SYSCALL(pthread_join, "%p,%p", _tid, U_NULLPTR);
+
+      drain(); // NB: the records written after the last drain of the thread...
+      }
+
+   ULog* plog;
+   char* buffer;
+   uint32_t size, head, dropped; // written by the producer
+   pid_t pid;
+   char pad[64];                 // NB: to avoid false sharing between producer and consumer...
+   uint32_t tail;                // written by the consumer
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+   bool bstop, bwait;            // bwait: the writer thread is (or it is going to be) sleeping
+
+protected:
+   void wakeup() // producer
+      {
+      U_TRACE_NO_PARAM(0, "ULogWriter::wakeup()")
+
+      __atomic_thread_fence(__ATOMIC_SEQ_CST); // NB: the store of head must be visible before the load of bwait...
+
+      if (__atomic_load_n(&bwait, __ATOMIC_SEQ_CST))
+         {
+         UThread::lock(&mutex);
+         UThread::signal(&cond);
+         UThread::unlock(&mutex);
+         }
+      }
+
+   uint32_t getEndOfLastLine(uint32_t from, uint32_t n)
+      {
+      U_TRACE(0, "ULogWriter::getEndOfLastLine(%u,%u)", from, n)
+
+      const char* ptr;
+      uint32_t off = from & (size - 1), n1 = U_min(n, size - off);
+
+      if (n > n1 &&
+          (ptr = (const char*)memrchr(buffer, '\n', n - n1)))
+         {
+         U_RETURN(n1 + (ptr - buffer) + 1);
+         }
+
+      if ((ptr = (const char*)memrchr(buffer + off, '\n', n1))) U_RETURN(ptr - (buffer + off) + 1);
+
+      U_RETURN(n); // NB: a single record greater than the batch...
+      }
+
+   uint32_t getEndOfLastRecord(uint32_t from, uint32_t n)
+      {
+      U_TRACE(0, "ULogWriter::getEndOfLastRecord(%u,%u)", from, n)
+
+      // NB: the batch starts with a record (MAGIC - type - varint length - body) and the ring buffer contains only whole records...
+
+      unsigned char c;
+      uint32_t pos, len, shift, end = 0;
+
+      while (true)
+         {
+         pos = end + 2;
+
+         for (len = shift = 0; shift < 35; shift += 7)
+            {
+            c = buffer[(from + pos++) & (size - 1)];
+
+            len |= (uint32_t)(c & 0x7F) << shift;
+
+            if ((c & 0x80) == 0) break;
+            }
+
+         if ((pos + len) > n) break;
+
+         end = pos + len;
+         }
+
+      if (end == 0) U_RETURN(pos + len); // NB: a single record greater than the batch...
+
+      U_RETURN(end);
+      }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(ULogWriter)
+};
+
+bool ULog::startAsync()
+{
+   U_TRACE_NO_PARAM(0, "ULog::startAsync()")
+
+   U_INTERNAL_DUMP("async_sz = %u pwriter = %p", async_sz, pwriter)
+
+   if (async_sz == 0) U_RETURN(false);
+
+   if (pwriter) // NB: we are a new child, the writer thread of the parent don't exist here...
+      {
+      U_INTERNAL_ASSERT_DIFFERS(pwriter->pid, u_pid)
+
+      pwriter = U_NULLPTR;
+      }
+
+   uint32_t sz = (uint32_t) u_nextPowerOfTwo(async_sz < PAGESIZE ? PAGESIZE : async_sz);
+
+   if (binary &&
+       log_file_sz)
+      {
+      binary->setWriter(log_file_sz); // NB: the buffer for the state of the segment must be allocated before the start of the thread...
+      }
+
+   U_NEW(ULogWriter, pwriter, ULogWriter(this, sz));
+
+   if (pwriter->buffer == (char*)MAP_FAILED)
+      {
+      pwriter->buffer = U_NULLPTR;
+
+      goto err;
+      }
+
+   if (pwriter->start() == false)
+      {
+err:  delete pwriter;
+             pwriter = U_NULLPTR;
+
+      U_SRV_LOG("WARNING: I can't start the writer thread of log %.*S, the records will be written synchronously", U_FILE_TO_TRACE(*this));
+
+      U_RETURN(false);
+      }
+
+   U_SRV_LOG("Async write of log %.*S activated (ring buffer of %u KB)", U_FILE_TO_TRACE(*this), sz / 1024);
+
+   U_RETURN(true);
+}
+
+void ULog::stopAsync()
+{
+   U_TRACE_NO_PARAM(0, "ULog::stopAsync()")
+
+   U_INTERNAL_ASSERT_POINTER(pwriter)
+
+   ULogWriter* _pwriter = pwriter;
+                          pwriter = U_NULLPTR;
+
+   if (_pwriter->pid != u_pid) return; // NB: we are a process created by fork(), the writer thread don't exist here...
+
+   _pwriter->stop();
+
+   uint32_t dropped = _pwriter->dropped;
+
+   if (dropped) U_SRV_LOG("WARNING: the ring buffer of log %.*S was full, %u records dropped since start", U_FILE_TO_TRACE(*this), dropped);
+
+   delete _pwriter;
+}
+
+__pure uint32_t ULog::getDroppedRecords() const
+{
+   U_TRACE_NO_PARAM(0, "ULog::getDroppedRecords()")
+
+   if (pwriter) U_RETURN(pwriter->dropped);
+
+   U_RETURN(0);
+}
+#endif
+
 ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
 {
    U_TRACE_REGISTER_OBJECT(0, ULog, "%V,%u", path.rep, _size)
@@ -60,7 +404,9 @@ ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
 #endif
 
    log_file_sz  =
-   log_gzip_sz  = 0;
+   log_gzip_sz  =
+   nrotate      = 0;
+   binary       = U_NULLPTR;
    ptr_log_data = U_NULLPTR;
 
    U_Log_syslog(this)         =
@@ -71,6 +417,12 @@ ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
    index_path_compress = 0;
 #endif
 
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   pwriter        = U_NULLPTR;
+   async_sz       =
+   dropped_logged = 0;
+#endif
+
    if (UFile::getPath().equal(U_CONSTANT_TO_PARAM("syslog")))
       {
       U_Log_syslog(this) = true;
@@ -94,6 +446,7 @@ ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
     *  uint32_t file_ptr;
     *  uint32_t file_page;
     *  uint32_t gzip_len;
+    *  uint32_t nrotate;
     *  sem_t lock_shared;
     *  // --------------> maybe unnamed array of char for gzip compression...
     * } log_data;
@@ -103,6 +456,7 @@ ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
 
    ptr_log_data->file_ptr = 0;
    ptr_log_data->gzip_len = 0;
+   ptr_log_data->nrotate  = 0;
 
    if (_size)
       {
@@ -438,7 +792,35 @@ void ULog::updateDate3(char* ptr_date)
 
 void ULog::write(const struct iovec* iov, int n)
 {
-   U_TRACE(1+256, "ULog::write(%p,%d)", iov, n)
+   U_TRACE(0, "ULog::write(%p,%d)", iov, n)
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   // NB: a process created by fork() (parallelization, classic model, ...) don't have the writer thread...
+
+   if (pwriter &&
+       pwriter->pid == u_pid)
+      {
+      if (pwriter->push(iov, n) == false) return;
+
+      uint32_t dropped = getDroppedRecords();
+
+      if (dropped != dropped_logged)
+         {
+         U_SRV_LOG("WARNING: the ring buffer of log %.*S was full, %u records dropped (%u since start)", U_FILE_TO_TRACE(*this), dropped - dropped_logged, dropped);
+
+         dropped_logged = dropped;
+         }
+
+      return;
+      }
+#endif
+
+   writeInternal(iov, n);
+}
+
+void ULog::writeInternal(const struct iovec* iov, int n, bool bwriter)
+{
+   U_TRACE(1+256, "ULog::writeInternal(%p,%d,%b)", iov, n, bwriter)
 
    U_INTERNAL_ASSERT_EQUALS(U_Log_syslog(this), false)
 
@@ -449,59 +831,98 @@ void ULog::write(const struct iovec* iov, int n)
       return;
       }
 
-   int len;
+   int i, len;
    const char* ptr;
-   uint32_t file_ptr;
+   const char* resume = U_NULLPTR;
+   uint32_t file_ptr, resume_len = 0, total = 0;
 
-   U_INTERNAL_DUMP("UFile::map = %p ptr_log_data->file_ptr = %u log_file_sz = %u", UFile::map, ptr_log_data->file_ptr, log_file_sz)
+   for (i = 0; i < n; ++i) total += iov[i].iov_len;
+
+   U_INTERNAL_DUMP("UFile::map = %p ptr_log_data->file_ptr = %u log_file_sz = %u total = %u", UFile::map, ptr_log_data->file_ptr, log_file_sz, total)
+
+   U_INTERNAL_ASSERT_MINOR(total, log_file_sz)
 
    lock();
 
    file_ptr = ptr_log_data->file_ptr;
 
-   for (int i = 0; i < n; ++i)
+   /**
+    * NB: with the binary format the records of a process refer to the start of its segment (time, dictionary). If they go in a file
+    * different from the one of the last write of this process (a rotation made by us now or by an other process) we write before them
+    * the state of the segment, so that every file is decoded on its own...
+    */
+
+   if (binary &&
+       (nrotate != ptr_log_data->nrotate ||
+        (file_ptr+total) > log_file_sz))
       {
-      if ((len = iov[i].iov_len))
+      resume = binary->getResume(iov, bwriter, resume_len); // NB: not pwriter, it is reset by stopAsync() before the last drain of the thread...
+
+      if ((total + resume_len) >= log_file_sz) resume_len = 0; // NB: the dictionary is too big for the file, the records wait the next segment...
+
+      total += resume_len;
+      }
+
+   if ((file_ptr+total) > log_file_sz) // if overwrite log file we compress it as gzip (NB: we check the whole record, so it is never split between two files)...
+      {
+#  ifdef USE_LIBZ
+      U_INTERNAL_DUMP("UFile::st_size = %u log_gzip_sz = %u", UFile::st_size, log_gzip_sz)
+
+      U_INTERNAL_ASSERT_MAJOR(file_ptr, 0)
+      U_INTERNAL_ASSERT(file_ptr <= UFile::st_size)
+
+      // NB: the shared area to compress log data may be not available at this time... (Ex: startup plugin u_server)
+
+      if (file_ptr <= log_gzip_sz)
          {
-         ptr = (const char*)iov[i].iov_base;
+         checkForLogRotateDataToWrite(); // check if there are previous data to write
 
-      // U_INTERNAL_DUMP("iov[%d](%u) -> %.*S", i, len, len, ptr)
+         ptr_log_data->gzip_len = u_gz_deflate(UFile::map, file_ptr, (char*)ptr_log_data+sizeof(log_data), true);
 
-         if ((file_ptr+len) > log_file_sz) // if overwrite log file we compress it as gzip...
-            {
-#        ifdef USE_LIBZ
-            U_INTERNAL_DUMP("UFile::st_size = %u log_gzip_sz = %u", UFile::st_size, log_gzip_sz)
+         U_INTERNAL_DUMP("u_gz_deflate(%u) = %u", file_ptr, ptr_log_data->gzip_len)
+         }
+      else if (buf_path_compress)
+         {
+         U_INTERNAL_ASSERT_EQUALS(ptr_log_data->gzip_len, 0)
 
-            U_INTERNAL_ASSERT_MAJOR(file_ptr, 0)
-            U_INTERNAL_ASSERT(file_ptr <= UFile::st_size)
+         // NB: not UStringExt::deflate(), it compress in the free area of UFile without the lock of the memory pool (we can be the writer thread)...
 
-            // NB: the shared area to compress log data may be not available at this time... (Ex: startup plugin u_server)
+         uint32_t sz = file_ptr + (file_ptr / 10) + 12U;
+         char* data_to_write = (char*) UMemoryPool::_malloc(&sz);
+         uint32_t gzip_len = u_gz_deflate(UFile::map, file_ptr, data_to_write, true);
 
-            if (file_ptr <= log_gzip_sz)
-               {
-               checkForLogRotateDataToWrite(); // check if there are previous data to write
+         char* ptr1 = buf_path_compress->c_pointer(index_path_compress);
 
-               ptr_log_data->gzip_len = u_gz_deflate(UFile::map, file_ptr, (char*)ptr_log_data+sizeof(log_data), true);
+         ptr1[u__snprintf(ptr1, 17, U_CONSTANT_TO_PARAM("%4D"))] = '.';
 
-               U_INTERNAL_DUMP("u_gz_deflate(%u) = %u", file_ptr, ptr_log_data->gzip_len)
-               }
-            else if (buf_path_compress)
-               {
-               U_INTERNAL_ASSERT_EQUALS(ptr_log_data->gzip_len, 0)
+         (void) UFile::writeTo(*buf_path_compress, data_to_write, gzip_len, O_RDWR | O_EXCL, false);
 
-               UString data_to_write = UStringExt::deflate(UFile::map, file_ptr, 1);
+         UMemoryPool::_free(data_to_write, sz);
+         }
+#  endif
 
-               char* ptr1 = buf_path_compress->c_pointer(index_path_compress);
+                    file_ptr  =
+      ptr_log_data->file_page = 0;
 
-               ptr1[u__snprintf(ptr1, 17, U_CONSTANT_TO_PARAM("%4D"))] = '.';
+      ptr_log_data->nrotate++;
+      }
 
-               (void) UFile::writeTo(*buf_path_compress, data_to_write, O_RDWR | O_EXCL, false);
-               }
-#        endif
+   nrotate = ptr_log_data->nrotate;
 
-                          file_ptr  =
-            ptr_log_data->file_page = 0;
-            }
+   if (resume_len)
+      {
+      U_MEMCPY(UFile::map + file_ptr, resume, resume_len);
+
+      file_ptr += resume_len;
+      }
+
+   for (i = 0; i < n; ++i)
+      {
+      if ((len = iov[i].iov_len))
+         {
+         ptr = (const char*)iov[i].iov_base;
+
+      // U_INTERNAL_DUMP("iov[%d](%u) -> %.*S", i, len, len, ptr)
 
          if (len == 1) UFile::map[file_ptr++] = *ptr;
          else
@@ -563,7 +984,7 @@ void ULog::write(const char* msg, uint32_t len)
 
    updateDate1();
 
-   write(iov_vec, 5);
+   writeInternal(iov_vec, 5);
 
    if (prefix_len) iov_vec[2].iov_len = 0;
 }
@@ -814,6 +1235,10 @@ void ULog::closeLogInternal()
 {
    U_TRACE_NO_PARAM(1, "ULog::closeLogInternal()")
 
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   if (pwriter) stopAsync(); // NB: we write the records that are still in the ring buffer...
+#endif
+
    if (U_Log_start_stop_msg(this)) log(U_CONSTANT_TO_PARAM(U_FMT_START_STOP), "SHUTDOWN", sizeof(void*) * 8);
 
    if (U_Log_syslog(this))
@@ -950,6 +1375,7 @@ void ULog::setShared(log_data* ptr)
 
    ptr->file_ptr  = ptr_log_data->file_ptr;
    ptr->file_page = ptr_log_data->file_page;
+   ptr->nrotate   = ptr_log_data->nrotate;
 
    U_FREE_TYPE(ptr_log_data, log_data);
 
@@ -1019,6 +1445,10 @@ const char* ULog::dump(bool _reset) const
                   << "prefix_len                " << prefix_len    << '\n'
                   << "log_file_sz               " << log_file_sz   << '\n'
                   << "log_gzip_sz               " << log_gzip_sz   << '\n'
+#              if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+                  << "async_sz                  " << async_sz       << '\n'
+                  << "pwriter                   " << (void*)pwriter << '\n'
+#              endif
                   << "_lock     (ULock          " << (void*)&_lock << ')';
 
    if (_reset)
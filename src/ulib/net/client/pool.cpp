@@ -0,0 +1,364 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    pool.cpp - pool of keep-alive connections to the backends
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/net/client/pool.h>
+
+UClientPool_Base::UClientPoolBackend::UClientPoolBackend(uint32_t max_idle)
+{
+   U_TRACE_REGISTER_OBJECT(0, UClientPoolBackend, "%u", max_idle)
+
+   nidle = nactive = 0;
+
+   idle     = (UClient_Base**) UMemoryPool::_malloc((nslot = max_idle + 1), sizeof(UClient_Base*));
+   last_use = (long*)          UMemoryPool::_malloc( nslot,                 sizeof(long));
+}
+
+UClientPool_Base::UClientPoolBackend::~UClientPoolBackend()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UClientPoolBackend)
+
+   U_INTERNAL_ASSERT_EQUALS(nidle, 0)
+
+   UMemoryPool::_free(idle,     nslot, sizeof(UClient_Base*));
+   UMemoryPool::_free(last_use, nslot, sizeof(long));
+}
+
+UClientPool_Base::UClientPool_Base(uint32_t _max_conn, uint32_t _max_idle, uint32_t _idle_timeout) : UEventTime(0L, 1L)
+{
+   U_TRACE_REGISTER_OBJECT(0, UClientPool_Base, "%u,%u,%u", _max_conn, _max_idle, _idle_timeout)
+
+   max_conn     = _max_conn;
+   max_idle     = _max_idle;
+   idle_timeout = _idle_timeout;
+
+   hits = misses = full = errors = closed = wait_usec = 0;
+}
+
+UClientPool_Base::~UClientPool_Base()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UClientPool_Base)
+
+   U_INTERNAL_ASSERT(table.empty())
+
+   UTimer::erase(this);
+}
+
+void UClientPool_Base::setHealthCheck(uint32_t sec)
+{
+   U_TRACE(0, "UClientPool_Base::setHealthCheck(%u)", sec)
+
+   UTimer::erase(this);
+
+   if (sec)
+      {
+      UTimeVal::set(sec);
+
+      UTimer::insert(this);
+      }
+}
+
+U_NO_EXPORT UClientPool_Base::UClientPoolBackend* UClientPool_Base::getBackend(const UString& host, unsigned int port, bool binsert)
+{
+   U_TRACE(0, "UClientPool_Base::getBackend(%V,%u,%b)", host.rep, port, binsert)
+
+   char buffer[U_PATH_MAX];
+   uint32_t len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("%v:%u"), host.rep, port);
+
+   UClientPoolBackend* backend = table.at(buffer, len);
+
+   if (backend == U_NULLPTR &&
+       binsert)
+      {
+      U_NEW(UClientPoolBackend, backend, UClientPoolBackend(max_idle));
+
+      table.insert(UString((const void*)buffer, len), backend);
+      }
+
+   U_RETURN_POINTER(backend, UClientPoolBackend);
+}
+
+// NB: a connection that we keep must be still open and without data not read (Ex: a reply arrived after a timeout)...
+
+U_NO_EXPORT bool UClientPool_Base::isAlive(UClient_Base* client)
+{
+   U_TRACE(0, "UClientPool_Base::isAlive(%p)", client)
+
+   if (client->isConnected() == false) U_RETURN(false);
+
+#ifdef MSG_DONTWAIT
+   char c;
+
+   if (U_SYSCALL(recv, "%d,%p,%u,%d", client->getFd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) != -1 || // 0 => closed by the peer
+       errno != EAGAIN)
+      {
+      U_RETURN(false);
+      }
+#endif
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT void UClientPool_Base::closeConnection(UClient_Base* client)
+{
+   U_TRACE(0, "UClientPool_Base::closeConnection(%p)", client)
+
+   ++closed;
+
+   destroy(client);
+}
+
+UClient_Base* UClientPool_Base::acquireConnection(const UString& host, unsigned int port)
+{
+   U_TRACE(0, "UClientPool_Base::acquireConnection(%V,%u)", host.rep, port)
+
+   UClient_Base* client;
+   struct timeval start, end;
+
+   u_gettimeofday(&start);
+
+   UClientPoolBackend* backend = getBackend(host, port, true);
+
+   U_INTERNAL_DUMP("nidle = %u nactive = %u", backend->nidle, backend->nactive)
+
+   while (backend->nidle)
+      {
+      client = backend->idle[--backend->nidle];
+
+      if (isAlive(client))
+         {
+         ++hits;
+
+         goto next;
+         }
+
+      closeConnection(client);
+      }
+
+   // NB: here there are not idle connections, so nactive is the number of all the connections to the backend...
+
+   if (max_conn &&
+       backend->nactive >= max_conn)
+      {
+      ++full;
+
+      client = U_NULLPTR;
+
+      goto end;
+      }
+
+   if ((client = create(host, port)) == U_NULLPTR)
+      {
+      ++errors;
+
+      goto end;
+      }
+
+   ++misses;
+
+next:
+   ++backend->nactive;
+
+end:
+   u_gettimeofday(&end);
+
+   wait_usec += (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_usec - start.tv_usec);
+
+   U_RETURN_POINTER(client, UClient_Base);
+}
+
+void UClientPool_Base::releaseConnection(UClient_Base* client, bool bkeep)
+{
+   U_TRACE(0, "UClientPool_Base::releaseConnection(%p,%b)", client, bkeep)
+
+   U_INTERNAL_ASSERT_POINTER(client)
+
+   UClientPoolBackend* backend = getBackend(client->getServer(), client->getPort(), false);
+
+   if (backend == U_NULLPTR) // NB: the pool was cleared while the connection was in use...
+      {
+      closeConnection(client);
+
+      return;
+      }
+
+   U_INTERNAL_ASSERT_MAJOR(backend->nactive, 0)
+
+   --backend->nactive;
+
+   if (bkeep                                 &&
+       backend->nidle < max_idle             &&
+       backend->nidle < backend->nslot       &&
+       client->isConnected())
+      {
+      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+      backend->last_use[backend->nidle] = u_now->tv_sec;
+      backend->idle[    backend->nidle] = client;
+
+      ++backend->nidle;
+
+      return;
+      }
+
+   closeConnection(client);
+}
+
+void UClientPool_Base::clear()
+{
+   U_TRACE_NO_PARAM(0, "UClientPool_Base::clear()")
+
+   if (table.first())
+      {
+      do {
+         UClientPoolBackend* backend = table.elem();
+
+         while (backend->nidle) closeConnection(backend->idle[--backend->nidle]);
+         }
+      while (table.next());
+      }
+
+   table.clear();
+}
+
+// health check of the idle connections
+
+int UClientPool_Base::handlerTime()
+{
+   U_TRACE_NO_PARAM(0, "UClientPool_Base::handlerTime()")
+
+   U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+   long limit = u_now->tv_sec - idle_timeout;
+
+   if (table.first())
+      {
+      do {
+         UClient_Base* client;
+         uint32_t i, n = 0;
+         UClientPoolBackend* backend = table.elem();
+
+         for (i = 0; i < backend->nidle; ++i)
+            {
+            client = backend->idle[i];
+
+            if ((idle_timeout &&
+                 backend->last_use[i] <= limit) ||
+                isAlive(client) == false)
+               {
+               closeConnection(client);
+
+               continue;
+               }
+
+            backend->last_use[n] = backend->last_use[i];
+            backend->idle[    n] = client;
+
+            ++n;
+            }
+
+         backend->nidle = n;
+         }
+      while (table.next());
+      }
+
+   U_RETURN(0); // monitoring
+}
+
+void UClientPool_Base::getStatistics(stats& s)
+{
+   U_TRACE(0, "UClientPool_Base::getStatistics(%p)", &s)
+
+   s.hits      = hits;
+   s.misses    = misses;
+   s.full      = full;
+   s.errors    = errors;
+   s.closed    = closed;
+   s.wait_usec = wait_usec;
+   s.active    =
+   s.idle      = 0;
+
+   if (table.first())
+      {
+      do {
+         UClientPoolBackend* backend = table.elem();
+
+         s.active += backend->nactive;
+         s.idle   += backend->nidle;
+         }
+      while (table.next());
+      }
+}
+
+UString UClientPool_Base::getStatistics()
+{
+   U_TRACE_NO_PARAM(0, "UClientPool_Base::getStatistics()")
+
+   stats s;
+
+   getStatistics(s);
+
+   UString result(200U);
+
+   result.snprintf(U_CONSTANT_TO_PARAM("hits %llu misses %llu full %llu errors %llu closed %llu wait_usec %llu active %u idle %u"),
+                   s.hits, s.misses, s.full, s.errors, s.closed, s.wait_usec, s.active, s.idle);
+
+   U_RETURN_STRING(result);
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UClientPool_Base::UClientPoolBackend::dump(bool _reset) const
+{
+   *UObjectIO::os << "idle                                " << (void*)idle     << '\n'
+                  << "nidle                               " << nidle           << '\n'
+                  << "nslot                               " << nslot           << '\n'
+                  << "nactive                             " << nactive         << '\n'
+                  << "last_use                            " << (void*)last_use;
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
+const char* UClientPool_Base::dump(bool _reset) const
+{
+   UEventTime::dump(false);
+
+   *UObjectIO::os << '\n'
+                  << "hits                                " << hits         << '\n'
+                  << "full                                " << full         << '\n'
+                  << "misses                              " << misses       << '\n'
+                  << "errors                              " << errors       << '\n'
+                  << "closed                              " << closed       << '\n'
+                  << "max_conn                            " << max_conn     << '\n'
+                  << "max_idle                            " << max_idle     << '\n'
+                  << "wait_usec                           " << wait_usec    << '\n'
+                  << "idle_timeout                        " << idle_timeout << '\n'
+                  << "table          (UHashMap            " << (void*)&table << ')';
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#endif
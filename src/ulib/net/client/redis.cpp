@@ -43,18 +43,6 @@ bool UREDISClient_Base::connect(const char* phost, unsigned int _port)
    if (UClient_Base::setHostPort(host, _port) &&
        UClient_Base::connect())
       {
-      UClient_Base::iovcnt = 4;
-
-      UClient_Base::iov[1].iov_base =
-      UClient_Base::iov[4].iov_base = (caddr_t)" ";
-      UClient_Base::iov[1].iov_len  =
-      UClient_Base::iov[4].iov_len  = 1;
-
-      UClient_Base::iov[3].iov_base =
-      UClient_Base::iov[5].iov_base = (caddr_t)U_CRLF;
-      UClient_Base::iov[3].iov_len  =
-      UClient_Base::iov[5].iov_len  = 2;
-
       U_DUMP("getRedisVersion() = %V", getRedisVersion().rep)
 
       U_RETURN(true);
@@ -321,9 +309,340 @@ bool UREDISClient_Base::processRequest(char recvtype, const char* p1, uint32_t l
    U_RETURN(false);
 }
 
+// PIPELINE
+
+UREDISPipeline::~UREDISPipeline()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UREDISPipeline)
+
+   if (isRunning()) // NB: still waiting for the replies of execAsync()...
+      {
+      func = U_NULLPTR;
+
+      UNotifier::handlerDelete((UEventFd*)this);
+      }
+}
+
+void UREDISPipeline::command(const char* p1, uint32_t len1, const char* p2, uint32_t len2, const char* p3, uint32_t len3)
+{
+   U_TRACE(0, "UREDISPipeline::command(%.*S,%u,%.*S,%u,%.*S,%u)", len1, p1, len1, len2, p2, len2, len3, p3, len3)
+
+   (void) buffer.append(p1, len1);
+
+   if (p2)
+      {
+      buffer.push_back(' ');
+
+      (void) buffer.append(p2, len2);
+      }
+
+   if (p3)
+      {
+      buffer.push_back(' ');
+
+      (void) buffer.append(p3, len3);
+      }
+
+   (void) buffer.append(U_CONSTANT_TO_PARAM(U_CRLF));
+
+   ++nqueued;
+}
+
+void UREDISPipeline::clear()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::clear()")
+
+   U_INTERNAL_ASSERT_EQUALS(nsent, 0)
+
+   buffer.setBuffer(U_CAPACITY);
+    vtype.setBuffer(U_CAPACITY);
+    vitem.clear();
+
+   nqueued = 0;
+}
+
+U_NO_EXPORT bool UREDISPipeline::send()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::send()")
+
+   U_INTERNAL_ASSERT_EQUALS(nsent, 0)
+   U_INTERNAL_ASSERT_EQUALS(client->iovcnt, 4)
+
+   vtype.setBuffer(U_CAPACITY);
+   vitem.clear();
+
+   if (nqueued == 0) U_RETURN(false);
+
+   // NB: all the queued commands with one writev()...
+
+   client->iovcnt = 1;
+
+   client->iov[0].iov_base = (caddr_t)buffer.data();
+   client->iov[0].iov_len  =          buffer.size();
+
+   client->response.setBuffer(U_CAPACITY);
+
+   bool result = client->sendRequest(false);
+
+   client->iovcnt = 4;
+
+   if (result)
+      {
+      nsent  = nqueued;
+      nreply = offset = 0;
+      }
+
+   buffer.setEmpty();
+
+   nqueued = 0;
+
+   U_RETURN(result);
+}
+
+// NB: return the pointer after the reply that start at ptr or U_NULLPTR if the reply is not complete...
+
+U_NO_EXPORT const char* UREDISPipeline::skipResponseItem(const char* ptr, const char* end)
+{
+   U_TRACE(0, "UREDISPipeline::skipResponseItem(%p,%p)", ptr, end)
+
+   if (ptr >= end) U_RETURN((const char*)U_NULLPTR);
+
+   char prefix = *ptr++;
+   const char* eol = (const char*) memchr(ptr, '\r', end - ptr);
+
+   if (eol == U_NULLPTR ||
+       (eol+2) > end)
+      {
+      U_RETURN((const char*)U_NULLPTR);
+      }
+
+   if (prefix != U_RC_BULK &&
+       prefix != U_RC_MULTIBULK)
+      {
+      U_RETURN(eol+2);
+      }
+
+   long len = u_strtol(ptr, eol);
+
+   ptr = eol+2;
+
+   if (len > 0)
+      {
+      if (prefix == U_RC_BULK)
+         {
+         ptr += len+2;
+
+         if (ptr > end) U_RETURN((const char*)U_NULLPTR);
+         }
+      else
+         {
+         for (long i = 0; i < len; ++i)
+            {
+            if ((ptr = skipResponseItem(ptr, end)) == U_NULLPTR) break;
+            }
+         }
+      }
+
+   U_RETURN(ptr);
+}
+
+U_NO_EXPORT bool UREDISPipeline::checkResponse()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::checkResponse()")
+
+   // NB: we start from the first reply not complete at the previous read...
+
+   const char* next;
+   const char* ptr = client->response.c_pointer(offset);
+   const char* end = client->response.pend();
+
+   while (nreply < nsent)
+      {
+      if ((next = skipResponseItem(ptr, end)) == U_NULLPTR) break;
+
+      ptr = next;
+
+      ++nreply;
+      }
+
+   offset = ptr - client->response.data();
+
+   U_INTERNAL_DUMP("nsent = %u nreply = %u offset = %u", nsent, nreply, offset)
+
+   if (nreply == nsent) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT void UREDISPipeline::processResponse()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::processResponse()")
+
+   U_INTERNAL_ASSERT_EQUALS(nreply, nsent)
+
+   char prefix;
+   char* ptr = client->response.data();
+   const char* next;
+
+   for (uint32_t i = 0; i < nsent; ++i)
+      {
+      vtype.push_back(prefix = *ptr);
+
+      if (prefix != U_RC_MULTIBULK)
+         {
+         ptr = UREDISClient_Base::getResponseItem(client->response, ptr, vitem, 0);
+
+         U_INTERNAL_ASSERT_EQUALS(memcmp(ptr, U_CRLF, 2), 0)
+
+         ptr += 2;
+
+         continue;
+         }
+
+      // NB: a multi-bulk reply is kept as it is (we parse it only if requested with getArray())...
+
+      next = skipResponseItem(ptr, client->response.pend());
+
+      U_INTERNAL_ASSERT_POINTER(next)
+
+      if (ptr[1] == '-') vitem.push_back(UString::getStringNull()); // "*-1\r\n" (null multi-bulk)
+      else               vitem.push_back(client->response.substr(ptr, next-ptr));
+
+      ptr = (char*)next;
+      }
+
+   U_DUMP_CONTAINER(vitem)
+
+   nsent = 0;
+}
+
+bool UREDISPipeline::getArray(const UString& item, UVector<UString>& vec)
+{
+   U_TRACE(0, "UREDISPipeline::getArray(%V,%p)", item.rep, &vec)
+
+   if (item.empty() ||
+       item.first_char() != U_RC_MULTIBULK)
+      {
+      U_RETURN(false);
+      }
+
+   (void) UREDISClient_Base::getResponseItem(item, (char*)item.data(), vec, 0);
+
+   U_RETURN(true);
+}
+
+bool UREDISPipeline::exec()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::exec()")
+
+   if (send() == false) U_RETURN(false);
+
+   while (checkResponse() == false)
+      {
+      if (client->readResponse(U_SINGLE_READ) == false)
+         {
+         nsent = 0;
+
+         U_RETURN(false);
+         }
+      }
+
+   processResponse();
+
+   U_RETURN(true);
+}
+
+bool UREDISPipeline::execAsync(vPFpvpv _func, void* _arg)
+{
+   U_TRACE(0, "UREDISPipeline::execAsync(%p,%p)", _func, _arg)
+
+   U_INTERNAL_ASSERT_POINTER(_func)
+
+   if (send() == false) U_RETURN(false);
+
+   func = _func;
+   arg  = _arg;
+
+   // NB: we are notified by UNotifier when the replies are arrived...
+
+   UEventFd::fd      = client->socket->getFd();
+   UEventFd::op_mask = EPOLLIN | EPOLLRDHUP;
+
+   UNotifier::insert(this);
+
+   U_RETURN(true);
+}
+
+int UREDISPipeline::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::handlerRead()")
+
+   U_INTERNAL_ASSERT_MAJOR(nsent, 0)
+
+   if (client->readResponse(U_SINGLE_READ) == false) U_RETURN(U_NOTIFIER_DELETE); // NB: the fd is ready so we don't wait, false => connection closed...
+
+   if (checkResponse() == false) U_RETURN(U_NOTIFIER_OK);
+
+   processResponse();
+
+   U_RETURN(U_NOTIFIER_DELETE);
+}
+
+void UREDISPipeline::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UREDISPipeline::handlerDelete()")
+
+   // NB: the pipeline is not allocated by UNotifier and the connection stay open...
+
+   UNotifier::erase(this);
+
+   UEventFd::fd = -1;
+
+   if (nsent) // NB: the replies are not arrived (connection closed, ...)
+      {
+      nsent = 0;
+
+      vtype.setBuffer(U_CAPACITY);
+      vitem.clear();
+
+      client->close();
+      }
+
+   if (func)
+      {
+      vPFpvpv _func = func;
+
+      func = U_NULLPTR;
+
+      _func(arg, this); // NB: we can call execAsync() again from here...
+      }
+}
+
 // DEBUG
 
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UREDISPipeline::dump(bool _reset) const
+{
+   *UObjectIO::os << "fd                                  " << fd              << '\n'
+                  << "nsent                               " << nsent           << '\n'
+                  << "nreply                              " << nreply          << '\n'
+                  << "offset                              " << offset          << '\n'
+                  << "nqueued                             " << nqueued         << '\n'
+                  << "client         (UREDISClient_Base   " << (void*)client   << ")\n"
+                  << "vtype          (UString             " << (void*)&vtype   << ")\n"
+                  << "vitem          (UVector             " << (void*)&vitem   << ")\n"
+                  << "buffer         (UString             " << (void*)&buffer  << ')';
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
 const char* UREDISClient_Base::dump(bool _reset) const
 {
    UClient_Base::dump(false);
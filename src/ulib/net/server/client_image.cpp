@@ -38,6 +38,7 @@ uint32_t      UClientImage_Base::rstart;
 uint32_t      UClientImage_Base::ncount;
 uint32_t      UClientImage_Base::nrequest;
 uint32_t      UClientImage_Base::size_request;
+uintptr_t     UClientImage_Base::suspend_serial;
 UString*      UClientImage_Base::body;
 UString*      UClientImage_Base::rbuffer;
 UString*      UClientImage_Base::wbuffer;
@@ -124,9 +125,10 @@ UClientImage_Base::UClientImage_Base()
 {
    U_TRACE_REGISTER_OBJECT(0, UClientImage_Base, "")
 
-   socket       = U_NULLPTR;
-   logbuf       = U_NULLPTR;
-   data_pending = U_NULLPTR;
+   socket         = U_NULLPTR;
+   logbuf         = U_NULLPTR;
+   data_pending   = U_NULLPTR;
+   data_suspended = U_NULLPTR;
 
    if (UServer_Base::isLog()) U_NEW(UString, logbuf, UString(200U));
 
@@ -533,6 +535,12 @@ void UClientImage_Base::handlerDelete()
       }
 #endif
 
+   if (data_suspended) // NB: the handle of the suspended request is no more valid...
+      {
+      delete data_suspended;
+             data_suspended = U_NULLPTR;
+      }
+
    if (data_pending)
       {
       delete data_pending;
@@ -609,7 +617,17 @@ int UClientImage_Base::handlerTimeout()
       }
 #endif
 
-   U_INTERNAL_DUMP("U_ClientImage_idle(this) = %d %B", U_ClientImage_idle(this), U_ClientImage_idle(this))
+   U_INTERNAL_DUMP("U_ClientImage_idle(this) = %d %B data_suspended = %p", U_ClientImage_idle(this), U_ClientImage_idle(this), data_suspended)
+
+   if (data_suspended)
+      {
+      // NB: the data of the response (Ex: the result of a query) is not arrived in the read timeout, we close the connection
+      //     (and with it the handle of the suspended request, so that a late resumeRequest() is ignored)...
+
+      socket->iState |= USocket::TIMEOUT;
+
+      U_RETURN(U_NOTIFIER_DELETE);
+      }
 
    if (U_ClientImage_idle(this) != U_YES) // U_YES = 0x0001
       {
@@ -1145,6 +1163,15 @@ int UClientImage_Base::handlerRead() // Connection-wide hooks
    UHTTP::UServletPage* usp;
    */
 
+   U_INTERNAL_DUMP("data_suspended = %p", data_suspended)
+
+   if (UNLIKELY(data_suspended != U_NULLPTR)) // NB: we don't read the connection until the suspended request is resumed...
+      {
+      U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN;
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
    prepareForRead();
 
 start:
@@ -1524,6 +1551,17 @@ check:            U_INTERNAL_DUMP("nrequest = %u resto = %u", nrequest, resto)
       if (UNLIKELY(socket->isClosed())) goto error;
       }
 
+   if (UNLIKELY(isRequestSuspended()))
+      {
+      suspendRequest();
+
+      endRequest();
+
+      last_event = u_now->tv_sec;
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
    U_INTERNAL_DUMP("socket->isClosed() = %b U_http_info.nResponseCode = %u U_ClientImage_close = %b U_ClientImage_state = %d %B",
                     socket->isClosed(),     U_http_info.nResponseCode,     U_ClientImage_close,     U_ClientImage_state, U_ClientImage_state)
 
@@ -1652,6 +1690,153 @@ death:
    U_RETURN(U_NOTIFIER_OK);
 }
 
+void* UClientImage_Base::getRequestHandle()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::getRequestHandle()")
+
+   U_INTERNAL_DUMP("U_ClientImage_pipeline = %b nrequest = %u U_ClientImage_parallelization = %d U_http_version = %C size_request = %u rbuffer->size() = %u",
+                    U_ClientImage_pipeline,     nrequest,     U_ClientImage_parallelization,     U_http_version,     size_request,     rbuffer->size())
+
+   // NB: with a pipeline (the check for it is done after the processing of the first request) the responses must be written in order...
+
+   if (U_ClientImage_pipeline        == false &&
+       U_ClientImage_parallelization == 0     &&
+       U_http_version                != '2'   &&
+       nrequest                      == 0     &&
+       size_request                  >= rbuffer->size())
+      {
+      // NB: the handle is the index of the client image plus a serial number multiple of max_connection,
+      //     so that on resume we can check if the connection was closed (and maybe reused) in the meanwhile...
+
+      uintptr_t handle = (suspend_serial + 1) * UNotifier::max_connection + (UServer_Base::pClientImage - UServer_Base::vClientImage);
+
+      U_RETURN_POINTER((void*)handle, void);
+      }
+
+   U_RETURN_POINTER(U_NULLPTR, void);
+}
+
+void UClientImage_Base::setRequestSuspended(void* handle)
+{
+   U_TRACE(0, "UClientImage_Base::setRequestSuspended(%p)", handle)
+
+   U_INTERNAL_ASSERT_POINTER(handle)
+   U_INTERNAL_ASSERT_EQUALS(handle, getRequestHandle())
+   U_INTERNAL_ASSERT_EQUALS(UServer_Base::pClientImage->data_suspended, U_NULLPTR)
+
+   ++suspend_serial;
+
+   U_NEW(UString, UServer_Base::pClientImage->data_suspended, UString(sizeof(uintptr_t) + sizeof(uucflag64) + sizeof(uhttpinfo) + 200U));
+
+   (void) UServer_Base::pClientImage->data_suspended->append((const char*)&handle, sizeof(uintptr_t));
+
+   U_ClientImage_request |= SUSPENDED | ALREADY_PROCESSED;
+
+   setRequestNoCache();
+
+   U_INTERNAL_DUMP("U_ClientImage_request = %d %B", U_ClientImage_request, U_ClientImage_request)
+}
+
+U_NO_EXPORT void UClientImage_Base::suspendRequest()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::suspendRequest()")
+
+   U_INTERNAL_ASSERT_POINTER(data_suspended)
+   U_INTERNAL_ASSERT_EQUALS(nrequest, 0)
+   U_INTERNAL_ASSERT_EQUALS(U_ClientImage_pipeline, false)
+
+   U_INTERNAL_DUMP("wbuffer(%u) = %V", wbuffer->size(), wbuffer->rep)
+
+   // NB: we save the info of the request (the pointers into the request are not valid anymore on resume) and the header written by the USP...
+
+   (void) data_suspended->append((const char*)&(u_clientimage_info.flag), sizeof(uucflag64));
+   (void) data_suspended->append((const char*)&U_http_info,               sizeof(uhttpinfo));
+   (void) data_suspended->append(*wbuffer);
+
+   resetBuffer(); // NB: so we don't write any response...
+}
+
+void UClientImage_Base::resumeRequest(void* handle, vPF func)
+{
+   U_TRACE(0, "UClientImage_Base::resumeRequest(%p,%p)", handle, func)
+
+   U_INTERNAL_ASSERT_POINTER(func)
+   U_INTERNAL_ASSERT_POINTER(UServer_Base::vClientImage)
+
+   UClientImage_Base* pimg = UServer_Base::vClientImage + ((uintptr_t)handle % UNotifier::max_connection);
+
+   U_INTERNAL_DUMP("pimg = %p pimg->data_suspended = %p", pimg, pimg->data_suspended)
+
+   if (pimg->data_suspended &&
+       memcmp(pimg->data_suspended->data(), &handle, sizeof(uintptr_t)) == 0)
+      {
+      pimg->resume(func);
+      }
+}
+
+U_NO_EXPORT void UClientImage_Base::resume(vPF func)
+{
+   U_TRACE(0, "UClientImage_Base::resume(%p)", func)
+
+   U_INTERNAL_ASSERT(socket->isOpen())
+   U_INTERNAL_ASSERT_EQUALS(UEventFd::fd, socket->iSockDesc)
+
+   int result;
+   const char* ptr = data_suspended->c_pointer(sizeof(uintptr_t));
+   uint32_t sz     = sizeof(uintptr_t) + sizeof(uucflag64) + sizeof(uhttpinfo);
+
+   UServer_Base::csocket            = socket;
+   UServer_Base::pClientImage       = this;
+   UServer_Base::client_address     = socket->cRemoteAddress.pcStrAddress;
+   UServer_Base::client_address_len = u__strlen(UServer_Base::client_address, __PRETTY_FUNCTION__);
+
+   U_MEMCPY(&(u_clientimage_info.flag), ptr,                     sizeof(uucflag64));
+   U_MEMCPY(&U_http_info,               ptr + sizeof(uucflag64), sizeof(uhttpinfo));
+
+   U_ClientImage_request &= ~SUSPENDED;
+
+   resetBuffer();
+
+   (void) wbuffer->append(data_suspended->c_pointer(sz), data_suspended->size() - sz);
+
+   delete data_suspended;
+          data_suspended = U_NULLPTR;
+
+   func(); // NB: it must write the response on wbuffer as the USP would do...
+
+   U_INTERNAL_DUMP("U_http_info.nResponseCode = %u wbuffer(%u) = %V", U_http_info.nResponseCode, wbuffer->size(), wbuffer->rep)
+
+   if (U_http_info.nResponseCode == HTTP_OK) UHTTP::setDynamicResponse();
+
+   result = (*wbuffer ? handlerResponse() : U_NOTIFIER_DELETE);
+
+   // NB: the end of the request processing (endRequest()) was done on suspend...
+
+   U_http_method_type = 0;
+
+   UHTTP::ext->clear();
+
+   if (iov_sav[0].iov_len) U_MEMCPY(iov_vec, iov_sav, U_IOV_TO_SAVE);
+
+   if (result == U_NOTIFIER_DELETE ||
+       U_ClientImage_close)
+      {
+      UNotifier::handlerDelete((UEventFd*)this);
+
+      return;
+      }
+
+   last_event = u_now->tv_sec;
+
+   // NB: maybe the client has sent another request while we was waiting (the connection is edge triggered)...
+
+   if (UNotifier::waitForRead(socket->iSockDesc, 0) == 1 &&
+       handlerRead() == U_NOTIFIER_DELETE)
+      {
+      UNotifier::handlerDelete((UEventFd*)this);
+      }
+}
+
 bool UClientImage_Base::writeResponse()
 {
    U_TRACE_NO_PARAM(0, "UClientImage_Base::writeResponse()")
@@ -2131,7 +2316,8 @@ const char* UClientImage_Base::dump(bool _reset) const
                   << "wbuffer         (UString           " << (void*)wbuffer      << ")\n"
                   << "request         (UString           " << (void*)request      << ")\n"
                   << "environment     (UString           " << (void*)environment  << ")\n"
-                  << "data_pending    (UString           " << (void*)data_pending << ')';
+                  << "data_pending    (UString           " << (void*)data_pending << ")\n"
+                  << "data_suspended  (UString           " << (void*)data_suspended << ')';
 
    if (_reset)
       {
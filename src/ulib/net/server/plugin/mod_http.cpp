@@ -17,12 +17,17 @@
 #include <ulib/utility/uhttp.h>
 #include <ulib/net/server/server.h>
 #include <ulib/utility/string_ext.h>
+#include <ulib/utility/binary_access_log.h>
 #include <ulib/net/server/plugin/mod_http.h>
 
 #ifndef U_HTTP2_DISABLE
 #  include <ulib/utility/http2.h>
 #endif
 
+#ifdef USE_LIBSSL
+#  include <ulib/ssl/net/ssl_session.h>
+#endif
+
 U_CREAT_FUNC(server_plugin_http, UHttpPlugIn)
 
 UHttpPlugIn::~UHttpPlugIn()
@@ -71,6 +76,8 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
    //
    // APACHE_LIKE_LOG        file to write NCSA extended/combined log format: "%h %l %u %t \"%r\" %>s %b \"%{Referer}i\" \"%{User-agent}i\""
    // LOG_FILE_SZ            memory size for file apache like log
+   // LOG_BUFFER_SZ          memory size of the per process ring buffer for apache like log (the records are written in batch by a dedicated thread)
+   // APACHE_LIKE_LOG_BINARY flag to write the apache like log in a compact binary format (to read it: userver_logdec [-j] <file>)
    //
    // ENABLE_INOTIFY         enable automatic update of document root image with inotify
    // CACHE_FILE_MASK        mask (DOS regexp) of pathfile that content      be cached in memory
@@ -367,21 +374,38 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
 
       if (x)
          {
-         UServer_Base::update_date  =
-         UServer_Base::update_date2 = true;
-
          U_INTERNAL_ASSERT_EQUALS(UServer_Base::apache_like_log, U_NULLPTR)
+         U_INTERNAL_ASSERT_EQUALS(UHTTP::apache_like_log_binary, U_NULLPTR)
+
+         UServer_Base::update_date = true;
+
+         if (cfg.readBoolean(U_CONSTANT_TO_PARAM("APACHE_LIKE_LOG_BINARY")))
+            {
+            U_NEW(UBinaryAccessLog, UHTTP::apache_like_log_binary, UBinaryAccessLog);
+            }
+         else
+            {
+            UServer_Base::update_date2 = true; // NB: the binary log don't need the date of the text format...
+            }
 
          uint32_t size = cfg.readLong(U_CONSTANT_TO_PARAM("LOG_FILE_SZ"));
 
          U_NEW(ULog, UServer_Base::apache_like_log, ULog(x, size));
 
+         if (UHTTP::apache_like_log_binary) UServer_Base::apache_like_log->setBinary(UHTTP::apache_like_log_binary);
+
          if (size)
             {
             U_INTERNAL_ASSERT_EQUALS(UServer_Base::shm_data_add, 0)
 
             UServer_Base::shm_data_add += UServer_Base::apache_like_log->getSizeLogRotateData();
             }
+
+#     if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+         size = cfg.readLong(U_CONSTANT_TO_PARAM("LOG_BUFFER_SZ"));
+
+         if (size) UServer_Base::apache_like_log->setAsync(size);
+#     endif
          }
 #   endif
 
@@ -505,6 +529,8 @@ int UHttpPlugIn::handlerInit()
 
       USSLSocket::staple.data = UServer_Base::getOffsetToDataShare(U_OCSP_MAX_RESPONSE_SIZE);
 #  endif
+
+      USSLSession::setDataShare();
       }
 #endif
 
@@ -522,7 +548,7 @@ int UHttpPlugIn::handlerRun() // NB: we use this method instead of handlerInit()
 #endif
 
 #ifdef USE_LIBSSL
-   if (UServer_Base::bssl) UHTTP::initSessionSSL();
+   if (UServer_Base::bssl) USSLSession::init();
    else
 #endif
    if (UServer_Base::handler_inotify) UHTTP::initDbNotFound();
@@ -673,13 +699,7 @@ int UHttpPlugIn::handlerSigHUP()
    U_TRACE_NO_PARAM(0, "UHttpPlugIn::handlerSigHUP()")
 
 #ifdef USE_LIBSSL
-   if (UServer_Base::bssl &&
-       UHTTP::db_session_ssl->compactionJournal() == false)
-      {
-      U_WARNING("SSL: compaction of db SSL session failed");
-
-      (void) U_SYSCALL(SSL_CTX_set_session_cache_mode, "%p,%d", USSLSocket::sctx, SSL_SESS_CACHE_OFF);
-      }
+   if (UServer_Base::bssl) U_SRV_LOG("SSL: session cache %v", USSLSession::getStatistics().rep);
 #endif
 
    if (UHTTP::bcallInitForAllUSP) UHTTP::callSigHUPForAllUSP();
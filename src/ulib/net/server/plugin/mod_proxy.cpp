@@ -26,7 +26,7 @@
 #endif
 */
 
-UHttpClient<UTCPSocket>* UProxyPlugIn::client_http;
+UClientPool<UHttpClient<UTCPSocket> >* UProxyPlugIn::pool;
 
 U_CREAT_FUNC(server_plugin_proxy, UProxyPlugIn)
 
@@ -39,7 +39,7 @@ UProxyPlugIn::~UProxyPlugIn()
 {
    U_TRACE_UNREGISTER_OBJECT(0, UProxyPlugIn)
 
-   if (client_http) delete client_http;
+   if (pool) delete pool;
 }
 
 // Server-wide hooks
@@ -68,7 +68,7 @@ int UProxyPlugIn::handlerInit()
 #endif
 */
 
-   U_NEW(UHttpClient<UTCPSocket>, client_http, UHttpClient<UTCPSocket>((UFileConfig*)U_NULLPTR));
+   U_NEW(UClientPool<UHttpClient<UTCPSocket> >, pool, UClientPool<UHttpClient<UTCPSocket> >);
 
    U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
 }
@@ -133,12 +133,15 @@ int UProxyPlugIn::handlerRequest()
 
       if (output_to_client == false)
          {
-         // before connect to server check if server and/or port to connect has changed...
+         // we take a connection to the server of the service from the pool (a warm one if there is, else a new one)...
 
-         if (client_http->setHostPort(UHTTP::service->getServer(), UHTTP::service->getPort()) &&
-             client_http->UClient_Base::isConnected())
+         UHttpClient<UTCPSocket>* client_http = pool->acquire(UHTTP::service->getServer(), UHTTP::service->getPort());
+
+         if (client_http == U_NULLPTR) // the server is not reachable or there are already max_conn connections to it...
             {
-            client_http->UClient_Base::close();
+            UHTTP::setServiceUnavailable();
+
+            U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
             }
 
          // --------------------------------------------------------------------------------------------------------------------
@@ -162,6 +165,8 @@ int UProxyPlugIn::handlerRequest()
                UClientImage_Base::wbuffer->setEmpty();
                }
 
+            pool->release(client_http, false);
+
             U_RETURN(U_PLUGIN_HANDLER_ERROR);
             }
 
@@ -223,7 +228,19 @@ int UProxyPlugIn::handlerRequest()
          else if (UServer_Base::isLog()) UServer_Base::log->logResponse(*UClientImage_Base::wbuffer, U_CONSTANT_TO_PARAM(""), 0);
 #     endif
 
+         // NB: after a redirect to another server the connection is not for the backend of the service...
+
+         if (client_http->getPort()   != (unsigned int)UHTTP::service->getPort() ||
+             client_http->getServer() != UHTTP::service->getServer())
+            {
+            result = false;
+            }
+
          client_http->reset(); // reset reference to request...
+
+         (void) client_http->setHostPort(UHTTP::service->getServer(), UHTTP::service->getPort()); // NB: reset() clear the server (the key of the pool)...
+
+         pool->release(client_http, result);
          }
 
       UClientImage_Base::setRequestProcessed();
@@ -239,7 +256,7 @@ int UProxyPlugIn::handlerRequest()
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
 const char* UProxyPlugIn::dump(bool reset) const
 {
-   *UObjectIO::os << "client_http (UHttpClient<UTCPSocket> " << (void*)client_http << ')';
+   *UObjectIO::os << "pool        (UClientPool            " << (void*)pool << ')';
 
    if (reset)
       {
@@ -22,6 +22,8 @@
 U_CREAT_FUNC(server_plugin_socket, UWebSocketPlugIn)
 
 vPFi      UWebSocketPlugIn::on_message;
+bool      UWebSocketPlugIn::bbroadcast;
+void*     UWebSocketPlugIn::broadcast_ptr;
 UCommand* UWebSocketPlugIn::command;
 
 UWebSocketPlugIn::UWebSocketPlugIn()
@@ -51,18 +53,23 @@ int UWebSocketPlugIn::handlerConfig(UFileConfig& cfg)
    U_TRACE(0, "UWebSocketPlugIn::handlerConfig(%p)", &cfg)
 
    // Perform registration of web socket method
-   // ----------------------------------------------------------------------------------------------
-   // COMMAND                          command (alternative to USP websocket) to execute
-   // ENVIRONMENT      environment for command (alternative to USP websocket) to execute
+   // ------------------------------------------------------------------------------------------------------------
+   // COMMAND                            command (alternative to USP websocket) to execute
+   // ENVIRONMENT        environment for command (alternative to USP websocket) to execute
    //
-   // MAX_MESSAGE_SIZE Maximum size (in bytes) of a message to accept; default is approximately 4GB
-   // ----------------------------------------------------------------------------------------------
+   // MAX_MESSAGE_SIZE   Maximum size (in bytes) of a message to accept; default is approximately 4GB
+   // PERMESSAGE_DEFLATE flag to accept the compression extension (RFC 7692) offered by the client; default is yes
+   // BROADCAST          flag to subscribe every connection to the messages sent with UWebSocket::broadcast()
+   // ------------------------------------------------------------------------------------------------------------
 
    if (cfg.loadTable())
       {
       command = UServer_Base::loadConfigCommand();
 
       UWebSocket::max_message_size = cfg.readLong(U_CONSTANT_TO_PARAM("MAX_MESSAGE_SIZE"), U_STRING_MAX_SIZE);
+      UWebSocket::enable_deflate   = cfg.readBoolean(U_CONSTANT_TO_PARAM("PERMESSAGE_DEFLATE"), true);
+
+      bbroadcast = cfg.readBoolean(U_CONSTANT_TO_PARAM("BROADCAST"));
 
       U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
       }
@@ -70,6 +77,15 @@ int UWebSocketPlugIn::handlerConfig(UFileConfig& cfg)
    U_RETURN(U_PLUGIN_HANDLER_GO_ON);
 }
 
+int UWebSocketPlugIn::handlerInit()
+{
+   U_TRACE_NO_PARAM(0, "UWebSocketPlugIn::handlerInit()")
+
+   if (bbroadcast) broadcast_ptr = UServer_Base::getOffsetToDataShare(sizeof(UWebSocket::ws_broadcast));
+
+   U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
+}
+
 int UWebSocketPlugIn::handlerRun()
 {
    U_TRACE_NO_PARAM(0, "UWebSocketPlugIn::handlerRun()")
@@ -78,6 +94,13 @@ int UWebSocketPlugIn::handlerRun()
 
    U_NEW(UString, UWebSocket::rbuffer, UString(U_CAPACITY));
 
+   if (bbroadcast)
+      {
+      UWebSocket::broadcast_data = (UWebSocket::ws_broadcast*) UServer_Base::getPointerToDataShare(broadcast_ptr);
+
+      UWebSocket::initBroadcast();
+      }
+
    UHTTP::UServletPage* usp = UHTTP::getUSP(U_CONSTANT_TO_PARAM("modsocket"));
 
    if (usp)
@@ -104,10 +127,20 @@ int UWebSocketPlugIn::handlerRequest()
 
    if (U_http_websocket_len)
       {
-      int fdmax = 0;
+      int n, fdmax = 0;
+      struct timeval timeout;
       fd_set fd_set_read, read_set;
       bool bcommand = (command && on_message == U_NULLPTR);
 
+      if (UWebSocket::broadcast_data)
+         {
+         // NB: the subscriber is served by this process for all the life of the connection, so we create a copy of us (if we have other clients)...
+
+         if (UServer_Base::startParallelization()) U_RETURN(U_PLUGIN_HANDLER_FINISHED); // parent
+
+         UWebSocket::subscribe();
+         }
+
       if (bcommand)
          {
          // Set environment for the command application server
@@ -144,9 +177,29 @@ int UWebSocketPlugIn::handlerRequest()
 
       if (bcommand == false) goto handle_data;
 
-loop: read_set = fd_set_read;
+loop: if (UWebSocket::broadcast_data &&
+          UWebSocket::writeBroadcast() == false)
+         {
+         goto end;
+         }
+
+      read_set = fd_set_read;
+
+      if (UWebSocket::broadcast_data)
+         {
+         timeout.tv_sec  = 0L;
+         timeout.tv_usec = U_WEBSOCKET_BROADCAST_POLL_MS * 1000L;
+         }
+
+      n = U_SYSCALL(select, "%d,%p,%p,%p,%p", fdmax, &read_set, U_NULLPTR, U_NULLPTR, (UWebSocket::broadcast_data ? &timeout : U_NULLPTR));
+
+      if (n == 0 &&
+          UServer_Base::flag_loop)
+         {
+         goto loop;
+         }
 
-      if (U_SYSCALL(select, "%d,%p,%p,%p,%p", fdmax, &read_set, U_NULLPTR, U_NULLPTR, U_NULLPTR) > 0)
+      if (n > 0)
          {
          if (FD_ISSET(UProcess::filedes[2], &read_set))
             {
@@ -163,6 +216,23 @@ loop: read_set = fd_set_read;
          else if (FD_ISSET(UServer_Base::csocket->iSockDesc, &read_set))
             {
 handle_data:
+            if (UWebSocket::broadcast_data)
+               {
+               // NB: while we wait for a message from the client we write the frames of the broadcast...
+
+               while (UWebSocket::writeBroadcast())
+                  {
+                  if (UWebSocket::rbuffer->empty() == false                                                         ||
+                      UNotifier::waitForRead(UServer_Base::csocket->iSockDesc, U_WEBSOCKET_BROADCAST_POLL_MS) != 0 ||
+                      UServer_Base::flag_loop == false)
+                     {
+                     goto read;
+                     }
+                  }
+
+               goto end;
+               }
+read:
             if (UWebSocket::handleDataFraming(UServer_Base::csocket) == STATUS_CODE_OK &&
                 (bcommand == false ? (on_message(0), U_http_info.nResponseCode != HTTP_INTERNAL_ERROR)
                                    : UNotifier::write(UProcess::filedes[1], U_STRING_TO_PARAM(*UClientImage_Base::wbuffer))))
@@ -176,6 +246,8 @@ handle_data:
             }
          }
 
+end:  if (UWebSocket::broadcast_data) UWebSocket::unsubscribe();
+
       // Send server-side closing handshake
 
       if (UServer_Base::csocket->isOpen() &&
@@ -195,8 +267,10 @@ handle_data:
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
 const char* UWebSocketPlugIn::dump(bool reset) const
 {
-   *UObjectIO::os << "on_message        " << (void*)on_message << '\n'
-                  << "command (UCommand " << (void*)command    << ')';
+   *UObjectIO::os << "bbroadcast        " << bbroadcast         << '\n'
+                  << "on_message        " << (void*)on_message  << '\n'
+                  << "broadcast_ptr     " << broadcast_ptr      << '\n'
+                  << "command (UCommand " << (void*)command     << ')';
 
    if (reset)
       {
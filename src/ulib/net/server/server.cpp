@@ -80,6 +80,7 @@
 #endif
 
 int           UServer_Base::rkids;
+int           UServer_Base::kid_index = -1;
 int           UServer_Base::timeoutMS;
 int           UServer_Base::verify_mode;
 int           UServer_Base::socket_flags;
@@ -94,6 +95,7 @@ bool          UServer_Base::public_address;
 bool          UServer_Base::monitoring_process;
 bool          UServer_Base::set_tcp_keep_alive;
 bool          UServer_Base::set_realtime_priority;
+bool          UServer_Base::reuseport_cpu_steering;
 bool          UServer_Base::update_date;
 bool          UServer_Base::update_date1;
 bool          UServer_Base::update_date2;
@@ -178,6 +180,8 @@ UVector<UIPAllow*>* UServer_Base::vallow_IP_prv;
 #ifdef DEBUG
 #  ifdef USE_LIBEVENT
 #     define U_WHICH "libevent" 
+#  elif defined(USE_IO_URING)
+#     define U_WHICH "io_uring" 
 #  elif defined(HAVE_EPOLL_WAIT)
 #     define U_WHICH "epoll" 
 #  else
@@ -204,6 +208,16 @@ UString UServer_Base::getStats()
                (float) UServer_Base::stats_connections / U_ONE_HOUR_IN_SECOND, UServer_Base::stats_simultaneous, UNotifier::nwatches, U_WHICH,
                (float) UNotifier::nwatches / U_ONE_HOUR_IN_SECOND, UStringExt::printSize(UServer_Base::stats_bytes).rep);
 
+   if (UServer_Base::ptr_shared_data &&
+       UServer_Base::preforked_num_kids > 1)
+      {
+      int n = (UServer_Base::preforked_num_kids < U_SRV_MAX_KIDS ? UServer_Base::preforked_num_kids : U_SRV_MAX_KIDS);
+
+      x.append(U_CONSTANT_TO_PARAM(" - accept per child:"));
+
+      for (int i = 0; i < n; ++i) x.snprintf_add(U_CONSTANT_TO_PARAM(" %u"), U_SRV_CNT_ACCEPT(i));
+      }
+
    U_RETURN_STRING(x);
 }
 
@@ -1665,6 +1679,10 @@ void UServer_Base::loadConfigParam()
    // LISTEN_BACKLOG        max number of ready to be delivered connections to accept()
    // SET_REALTIME_PRIORITY flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
    //
+   // REUSEPORT_CPU_STEERING flag indicating that every preforked process is pinned to a cpu and that the kernel steers (SO_REUSEPORT+BPF)
+   //                        the new connections to the listening socket of the process running on the cpu that received them
+   //                        (SO_ATTACH_REUSEPORT_EBPF, need PREFORK_CHILD multiple of the number of cpu and not greater than 64)
+   //
    // CLIENT_THRESHOLD           min number of clients to active polling
    // CLIENT_FOR_PARALLELIZATION min number of clients to active parallelization
    //
@@ -1700,6 +1718,7 @@ void UServer_Base::loadConfigParam()
    // CA_PATH       locations of trusted CA certificates used in the verification
    // VERIFY_MODE   mode of verification (SSL_VERIFY_NONE=0, SSL_VERIFY_PEER=1, SSL_VERIFY_FAIL_IF_NO_PEER_CERT=2, SSL_VERIFY_CLIENT_ONCE=4)
    // CIPHER_SUITE  cipher suite model (Intermediate=0, Modern=1, Old=2)
+   // KTLS          flag indicating to give the encryption of the records to the kernel (kTLS) after the handshake, so that sendfile() can be used
    //
    // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (experimental)
    //                                                                     0 - serialize, no forking
@@ -1760,6 +1779,10 @@ void UServer_Base::loadConfigParam()
    set_tcp_keep_alive    = cfg->readBoolean(U_CONSTANT_TO_PARAM("TCP_KEEP_ALIVE"));
    set_realtime_priority = cfg->readBoolean(U_CONSTANT_TO_PARAM("SET_REALTIME_PRIORITY"), true);
 
+#if defined(U_LINUX) && (!defined(U_SERVER_CAPTIVE_PORTAL) || defined(ENABLE_THREAD))
+   reuseport_cpu_steering = cfg->readBoolean(U_CONSTANT_TO_PARAM("REUSEPORT_CPU_STEERING"));
+#endif
+
    crash_count                    = cfg->readLong(U_CONSTANT_TO_PARAM("CRASH_COUNT"), 5);
    tcp_linger_set                 = cfg->readLong(U_CONSTANT_TO_PARAM("TCP_LINGER_SET"), -2);
    USocket::iBackLog              = cfg->readLong(U_CONSTANT_TO_PARAM("LISTEN_BACKLOG"), SOMAXCONN);
@@ -1850,7 +1873,17 @@ void UServer_Base::loadConfigParam()
    *dh_file    = cfg->at(U_CONSTANT_TO_PARAM("DH_FILE"));
    verify_mode = cfg->at(U_CONSTANT_TO_PARAM("VERIFY_MODE"));
 
-   if (bssl) min_size_for_sendfile = U_NOT_FOUND; // NB: we can't use sendfile with SSL...
+#  ifdef U_USE_KTLS
+   USSLSocket::bktls = cfg->readBoolean(U_CONSTANT_TO_PARAM("KTLS"));
+
+   if (bssl &&
+       USSLSocket::bktls == false)
+#  else
+   if (bssl)
+#  endif
+   {
+   min_size_for_sendfile = U_NOT_FOUND; // NB: we can't use sendfile with SSL (without kTLS)...
+   }
 #endif
 
    U_INTERNAL_DUMP("min_size_for_sendfile = %u", min_size_for_sendfile)
@@ -3163,6 +3196,14 @@ RETSIGTYPE UServer_Base::handlerForSigTERM(int signo)
 
 #     ifndef U_LOG_DISABLE
          if (isLog()) logMemUsage("SIGTERM");
+
+#      if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_) && !defined(USE_LIBEVENT) && !defined(USE_RUBY)
+         if (apache_like_log &&
+             apache_like_log->isAsync()) // NB: here we are not in the signal handler (async signal)...
+            {
+            apache_like_log->stopAsync(); // NB: we write the records that are still in the ring buffer...
+            }
+#      endif
 #     endif
 
          U_EXIT(0);
@@ -3473,6 +3514,14 @@ try_accept:
    ULock::atomicIncrement(U_SRV_TOT_CONNECTION);
 
    U_INTERNAL_DUMP("U_SRV_TOT_CONNECTION = %u", U_SRV_TOT_CONNECTION)
+
+   if (kid_index != -1 &&
+       ptr_shared_data)
+      {
+      ++U_SRV_CNT_ACCEPT(kid_index); // NB: only this process write on this slot...
+
+      U_INTERNAL_DUMP("U_SRV_CNT_ACCEPT(%d) = %u", kid_index, U_SRV_CNT_ACCEPT(kid_index))
+      }
 #endif
 
    ++UNotifier::num_connection;
@@ -3774,6 +3823,14 @@ void UServer_Base::runLoop(const char* user)
 
    if (pluginsHandlerFork() != U_PLUGIN_HANDLER_FINISHED) U_ERROR("Plugins stage fork failed");
 
+#if !defined(U_LOG_DISABLE) && defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   if (apache_like_log &&
+       preforked_num_kids != -1) // NB: the ring buffer has a single producer, so not with the server thread approach...
+      {
+      (void) apache_like_log->startAsync(); // NB: the writer thread must be created in every child (it don't survive to fork())...
+      }
+#endif
+
    socket->reusePort(socket_flags);
 
 #ifdef U_LINUX
@@ -3922,6 +3979,14 @@ void UServer_Base::runLoop(const char* user)
 
       (void) pthis->UServer_Base::handlerRead();
       }
+
+#if !defined(U_LOG_DISABLE) && defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   if (apache_like_log &&
+       apache_like_log->isAsync())
+      {
+      apache_like_log->stopAsync();
+      }
+#endif
 }
 
 void UServer_Base::run()
@@ -3963,15 +4028,43 @@ void UServer_Base::run()
 
    int nkids;
    cpu_set_t cpuset;
-   pid_t pid, pid_to_wait;
+   pid_t pid, pid_to_wait, kid_pid[U_SRV_MAX_KIDS]; // NB: the slot of every child, to keep the cpu and the statistics of a child that we restart...
+
+   (void) memset(kid_pid, 0, sizeof(kid_pid));
 
 #if defined(HAVE_SCHED_GETAFFINITY) && (!defined(U_SERVER_CAPTIVE_PORTAL) || defined(ENABLE_THREAD))
-   if (u_get_num_cpu() > 1 &&
-       (preforked_num_kids % u_num_cpu) == 0)
+   if (u_get_num_cpu() > 1)
       {
-      baffinity = true;
+      if ((preforked_num_kids % u_num_cpu) == 0)
+         {
+         baffinity = true;
+
+         U_SRV_LOG("cpu affinity is to be set; thread count (%u) multiple of cpu count (%u)", preforked_num_kids, u_num_cpu);
+         }
 
-      U_SRV_LOG("cpu affinity is to be set; thread count (%u) multiple of cpu count (%u)", preforked_num_kids, u_num_cpu);
+      if (reuseport_cpu_steering &&
+          USocket::breuseport    &&
+          preforked_num_kids > 1)
+         {
+         /**
+          * NB: the child of slot i is pinned to the cpu (i % u_num_cpu) and put its listening socket at the index i of the map of the
+          * eBPF program, so we need that every cpu have the same number of children and that every child have its own slot...
+          */
+
+         if (baffinity == false ||
+             preforked_num_kids > U_SRV_MAX_KIDS)
+            {
+            U_SRV_LOG("WARNING: SO_REUSEPORT cpu steering disabled; thread count (%u) must be a multiple of cpu count (%u) and not greater than %u", preforked_num_kids, u_num_cpu, U_SRV_MAX_KIDS);
+            }
+         else if (USocket::setReusePortSteering(preforked_num_kids, u_num_cpu) == false)
+            {
+            U_SRV_LOG("WARNING: SO_REUSEPORT cpu steering disabled; load of the eBPF program failed - %R", 0); // NB: the last argument (0) is necessary...
+            }
+         else
+            {
+            U_SRV_LOG("SO_REUSEPORT cpu steering is to be set; every child (%u) have its own listening socket and is pinned to a cpu (%u)", preforked_num_kids, u_num_cpu);
+            }
+         }
       }
 #endif
 
@@ -3987,11 +4080,26 @@ void UServer_Base::run()
 
       while (rkids < nkids)
          {
+         for (kid_index = 0; kid_index < U_SRV_MAX_KIDS && kid_pid[kid_index]; ++kid_index) {} // search for a free slot
+
+         if (kid_index == U_SRV_MAX_KIDS)
+            {
+            kid_index = -1; // NB: no slot, the child is without per-child statistics and cpu steering...
+
+            U_SRV_LOG("WARNING: no free slot for the new child, it will run without per-child statistics (max %u children)", U_SRV_MAX_KIDS);
+            }
+         else
+            {
+            U_SRV_CNT_ACCEPT(kid_index) = 0;
+            }
+
          if (proc->fork() &&
              proc->parent())
             {
             ++rkids;
 
+            if (kid_index != -1) kid_pid[kid_index] = proc->_pid;
+
             if (preforked_num_kids <= 0) pid_to_wait = proc->_pid;
 
             U_SRV_LOG("Started new child (pid %d), up to %u children", proc->_pid, rkids);
@@ -4001,17 +4109,23 @@ void UServer_Base::run()
 
          if (proc->child())
             {
-            U_INTERNAL_DUMP("child = %P UNotifier::num_connection = %d", UNotifier::num_connection)
+            U_INTERNAL_DUMP("child = %P UNotifier::num_connection = %d kid_index = %d", UNotifier::num_connection, kid_index)
+
+#        ifdef U_LINUX
+            USocket::reuseport_index = kid_index;
+#        endif
 
 #        if defined(HAVE_SCHED_GETAFFINITY) && (!defined(U_SERVER_CAPTIVE_PORTAL) || defined(ENABLE_THREAD))
             if (baffinity)
                {
                CPU_ZERO(&cpuset);
 
-               u_bind2cpu(&cpuset, rkids % u_num_cpu); // Pin the process to a particular cpu...
+               int kid_cpu = (kid_index != -1 ? kid_index : rkids) % u_num_cpu;
+
+               u_bind2cpu(&cpuset, kid_cpu); // Pin the process to a particular cpu...
 
 #           ifdef SO_INCOMING_CPU
-               USocket::incoming_cpu = rkids % u_num_cpu;
+               USocket::incoming_cpu = kid_cpu;
 #           endif
 
 #           ifndef U_LOG_DISABLE
@@ -4041,7 +4155,7 @@ void UServer_Base::run()
                {
                struct bitmask* bmask = (struct bitmask*) U_SYSCALL(numa_bitmask_alloc, "%u", 16);
 
-               (void) U_SYSCALL(numa_bitmask_setbit, "%p,%u", bmask, rkids % 2);
+               (void) U_SYSCALL(numa_bitmask_setbit, "%p,%u", bmask, (kid_index != -1 ? kid_index : rkids) % 2);
 
                U_SYSCALL_VOID(numa_set_membind,  "%p", bmask);
                U_SYSCALL_VOID(numa_bitmask_free, "%p", bmask);
@@ -4105,6 +4219,8 @@ void UServer_Base::run()
          {
          manageSigHUP();
 
+         (void) memset(kid_pid, 0, sizeof(kid_pid));
+
          continue;
          }
 
@@ -4115,9 +4231,17 @@ void UServer_Base::run()
 
          --rkids;
 
-         baffinity = false;
+         for (kid_index = 0; kid_index < U_SRV_MAX_KIDS; ++kid_index)
+            {
+            if (kid_pid[kid_index] == pid)
+               {
+               kid_pid[kid_index] = 0; // NB: the slot is free, the new child take the place (and the cpu) of this one...
+
+               break;
+               }
+            }
 
-         U_INTERNAL_DUMP("down to %u children", rkids)
+         U_INTERNAL_DUMP("down to %u children kid_index = %d", rkids, kid_index)
 
          // Another little safety brake here: since children should not
          // exit too quickly, pausing before starting them should be harmless
@@ -4284,6 +4408,7 @@ const char* UServer_Base::dump(bool reset) const
                   << "shared_data_add           " << shared_data_add            << '\n'
                   << "ptr_shared_data           " << (void*)ptr_shared_data     << '\n'
                   << "preforked_num_kids        " << preforked_num_kids         << '\n'
+                  << "kid_index                 " << kid_index                  << '\n'
                   << "log           (ULog       " << (void*)log                 << ")\n"
                   << "socket        (USocket    " << (void*)socket              << ")\n"
                   << "host          (UString    " << (void*)host                << ")\n"
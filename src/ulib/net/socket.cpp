@@ -38,12 +38,22 @@ U_DUMP_KERNEL_VERSION(LINUX_VERSION_CODE)
 #ifdef HAVE_ARPA_INET_H
 #  include <net/if_arp.h>
 #endif
+#ifdef U_LINUX
+#  include <linux/bpf.h>
+#  include <sys/syscall.h>
+#  ifndef SO_ATTACH_REUSEPORT_EBPF
+#  define SO_ATTACH_REUSEPORT_EBPF 52
+#  endif
+#endif
 
 int            USocket::incoming_cpu = -1;
 int            USocket::iBackLog = SOMAXCONN;
 int            USocket::accept4_flags;  // If flags is 0, then accept4() is the same as accept()
 bool           USocket::breuseport;
 bool           USocket::bincoming_cpu;
+int            USocket::reuseport_index = -1;
+int            USocket::reuseport_map_fd = -1;
+int            USocket::reuseport_prog_fd = -1;
 SocketAddress* USocket::cLocal;
 
 #include "socket_address.cpp"
@@ -542,6 +552,30 @@ void USocket::reusePort(int _flags)
       if (incoming_cpu != -1) bincoming_cpu = setSockOpt(SOL_SOCKET, SO_INCOMING_CPU, (void*)&incoming_cpu);
 #  endif
 
+      U_INTERNAL_DUMP("reuseport_index = %d reuseport_map_fd = %d reuseport_prog_fd = %d", reuseport_index, reuseport_map_fd, reuseport_prog_fd)
+
+      if (reuseport_map_fd != -1 &&
+          reuseport_index  != -1)
+         {
+         // NB: we put our listening socket in the slot of this process, it replaces the one of a previous process with the same slot (respawn)...
+
+         union bpf_attr attr;
+         uint32_t key = reuseport_index, value = iSockDesc;
+
+         (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+         attr.map_fd = reuseport_map_fd;
+         attr.key    = (uintptr_t)&key;
+         attr.value  = (uintptr_t)&value;
+         attr.flags  = BPF_ANY;
+
+         if (U_SYSCALL(syscall, "%d,%d,%p,%u", __NR_bpf, BPF_MAP_UPDATE_ELEM, &attr, sizeof(attr)) != 0 ||
+             setSockOpt(SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, &reuseport_prog_fd, sizeof(int)) == false)
+            {
+            U_WARNING("SO_REUSEPORT cpu steering failed for the listening socket of slot %d (%R), the kernel use the standard hash", reuseport_index, 0); // NB: the last argument (0) is necessary...
+            }
+         }
+
       (void) U_SYSCALL(close, "%d", old);
       }
 #endif
@@ -551,6 +585,88 @@ void USocket::reusePort(int _flags)
 #endif
 }
 
+/**
+ * Cpu steering of the SO_REUSEPORT group: an eBPF program (BPF_PROG_TYPE_SK_REUSEPORT) select the listening socket for a new
+ * connection from a map (BPF_MAP_TYPE_REUSEPORT_SOCKARRAY) where every preforked process put its own listening socket at the
+ * index of its slot. The process of slot i is pinned to the cpu (i % num_cpu), so the program pick the index:
+ *
+ * cpu that processed the SYN + num_cpu * (random % (num_socket / num_cpu))
+ *
+ * The slot of a process that exit is empty (the kernel remove the closed socket from the map) until the process that take its
+ * place put there its socket: meanwhile (or if the selection fail) the kernel falls back to the standard hash of the group...
+ */
+
+bool USocket::setReusePortSteering(uint32_t num_socket, uint32_t num_cpu)
+{
+   U_TRACE(1, "USocket::setReusePortSteering(%u,%u)", num_socket, num_cpu)
+
+   U_INTERNAL_ASSERT_MAJOR(num_cpu, 0)
+   U_INTERNAL_ASSERT_EQUALS(reuseport_map_fd, -1)
+   U_INTERNAL_ASSERT_EQUALS(num_socket % num_cpu, 0)
+
+#if defined(U_LINUX) && defined(__NR_bpf)
+   union bpf_attr attr;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+   attr.map_type    = BPF_MAP_TYPE_REUSEPORT_SOCKARRAY;
+   attr.key_size    = sizeof(uint32_t);
+   attr.value_size  = sizeof(uint32_t);
+   attr.max_entries = num_socket;
+
+   reuseport_map_fd = U_SYSCALL(syscall, "%d,%d,%p,%u", __NR_bpf, BPF_MAP_CREATE, &attr, sizeof(attr));
+
+   if (reuseport_map_fd == -1) U_RETURN(false);
+
+   struct bpf_insn code[32];
+   uint32_t n = 0;
+
+#  define U_BPF_INSN(_code, _dst, _src, _off, _imm) { struct bpf_insn insn = { (uint8_t)(_code), (_dst), (_src), (int16_t)(_off), (int32_t)(_imm) }; code[n++] = insn; }
+
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X,   BPF_REG_6, BPF_REG_1,  0, 0)                            // r6 = ctx
+   U_BPF_INSN(BPF_JMP   | BPF_CALL,          0,         0,          0, BPF_FUNC_get_smp_processor_id) // r0 = cpu
+
+   if (num_socket > num_cpu)
+      {
+      U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_0,  0, 0)                            // r7 = cpu
+      U_BPF_INSN(BPF_JMP   | BPF_CALL,        0,         0,          0, BPF_FUNC_get_prandom_u32)     // r0 = random
+      U_BPF_INSN(BPF_ALU   | BPF_MOD | BPF_K, BPF_REG_0, 0,          0, num_socket / num_cpu)         // r0 = random % (num_socket / num_cpu)
+      U_BPF_INSN(BPF_ALU   | BPF_MUL | BPF_K, BPF_REG_0, 0,          0, num_cpu)                      // r0 = r0 * num_cpu
+      U_BPF_INSN(BPF_ALU   | BPF_ADD | BPF_X, BPF_REG_0, BPF_REG_7,  0, 0)                            // r0 = r0 + cpu
+      }
+
+   U_BPF_INSN(BPF_STX   | BPF_MEM | BPF_W,   BPF_REG_10, BPF_REG_0, -4, 0)                            // key = r0 (stack)
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X,   BPF_REG_1, BPF_REG_6,  0, 0)                            // r1 = ctx
+   U_BPF_INSN(BPF_LD    | BPF_DW  | BPF_IMM, BPF_REG_2, BPF_PSEUDO_MAP_FD, 0, reuseport_map_fd)      // r2 = map
+   U_BPF_INSN(0,                             0,         0,          0, 0)
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X,   BPF_REG_3, BPF_REG_10, 0, 0)                            // r3 = &key
+   U_BPF_INSN(BPF_ALU64 | BPF_ADD | BPF_K,   BPF_REG_3, 0,          0, -4)
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K,   BPF_REG_4, 0,          0, 0)                            // r4 = flags
+   U_BPF_INSN(BPF_JMP   | BPF_CALL,          0,         0,          0, BPF_FUNC_sk_select_reuseport)  // NB: if it fails the kernel use the hash...
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K,   BPF_REG_0, 0,          0, SK_PASS)                      // return SK_PASS
+   U_BPF_INSN(BPF_JMP   | BPF_EXIT,          0,         0,          0, 0)
+
+#  undef U_BPF_INSN
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+   attr.prog_type = BPF_PROG_TYPE_SK_REUSEPORT;
+   attr.insns     = (uintptr_t)code;
+   attr.insn_cnt  = n;
+   attr.license   = (uintptr_t)"GPL";
+
+   reuseport_prog_fd = U_SYSCALL(syscall, "%d,%d,%p,%u", __NR_bpf, BPF_PROG_LOAD, &attr, sizeof(attr));
+
+   if (reuseport_prog_fd != -1) U_RETURN(true);
+
+   (void) U_SYSCALL(close, "%d", reuseport_map_fd);
+
+   reuseport_map_fd = -1;
+#endif
+
+   U_RETURN(false);
+}
+
 void USocket::setRemote()
 {
    U_TRACE_NO_PARAM(1, "USocket::setRemote()")
@@ -872,7 +988,9 @@ void USocket::close_socket()
 #if defined(HAVE_EPOLL_WAIT) && !defined(USE_LIBEVENT)
    if (UNotifier::isHandler(iSockDesc))
       {
+#  ifndef USE_IO_URING
       (void) U_SYSCALL(epoll_ctl, "%d,%d,%d,%p", UNotifier::epollfd, EPOLL_CTL_DEL, iSockDesc, (struct epoll_event*)1);
+#  endif
 
       UNotifier::handlerDelete(iSockDesc, EPOLLIN | EPOLLRDHUP);
       }
@@ -995,7 +1113,7 @@ bool USocket::acceptClient(USocket* pcNewConnection)
          }
 #  endif
 
-      U_socket_Type(pcNewConnection) = U_socket_Type(this);
+      U_socket_Type(pcNewConnection) = U_socket_Type(this) | (U_socket_Type(pcNewConnection) & SK_KTLS); // NB: kTLS is for connection (see USSLSocket::acceptSSL())...
 
       U_RETURN(true);
       }
@@ -89,7 +89,251 @@ void UEventFd::operator()(int _fd, short event)
    if (ret == U_NOTIFIER_DELETE) UNotifier::handlerDelete(this);
 }
 #else
-# ifdef HAVE_EPOLL_WAIT
+# ifdef USE_IO_URING
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+
+#  define U_IO_URING_IGNORE ((__u64)-1) // user_data of the request whose completion is not interesting (cancel)
+
+int                  UNotifier::ring_fd;
+char*                UNotifier::ring_ptr;
+uint32_t*            UNotifier::sq_head;
+uint32_t*            UNotifier::sq_tail;
+uint32_t*            UNotifier::cq_head;
+uint32_t*            UNotifier::cq_tail;
+uint32_t             UNotifier::sq_mask;
+uint32_t             UNotifier::cq_mask;
+uint32_t             UNotifier::ring_len;
+uint32_t             UNotifier::ring_gen;
+uint32_t             UNotifier::sq_entries;
+struct io_uring_sqe* UNotifier::sqes;
+struct io_uring_cqe* UNotifier::cqes;
+static pid_t         ring_pid;
+
+U_NO_EXPORT void UNotifier::ringSetup()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::ringSetup()")
+
+   U_INTERNAL_ASSERT_EQUALS(ring_fd, 0)
+   U_INTERNAL_ASSERT_MAJOR(max_connection, 0)
+
+   struct io_uring_params params;
+
+   uint32_t entries = (max_connection < 64                     ? 64 :
+                       max_connection > U_IO_URING_MAX_ENTRIES ? U_IO_URING_MAX_ENTRIES : max_connection);
+
+   // NB: the submission ring is flushed when full, while on the completion ring each connection can have a completion pending...
+
+   (void) memset(&params, 0, sizeof(struct io_uring_params));
+
+   params.flags      = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+   params.cq_entries = (max_connection * 2 < entries * 2 ? entries * 2 :
+                        max_connection * 2 > 65536       ? 65536       : max_connection * 2);
+
+   ring_fd = U_SYSCALL(syscall, "%d,%u,%p", __NR_io_uring_setup, entries, &params);
+
+   if (ring_fd == -1 &&
+       errno == EINVAL) // IORING_SETUP_COOP_TASKRUN (Linux >= 5.19)
+      {
+      params.flags = IORING_SETUP_CQSIZE;
+
+      ring_fd = U_SYSCALL(syscall, "%d,%u,%p", __NR_io_uring_setup, entries, &params);
+      }
+
+   if (ring_fd == -1) U_ERROR("io_uring_setup() failed...");
+
+   U_INTERNAL_DUMP("params.features = %B sq_entries = %u cq_entries = %u", params.features, params.sq_entries, params.cq_entries)
+
+   // NB: IORING_FEAT_LINKED_FILE implies kernel >= 5.19 (multishot poll, IORING_ASYNC_CANCEL_ALL, IOSQE_CQE_SKIP_SUCCESS)
+
+   if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 ||
+       (params.features & IORING_FEAT_EXT_ARG)     == 0 ||
+       (params.features & IORING_FEAT_LINKED_FILE) == 0)
+      {
+      U_ERROR("io_uring: kernel too old (we need Linux >= 5.19)...");
+      }
+
+   ring_len = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+
+   uint32_t cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+   if (ring_len < cq_len) ring_len = cq_len;
+
+   ring_ptr = (char*) U_SYSCALL(mmap, "%p,%u,%d,%d,%d,%I", 0, ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+
+   if (ring_ptr == (char*)MAP_FAILED) U_ERROR("io_uring: mmap() of the rings failed...");
+
+   sq_entries = params.sq_entries;
+
+   sqes = (struct io_uring_sqe*) U_SYSCALL(mmap, "%p,%u,%d,%d,%d,%I", 0, sq_entries * sizeof(struct io_uring_sqe),
+                                           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+   if (sqes == (struct io_uring_sqe*)MAP_FAILED) U_ERROR("io_uring: mmap() of the submission entries failed...");
+
+   sq_head = (uint32_t*)(ring_ptr + params.sq_off.head);
+   sq_tail = (uint32_t*)(ring_ptr + params.sq_off.tail);
+   sq_mask = *(uint32_t*)(ring_ptr + params.sq_off.ring_mask);
+   cq_head = (uint32_t*)(ring_ptr + params.cq_off.head);
+   cq_tail = (uint32_t*)(ring_ptr + params.cq_off.tail);
+   cq_mask = *(uint32_t*)(ring_ptr + params.cq_off.ring_mask);
+   cqes    = (struct io_uring_cqe*)(ring_ptr + params.cq_off.cqes);
+
+   // NB: the slot i of the submission ring always points to the entry i...
+
+   uint32_t* sq_array = (uint32_t*)(ring_ptr + params.sq_off.array);
+
+   for (uint32_t i = 0; i < sq_entries; ++i) sq_array[i] = i;
+
+   ring_pid = u_pid;
+}
+
+U_NO_EXPORT void UNotifier::ringClose()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::ringClose()")
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   (void) U_SYSCALL(munmap, "%p,%u", sqes, sq_entries * sizeof(struct io_uring_sqe));
+   (void) U_SYSCALL(munmap, "%p,%u", ring_ptr, ring_len);
+
+   (void) U_SYSCALL(close, "%d", ring_fd);
+
+   ring_fd = 0;
+}
+
+U_NO_EXPORT struct io_uring_sqe* UNotifier::getSqe()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::getSqe()")
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   /**
+    * NB: the mapping of the rings is shared with the processes forked without calling init() after (ex: parallelization),
+    * they must not touch the interest set of the parent...
+    */
+
+   if (UNLIKELY(ring_pid != u_pid)) U_RETURN_POINTER(U_NULLPTR, struct io_uring_sqe);
+
+   uint32_t tail = *sq_tail;
+
+   if ((tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)) >= sq_entries) // the submission ring is full
+      {
+      (void) U_SYSCALL(syscall, "%d,%d,%u,%u,%u,%p,%u", __NR_io_uring_enter, ring_fd, sq_entries, 0, 0, 0, 0);
+      }
+
+   struct io_uring_sqe* sqe = sqes + (tail & sq_mask);
+
+   (void) memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+   U_RETURN_POINTER(sqe, struct io_uring_sqe);
+}
+
+/**
+ * The user_data of a poll request is the file descriptor (lower half) with the generation of the request (upper half): the
+ * completion is dispatched like with select() (setHandler(fd)) only if the generation is the same of the handler registered
+ * for the descriptor, so a completion still queued for a descriptor already closed and reused (or for a request replaced by
+ * modify()) is discarded. We must also cancel explicitly the request on close(), because the kernel keeps a reference to the
+ * file until the request is active, and the cancel must match the exact user_data (IORING_ASYNC_CANCEL_FD is useless after close)
+ */
+
+#define U_IO_URING_USER_DATA(item) (((__u64)(item)->ring_gen << 32) | (uint32_t)(item)->fd)
+
+U_NO_EXPORT void UNotifier::pollAdd(UEventFd* item, uint32_t mask)
+{
+   U_TRACE(0, "UNotifier::pollAdd(%p,%B)", item, mask)
+
+   lock();
+
+   struct io_uring_sqe* sqe = getSqe();
+
+   if (sqe)
+      {
+      if (++ring_gen == (uint32_t)-1) ring_gen = 1; // NB: (uint32_t)-1 is the upper half of U_IO_URING_IGNORE...
+
+      item->ring_gen = ring_gen;
+
+      sqe->opcode        = IORING_OP_POLL_ADD;
+      sqe->fd            = item->fd;
+      sqe->len           = ((mask & EPOLLET) != 0 ? IORING_POLL_ADD_MULTI : 0); // NB: level-triggered is a oneshot request rearmed after the dispatch...
+      sqe->poll32_events = (mask & ~EPOLLET);
+      sqe->user_data     = U_IO_URING_USER_DATA(item);
+
+      __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+      }
+
+   unlock();
+}
+
+U_NO_EXPORT void UNotifier::pollRemove(UEventFd* item)
+{
+   U_TRACE(0, "UNotifier::pollRemove(%p)", item)
+
+   U_INTERNAL_DUMP("fd = %d ring_gen = %u", item->fd, item->ring_gen)
+
+   lock();
+
+   struct io_uring_sqe* sqe = getSqe();
+
+   if (sqe)
+      {
+      sqe->opcode       = IORING_OP_ASYNC_CANCEL;
+      sqe->flags        = IOSQE_CQE_SKIP_SUCCESS;
+      sqe->addr         = U_IO_URING_USER_DATA(item);
+      sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+      sqe->user_data    = U_IO_URING_IGNORE;
+
+      __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+      }
+
+   item->ring_gen = 0; // NB: from now the completions of this request are discarded...
+
+   unlock();
+}
+
+U_NO_EXPORT int UNotifier::ringEnter(UEventTime* ptimeout)
+{
+   U_TRACE(1, "UNotifier::ringEnter(%p)", ptimeout)
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   int result;
+   struct __kernel_timespec ts;
+   struct io_uring_getevents_arg arg;
+
+   (void) memset(&arg, 0, sizeof(struct io_uring_getevents_arg));
+
+   if (ptimeout)
+      {
+      long ms = UEventTime::getMilliSecond(ptimeout);
+
+      if (ms < 0) ms = 0;
+
+      ts.tv_sec  =  ms / 1000L;
+      ts.tv_nsec = (ms % 1000L) * 1000000L;
+
+      arg.ts = (__u64)(uintptr_t)&ts;
+      }
+
+   // NB: with a single syscall we submit the pending changes of the interest set and we wait for the completions...
+
+   result = U_SYSCALL(syscall, "%d,%d,%u,%u,%u,%p,%u", __NR_io_uring_enter, ring_fd, *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE), 1,
+                                                       IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(struct io_uring_getevents_arg));
+
+   uint32_t ready = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) - *cq_head;
+
+   U_INTERNAL_DUMP("result = %d ready = %u", result, ready)
+
+   if (ready == 0 &&
+       result == -1)
+      {
+      if (errno == ETIME) U_RETURN(0);
+
+      U_RETURN(-1);
+      }
+
+   U_RETURN(ready);
+}
+# elif defined(HAVE_EPOLL_WAIT)
 int                  UNotifier::epollfd;
 struct epoll_event*  UNotifier::events;
 struct epoll_event*  UNotifier::pevents;
@@ -152,7 +396,52 @@ void UNotifier::init()
 {
    U_TRACE(0, "UNotifier::init()")
 
-#ifdef HAVE_EPOLL_WAIT
+#ifdef USE_IO_URING
+   int old = ring_fd;
+
+   U_INTERNAL_DUMP("old = %d", old)
+
+   if (old) ringClose();
+
+   ringSetup();
+
+   if (old)
+      {
+      U_INTERNAL_DUMP("num_connection = %u", num_connection)
+
+      if (num_connection)
+         {
+         U_INTERNAL_ASSERT_POINTER(lo_map_fd)
+         U_INTERNAL_ASSERT_POINTER(hi_map_fd)
+
+         // NB: reinitialized all after fork()...
+
+         for (int fd = 1; fd < (int32_t)lo_map_fd_len; ++fd)
+            {
+            if ((handler_event = lo_map_fd[fd]))
+               {
+               U_INTERNAL_DUMP("fd = %d op_mask = %d %B", fd, handler_event->op_mask, handler_event->op_mask)
+
+               pollAdd(handler_event, handler_event->op_mask | EPOLLEXCLUSIVE | EPOLLROUNDROBIN);
+               }
+            }
+
+         if (hi_map_fd->first())
+            {
+            do {
+               handler_event = hi_map_fd->elem();
+
+               U_INTERNAL_DUMP("op_mask = %d %B", handler_event->op_mask, handler_event->op_mask)
+
+               pollAdd(handler_event, handler_event->op_mask | EPOLLEXCLUSIVE | EPOLLROUNDROBIN);
+               }
+            while (hi_map_fd->next());
+            }
+         }
+
+      return;
+      }
+#elif defined(HAVE_EPOLL_WAIT)
    int old = epollfd;
 
    U_INTERNAL_DUMP("old = %d", old)
@@ -290,7 +579,7 @@ next:
       {
       createMapFd();
 
-#ifdef HAVE_EPOLL_WAIT
+#if defined(HAVE_EPOLL_WAIT) && !defined(USE_IO_URING)
       U_INTERNAL_ASSERT_EQUALS(events, U_NULLPTR)
 
        events =
@@ -314,7 +603,9 @@ void UNotifier::resume(UEventFd* item)
    U_INTERNAL_ASSERT_POINTER(item)
    U_INTERNAL_ASSERT_EQUALS(item->op_mask, EPOLLOUT)
 
-#ifdef HAVE_EPOLL_WAIT
+#ifdef USE_IO_URING
+   pollAdd(item, EPOLLOUT);
+#elif defined(HAVE_EPOLL_WAIT)
    struct epoll_event _events = { EPOLLOUT, { item } };
 
    (void) U_SYSCALL(epoll_ctl, "%d,%d,%d,%p", epollfd, EPOLL_CTL_ADD, item->fd, &_events);
@@ -346,7 +637,9 @@ void UNotifier::suspend(UEventFd* item)
    U_INTERNAL_ASSERT_POINTER(item)
    U_INTERNAL_ASSERT_EQUALS(item->op_mask, EPOLLOUT)
 
-#ifdef HAVE_EPOLL_WAIT
+#ifdef USE_IO_URING
+   pollRemove(item);
+#elif defined(HAVE_EPOLL_WAIT)
    (void) U_SYSCALL(epoll_ctl, "%d,%d,%d,%p", epollfd, EPOLL_CTL_DEL, item->fd, (struct epoll_event*)1);
 #elif defined(HAVE_KQUEUE)
    U_INTERNAL_ASSERT_MAJOR(kq, 0)
@@ -375,7 +668,9 @@ int UNotifier::waitForEvent(int fd_max, fd_set* read_set, fd_set* write_set, UEv
 
    int result;
 
-#ifdef HAVE_EPOLL_WAIT
+#ifdef USE_IO_URING
+   result = ringEnter(ptimeout);
+#elif defined(HAVE_EPOLL_WAIT)
    result = U_SYSCALL(epoll_wait, "%d,%p,%u,%d", epollfd, events, max_connection, UEventTime::getMilliSecond(ptimeout));
 #elif defined(HAVE_KQUEUE)
    result = U_SYSCALL(kevent, "%d,%p,%d,%p,%d,%p", kq, kqevents, nkqevents, kqrevents, max_connection, UEventTime::getTimeSpec(ptimeout));
@@ -422,6 +717,9 @@ loop:
                 (fd_write_cnt ? &write_set
                               : 0),
                 ptimeout);
+#elif defined(USE_IO_URING)
+loop:
+   nfd_ready = ringEnter(ptimeout);
 #elif defined(HAVE_KQUEUE)
 loop:
    nfd_ready = U_SYSCALL(kevent, "%d,%p,%d,%p,%d,%p", kq, kqevents, nkqevents, kqrevents, max_connection, UEventTime::getTimeSpec(ptimeout));
@@ -477,6 +775,48 @@ loop:
                }
             }
          }
+#  elif defined(USE_IO_URING)
+      int i = 0, fd, res;
+      uint32_t gen, flags, head = *cq_head;
+      struct io_uring_cqe* cqe;
+      __u64 user_data;
+
+loop0:
+      cqe       = cqes + (head & cq_mask);
+      user_data = cqe->user_data;
+      res       = cqe->res;
+      flags     = cqe->flags;
+      fd        = (int)(uint32_t)user_data;
+      gen       = (uint32_t)(user_data >> 32);
+
+      __atomic_store_n(cq_head, ++head, __ATOMIC_RELEASE); // NB: from now the kernel can reuse the slot...
+
+      U_INTERNAL_DUMP("i = %d fd = %d gen = %u res = %d flags = %u", i, fd, gen, res, flags)
+
+      if (user_data != U_IO_URING_IGNORE &&
+          res       != -ECANCELED        && // NB: request cancelled by suspend(), modify() or handlerDelete()...
+          setHandler(fd)                 &&
+          handler_event->ring_gen == gen) // NB: a completion of a request for a descriptor closed and reused is stale...
+         {
+         U_INTERNAL_ASSERT_EQUALS(handler_event->fd, fd)
+
+         U_INTERNAL_DUMP("bread = %b bwrite = %b", ((res & (EPOLLIN | EPOLLRDHUP)) != 0), ((res & EPOLLOUT) != 0))
+
+         if (UNLIKELY(res < 0)                                 ||
+             UNLIKELY((res & (EPOLLERR | EPOLLHUP))   != 0) ||
+              (LIKELY((res & (EPOLLIN  | EPOLLRDHUP)) != 0) ? handler_event->handlerRead()
+                                                            : handler_event->handlerWrite()) == U_NOTIFIER_DELETE)
+            {
+            handlerDelete(handler_event);
+            }
+         else if ((flags & IORING_CQE_F_MORE) == 0 && // oneshot request or multishot request terminated (ex: overflow of the completion ring)
+                  handler_event->ring_gen == gen)    // NB: not already replaced by modify() or cancelled by suspend()...
+            {
+            pollAdd(handler_event, handler_event->op_mask);
+            }
+         }
+
+      if (++i < nfd_ready) goto loop0;
 #  elif defined(HAVE_KQUEUE)
       int i = 0;
       struct kevent* pkqrevents = kqrevents;
@@ -670,7 +1010,7 @@ loop:
    if (nfd_ready == 0 &&
        ptimeout  != U_NULLPTR)
       {
-      U_INTERNAL_ASSERT_EQUALS(UTimer::first->alarm, ptimeout)
+      U_INTERNAL_ASSERT_EQUALS(UTimer::heap[0]->alarm, ptimeout)
 
       U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
 
@@ -802,6 +1142,8 @@ void UNotifier::insert(UEventFd* item, int op)
    U_NEW(UEvent<UEventFd>, item->pevent, UEvent<UEventFd>(fd, mask, *item));
 
    (void) UDispatcher::add(*(item->pevent));
+#elif defined(USE_IO_URING)
+   pollAdd(item, item->op_mask | op);
 #elif defined(HAVE_EPOLL_WAIT)
    U_INTERNAL_ASSERT_MAJOR(epollfd, 0)
 
@@ -858,6 +1200,40 @@ void UNotifier::insert(UEventFd* item, int op)
 #endif
 }
 
+/**
+ * handlerDelete() don't remove the fd from the interest set of the kernel (epoll/kqueue) because the fd is closed after
+ * (and the kernel do it at close). For a fd that stay open (ex: a client connection that we keep) we must call this too,
+ * otherwise we can get an event for a handler that don't exist anymore...
+ */
+
+void UNotifier::erase(UEventFd* item)
+{
+   U_TRACE(0, "UNotifier::erase(%p)", item)
+
+   U_INTERNAL_ASSERT_POINTER(item)
+   U_INTERNAL_ASSERT_DIFFERS(item->fd, -1)
+
+#ifdef USE_LIBEVENT
+   if (item->pevent)
+      {
+      UDispatcher::del(item->pevent);
+                delete item->pevent;
+                       item->pevent = U_NULLPTR;
+      }
+#elif defined(USE_IO_URING)
+   // NB: the poll request is already cancelled by handlerDelete()...
+#elif defined(HAVE_EPOLL_WAIT)
+   U_INTERNAL_ASSERT_MAJOR(epollfd, 0)
+
+   (void) U_SYSCALL(epoll_ctl, "%d,%d,%d,%p", epollfd, EPOLL_CTL_DEL, item->fd, (struct epoll_event*)1);
+#elif defined(HAVE_KQUEUE)
+   U_INTERNAL_ASSERT_MAJOR(kq, 0)
+   U_INTERNAL_ASSERT_MINOR(nkqevents, max_connection)
+
+   EV_SET(kqevents+nkqevents++, item->fd, ((item->op_mask & (EPOLLIN | EPOLLRDHUP)) != 0) ? EVFILT_READ : EVFILT_WRITE, EV_DELETE | EV_DISABLE, 0, 0, (void*)item);
+#endif
+}
+
 void UNotifier::modify(UEventFd* item)
 {
    U_TRACE(0, "UNotifier::modify(%p)", item)
@@ -881,6 +1257,9 @@ void UNotifier::modify(UEventFd* item)
    U_NEW(UEvent<UEventFd>, item->pevent, UEvent<UEventFd>(fd, mask, *item));
 
    (void) UDispatcher::add(*(item->pevent));
+#elif defined(USE_IO_URING)
+   pollRemove(item);
+   pollAdd(item, item->op_mask);
 #elif defined(HAVE_EPOLL_WAIT)
    U_INTERNAL_ASSERT_MAJOR(epollfd, 0)
 
@@ -958,17 +1337,39 @@ void UNotifier::handlerDelete(int fd, int mask)
 
    U_INTERNAL_ASSERT_MAJOR(fd, 0)
 
-   if (fd < (int32_t)lo_map_fd_len) lo_map_fd[fd] = U_NULLPTR;
+#ifdef USE_IO_URING
+   UEventFd* item = U_NULLPTR;
+#endif
+
+   if (fd < (int32_t)lo_map_fd_len)
+      {
+#  ifdef USE_IO_URING
+      item = lo_map_fd[fd];
+#  endif
+
+      lo_map_fd[fd] = U_NULLPTR;
+      }
    else
       {
       lock();
 
+#  ifdef USE_IO_URING
+      if (hi_map_fd->find(fd))
+         {
+         item = hi_map_fd->elem();
+
+         hi_map_fd->eraseAfterFind();
+         }
+#  else
       (void) hi_map_fd->erase(fd);
+#  endif
 
       unlock();
       }
 
-#if !defined(USE_LIBEVENT) && !defined(HAVE_EPOLL_WAIT) && !defined(HAVE_KQUEUE)
+#ifdef USE_IO_URING
+   if (item) pollRemove(item);
+#elif !defined(USE_LIBEVENT) && !defined(HAVE_EPOLL_WAIT) && !defined(HAVE_KQUEUE)
    if ((mask & (EPOLLIN | EPOLLRDHUP)) != 0)
       {
       U_INTERNAL_ASSERT(FD_ISSET(fd, &fd_set_read))
@@ -1120,7 +1521,9 @@ void UNotifier::clear()
    delete hi_map_fd;
 
 #ifndef USE_LIBEVENT
-# ifdef HAVE_EPOLL_WAIT
+# ifdef USE_IO_URING
+   ringClose();
+# elif defined(HAVE_EPOLL_WAIT)
    U_INTERNAL_ASSERT_POINTER(events)
 
    UMemoryPool::_free(events, max_connection + 1, sizeof(struct epoll_event));
@@ -1488,6 +1891,9 @@ const char* UNotifier::dump(bool reset) const
 {
 #ifdef USE_LIBEVENT
 // nothing
+#elif defined(USE_IO_URING)
+   *UObjectIO::os << "ring_fd                     " << ring_fd        << '\n'
+                  << "sq_entries                  " << sq_entries     << '\n';
 #elif defined(HAVE_EPOLL_WAIT)
    *UObjectIO::os << "epollfd                     " << epollfd        << '\n';
 #elif defined(HAVE_KQUEUE)
@@ -57,6 +57,11 @@
 #else
 #  define LIBZOPFLI_ENABLE   "no"
 #endif
+#ifdef USE_LIBBROTLI
+#  define LIBBROTLI_ENABLE   "yes ( " _LIBBROTLI_VERSION " )"
+#else
+#  define LIBBROTLI_ENABLE   "no"
+#endif
 #ifdef USE_LIBTDB
 #  define LIBTDB_ENABLE      "yes ( " _LIBTDB_VERSION " )"
 #else
@@ -655,6 +660,7 @@ uint32_t UOptions::getopt(int argc, char** argv, int* poptind)
          thread support: enabled
            LIBZ support: yes ( 1.2.6 )
       LIBZOPFLI support: yes ( 1.0.1 )
+      LIBBROTLI support: yes ( 1.0.9 )
          LIBTDB support: yes ( 1.3.5 )
            PCRE support: yes ( 8.12 )
             SSL support: yes ( 1.0.0e )
@@ -715,6 +721,7 @@ PYTHON language support: yes ( 2.7 )
       "memory pool support....:%W " MEMORY_POOL_ENABLE "%W\n\n" \
       "LIBZ support...........:%W " LIBZ_ENABLE "%W\n" \
       "LIBZOPFLI support......:%W " LIBZOPFLI_ENABLE "%W\n" \
+      "LIBBROTLI support......:%W " LIBBROTLI_ENABLE "%W\n" \
       "LIBTDB support.........:%W " LIBTDB_ENABLE "%W\n" \
       "PCRE support...........:%W " LIBPCRE_ENABLE "%W\n" \
       "SSL support............:%W " LIBSSL_ENABLE "%W\n" \
@@ -792,6 +799,7 @@ PYTHON language support: yes ( 2.7 )
                BRIGHTYELLOW, RESET,
                BRIGHTYELLOW, RESET,
                BRIGHTYELLOW, RESET,
+               BRIGHTYELLOW, RESET,
                // parser
                BRIGHTYELLOW, RESET,
                BRIGHTYELLOW, RESET);
@@ -11,6 +11,7 @@
 //
 // ============================================================================
 
+#include <ulib/notifier.h>
 #include <ulib/net/socket.h>
 #include <ulib/orm/driver/orm_driver_pgsql.h>
 
@@ -186,6 +187,7 @@ UPgSqlStatement::UPgSqlStatement(const char* s, uint32_t n) : USqlStatement(U_NU
    (void) stmt.shrink();
 
    res          = U_NULLPTR;
+   nreset       = 0;
    paramValues  = U_NULLPTR;
    paramFormats = paramLengths = U_NULLPTR;
    resultFormat = true; // is zero to obtain results in text format, or one to obtain results in binary format
@@ -279,6 +281,19 @@ bool UPgSqlStatement::setBindParam(UOrmDriver* pdrv)
          }
       }
 
+   if (pHandle &&
+       ((UOrmDriverPgSql*)pdrv)->isPrepared(this) == false) // NB: the connection was reset, the statement is no more prepared...
+      {
+      U_SYSCALL_VOID(PQclear, "%p", (PGresult*)pHandle);
+                                               pHandle = U_NULLPTR;
+
+      if (res)
+         {
+         U_SYSCALL_VOID(PQclear, "%p", res);
+                                       res = U_NULLPTR;
+         }
+      }
+
    if (pHandle == U_NULLPTR)
       {
       /**
@@ -336,6 +351,8 @@ bool UPgSqlStatement::setBindParam(UOrmDriver* pdrv)
 
       num_bind_result = U_SYSCALL(PQnfields, "%p", res);
 
+      nreset = ((UOrmDriverPgSql*)pdrv)->nreset;
+
 #  ifdef DEBUG
       Oid paramtype;
 
@@ -563,6 +580,341 @@ void UOrmDriverPgSql::execute(USqlStatement* pstmt)
    ((UPgSqlStatement*)pstmt)->setBindResult(this);
 }
 
+U_NO_EXPORT bool UOrmDriverPgSql::getBatchResult(UPgSqlStatement* pstmt, uint32_t i, vPFpvu getResult, void* obj)
+{
+   U_TRACE(0, "UOrmDriverPgSql::getBatchResult(%p,%u,%p,%p)", pstmt, i, getResult, obj)
+
+   bool result = false;
+   PGresult* res = (PGresult*) U_SYSCALL(PQgetResult, "%p", (PGconn*)UOrmDriver::connection);
+
+   if (res == U_NULLPTR)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   if (U_SYSCALL(PQresultStatus, "%p", res) == PGRES_PIPELINE_ABORTED) U_SYSCALL_VOID(PQclear, "%p", res); // NB: a previous execution of the pipeline is failed...
+   else if (checkExecution(res))
+      {
+      result = true;
+
+      U_SYSCALL_VOID(PQclear, "%p", pstmt->res);
+
+      pstmt->res = res;
+
+      pstmt->current_row    =
+      pstmt->num_row_result = 0;
+
+      pstmt->setBindResult(this);
+
+      if (getResult) getResult(obj, i);
+      }
+
+   // NB: in pipeline mode the results of every execution are terminated by a null pointer...
+
+   while ((res = (PGresult*) U_SYSCALL(PQgetResult, "%p", (PGconn*)UOrmDriver::connection))) U_SYSCALL_VOID(PQclear, "%p", res);
+
+   U_RETURN(result);
+}
+
+bool UOrmDriverPgSql::executeBatch(USqlStatement* pstmt, uint32_t n, vPFpvu setParam, vPFpvu getResult, void* obj)
+{
+   U_TRACE(0, "UOrmDriverPgSql::executeBatch(%p,%u,%p,%p,%p)", pstmt, n, setParam, getResult, obj)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+#ifndef LIBPQ_HAS_PIPELINING
+   return UOrmDriver::executeBatch(pstmt, n, setParam, getResult, obj);
+#else
+   PGresult* res;
+   bool result = true;
+   uint32_t i, j, end;
+   PGconn* conn = (PGconn*)UOrmDriver::connection;
+
+   // NB: PQprepare() is synchronous and it is not allowed in pipeline mode, so we prepare the statement (if needed) before to enter it...
+
+   if (isPrepared((UPgSqlStatement*)pstmt) == false &&
+       ((UPgSqlStatement*)pstmt)->setBindParam(this) == false)
+      {
+      U_RETURN(false);
+      }
+
+   if (U_SYSCALL(PQenterPipelineMode, "%p", conn) == 0)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   for (i = 0; i < n; i = j)
+      {
+      end = U_min(n, i + U_PGSQL_PIPELINE_DEPTH);
+
+      for (j = i; j < end; ++j)
+         {
+         if (setParam) setParam(obj, j);
+
+         (void) ((UPgSqlStatement*)pstmt)->setBindParam(this); // NB: the statement is prepared so it can't fail...
+
+         if (U_SYSCALL(PQsendQueryPrepared, "%p,%S,%d,%p,%p,%p,%d",
+                        conn,
+                        ((UPgSqlStatement*)pstmt)->stmtName,
+                        pstmt->num_bind_param,
+                        ((UPgSqlStatement*)pstmt)->paramValues,
+                        ((UPgSqlStatement*)pstmt)->paramLengths,
+                        ((UPgSqlStatement*)pstmt)->paramFormats,
+                        ((UPgSqlStatement*)pstmt)->resultFormat) == 0)
+            {
+            UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+            result = false;
+
+            break;
+            }
+         }
+
+      if (U_SYSCALL(PQpipelineSync, "%p", conn) == 0)
+         {
+         UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+         (void) U_SYSCALL(PQexitPipelineMode, "%p", conn);
+
+         U_RETURN(false);
+         }
+
+      U_INTERNAL_DUMP("sent = %u", j - i)
+
+      for (uint32_t k = i; k < j; ++k)
+         {
+         if (getBatchResult((UPgSqlStatement*)pstmt, k, getResult, obj) == false) result = false;
+         }
+
+      if ((res = (PGresult*) U_SYSCALL(PQgetResult, "%p", conn))) // PGRES_PIPELINE_SYNC
+         {
+         U_INTERNAL_ASSERT_EQUALS(PQresultStatus(res), PGRES_PIPELINE_SYNC)
+
+         U_SYSCALL_VOID(PQclear, "%p", res);
+         }
+
+      if (j < end) break;
+      }
+
+   if (U_SYSCALL(PQexitPipelineMode, "%p", conn) == 0)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   U_RETURN(result);
+#endif
+}
+
+int UOrmDriverPgSql::getFd()
+{
+   U_TRACE_NO_PARAM(0, "UOrmDriverPgSql::getFd()")
+
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+   int sfd = U_SYSCALL(PQsocket, "%p", (PGconn*)UOrmDriver::connection);
+
+   U_RETURN(sfd);
+}
+
+bool UOrmDriverPgSql::asyncSend(USqlStatement* pstmt)
+{
+   U_TRACE(0, "UOrmDriverPgSql::asyncSend(%p)", pstmt)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+#ifndef LIBPQ_HAS_PIPELINING
+   U_RETURN(false);
+#else
+   int r;
+   PGconn* conn = (PGconn*)UOrmDriver::connection;
+
+   if (isPrepared((UPgSqlStatement*)pstmt) == false)
+      {
+      // NB: in pipeline mode we can't prepare the statement (it is synchronous), so we must wait the end of the executions in flight...
+
+      if (UOrmDriver::getNumAsyncInFlight()) U_RETURN(false);
+
+      if (U_SYSCALL(PQpipelineStatus, "%p", conn) != PQ_PIPELINE_OFF &&
+          U_SYSCALL(PQexitPipelineMode, "%p", conn) == 0)
+         {
+         UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+         U_RETURN(false);
+         }
+      }
+
+   if (((UPgSqlStatement*)pstmt)->setBindParam(this) == false) U_RETURN(false);
+
+   if (U_SYSCALL(PQpipelineStatus, "%p", conn) == PQ_PIPELINE_OFF)
+      {
+      if (U_SYSCALL(PQsetnonblocking, "%p,%d", conn, 1)  != 0 ||
+          U_SYSCALL(PQenterPipelineMode, "%p", conn) == 0)
+         {
+         UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+         U_RETURN(false);
+         }
+
+      async_status = U_ORM_ASYNC_AGAIN;
+      }
+
+   U_INTERNAL_ASSERT(UOrmDriver::getNumAsyncInFlight() || async_status == U_ORM_ASYNC_AGAIN)
+
+   if (U_SYSCALL(PQsendQueryPrepared, "%p,%S,%d,%p,%p,%p,%d",
+                  conn,
+                  ((UPgSqlStatement*)pstmt)->stmtName,
+                  pstmt->num_bind_param,
+                  ((UPgSqlStatement*)pstmt)->paramValues,
+                  ((UPgSqlStatement*)pstmt)->paramLengths,
+                  ((UPgSqlStatement*)pstmt)->paramFormats,
+                  ((UPgSqlStatement*)pstmt)->resultFormat) == 0 ||
+       U_SYSCALL(PQpipelineSync, "%p", conn) == 0)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   // NB: the connection is nonblocking, if the socket buffer is full we must wait to send the rest of the output...
+
+   while ((r = U_SYSCALL(PQflush, "%p", conn)) == 1)
+      {
+      if (UNotifier::waitForWrite(U_SYSCALL(PQsocket, "%p", conn), U_TIMEOUT_MS) != 1) break;
+      }
+
+   if (r) UOrmDriver::printError(__PRETTY_FUNCTION__); // NB: the execution is queued, the connection lost is reported by asyncRead()...
+
+   U_RETURN(true);
+#endif
+}
+
+bool UOrmDriverPgSql::asyncReset()
+{
+   U_TRACE_NO_PARAM(0, "UOrmDriverPgSql::asyncReset()")
+
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+   PGconn* conn = (PGconn*)UOrmDriver::connection;
+
+   async_status = U_ORM_ASYNC_AGAIN;
+
+#ifdef LIBPQ_HAS_PIPELINING
+   // NB: we can exit the pipeline mode only if there are no results pending (the ones of the executions that we have failed)...
+
+   if (U_SYSCALL(PQstatus, "%p", conn) == CONNECTION_OK &&
+       (U_SYSCALL(PQpipelineStatus, "%p", conn) == PQ_PIPELINE_OFF ||
+        U_SYSCALL(PQexitPipelineMode, "%p", conn) == 1)           &&
+       U_SYSCALL(PQsetnonblocking, "%p,%d", conn, 0) == 0)
+      {
+      U_RETURN(true);
+      }
+#endif
+
+   // NB: the connection is lost or in a state that we can't recover, we open it again (the statements prepared in the session are lost)...
+
+   U_SYSCALL_VOID(PQreset, "%p", conn);
+
+   ++nreset;
+
+   if (U_SYSCALL(PQstatus, "%p", conn) != CONNECTION_OK)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+bool UOrmDriverPgSql::asyncRead()
+{
+   U_TRACE_NO_PARAM(0, "UOrmDriverPgSql::asyncRead()")
+
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+   if (U_SYSCALL(PQconsumeInput, "%p", (PGconn*)UOrmDriver::connection) == 0)
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+int UOrmDriverPgSql::asyncResult(USqlStatement* pstmt)
+{
+   U_TRACE(0, "UOrmDriverPgSql::asyncResult(%p)", pstmt)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+#ifndef LIBPQ_HAS_PIPELINING
+   U_RETURN(U_ORM_ASYNC_ERROR);
+#else
+   int result;
+   PGresult* res;
+   bool bnull = false;
+   PGconn* conn = (PGconn*)UOrmDriver::connection;
+
+   while (U_SYSCALL(PQisBusy, "%p", conn) == 0)
+      {
+      res = (PGresult*) U_SYSCALL(PQgetResult, "%p", conn);
+
+      if (res == U_NULLPTR) // NB: in pipeline mode the results of every execution are terminated by a null pointer...
+         {
+         if (bnull) break;
+
+         bnull = true;
+
+         continue;
+         }
+
+      bnull = false;
+
+      if (U_SYSCALL(PQresultStatus, "%p", res) == PGRES_PIPELINE_SYNC)
+         {
+         U_SYSCALL_VOID(PQclear, "%p", res);
+
+         result = (async_status == U_ORM_ASYNC_OK ? U_ORM_ASYNC_OK : U_ORM_ASYNC_ERROR);
+
+         async_status = U_ORM_ASYNC_AGAIN;
+
+         // NB: we bind the result only now, just before the callback, because in the meanwhile the binding
+         //     registers can be changed by other executions (they are often the same of the binding param)...
+
+         if (result == U_ORM_ASYNC_OK) ((UPgSqlStatement*)pstmt)->setBindResult(this);
+
+         U_RETURN(result);
+         }
+
+      if (async_status != U_ORM_ASYNC_AGAIN) U_SYSCALL_VOID(PQclear, "%p", res);
+      else if (checkExecution(res) == false) async_status = U_ORM_ASYNC_ERROR;
+      else
+         {
+         async_status = U_ORM_ASYNC_OK;
+
+         U_SYSCALL_VOID(PQclear, "%p", ((UPgSqlStatement*)pstmt)->res);
+
+         ((UPgSqlStatement*)pstmt)->res = res;
+
+         pstmt->current_row    =
+         pstmt->num_row_result = 0;
+         }
+      }
+
+   U_RETURN(U_ORM_ASYNC_AGAIN);
+#endif
+}
+
 bool UOrmDriverPgSql::nextRow(USqlStatement* pstmt)
 {
    U_TRACE(0, "UOrmDriverPgSql::nextRow(%p)", pstmt)
@@ -670,6 +1022,7 @@ const char* UPgSqlStatement::dump(bool _reset) const
    USqlStatement::dump(false);
 
    *UObjectIO::os << '\n'
+                  << "nreset                                     " << nreset   << '\n'
                   << "stmtName                                   " << stmtName;
 
    if (_reset)
@@ -686,7 +1039,9 @@ const char* UOrmDriverPgSql::dump(bool _reset) const
 {
    UOrmDriver::dump(false);
 
-   *UObjectIO::os << '\n';
+   *UObjectIO::os << '\n'
+                  << "nreset                   " << nreset       << '\n'
+                  << "async_status             " << async_status << '\n';
 
    if (_reset)
       {
@@ -12,6 +12,7 @@
 // ============================================================================
 
 #include <ulib/orm/orm.h>
+#include <ulib/notifier.h>
 #include <ulib/orm/orm_driver.h>
 
 #if defined(U_STDCPP_ENABLE) && !defined(HAVE_OLD_IOSTREAM)
@@ -106,6 +107,14 @@ UOrmSession::~UOrmSession()
 
    if (pdrv)
       {
+      if (pdrv->pasync &&
+          pdrv->pasync->fd != -1)
+         {
+         pdrv->pasync->breset = false; // NB: we are going to close the connection...
+
+         UNotifier::handlerDelete(pdrv->pasync); // NB: the connection was registered by executeAsync()...
+         }
+
       pdrv->handlerDisConnect();
 
       if (UOrmDriver::vdriver->find(pdrv) != U_NOT_FOUND) pdrv->vopt.clear();
@@ -250,11 +259,47 @@ void UOrmStatement::execute()
    U_INTERNAL_ASSERT_POINTER(pstmt)
    U_INTERNAL_ASSERT_POINTER(psession->pdrv)
    U_INTERNAL_ASSERT_EQUALS(pdrv, psession->pdrv)
+   U_INTERNAL_ASSERT_EQUALS(pdrv->getNumAsyncInFlight(), 0)
 
    pdrv->execute(pstmt);
 #endif
 }
 
+bool UOrmStatement::executeAsync(vPFpvb func, void* arg)
+{
+   U_TRACE(0, "UOrmStatement::executeAsync(%p,%p)", func, arg)
+
+#if defined(USE_SQLITE) || defined(USE_MYSQL) || defined(USE_PGSQL)
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(psession->pdrv)
+   U_INTERNAL_ASSERT_EQUALS(pdrv, psession->pdrv)
+
+   if (pdrv->executeAsync(pstmt, func, arg)) U_RETURN(true);
+#endif
+
+   U_RETURN(false);
+}
+
+bool UOrmStatement::executeBatch(uint32_t n, vPFpvu setParam, vPFpvu getResult, void* obj)
+{
+   U_TRACE(0, "UOrmStatement::executeBatch(%u,%p,%p,%p)", n, setParam, getResult, obj)
+
+#if defined(USE_SQLITE) || defined(USE_MYSQL) || defined(USE_PGSQL)
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(psession->pdrv)
+   U_INTERNAL_ASSERT_EQUALS(pdrv, psession->pdrv)
+   U_INTERNAL_ASSERT_EQUALS(pdrv->getNumAsyncInFlight(), 0)
+
+   if (n == 0 ||
+       pdrv->executeBatch(pstmt, n, setParam, getResult, obj))
+      {
+      U_RETURN(true);
+      }
+#endif
+
+   U_RETURN(false);
+}
+
 // This function returns the number of database rows that were changed
 // or inserted or deleted by the most recently completed SQL statement
 
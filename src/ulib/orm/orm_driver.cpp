@@ -37,6 +37,8 @@ UVector<UOrmDriver*>* UOrmDriver::vdriver;
 UOrmDriver::~UOrmDriver()
 {
    U_TRACE_UNREGISTER_OBJECT(0, UOrmDriver)
+
+   if (pasync) delete pasync;
 }
 
 void UOrmDriver::clear()
@@ -204,6 +206,8 @@ void UOrmDriver::printError(const char* function)
 
    handlerError();
 
+   ++nerror;
+
    const char* ptr1 = (errname  == U_NULLPTR ? (errname  = "") : " ");
    const char* ptr2 = (SQLSTATE == U_NULLPTR ? (SQLSTATE = "") : " - SQLSTATE: ");
 
@@ -299,6 +303,150 @@ UString UOrmDriver::getOptionValue(const char* _name, uint32_t len)
    return UString::getStringNull();
 }
 
+bool UOrmDriver::executeBatch(USqlStatement* pstmt, uint32_t n, vPFpvu setParam, vPFpvu getResult, void* obj)
+{
+   U_TRACE(0, "UOrmDriver::executeBatch(%p,%u,%p,%p,%p)", pstmt, n, setParam, getResult, obj)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+
+   // NB: the driver don't support pipelining, we execute them serially and we stop at the first execution that fail
+   //     (execute() don't return a status, the error is reported with printError() that reset errcode)...
+
+   for (uint32_t i = 0, nerror0 = nerror; i < n; ++i)
+      {
+      if (setParam) setParam(obj, i);
+
+      execute(pstmt);
+
+      if (nerror != nerror0) U_RETURN(false);
+
+      if (getResult) getResult(obj, i);
+      }
+
+   U_RETURN(true);
+}
+
+bool UOrmDriver::executeAsync(USqlStatement* pstmt, vPFpvb func, void* arg)
+{
+   U_TRACE(0, "UOrmDriver::executeAsync(%p,%p,%p)", pstmt, func, arg)
+
+   U_INTERNAL_ASSERT_POINTER(func)
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+
+   if (pasync == U_NULLPTR) U_NEW(UOrmAsync, pasync, UOrmAsync(this));
+
+   if (pasync->num == U_ORM_ASYNC_MAX ||
+       asyncSend(pstmt) == false)
+      {
+      U_RETURN(false);
+      }
+
+   pasync->push(pstmt, func, arg);
+
+   U_RETURN(true);
+}
+
+UOrmAsync::~UOrmAsync()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UOrmAsync)
+
+   U_INTERNAL_ASSERT_EQUALS(num, 0)
+}
+
+void UOrmAsync::push(USqlStatement* pstmt, vPFpvb func, void* arg)
+{
+   U_TRACE(0, "UOrmAsync::push(%p,%p,%p)", pstmt, func, arg)
+
+   U_INTERNAL_ASSERT_MINOR(num, U_ORM_ASYNC_MAX)
+
+   uormasync* item = queue + ((head + num++) & (U_ORM_ASYNC_MAX-1));
+
+   item->pstmt = pstmt;
+   item->func  = func;
+   item->arg   = arg;
+
+   U_INTERNAL_DUMP("head = %u num = %u UEventFd::fd = %d", head, num, UEventFd::fd)
+
+   if (UEventFd::fd == -1)
+      {
+      // NB: the connection stay registered with UNotifier until it is closed...
+
+      UEventFd::fd      = pdrv->getFd();
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP;
+
+      UNotifier::insert(this);
+      }
+}
+
+int UOrmAsync::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UOrmAsync::handlerRead()")
+
+   if (pdrv->asyncRead() == false) U_RETURN(U_NOTIFIER_DELETE);
+
+   int result;
+   vPFpvb func;
+   void* arg;
+
+   while (num)
+      {
+      result = pdrv->asyncResult(queue[head].pstmt);
+
+      if (result == U_ORM_ASYNC_AGAIN) break;
+
+      func = queue[head].func;
+      arg  = queue[head].arg;
+
+      head = (head + 1) & (U_ORM_ASYNC_MAX-1);
+
+      --num;
+
+      func(arg, result == U_ORM_ASYNC_OK); // NB: it can call executeAsync() again...
+      }
+
+   U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN; // NB: all the input available is consumed (we are edge triggered)...
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+void UOrmAsync::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UOrmAsync::handlerDelete()")
+
+   U_INTERNAL_DUMP("UEventFd::fd = %d num = %u", UEventFd::fd, num)
+
+   // NB: we are owned by the driver, we only unregister the connection and fail the executions in flight...
+
+   UNotifier::erase(this);
+
+   UEventFd::fd = -1;
+
+   vPFpvb func;
+   void* arg;
+
+   while (num)
+      {
+      func = queue[head].func;
+      arg  = queue[head].arg;
+
+      head = (head + 1) & (U_ORM_ASYNC_MAX-1);
+
+      --num;
+
+      func(arg, false);
+      }
+
+   head = 0;
+
+   // NB: the connection can be lost or with the results of the failed executions still pending, we must not leave it as it was...
+
+   if (breset &&
+       pdrv->asyncReset() == false)
+      {
+      U_WARNING("UOrmAsync::handlerDelete(): the connection to the database %V can't be restored", pdrv->dbname.rep);
+      }
+}
+
 USqlStatementBindParam::USqlStatementBindParam(const char* s, int n, bool bstatic)
 {
    U_TRACE_REGISTER_OBJECT(0, USqlStatementBindParam, "%.*S,%u,%b", n, s, n, bstatic)
@@ -683,11 +831,31 @@ const char* USqlStatement::dump(bool _reset) const
    return U_NULLPTR;
 }
 
+const char* UOrmAsync::dump(bool _reset) const
+{
+   *UObjectIO::os << "fd                       " << fd            << '\n'
+                  << "num                      " << num           << '\n'
+                  << "head                     " << head          << '\n'
+                  << "breset                   " << breset        << '\n'
+                  << "pdrv                     " << (void*)pdrv;
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
 const char* UOrmDriver::dump(bool _reset) const
 {
    *UObjectIO::os << "errmsg                   " << (void*)errmsg     << '\n'
                   << "errcode                  " << errcode           << '\n'
+                  << "nerror                   " << nerror            << '\n'
                   << "connection               " << (void*)connection << '\n'
+                  << "pasync                   " << (void*)pasync     << '\n'
                   << "opt    (UString          " << (void*)&opt       << ")\n"
                   << "name   (UString          " << (void*)&name      << ")\n"
                   << "dbname (UString          " << (void*)&dbname    << ")\n"
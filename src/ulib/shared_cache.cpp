@@ -0,0 +1,563 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    shared_cache.cpp
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/shared_cache.h>
+
+#define U_NO_TTL           (uint32_t)-1
+#define U_LOG_HEAD         8U          // NB: pos 0 of the log mean empty slot...
+#define U_SHARD_MIN_SIZE   (16U * 1024U)
+#define U_SHARD_MAGIC      0x55534843  // "USHC"
+#define U_MAX_SECOND_CHANCE 8          // max number of entries moved for each set (to bound the latency of the CLOCK)
+
+USharedCache::~USharedCache()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, USharedCache)
+
+   if (fd != -1)
+      {
+      UFile::close(fd);
+
+      UFile::munmap(info, sizeof(USharedCache::cache_info) + info->nshard * info->shard_size);
+      }
+}
+
+void USharedCache::lock(shard_info* shard)
+{
+   U_TRACE(0, "USharedCache::lock(%p)", shard)
+
+#ifdef HAVE_GCC_ATOMICS
+   uint32_t owner, cnt = 0;
+
+   while (__sync_bool_compare_and_swap(&shard->lock, 0, (uint32_t)u_pid) == false)
+      {
+      if (++cnt < 128) continue;
+
+      (void) sched_yield();
+
+      // NB: a process can die (ex: SIGKILL) holding the lock, in this case we take it and reset the shard...
+
+      if ((cnt & 1023) == 0                                   &&
+          (owner = shard->lock) != 0                          &&
+          U_SYSCALL(kill, "%d,%d", (pid_t)owner, 0) == -1     &&
+          errno == ESRCH                                      &&
+          __sync_bool_compare_and_swap(&shard->lock, owner, (uint32_t)u_pid))
+         {
+         U_WARNING("USharedCache: the process %u died holding the lock of a shard, the shard is reset", owner);
+
+         shard->size = 0; // NB: notify to the caller that we must reset the shard...
+
+         break;
+         }
+      }
+#else
+   while (shard->lock) (void) sched_yield();
+
+   shard->lock = (uint32_t)u_pid;
+#endif
+}
+
+void USharedCache::unlock(shard_info* shard)
+{
+   U_TRACE(0, "USharedCache::unlock(%p)", shard)
+
+   U_INTERNAL_ASSERT_EQUALS(shard->lock, (uint32_t)u_pid)
+
+#ifdef HAVE_GCC_ATOMICS
+   (void) __sync_lock_test_and_set(&shard->lock, 0);
+#else
+   shard->lock = 0;
+#endif
+}
+
+void USharedCache::resetShard(shard_info* shard)
+{
+   U_TRACE(1, "USharedCache::resetShard(%p)", shard)
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", getSlot(shard), 0, info->nslot * sizeof(USharedCache::shard_slot));
+
+   shard->count = 0;
+   shard->size  = info->shard_size - sizeof(USharedCache::shard_info) - info->nslot * sizeof(USharedCache::shard_slot);
+
+   // U_LOG_HEAD <= writer <= oldest <= unused <= size
+
+   shard->writer = U_LOG_HEAD;
+   shard->oldest =
+   shard->unused = shard->size;
+
+   U_INTERNAL_DUMP("count = %u writer = %u oldest = %u unused = %u size = %u", shard->count, shard->writer, shard->oldest, shard->unused, shard->size)
+}
+
+bool USharedCache::open(const UString& path, uint32_t size, uint32_t nshard, const UString* environment, bool btemp)
+{
+   U_TRACE(0, "USharedCache::open(%V,%u,%u,%p,%b)", path.rep, size, nshard, environment, btemp)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_EQUALS(fd, -1)
+   U_INTERNAL_ASSERT_RANGE(U_SHARD_MIN_SIZE, size, 1000U * 1000U * 1000U)
+
+   UFile _x(path, environment);
+
+   if (_x.creat(O_RDWR) == false) U_RETURN(false);
+
+   bool exist = (_x.size() == size);
+
+   if (exist == false) (void) _x.ftruncate(size);
+
+   if (_x.memmap(PROT_READ | PROT_WRITE) == false)
+      {
+      _x.close();
+
+      U_RETURN(false);
+      }
+
+   fd = _x.getFd();
+
+   if (btemp) (void) _x._unlink();
+
+   if (exist == false) ((cache_info*)_x.getMap())->magic = 0;
+
+   init(_x.getMap(), size, nshard);
+
+   U_RETURN(true);
+}
+
+void USharedCache::init(void* ptr, uint32_t size, uint32_t nshard)
+{
+   U_TRACE(0, "USharedCache::init(%p,%u,%u)", ptr, size, nshard)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT_EQUALS(info, U_NULLPTR)
+   U_INTERNAL_ASSERT_RANGE(U_SHARD_MIN_SIZE, size, 1000U * 1000U * 1000U)
+
+   info = (cache_info*)ptr;
+
+   if (info->magic == U_SHARD_MAGIC &&
+       (sizeof(USharedCache::cache_info) + info->nshard * info->shard_size) <= size)
+      {
+      U_INTERNAL_DUMP("nshard = %u shard_size = %u nslot = %u", info->nshard, info->shard_size, info->nslot)
+
+      return;
+      }
+
+   // nshard: power of 2 (by default 2 * number of cpu) with at least U_SHARD_MIN_SIZE for shard
+
+   if (nshard == 0) nshard = u_get_num_cpu() * 2;
+
+   uint32_t n = 1;
+
+   while (n < nshard &&
+          n < U_SHARED_CACHE_MAX_SHARD &&
+          (size - sizeof(USharedCache::cache_info)) / (n << 1) >= U_SHARD_MIN_SIZE)
+      {
+      n <<= 1;
+      }
+
+   info->nshard     = n;
+   info->shard_size = ((size - sizeof(USharedCache::cache_info)) / n) & ~63;
+
+   // nslot: power of 2 with room for entries of 64 bytes (in average) in the log
+
+   uint32_t avail = info->shard_size - sizeof(USharedCache::shard_info);
+
+   info->nslot = 16;
+
+   while (((info->nslot << 1) * (sizeof(USharedCache::shard_slot) + 64)) <= avail) info->nslot <<= 1;
+
+   U_INTERNAL_DUMP("nshard = %u shard_size = %u nslot = %u", info->nshard, info->shard_size, info->nslot)
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      shard_info* shard = (shard_info*)((char*)(info+1) + i * info->shard_size);
+
+      (void) U_SYSCALL(memset, "%p,%d,%u", shard, 0, sizeof(USharedCache::shard_info));
+
+      resetShard(shard);
+      }
+
+   info->magic = U_SHARD_MAGIC;
+}
+
+uint32_t USharedCache::find(shard_info* shard, uint32_t keyhash, const char* key, uint32_t keylen) const
+{
+   U_TRACE(0, "USharedCache::find(%p,%u,%.*S,%u)", shard, keyhash, keylen, key, keylen)
+
+   shard_slot* slot = getSlot(shard);
+   uint32_t mask = info->nslot - 1, i = keyhash & mask;
+
+   while (slot[i].pos)
+      {
+      if (slot[i].hash == keyhash)
+         {
+         shard_entry* e = entry(shard, slot[i].pos);
+
+         if (e->keylen == keylen &&
+             memcmp(e+1, key, keylen) == 0)
+            {
+            U_RETURN(i);
+            }
+         }
+
+      i = (i + 1) & mask;
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+void USharedCache::erase(shard_info* shard, uint32_t i)
+{
+   U_TRACE(0, "USharedCache::erase(%p,%u)", shard, i)
+
+   U_INTERNAL_ASSERT_MAJOR(shard->count, 0)
+
+   shard_slot* slot = getSlot(shard);
+
+   entry(shard, slot[i].pos)->time_expire = 0; // set entry dead...
+
+   // backward shift deletion (we don't need tombstone)
+
+   uint32_t k, mask = info->nslot - 1, j = i;
+
+   while (true)
+      {
+      j = (j + 1) & mask;
+
+      if (slot[j].pos == 0) break;
+
+      k = slot[j].hash & mask; // ideal position of the slot j
+
+      if ((j > i && (k <= i || k > j)) ||
+          (j < i && (k <= i && k > j)))
+         {
+         slot[i] = slot[j];
+
+         i = j;
+         }
+      }
+
+   slot[i].pos = 0;
+
+   --shard->count;
+}
+
+bool USharedCache::evict(shard_info* shard, bool bforce)
+{
+   U_TRACE(0, "USharedCache::evict(%p,%b)", shard, bforce)
+
+   bool bmove = false;
+
+   U_INTERNAL_DUMP("count = %u writer = %u oldest = %u unused = %u size = %u", shard->count, shard->writer, shard->oldest, shard->unused, shard->size)
+
+   if (shard->oldest == shard->unused)
+      {
+      if (shard->writer == U_LOG_HEAD) U_RETURN(false); // empty log
+
+      shard->unused = shard->writer;
+      shard->oldest = shard->writer = U_LOG_HEAD;
+      }
+
+   shard_entry* e = entry(shard, shard->oldest);
+
+   uint32_t pos = shard->oldest, len = getEntryLen(e->keylen, e->datalen);
+
+   if (e->time_expire) // the entry is in the index...
+      {
+      shard_slot* slot = getSlot(shard);
+      uint32_t mask = info->nslot - 1, i = e->hash & mask;
+
+      while (slot[i].pos != pos) i = (i + 1) & mask;
+
+      if (e->time_expire != U_NO_TTL &&
+          u_now->tv_sec >= (long)e->time_expire)
+         {
+         ++shard->expired;
+
+         erase(shard, i);
+         }
+      else if (bforce == false &&
+               e->referenced)
+         {
+         // second chance: move the entry to the head of the log
+
+         e->referenced = 0;
+
+         if (shard->writer != pos) (void) memmove(getLog(shard) + shard->writer, e, len);
+
+         slot[i].pos = shard->writer;
+
+         shard->writer += len;
+
+         bmove = true;
+         }
+      else
+         {
+         ++shard->evictions;
+
+         erase(shard, i);
+         }
+      }
+
+   shard->oldest += len;
+
+   U_INTERNAL_ASSERT(shard->oldest <= shard->unused)
+
+   if (shard->oldest == shard->unused) shard->unused = shard->oldest = shard->size;
+
+   U_RETURN(bmove);
+}
+
+bool USharedCache::set(const char* key, uint32_t keylen, const char* data, uint32_t datalen, uint32_t _ttl)
+{
+   U_TRACE(0, "USharedCache::set(%.*S,%u,%.*S,%u,%u)", keylen, key, keylen, datalen, data, datalen, _ttl)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(info)
+   U_INTERNAL_ASSERT(_ttl <= U_MAX_TTL)
+   U_INTERNAL_ASSERT_MAJOR(keylen, 0)
+
+   uint32_t keyhash  = hash(key, keylen),
+            entrylen = getEntryLen(keylen, datalen);
+
+   shard_info* shard = getShard(keyhash);
+
+   lock(shard);
+
+   if (shard->size == 0) resetShard(shard);
+
+   if (entrylen > (shard->size - U_LOG_HEAD))
+      {
+      unlock(shard);
+
+      U_WARNING("USharedCache: entry too big (%u bytes) for a shard of %u bytes", entrylen, shard->size);
+
+      U_RETURN(false);
+      }
+
+   U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+   uint32_t i = find(shard, keyhash, key, keylen);
+
+   if (i != U_NOT_FOUND) erase(shard, i);
+
+   // NB: we need room in the log and the load factor of the index must be <= 0.75...
+
+   for (uint32_t moved = 0; (shard->writer + entrylen) > shard->oldest ||
+                             shard->count >= (info->nslot - (info->nslot >> 2)); )
+      {
+      if (evict(shard, (moved >= U_MAX_SECOND_CHANCE))) ++moved;
+      }
+
+   shard_entry* e = entry(shard, shard->writer);
+
+   e->hash        = keyhash;
+   e->keylen      = keylen;
+   e->datalen     = datalen;
+   e->time_expire = (_ttl ? u_now->tv_sec + _ttl : U_NO_TTL);
+   e->referenced  = 0;
+
+   U_MEMCPY((char*)(e+1),          key,  keylen);
+   U_MEMCPY((char*)(e+1) + keylen, data, datalen);
+
+   shard_slot* slot = getSlot(shard);
+   uint32_t mask = info->nslot - 1;
+
+   for (i = keyhash & mask; slot[i].pos; i = (i + 1) & mask) {}
+
+   slot[i].hash = keyhash;
+   slot[i].pos  = shard->writer;
+
+   shard->writer += entrylen;
+
+   ++shard->count;
+   ++shard->sets;
+
+   U_INTERNAL_DUMP("count = %u writer = %u oldest = %u unused = %u size = %u", shard->count, shard->writer, shard->oldest, shard->unused, shard->size)
+
+   unlock(shard);
+
+   U_RETURN(true);
+}
+
+UString USharedCache::get(const char* key, uint32_t keylen)
+{
+   U_TRACE(0, "USharedCache::get(%.*S,%u)", keylen, key, keylen)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(info)
+
+   uint32_t keyhash = hash(key, keylen);
+
+   shard_info* shard = getShard(keyhash);
+
+   lock(shard);
+
+   if (shard->size == 0) resetShard(shard);
+
+   uint32_t i = find(shard, keyhash, key, keylen);
+
+   if (i != U_NOT_FOUND)
+      {
+      shard_entry* e = entry(shard, getSlot(shard)[i].pos);
+
+      if (e->time_expire != U_NO_TTL)
+         {
+         U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+         if (u_now->tv_sec >= (long)e->time_expire)
+            {
+            ++shard->expired;
+
+            erase(shard, i);
+
+            goto miss;
+            }
+         }
+
+      e->referenced = 1;
+
+      ++shard->hits;
+
+      ttl = e->time_expire;
+
+      UString str((const void*)((const char*)(e+1) + keylen), e->datalen); // NB: we must copy the data, the entry can be moved by others...
+
+      unlock(shard);
+
+      U_RETURN_STRING(str);
+      }
+
+miss:
+   ++shard->misses;
+
+   unlock(shard);
+
+   return UString::getStringNull();
+}
+
+bool USharedCache::remove(const char* key, uint32_t keylen)
+{
+   U_TRACE(0, "USharedCache::remove(%.*S,%u)", keylen, key, keylen)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(info)
+
+   uint32_t keyhash = hash(key, keylen);
+
+   shard_info* shard = getShard(keyhash);
+
+   lock(shard);
+
+   if (shard->size == 0) resetShard(shard);
+
+   uint32_t i = find(shard, keyhash, key, keylen);
+
+   if (i != U_NOT_FOUND) erase(shard, i);
+
+   unlock(shard);
+
+   if (i != U_NOT_FOUND) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+void USharedCache::clear()
+{
+   U_TRACE_NO_PARAM(0, "USharedCache::clear()")
+
+   U_INTERNAL_ASSERT_POINTER(info)
+
+   for (uint32_t i = 0; i < info->nshard; ++i)
+      {
+      shard_info* shard = (shard_info*)((char*)(info+1) + i * info->shard_size);
+
+      lock(shard);
+
+      resetShard(shard);
+
+      unlock(shard);
+      }
+}
+
+void USharedCache::getStatistics(stats& s)
+{
+   U_TRACE(0, "USharedCache::getStatistics(%p)", &s)
+
+   U_INTERNAL_ASSERT_POINTER(info)
+
+   (void) memset(&s, 0, sizeof(stats));
+
+   for (uint32_t i = 0; i < info->nshard; ++i)
+      {
+      shard_info* shard = (shard_info*)((char*)(info+1) + i * info->shard_size);
+
+      lock(shard);
+
+      s.hits      += shard->hits;
+      s.misses    += shard->misses;
+      s.sets      += shard->sets;
+      s.evictions += shard->evictions;
+      s.expired   += shard->expired;
+      s.count     += shard->count;
+
+      unlock(shard);
+      }
+}
+
+UString USharedCache::getStatistics()
+{
+   U_TRACE_NO_PARAM(0, "USharedCache::getStatistics()")
+
+   stats s;
+
+   getStatistics(s);
+
+   UString result(200U);
+
+   result.snprintf(U_CONSTANT_TO_PARAM("hits %llu misses %llu sets %llu evictions %llu expired %llu count %u"),
+                   s.hits, s.misses, s.sets, s.evictions, s.expired, s.count);
+
+   U_RETURN_STRING(result);
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* USharedCache::dump(bool _reset) const
+{
+   *UObjectIO::os << "fd                    " << fd                   << '\n'
+                  << "ttl                   " << ttl                  << '\n'
+                  << "info                  " << (void*)info;
+
+   if (info)
+      {
+      *UObjectIO::os << '\n'
+                     << "nslot                 " << info->nslot       << '\n'
+                     << "nshard                " << info->nshard      << '\n'
+                     << "shard_size            " << info->shard_size;
+      }
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#endif
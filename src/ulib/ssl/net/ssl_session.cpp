@@ -11,10 +11,15 @@
 //
 // ============================================================================
 
-#include <ulib/db/rdb.h>
-#include <ulib/utility/uhttp.h>
+#include <ulib/net/server/server.h>
 #include <ulib/ssl/net/ssl_session.h>
 
+#include <openssl/rand.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#  include <openssl/core_names.h>
+#endif
+
 /**
  * Forward secrecy
  *
@@ -30,9 +35,14 @@
  * secret, local key and send that to the client. The former is called Session IDs and the latter is called Session Tickets.
  * But Session Tickets are transmitted over the wire and so the server's Session Ticket encryption key is capable of decrypting
  * past connections. Most servers will generate a random Session Ticket key at startup unless otherwise configured, but you should check
+ *
+ * NB: for this reason the Session Ticket keys shared by the preforked processes are rotated every session timeout...
  */
 
-SSL_SESSION* USSLSession::sess;
+void*                      USSLSession::ptr_cache;
+SSL_SESSION*               USSLSession::sess;
+USharedCache*              USSLSession::cache;
+USSLSession::ticket_keys*  USSLSession::keys;
 
 // define method VIRTUAL of class UDataStorage
 
@@ -72,6 +82,143 @@ void USSLSession::fromData(const char* ptr, uint32_t len)
    sess = (SSL_SESSION*) U_SYSCALL(d2i_SSL_SESSION, "%p,%p,%ld", U_NULLPTR, &p, (long)len);
 }
 
+void USSLSession::setDataShare()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::setDataShare()")
+
+   U_INTERNAL_ASSERT_EQUALS(keys, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(ptr_cache, U_NULLPTR)
+
+   keys      = (ticket_keys*) UServer_Base::getOffsetToDataShare(sizeof(ticket_keys));
+   ptr_cache =                UServer_Base::getOffsetToDataShare(U_SSL_SESSION_CACHE_SIZE);
+}
+
+void USSLSession::rotateTicketKey(uint32_t n)
+{
+   U_TRACE(0, "USSLSession::rotateTicketKey(%u)", n)
+
+   U_INTERNAL_ASSERT_POINTER(keys)
+
+   // NB: we write the slot of the key before the previous, the other processes can read only the current and the previous key...
+
+   ticket_key* key = keys->key + (n % 3);
+
+   if (U_SYSCALL(RAND_bytes, "%p,%d", (unsigned char*)key, sizeof(ticket_key)) != 1) U_ERROR("SSL: RAND_bytes() for the session ticket key failed");
+
+#ifdef HAVE_GCC_ATOMICS
+   __sync_synchronize();
+#endif
+
+   keys->current = n;
+
+   U_SRV_LOG("SSL: session ticket key rotated (%u)", n);
+}
+
+void USSLSession::init()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::init()")
+
+   U_INTERNAL_ASSERT_POINTER(USSLSocket::sctx)
+   U_INTERNAL_ASSERT_EQUALS(cache, U_NULLPTR)
+
+   if (UServer_Base::ptr_shared_data == U_NULLPTR) // NB: no shared data, we have only the internal session cache of every process...
+      {
+      keys      = U_NULLPTR;
+      ptr_cache = U_NULLPTR;
+
+      U_SRV_LOG("WARNING: no shared data, SSL session cache not shared between processes");
+
+      return;
+      }
+
+   U_NEW(USharedCache, cache, USharedCache);
+
+   cache->init(UServer_Base::getPointerToDataShare(ptr_cache), U_SSL_SESSION_CACHE_SIZE);
+
+   keys = (ticket_keys*) UServer_Base::getPointerToDataShare(keys);
+
+   /**
+    * In order to allow external session caching, synchronization with the internal session cache is realized via callback functions.
+    * Inside these callback functions, session can be saved to disk or put into a database using the d2i_SSL_SESSION(3) interface.
+    *
+    * The new_session_cb() is called, whenever a new session has been negotiated and session caching is enabled
+    * (see SSL_CTX_set_session_cache_mode(3)). The new_session_cb() is passed the ssl connection and the ssl session sess.
+    * If the callback returns 0, the session will be immediately removed again.
+    *
+    * The remove_session_cb() is called, whenever the SSL engine removes a session from the internal cache. This happens when
+    * the session is removed because it is expired or when a connection was not shutdown cleanly. It also happens for all sessions
+    * in the internal session cache when SSL_CTX_free(3) is called. The remove_session_cb() is passed the ctx and the ssl session sess.
+    * It does not provide any feedback.
+    *
+    * The get_session_cb() is only called on SSL/TLS servers with the session id proposed by the client. The get_session_cb() is
+    * always called, also when session caching was disabled. The get_session_cb() is passed the ssl connection, the session id and
+    * the length at the memory location data. With the parameter copy the callback can require the SSL engine to increment the
+    * reference count of the SSL_SESSION object, Normally the reference count is not incremented and therefore the session must not
+    * be explicitly freed with SSL_SESSION_free(3)
+    */
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+   typedef SSL_SESSION* (*psPFpspcipi) (SSL*,      unsigned char*,int,int*);
+#else
+   typedef SSL_SESSION* (*psPFpspcipi) (SSL*,const unsigned char*,int,int*);
+#endif
+
+   U_SYSCALL_VOID(SSL_CTX_sess_set_new_cb,    "%p,%p", USSLSocket::sctx,              USSLSession::newSession);
+   U_SYSCALL_VOID(SSL_CTX_sess_set_get_cb,    "%p,%p", USSLSocket::sctx, (psPFpspcipi)USSLSession::getSession);
+   U_SYSCALL_VOID(SSL_CTX_sess_set_remove_cb, "%p,%p", USSLSocket::sctx,              USSLSession::removeSession);
+
+   // NB: All currently supported protocols have the same default timeout value of 300 seconds
+   // ----------------------------------------------------------------------------------------
+   // (void) U_SYSCALL(SSL_CTX_set_timeout,         "%p,%u", USSLSocket::sctx, 300);
+      (void) U_SYSCALL(SSL_CTX_sess_set_cache_size, "%p,%u", USSLSocket::sctx, 1024 * 1024);
+
+   U_INTERNAL_DUMP("timeout = %d", SSL_CTX_get_timeout(USSLSocket::sctx))
+
+   // the keys for the session tickets (NB: we are before the fork, every child use the same keys...)
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   (void) U_SYSCALL(SSL_CTX_set_tlsext_ticket_key_evp_cb, "%p,%p", USSLSocket::sctx, USSLSession::ticketKey);
+#elif !defined(OPENSSL_NO_TLSEXT)
+   (void) U_SYSCALL(SSL_CTX_set_tlsext_ticket_key_cb,     "%p,%p", USSLSocket::sctx, USSLSession::ticketKey);
+#endif
+
+   if (keys->rotate == 0)
+      {
+      rotateTicketKey(0);
+
+      keys->rotate = u_now->tv_sec + SSL_CTX_get_timeout(USSLSocket::sctx);
+      }
+
+   U_SRV_LOG("SSL: session cache of %u KB shared between processes (%u shards)", U_SSL_SESSION_CACHE_SIZE / 1024, cache->getNumShard());
+}
+
+void USSLSession::close()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::close()")
+
+   if (cache)
+      {
+      delete cache;
+             cache = U_NULLPTR;
+      }
+}
+
+UString USSLSession::getStatistics()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::getStatistics()")
+
+   UString result;
+
+   if (cache)
+      {
+      result = cache->getStatistics();
+
+      result.snprintf_add(U_CONSTANT_TO_PARAM(" ticket key rotation %u"), keys->current);
+      }
+
+   U_RETURN_STRING(result);
+}
+
 int USSLSession::newSession(SSL* ssl, SSL_SESSION* _sess)
 {
    U_TRACE(0, "USSLSession::newSession(%p,%p)", ssl, _sess)
@@ -83,17 +230,42 @@ int USSLSession::newSession(SSL* ssl, SSL_SESSION* _sess)
 #endif
 */
 
-   sess = _sess;
+   U_INTERNAL_ASSERT_POINTER(cache)
+
+#ifdef TLS1_3_VERSION
+   // NB: with the stateless tickets of TLSv1.3 the session id is a dummy, there is nothing to resume by id...
+
+   if (U_SYSCALL(SSL_version, "%p", ssl) >= TLS1_3_VERSION &&
+       (U_SYSCALL(SSL_get_options, "%p", ssl) & SSL_OP_NO_TICKET) == 0)
+      {
+      U_RETURN(0);
+      }
+#endif
 
+   // converts SSL_SESSION object to ASN1 representation
+
+   int len = U_SYSCALL(i2d_SSL_SESSION, "%p,%p", _sess, U_NULLPTR);
+
+   if (len <= 0 ||
+       len > (int)U_BUFFER_SIZE)
+      {
+      U_RETURN(0);
+      }
+
+   unsigned char* p = (unsigned char*)u_buffer;
+
+   len = U_SYSCALL(i2d_SSL_SESSION, "%p,%p", _sess, &p);
+
+   unsigned int idlen;
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
-   UHTTP::db_session_ssl->insertDataStorage((const char*)sess->session_id, sess->session_id_length);
+   const unsigned char* id = _sess->session_id;
+                     idlen = _sess->session_id_length;
 #else
-   unsigned int idlen;
-   const unsigned char* id = (const unsigned char*) U_SYSCALL(SSL_SESSION_get_id, "", sess, &idlen);
-
-   UHTTP::db_session_ssl->insertDataStorage((const char*)id, idlen);
+   const unsigned char* id = (const unsigned char*) U_SYSCALL(SSL_SESSION_get_id, "%p,%p", _sess, &idlen);
 #endif
 
+   (void) cache->set((const char*)id, idlen, u_buffer, len, U_SYSCALL(SSL_SESSION_get_timeout, "%p", _sess));
+
    U_RETURN(0);
 }
 
@@ -101,10 +273,25 @@ SSL_SESSION* USSLSession::getSession(SSL* ssl, unsigned char* id, int len, int*
 {
    U_TRACE(0, "USSLSession::getSession(%p,%.*S,%d,%p)", ssl, len, id, len, copy)
 
+   U_INTERNAL_ASSERT_POINTER(cache)
+
    sess  = U_NULLPTR;
    *copy = 0;
 
-   UHTTP::db_session_ssl->getDataStorage((const char*)id, (uint32_t)len);
+   UString data = cache->get((const char*)id, (uint32_t)len);
+
+   if (data)
+      {
+      // converts SSL_SESSION object from ASN1 representation
+
+#  ifdef HAVE_OPENSSL_97
+            unsigned char* p =       (unsigned char*)data.data();
+#  else
+      const unsigned char* p = (const unsigned char*)data.data();
+#  endif
+
+      sess = (SSL_SESSION*) U_SYSCALL(d2i_SSL_SESSION, "%p,%p,%ld", U_NULLPTR, &p, (long)data.size());
+      }
 
 /*
 #ifdef DEBUG
@@ -127,24 +314,96 @@ void USSLSession::removeSession(SSL_CTX* ctx, SSL_SESSION* _sess)
 #endif
 */
 
-   U_INTERNAL_ASSERT_POINTER(UHTTP::db_session_ssl)
-
-   int result;
+   U_INTERNAL_ASSERT_POINTER(cache)
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
-   result = UHTTP::db_session_ssl->remove((const char*)_sess->session_id, (uint32_t)_sess->session_id_length);
+   (void) cache->remove((const char*)_sess->session_id, (uint32_t)_sess->session_id_length);
 #else
    unsigned int idlen;
-   const unsigned char* id = (const unsigned char*) U_SYSCALL(SSL_SESSION_get_id, "", sess, &idlen);
+   const unsigned char* id = (const unsigned char*) U_SYSCALL(SSL_SESSION_get_id, "%p,%p", _sess, &idlen);
 
-   result = UHTTP::db_session_ssl->remove((const char*)id, (uint32_t)idlen);
+   (void) cache->remove((const char*)id, (uint32_t)idlen);
 #endif
+}
+
+/**
+ * The callback of the session tickets: with enc == 1 we give the name of the current key and we initialize the cipher (AES-256-CBC)
+ * and the HMAC (SHA-256) for the encryption of a new ticket, with enc == 0 we search the key by name: 1 => valid, 2 => valid but it must
+ * be renewed (previous key), 0 => not found (full handshake)
+ */
 
-   // -2: The entry was already marked deleted in the hash-tree
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L || !defined(OPENSSL_NO_TLSEXT)
+#  if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int USSLSession::ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, EVP_MAC_CTX* hctx, int enc)
+#  else
+int USSLSession::ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx,    HMAC_CTX* hctx, int enc)
+#  endif
+{
+   U_TRACE(0, "USSLSession::ticketKey(%p,%p,%p,%p,%p,%d)", ssl, name, iv, ectx, hctx, enc)
+
+   U_INTERNAL_ASSERT_POINTER(keys)
 
-   if (result &&
-       result != -2)
+   int result  = 1;
+   uint32_t n  = keys->current,
+          now  = u_now->tv_sec;
+   ticket_key* key;
+
+   if (enc)
       {
-      U_WARNING("Remove of SSL session on db failed with error %d", result);
+      uint32_t rotate = keys->rotate;
+
+      // NB: only one process win the race for the rotation...
+
+      if (now >= rotate &&
+#  ifdef HAVE_GCC_ATOMICS
+          __sync_bool_compare_and_swap(&keys->rotate, rotate, now + SSL_CTX_get_timeout(SSL_get_SSL_CTX(ssl))))
+#  else
+          (keys->rotate = now + SSL_CTX_get_timeout(SSL_get_SSL_CTX(ssl))))
+#  endif
+         {
+         rotateTicketKey(++n);
+         }
+
+      key = keys->key + (n % 3);
+
+      if (U_SYSCALL(RAND_bytes, "%p,%d", iv, EVP_MAX_IV_LENGTH) != 1) U_RETURN(-1);
+
+      U_MEMCPY(name, key->name, sizeof(key->name));
+
+      (void) U_SYSCALL(EVP_EncryptInit_ex, "%p,%p,%p,%p,%p", ectx, EVP_aes_256_cbc(), U_NULLPTR, key->aes_key, iv);
       }
+   else
+      {
+      key = keys->key + (n % 3);
+
+      if (memcmp(name, key->name, sizeof(key->name)) != 0)
+         {
+         key = keys->key + ((n + 2) % 3);
+
+         if (n == 0 ||
+             memcmp(name, key->name, sizeof(key->name)) != 0)
+            {
+            U_RETURN(0);
+            }
+
+         result = 2;
+         }
+
+      (void) U_SYSCALL(EVP_DecryptInit_ex, "%p,%p,%p,%p,%p", ectx, EVP_aes_256_cbc(), U_NULLPTR, key->aes_key, iv);
+      }
+
+#  if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   OSSL_PARAM params[3];
+
+   params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key->hmac_key, sizeof(key->hmac_key));
+   params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"sha256", 0);
+   params[2] = OSSL_PARAM_construct_end();
+
+   (void) U_SYSCALL(EVP_MAC_CTX_set_params, "%p,%p", hctx, params);
+#  else
+   (void) U_SYSCALL(HMAC_Init_ex, "%p,%p,%d,%p,%p", hctx, key->hmac_key, sizeof(key->hmac_key), EVP_sha256(), U_NULLPTR);
+#  endif
+
+   U_RETURN(result);
 }
+#endif
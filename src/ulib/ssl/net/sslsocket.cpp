@@ -34,6 +34,9 @@
 #endif
 
 int      USSLSocket::session_cache_index;
+#ifdef U_USE_KTLS
+bool     USSLSocket::bktls;
+#endif
 SSL_CTX* USSLSocket::cctx; // client
 SSL_CTX* USSLSocket::sctx; // server
 
@@ -992,6 +995,10 @@ bool USSLSocket::acceptSSL(USSLSocket* pcNewConnection)
 
    (void) U_SYSCALL(SSL_set_fd, "%p,%d", ssl, fd); // get SSL to use our socket
 
+#ifdef U_USE_KTLS
+   if (bktls) (void) U_SYSCALL(SSL_set_options, "%p,%d", ssl, SSL_OP_ENABLE_KTLS);
+#endif
+
 loop:
    errno = 0;
    ret   = U_SYSCALL(SSL_accept, "%p", ssl); // get SSL handshake with client
@@ -1000,6 +1007,18 @@ loop:
       {
       SSL_set_app_data(ssl, pcNewConnection);
 
+      U_socket_Type(pcNewConnection) &= ~SK_KTLS;
+
+#  ifdef U_USE_KTLS
+      if (bktls &&
+          BIO_get_ktls_send(SSL_get_wbio(ssl)))
+         {
+         U_socket_Type(pcNewConnection) |= SK_KTLS;
+         }
+
+      U_INTERNAL_DUMP("isKTLS() = %b", pcNewConnection->isKTLS())
+#  endif
+
       pcNewConnection->ssl            = ssl;
       pcNewConnection->ret            = SSL_ERROR_NONE;
       pcNewConnection->iState         = CONNECT;
@@ -604,7 +604,7 @@ UStringRep* UStringRep::create(uint32_t length, uint32_t need, const char* ptr)
 #else
    if (need > U_CAPACITY)
       {
-      _ptr = UFile::mmap(&need, -1, PROT_READ | PROT_WRITE, MAP_PRIVATE | U_MAP_ANON, 0);
+      _ptr = UMemoryPool::mmap(&need); // NB: with the lock of the depot, the block is given back by UMemoryPool::deallocate()...
 
       if (_ptr == MAP_FAILED)
          {
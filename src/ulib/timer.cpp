@@ -13,9 +13,70 @@
 
 #include <ulib/timer.h>
 
-int     UTimer::mode;
-UTimer* UTimer::pool;
-UTimer* UTimer::first;
+int      UTimer::mode;
+UTimer*  UTimer::pool;
+UTimer*  UTimer::batch;
+UTimer** UTimer::heap;
+uint32_t UTimer::num;
+uint32_t UTimer::capacity;
+
+/**
+ * 4-ary min-heap: the children of node i are 4i+1 ... 4i+4, the parent is (i-1)/4.
+ * Compared to a binary heap it is half as deep and the children of a node usually
+ * share a cache line, which pays off with tens of thousands of pending timers...
+ */
+
+U_NO_EXPORT void UTimer::siftUp(uint32_t i)
+{
+   U_TRACE(0, "UTimer::siftUp(%u)", i)
+
+   U_INTERNAL_ASSERT_MINOR(i, num)
+
+   UTimer* item = heap[i];
+
+   while (i)
+      {
+      uint32_t parent = (i - 1) >> 2;
+
+      if ((*item < *heap[parent]) == false) break;
+
+      (heap[i] = heap[parent])->alarm->timer_index = i;
+
+      i = parent;
+      }
+
+   (heap[i] = item)->alarm->timer_index = i;
+}
+
+U_NO_EXPORT void UTimer::siftDown(uint32_t i)
+{
+   U_TRACE(0, "UTimer::siftDown(%u)", i)
+
+   U_INTERNAL_ASSERT_MINOR(i, num)
+
+   uint32_t child, last, j;
+   UTimer* item = heap[i];
+
+   while ((child = (i << 2) + 1) < num)
+      {
+      last = child + 4;
+
+      if (last > num) last = num;
+
+      for (j = child + 1; j < last; ++j)
+         {
+         if (*heap[j] < *heap[child]) child = j;
+         }
+
+      if ((*heap[child] < *item) == false) break;
+
+      (heap[i] = heap[child])->alarm->timer_index = i;
+
+      i = child;
+      }
+
+   (heap[i] = item)->alarm->timer_index = i;
+}
 
 U_NO_EXPORT void UTimer::insertEntry()
 {
@@ -23,30 +84,50 @@ U_NO_EXPORT void UTimer::insertEntry()
 
    U_CHECK_MEMORY
 
-   U_INTERNAL_DUMP("first = %p", first)
+   U_INTERNAL_DUMP("num = %u capacity = %u", num, capacity)
 
-   if (first)
+   if (num == capacity)
       {
-      UTimer** ptr = &first;
+      UTimer** old_heap     = heap;
+      uint32_t old_capacity = capacity;
 
-      do {
-         U_INTERNAL_DUMP("this = %p *ptr = %p", this, *ptr)
+      capacity = (capacity ? capacity << 1 : 64); // x 2...
 
-         if (*this < **ptr) break;
+      heap = (UTimer**) UMemoryPool::_malloc(&capacity, sizeof(UTimer*));
 
-         ptr = &(*ptr)->next;
-         }
-      while (*ptr);
+      if (num) U_MEMCPY(heap, old_heap, num * sizeof(UTimer*));
 
-      next = *ptr;
-      *ptr = this;
+      if (old_heap) UMemoryPool::_free(old_heap, old_capacity, sizeof(UTimer*));
       }
-   else
+
+   heap[num] = this;
+
+   siftUp(num++);
+
+   U_ASSERT(invariant())
+}
+
+U_NO_EXPORT void UTimer::removeEntry(uint32_t i)
+{
+   U_TRACE(0, "UTimer::removeEntry(%u)", i)
+
+   U_INTERNAL_ASSERT_MINOR(i, num)
+
+   heap[i]->alarm->timer_index = U_NOT_FOUND;
+
+   if (i != --num)
       {
-      // The list is empty
+      heap[i] = heap[num];
 
-      next  = U_NULLPTR;
-      first = this;
+      if (i &&
+          *heap[i] < *heap[(i - 1) >> 2])
+         {
+         siftUp(i);
+         }
+      else
+         {
+         siftDown(i);
+         }
       }
 
    U_ASSERT(invariant())
@@ -73,40 +154,29 @@ void UTimer::insert(UEventTime* a)
       pool = pool->next;
       }
 
-   // add it in to its new list, sorted correctly
+   // add it in to the heap, sorted correctly
 
    (item->alarm = a)->setTimeToExpire();
 
    item->insertEntry();
 
-#ifdef DEBUG
-   item = first;
-
-   for (uint32_t i = 0; item; ++i, item = item->next) U_INTERNAL_DUMP("item[%u] = %p", i, item)
-#endif
+   U_INTERNAL_DUMP("num = %u", num)
 }
 
-void UTimer::callHandlerTimeout()
+U_NO_EXPORT void UTimer::dispatch(UTimer* item)
 {
-   U_TRACE_NO_PARAM(0, "UTimer::callHandlerTimeout()")
-
-   U_INTERNAL_ASSERT_POINTER(first)
-
-   UTimer* item = first;
-                  first = first->next; // remove it from its active list
+   U_TRACE(0, "UTimer::dispatch(%p)", item)
 
    int result = item->alarm->handlerTime();
 
         if (result == -1) erase(item); // -1 => normal
    else if (result ==  0)              //  0 => monitoring
       {
-      U_INTERNAL_DUMP("UEventTime::timeout1 = %#19D (next alarm expire) = %#19D", UEventTime::timeout1.tv_sec, item->next ? item->next->alarm->expire() : 0L)
-
       u_gettimeofday(&UEventTime::timeout1);
 
-      U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first)
+      U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } num = %u", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, num)
 
-      // add it back in to its new list, sorted correctly
+      // add it back in to the heap, sorted correctly
 
       item->alarm->updateTimeToExpire();
 
@@ -114,42 +184,46 @@ void UTimer::callHandlerTimeout()
       }
 }
 
-void UTimer::updateTimeToExpire(UEventTime* ptime)
+void UTimer::callHandlerTimeout()
 {
-   U_TRACE(0, "UTimer::updateTimeToExpire(%p)", ptime)
-
-   U_INTERNAL_ASSERT_POINTER(first)
+   U_TRACE_NO_PARAM(0, "UTimer::callHandlerTimeout()")
 
-   UTimer* item;
+   U_INTERNAL_ASSERT_MAJOR(num, 0)
 
-   for (UTimer** ptr = &first; (item = *ptr); ptr = &(*ptr)->next)
-      {
-      if (item->alarm == ptime)
-         {
-         U_INTERNAL_DUMP("*ptr = %p item->next = %p", *ptr, item->next)
+   UTimer* item = heap[0];
 
-         *ptr = item->next; // remove it from its active list
+   removeEntry(0); // remove it from the heap
 
-         break;
-         }
-      }
+   dispatch(item);
+}
 
-   U_ASSERT(invariant())
-   U_INTERNAL_ASSERT_POINTER(item)
+void UTimer::updateTimeToExpire(UEventTime* ptime)
+{
+   U_TRACE(0, "UTimer::updateTimeToExpire(%p)", ptime)
 
-   U_INTERNAL_DUMP("UEventTime::timeout1 = %#19D (next alarm expire) = %#19D", UEventTime::timeout1.tv_sec, item->next ? item->next->alarm->expire() : 0L)
+   U_ASSERT(isHandler(ptime))
 
    u_gettimeofday(&UEventTime::timeout1);
 
-   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first)
-
-   // add it back in to its new list, sorted correctly
+   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } num = %u", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, num)
 
    ptime->updateTimeToExpire();
 
-#ifndef U_COVERITY_FALSE_POSITIVE // Dereference after null check (FORWARD_NULL)
-   item->insertEntry();
-#endif
+   // NB: the time to expire can move in both directions (ex: a shorter keep-alive)...
+
+   uint32_t i = ptime->timer_index;
+
+   if (i &&
+       *heap[i] < *heap[(i - 1) >> 2])
+      {
+      siftUp(i);
+      }
+   else
+      {
+      siftDown(i);
+      }
+
+   U_ASSERT(invariant())
 }
 
 void UTimer::run()
@@ -158,31 +232,55 @@ void UTimer::run()
 
    u_gettimeofday(&UEventTime::timeout1);
 
-   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first)
+   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } num = %u", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, num)
 
-   UTimer* item = first;
-   bool bnosignal = (mode == NOSIGNAL);
+   if (num)
+      {
+      UTimer* item;
+      UTimer** ptail = &batch;
+      bool bnosignal = (mode == NOSIGNAL);
 
-loop:
-#ifdef DEBUG
-   U_INTERNAL_DUMP("item = %p item->next = %p", item, item->next)
+      U_INTERNAL_ASSERT_EQUALS(batch, U_NULLPTR)
 
-   U_INTERNAL_ASSERT_POINTER(item)
+      // first we pull out of the heap all the expired timers (in order of expiration), then we call the handlers,
+      // so that the timers rescheduled by the handlers (monitoring) cannot be picked up again by the same run.
+      // While they wait in the batch the alarms are marked, so that erase() from a handler can cancel them...
 
-   if (item->next) U_INTERNAL_ASSERT(*item <= *(item->next))
-#endif
+      do {
+         item = heap[0];
 
-   if (bnosignal ? item->alarm->isExpired()
-                 : item->alarm->isExpiredWithTolerance())
-      {
-      item = item->next;
+         if ((bnosignal ? item->alarm->isExpired()
+                        : item->alarm->isExpiredWithTolerance()) == false)
+            {
+            break;
+            }
+
+         removeEntry(0);
 
-      callHandlerTimeout();
+         item->alarm->timer_index = U_TIMER_BATCH;
+
+         *ptail = item;
+         ptail = &(item->next);
+         }
+      while (num);
+
+      *ptail = U_NULLPTR;
+
+      while ((item = batch))
+         {
+         batch = item->next;
+
+         if (item->alarm == U_NULLPTR) erase(item); // NB: cancelled by the handler of a previous alarm of the batch...
+         else
+            {
+            item->alarm->timer_index = U_NOT_FOUND;
 
-      if (item) goto loop;
+            dispatch(item);
+            }
+         }
       }
 
-   U_INTERNAL_DUMP("first = %p", first)
+   U_INTERNAL_DUMP("num = %u", num)
 
    if (UInterrupt::event_signal_pending) UInterrupt::callHandlerSignal();
 }
@@ -195,7 +293,7 @@ void UTimer::setTimer()
 
    run();
 
-   if (first) first->alarm->setTimeVal(&(UInterrupt::timerval.it_value));
+   if (num) heap[0]->alarm->setTimeVal(&(UInterrupt::timerval.it_value));
    else
       {
       UInterrupt::timerval.it_value.tv_sec  =
@@ -216,32 +314,39 @@ void UTimer::erase(UEventTime* palarm)
 {
    U_TRACE(0, "UTimer::erase(%p)", palarm)
 
-   U_INTERNAL_ASSERT_POINTER(first)
+   if (isHandler(palarm))
+      {
+      UTimer* item = heap[palarm->timer_index];
 
-   UTimer* item;
+      U_INTERNAL_DUMP("item = %p timer_index = %u", item, palarm->timer_index)
 
-   for (UTimer** ptr = &first; (item = *ptr); ptr = &(*ptr)->next)
+      removeEntry(palarm->timer_index); // remove it from the heap
+
+      erase(item);
+      }
+   else if (palarm->timer_index == U_TIMER_BATCH) // NB: it is waiting in the batch of run(), we cancel it (the item is freed by run())...
       {
-      if (item->alarm == palarm)
+      for (UTimer* item = batch; item; item = item->next)
          {
-         U_INTERNAL_DUMP("*ptr = %p item->next = %p", *ptr, item->next)
-
-         *ptr = item->next; // remove it from its active list
+         if (item->alarm == palarm)
+            {
+            U_INTERNAL_DUMP("item = %p cancelled", item)
 
-         erase(item);
+            item->alarm = U_NULLPTR;
 
-         break;
+            break;
+            }
          }
-      }
 
-   U_ASSERT(invariant())
+      palarm->timer_index = U_NOT_FOUND;
+      }
 }
 
 void UTimer::clear()
 {
    U_TRACE_NO_PARAM(1, "UTimer::clear()")
 
-   U_INTERNAL_DUMP("mode = %d first = %p pool = %p", mode, first, pool)
+   U_INTERNAL_DUMP("mode = %d num = %u pool = %p", mode, num, pool)
 
    UTimer* next;
    UTimer* item;
@@ -254,21 +359,23 @@ void UTimer::clear()
       (void) U_SYSCALL(setitimer, "%d,%p,%p", ITIMER_REAL, &UInterrupt::timerval, U_NULLPTR);
       }
 
-   if (first)
+   if (heap)
       {
-      next = first;
-             first = U_NULLPTR;
-
-      do {
-         item = next;
-                next = item->next;
+      for (uint32_t i = 0; i < num; ++i)
+         {
+         item = heap[i];
 
-         U_INTERNAL_DUMP("item->alarm = %p next = %p", item->alarm, next)
+         U_INTERNAL_DUMP("item->alarm = %p", item->alarm)
 
          delete item->alarm;
          delete item;
          }
-      while (next);
+
+      UMemoryPool::_free(heap, capacity, sizeof(UTimer*));
+
+      heap     = U_NULLPTR;
+      num      =
+      capacity = 0;
       }
 
    if (pool)
@@ -294,17 +401,21 @@ bool UTimer::invariant()
 {
    U_TRACE_NO_PARAM(0, "UTimer::invariant()")
 
-   if (first)
+   for (uint32_t i = 0; i < num; ++i)
       {
-      for (UTimer* item = first; item->next; item = item->next)
+      if (heap[i]->alarm->timer_index != i)
          {
-         if (          item->next &&
-             *item > *(item->next))
-            {
-            U_ERROR("UTimer::invariant() failed: item = %p { %ld %6ld } item->next = %p { %ld %6ld }",
-                        item,             item->alarm->xtime.tv_sec,       item->alarm->xtime.tv_usec,
-                        item->next, item->next->alarm->xtime.tv_sec, item->next->alarm->xtime.tv_usec);
-            }
+         U_ERROR("UTimer::invariant() failed: heap[%u] = %p timer_index = %u", i, heap[i], heap[i]->alarm->timer_index);
+         }
+
+      if (i &&
+          *heap[i] < *heap[(i - 1) >> 2])
+         {
+         UTimer* parent = heap[(i - 1) >> 2];
+
+         U_ERROR("UTimer::invariant() failed: item = %p { %ld %6ld } parent = %p { %ld %6ld }",
+                     heap[i], heap[i]->alarm->xtime.tv_sec, heap[i]->alarm->xtime.tv_usec,
+                     parent,   parent->alarm->xtime.tv_sec,  parent->alarm->xtime.tv_usec);
          }
       }
 
@@ -344,12 +455,16 @@ void UTimer::printInfo(ostream& os)
 {
    U_TRACE(0+256, "UTimer::printInfo(%p)", &os)
 
-   os << "first = ";
+   os << "heap  = (";
 
-   if (first) os << *first;
-   else       os << (void*)first;
+   for (uint32_t i = 0; i < num; ++i)
+      {
+      os.put(' ');
+
+      os << *(heap[i]->alarm);
+      }
 
-   os << "\npool  = ";
+   os << " )\npool  = ";
 
    if (pool) os << *pool;
    else      os << (void*)pool;
@@ -365,7 +480,9 @@ const char* UTimer::dump(bool reset) const
                                                  << " "     << UInterrupt::timerval.it_value.tv_usec
                                                                  << " } }\n"
                   << "pool         (UTimer     " << (void*)pool  << ")\n"
-                  << "first        (UTimer     " << (void*)first << ")\n"
+                  << "num                      " << num          << '\n'
+                  << "capacity                 " << capacity     << '\n'
+                  << "heap         (UTimer*    " << (void*)heap  << ")\n"
                   << "next         (UTimer     " << (void*)next  << ")\n"
                   << "alarm        (UEventTime " << (void*)alarm << ")";
 
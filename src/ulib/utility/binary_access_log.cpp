@@ -0,0 +1,1082 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    binary_access_log.cpp - compact binary format for the apache like log
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/utility/binary_access_log.h>
+
+#define U_BINARY_ACCESS_LOG_TARGET 0x01 // the request have the target (method target [protocol])
+#define U_BINARY_ACCESS_LOG_QUERY  0x02 // the target have the query
+#define U_BINARY_ACCESS_LOG_PROTO  0x04 // the request have the protocol
+
+UBinaryAccessLog::UBinaryAccessLog() : dict(U_BINARY_ACCESS_LOG_MAX_ENTRY), vdict(256U), resume(U_CAPACITY)
+{
+   U_TRACE_REGISTER_OBJECT(0, UBinaryAccessLog, "", 0)
+
+   buffer      = (char*)            UMemoryPool::_malloc(U_BINARY_ACCESS_LOG_MAX_RECORD);
+   cache       = (ubinarylogcache*) UMemoryPool::_malloc(U_BINARY_ACCESS_LOG_CACHE, sizeof(ubinarylogcache), true);
+   ptr         = buffer;
+   start       =
+   last        =
+   last_prev   = 0;
+   nentry      =
+   nentry_prev =
+   nrecord     =
+   nsegment    =
+   dict_sz     =
+   nrotate     = 0;
+   adjust      = 0;
+   pid         = 0;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &wstate, 0, sizeof(ubinarylogstate));
+}
+
+UBinaryAccessLog::~UBinaryAccessLog()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UBinaryAccessLog)
+
+   UMemoryPool::_free(buffer, U_BINARY_ACCESS_LOG_MAX_RECORD);
+   UMemoryPool::_free(cache,  U_BINARY_ACCESS_LOG_CACHE, sizeof(ubinarylogcache));
+
+   if (wstate.data) UMemoryPool::_free(wstate.data, wstate.size);
+
+   clearDictionary();
+}
+
+void UBinaryAccessLog::clearDictionary()
+{
+   U_TRACE_NO_PARAM(0, "UBinaryAccessLog::clearDictionary()")
+
+   if (dict.first())
+      {
+      do { dict.eraseAfterFind(); } while (dict.next()); // NB: an erase don't move the other entries...
+      }
+
+   vdict.clear();
+}
+
+static uint32_t putSegment(char* segment, pid_t pid, time_t sec, int adjust)
+{
+   U_TRACE(0, "putSegment(%p,%d,%ld,%d)", segment, pid, sec, adjust)
+
+   // MAGIC 'S' len - version pid time adjust
+
+   char* p = segment + 3;
+
+   p = UBinaryAccessLog::putVarint(p, U_BINARY_ACCESS_LOG_VERSION);
+   p = UBinaryAccessLog::putVarint(p, pid);
+   p = UBinaryAccessLog::putVarint(p, (uint32_t)sec);
+   p = UBinaryAccessLog::putVarint(p, UBinaryAccessLog::zigzag(adjust));
+
+   segment[0] = (char)U_BINARY_ACCESS_LOG_MAGIC;
+   segment[1] = 'S';
+   segment[2] = (char)(p - segment - 3);
+
+   U_RETURN(p - segment);
+}
+
+uint32_t UBinaryAccessLog::newSegment(time_t sec)
+{
+   U_TRACE(0, "UBinaryAccessLog::newSegment(%ld)", sec)
+
+   clearDictionary();
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", cache, 0, U_BINARY_ACCESS_LOG_CACHE * sizeof(ubinarylogcache));
+
+   pid    = u_pid;
+   start   =
+   last    = sec;
+   nentry  =
+   dict_sz = 0;
+   adjust = *u_pnow_adjust;
+
+   ++nsegment;
+
+   uint32_t len = putSegment(segment, pid, sec, adjust);
+
+   U_INTERNAL_DUMP("start = %ld adjust = %d nsegment = %u len = %u", start, adjust, nsegment, len)
+
+   U_RETURN(len);
+}
+
+void UBinaryAccessLog::putString(const char* s, uint32_t len)
+{
+   U_TRACE(0, "UBinaryAccessLog::putString(%.*S,%u)", len, s, len)
+
+   // 0 => literal, 1 => definition (the string take the next id), n => id n-2
+
+   if (len == 0)
+      {
+      *ptr++ = 0;
+
+      putLiteral(s, 0);
+
+      return;
+      }
+
+   if (len > U_BINARY_ACCESS_LOG_MAX_STRING) len = U_BINARY_ACCESS_LOG_MAX_STRING;
+
+   // NB: before the lookup in the dictionary (the hash of the whole string) we try the cache indexed by the length and the ends of the string...
+
+   uint32_t id;
+   ubinarylogcache* pcache = cache + cacheIndex(s, len);
+
+   if (pcache->key                &&
+       pcache->key->size() == len &&
+       memcmp(pcache->key->data(), s, len) == 0)
+      {
+      ptr = putVarint(ptr, pcache->id + 2);
+
+      return;
+      }
+
+   if (dict.find(s, len))
+      {
+      id = (uint32_t)(long)dict.elem();
+
+      pcache->key = dict.key();
+      pcache->id  = id;
+
+      ptr = putVarint(ptr, id + 2);
+
+      return;
+      }
+
+   U_INTERNAL_ASSERT_MINOR(nentry, U_BINARY_ACCESS_LOG_MAX_ENTRY)
+
+   UString key((const void*)s, len);
+
+   dict.insertAfterFind(key, (const void*)(long)(id = nentry++));
+
+   vdict.push_back(key);
+
+   pcache->key = key.rep;
+   pcache->id  = id;
+
+   dict_sz += len;
+
+   *ptr++ = 1;
+
+   putLiteral(s, len);
+}
+
+void UBinaryAccessLog::write(ULog* log, const uaccesslogrecord& r)
+{
+   U_TRACE(0, "UBinaryAccessLog::write(%p,%p)", log, &r)
+
+   U_INTERNAL_ASSERT_POINTER(log)
+
+   int n = 0;
+   struct iovec iov[2];
+
+   // NB: a record define at most 6 strings...
+
+   if (pid != u_pid                                         ||
+       (nentry + 6) > U_BINARY_ACCESS_LOG_MAX_ENTRY        ||
+       (r.sec - start) >= U_BINARY_ACCESS_LOG_INTERVAL     ||
+        r.sec < last                                       ||
+       adjust != *u_pnow_adjust                            ||
+       (log->log_file_sz &&
+        (nrotate != log->ptr_log_data->nrotate ||
+         dict_sz  > (log->log_file_sz / 8)))) // NB: with the rotation the state of the segment is written again in the new file (see getResume())...
+      {
+      iov[0].iov_base = (caddr_t)segment;
+      iov[0].iov_len  = newSegment(r.sec);
+
+      if (log->log_file_sz) nrotate = log->ptr_log_data->nrotate;
+
+      n = 1;
+      }
+
+   // NB: the state of the segment before this record (see getResume())...
+
+   last_prev   = last;
+   nentry_prev = nentry;
+
+   // MAGIC 'R' len - pid delta_time host flags method [path] [query] [protocol] code body_len referer agent
+
+   char* body = ptr = buffer + 4;
+
+   ptr = putVarint(ptr, pid);
+   ptr = putVarint(ptr, (uint32_t)(r.sec - last));
+
+   last = r.sec;
+
+   putString(r.host, r.host_len);
+
+   const char* req = r.request;
+   uint32_t    len = U_min(r.request_len, U_BINARY_ACCESS_LOG_MAX_STRING);
+   const char* end = req + len;
+   const char* sp  = (const char*) memchr(req, ' ', len);
+
+   char* pflags = ptr++;
+
+   if (sp == U_NULLPTR)
+      {
+      *pflags = 0;
+
+      putString(req, len);
+      }
+   else
+      {
+      char flags = U_BINARY_ACCESS_LOG_TARGET;
+
+      putString(req, sp - req);
+
+      const char* target = sp + 1;
+      const char* proto  = (const char*) memrchr(target, ' ', end - target);
+      const char* tend   = (proto ? proto : end);
+      const char* query  = (const char*) memchr(target, '?', tend - target);
+
+      putString(target, (query ? query : tend) - target);
+
+      if (query)
+         {
+         flags |= U_BINARY_ACCESS_LOG_QUERY;
+
+         putLiteral(query + 1, tend - query - 1);
+         }
+
+      if (proto)
+         {
+         flags |= U_BINARY_ACCESS_LOG_PROTO;
+
+         putString(proto + 1, end - proto - 1);
+         }
+
+      *pflags = flags;
+      }
+
+   ptr = putVarint(ptr, r.code);
+   ptr = putVarint(ptr, r.body_len);
+
+   putString(r.referer, r.referer_len);
+   putString(r.agent,   r.agent_len);
+
+   len = ptr - body;
+
+   U_INTERNAL_ASSERT_MINOR(len, 128 * 128)
+   U_INTERNAL_ASSERT(ptr <= (buffer + U_BINARY_ACCESS_LOG_MAX_RECORD))
+
+   char* head = body - (len < 128 ? 3 : 4);
+
+   head[0] = (char)U_BINARY_ACCESS_LOG_MAGIC;
+   head[1] = 'R';
+
+   (void) putVarint(head + 2, len);
+
+   iov[n].iov_base = (caddr_t)head;
+   iov[n].iov_len  = ptr - head;
+
+   log->write(iov, n + 1); // NB: the start of the segment and the record are written together...
+
+   ++nrecord;
+}
+
+void UBinaryAccessLog::putResume(UString& _buffer, pid_t _pid, time_t sec, int _adjust, const UVector<UString>& vec, uint32_t n)
+{
+   U_TRACE(0, "UBinaryAccessLog::putResume(%V,%d,%ld,%d,%p,%u)", _buffer.rep, _pid, sec, _adjust, &vec, n)
+
+   uint32_t len;
+   char* p;
+   char* head;
+   char body[U_BINARY_ACCESS_LOG_MAX_RECORD];
+
+   (void) _buffer.append(body, putSegment(body, _pid, sec, _adjust));
+
+   // MAGIC 'D' len - pid [len string]... (the strings take the next id, a record for every U_BINARY_ACCESS_LOG_MAX_RECORD bytes)
+
+   for (uint32_t i = 0; i < n; )
+      {
+      p = putVarint(body + 4, _pid);
+
+      for (; i < n; ++i)
+         {
+         UString str = vec[i];
+
+         len = str.size();
+
+         if ((p + len + 5) > (body + sizeof(body))) break; // NB: a string is at most U_BINARY_ACCESS_LOG_MAX_STRING bytes...
+
+         p = putVarint(p, len);
+
+         U_MEMCPY(p, str.data(), len);
+
+         p += len;
+         }
+
+      len = p - (body + 4);
+
+      U_INTERNAL_ASSERT_MINOR(len, 128 * 128)
+
+      head = body + 4 - (len < 128 ? 3 : 4);
+
+      head[0] = (char)U_BINARY_ACCESS_LOG_MAGIC;
+      head[1] = 'D';
+
+      (void) putVarint(head + 2, len);
+
+      (void) _buffer.append(head, p - head);
+      }
+}
+
+void UBinaryAccessLog::setWriter(uint32_t log_file_sz)
+{
+   U_TRACE(0, "UBinaryAccessLog::setWriter(%u)", log_file_sz)
+
+   /**
+    * NB: the strings of the dictionary of a segment are at most 1/8 of the file plus the strings of a record (see write()), with the varint
+    *     of the length for every string and the header of a record 'D' for every U_BINARY_ACCESS_LOG_MAX_RECORD bytes...
+    */
+
+   uint32_t sz = 32 + (log_file_sz / 8) + 2 * U_BINARY_ACCESS_LOG_MAX_RECORD + 2 * U_BINARY_ACCESS_LOG_MAX_ENTRY;
+
+   sz += (sz / (U_BINARY_ACCESS_LOG_MAX_RECORD - U_BINARY_ACCESS_LOG_MAX_STRING - 16) + 1) * 16;
+
+   if (wstate.size < sz)
+      {
+      if (wstate.data) UMemoryPool::_free(wstate.data, wstate.size);
+
+      wstate.data = (char*) UMemoryPool::_malloc(sz);
+      wstate.size = sz;
+      }
+
+   wstate.valid = false; // NB: we wait for the start of a segment of this process...
+}
+
+// NB: the records are contiguous in the ring buffer but a record can wrap, so the writer thread reads them in place from the two iovec...
+
+class UBinaryLogInput {
+public:
+   const char* p0;
+   const char* p1;
+   uint32_t n0, size, pos;
+
+   UBinaryLogInput(const struct iovec* iov, int n)
+      {
+      p0   = (const char*)iov[0].iov_base;
+      n0   =              iov[0].iov_len;
+      p1   = (n == 2 ? (const char*)iov[1].iov_base : U_NULLPTR);
+      size = (n == 2 ? n0 + iov[1].iov_len : n0);
+      pos  = 0;
+      }
+
+   unsigned char at(uint32_t i) const { return (unsigned char)(i < n0 ? p0[i] : p1[i - n0]); }
+
+   bool getVarint(uint32_t end, uint32_t& n)
+      {
+      uint32_t shift = 0;
+
+      for (n = 0; pos < end && shift < 35; shift += 7)
+         {
+         unsigned char c = at(pos++);
+
+         n |= (uint32_t)(c & 0x7F) << shift;
+
+         if ((c & 0x80) == 0) return true;
+         }
+
+      return false;
+      }
+
+   void copy(char* dst, uint32_t len)
+      {
+      U_TRACE(0, "UBinaryLogInput::copy(%p,%u)", dst, len)
+
+      if (pos >= n0)
+         {
+         U_MEMCPY(dst, p1 + (pos - n0), len);
+         }
+      else
+         {
+         uint32_t len0 = U_min(len, n0 - pos);
+
+         U_MEMCPY(dst, p0 + pos, len0);
+
+         if (len > len0) U_MEMCPY(dst + len0, p1, len - len0);
+         }
+
+      pos += len;
+      }
+};
+
+static void openDictionary(ubinarylogstate& w)
+{
+   U_TRACE(0, "openDictionary(%p)", &w)
+
+   // MAGIC 'D' len - pid [len string]... (NB: the header is written by closeDictionary() with the length on two bytes)
+
+   w.dstart = w.len;
+   w.dcount = 0;
+   w.len    = UBinaryAccessLog::putVarint(w.data + w.dstart + 4, u_pid) - w.data;
+}
+
+static void closeDictionary(ubinarylogstate& w)
+{
+   U_TRACE(0, "closeDictionary(%p)", &w)
+
+   uint32_t len = w.len - (w.dstart + 4);
+
+   U_INTERNAL_ASSERT_MINOR(len, 128 * 128)
+
+   char* head = w.data + w.dstart;
+
+   head[0] = (char)U_BINARY_ACCESS_LOG_MAGIC;
+   head[1] = 'D';
+   head[2] = (char)((len & 0x7F) | 0x80); // NB: a varint not minimal, the decoder accept it...
+   head[3] = (char) (len >> 7);
+}
+
+static bool addDictionary(ubinarylogstate& w, UBinaryLogInput& in, uint32_t end)
+{
+   U_TRACE(0, "addDictionary(%p,%p,%u)", &w, &in, end)
+
+   // 0 => literal, 1 => definition (the string take the next id), n => id n-2
+
+   uint32_t n, len;
+
+   if (in.getVarint(end, n) == false) U_RETURN(false);
+
+   if (n >= 2) U_RETURN(true);
+
+   if (in.getVarint(end, len) == false ||
+       len > (end - in.pos))
+      {
+      U_RETURN(false);
+      }
+
+   if (n == 0)
+      {
+      in.pos += len;
+
+      U_RETURN(true);
+      }
+
+   if ((w.len + len + 5 + 16) > w.size) U_RETURN(false); // NB: the dictionary don't fit, the records wait for the next segment...
+
+   if ((w.len - (w.dstart + 4) + len + 5) > U_BINARY_ACCESS_LOG_MAX_RECORD)
+      {
+      closeDictionary(w);
+       openDictionary(w);
+      }
+
+   w.len = UBinaryAccessLog::putVarint(w.data + w.len, len) - w.data;
+
+   in.copy(w.data + w.len, len);
+
+   w.len += len;
+
+   ++w.dcount;
+
+   U_RETURN(true);
+}
+
+static bool addRequest(ubinarylogstate& w, UBinaryLogInput& in, uint32_t end)
+{
+   U_TRACE(0, "addRequest(%p,%p,%u)", &w, &in, end)
+
+   // pid delta_time host flags method [path] [query] [protocol] code body_len referer agent
+
+   uint32_t n, flags;
+
+   if (in.getVarint(end, n) == false) U_RETURN(false);
+
+   if ((pid_t)n != u_pid) U_RETURN(true); // NB: can't happen, the records of the ring buffer are written by this process...
+
+   if (in.getVarint(end, n)       == false ||
+       addDictionary(w, in, end)  == false ||
+       in.pos >= end)
+      {
+      U_RETURN(false);
+      }
+
+   w.last += n;
+
+   flags = in.at(in.pos++);
+
+   if (addDictionary(w, in, end) == false) U_RETURN(false);
+
+   if ((flags & U_BINARY_ACCESS_LOG_TARGET) != 0)
+      {
+      if (addDictionary(w, in, end) == false) U_RETURN(false);
+
+      if ((flags & U_BINARY_ACCESS_LOG_QUERY) != 0)
+         {
+         if (in.getVarint(end, n) == false ||
+             n > (end - in.pos))
+            {
+            U_RETURN(false);
+            }
+
+         in.pos += n;
+         }
+
+      if ((flags & U_BINARY_ACCESS_LOG_PROTO) != 0 &&
+          addDictionary(w, in, end) == false)
+         {
+         U_RETURN(false);
+         }
+      }
+
+   if (in.getVarint(end, n)      &&
+       in.getVarint(end, n)      &&
+       addDictionary(w, in, end) &&
+       addDictionary(w, in, end))
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+void UBinaryAccessLog::written(const struct iovec* iov, int n)
+{
+   U_TRACE(0, "UBinaryAccessLog::written(%p,%d)", iov, n)
+
+   if (wstate.data == U_NULLPTR) return; // NB: setWriter() not called...
+
+   // NB: here we are in the writer thread, we must not allocate from the memory pool...
+
+   UBinaryLogInput in(iov, n);
+   uint32_t len, end, version, _pid, sec, _adjust;
+
+   while ((in.pos + 3) <= in.size)
+      {
+      if (in.at(in.pos) != U_BINARY_ACCESS_LOG_MAGIC) // NB: can't happen...
+         {
+         ++in.pos;
+
+         continue;
+         }
+
+      char type = in.at(in.pos + 1);
+
+      in.pos += 2;
+
+      if (in.getVarint(in.size, len) == false ||
+          len > (in.size - in.pos))
+         {
+         break;
+         }
+
+      end = in.pos + len;
+
+      if (type == 'S')
+         {
+         if (in.getVarint(end, version) &&
+             in.getVarint(end, _pid)    &&
+             in.getVarint(end, sec)     &&
+             in.getVarint(end, _adjust) &&
+             (pid_t)_pid == u_pid)
+            {
+            wstate.last   = sec;
+            wstate.adjust = unzigzag(_adjust);
+            wstate.len    = 32;
+            wstate.valid  = true;
+
+            openDictionary(wstate);
+            }
+         }
+      else if (type == 'R' &&
+               wstate.valid)
+         {
+         if (addRequest(wstate, in, end) == false) wstate.valid = false; // NB: the records of this segment can't be decoded after the rotation...
+         }
+
+      in.pos = end;
+      }
+
+   U_INTERNAL_DUMP("wstate.valid = %b wstate.len = %u wstate.dcount = %u", wstate.valid, wstate.len, wstate.dcount)
+}
+
+const char* UBinaryAccessLog::getResume(const struct iovec* iov, bool bwriter, uint32_t& len)
+{
+   U_TRACE(0, "UBinaryAccessLog::getResume(%p,%b,%p)", iov, bwriter, &len)
+
+   len = 0;
+
+   // NB: the records of iov can start a new segment (with the ring buffer the second byte of the record can be in the second iovec)...
+
+   char type = (iov[0].iov_len >= 2 ? ((const char*)iov[0].iov_base)[1]
+                                    : ((const char*)iov[1].iov_base)[1 - iov[0].iov_len]);
+
+   if (type == 'S') U_RETURN((const char*)U_NULLPTR);
+
+   if (bwriter)
+      {
+      if (wstate.valid == false) U_RETURN((const char*)U_NULLPTR);
+
+      // the record 'S' goes in the room before the records 'D' (the last one can be empty)
+
+      uint32_t end = wstate.len;
+
+      if (wstate.dcount) closeDictionary(wstate);
+      else               end = wstate.dstart;
+
+      char seg[32]; // NB: not the member segment, it is written by the process that serve the requests...
+
+      uint32_t slen = putSegment(seg, u_pid, wstate.last, wstate.adjust);
+      char*    head = wstate.data + 32 - slen;
+
+      U_MEMCPY(head, seg, slen);
+
+      len = wstate.data + end - head;
+
+      U_RETURN(head);
+      }
+
+   if (pid != u_pid) U_RETURN((const char*)U_NULLPTR);
+
+   resume.setEmpty();
+
+   putResume(resume, pid, last_prev, adjust, vdict, nentry_prev);
+
+   len = resume.size();
+
+   U_RETURN(resume.data());
+}
+
+UBinaryAccessLogReader::UBinaryAccessLogReader() : vstream(16U), request(U_CAPACITY)
+{
+   U_TRACE_REGISTER_OBJECT(0, UBinaryAccessLogReader, "", 0)
+
+   pnext    =
+   pend     = U_NULLPTR;
+   nrecord  =
+   nsegment =
+   nskipped =
+   ngarbage = 0;
+}
+
+UBinaryAccessLogReader::~UBinaryAccessLogReader()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UBinaryAccessLogReader)
+}
+
+UBinaryAccessLogReader::UStream* UBinaryAccessLogReader::getStream(pid_t pid, bool create)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::getStream(%d,%b)", pid, create)
+
+   UStream* s;
+
+   for (uint32_t i = 0, n = vstream.size(); i < n; ++i)
+      {
+      s = vstream[i];
+
+      if (s->pid == pid) U_RETURN_POINTER(s, UStream);
+      }
+
+   if (create == false) U_RETURN_POINTER(U_NULLPTR, UStream);
+
+   U_NEW(UStream, s, UStream(pid));
+
+   vstream.push_back(s);
+
+   U_RETURN_POINTER(s, UStream);
+}
+
+bool UBinaryAccessLogReader::getString(UStream* s, const char*& ptr, const char* end, const char*& str, uint32_t& len)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::getString(%p,%p,%p,%p,%p)", s, ptr, end, &str, &len)
+
+   uint32_t n;
+
+   if (getVarint(ptr, end, n) == false) U_RETURN(false);
+
+   if (n >= 2)
+      {
+      n -= 2;
+
+      if (n >= s->dict.size()) U_RETURN(false);
+
+      UStringRep* rep = s->dict.UVector<UStringRep*>::at(n);
+
+      str = rep->data();
+      len = rep->size();
+
+      U_RETURN(true);
+      }
+
+   if (getVarint(ptr, end, len) == false ||
+       len > (uint32_t)(end - ptr))
+      {
+      U_RETURN(false);
+      }
+
+   str  = ptr;
+   ptr += len;
+
+   if (n == 1) s->dict.push_back(UString((const void*)str, len));
+
+   U_RETURN(true);
+}
+
+bool UBinaryAccessLogReader::decodeSegment(const char* ptr, const char* end)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::decodeSegment(%p,%p)", ptr, end)
+
+   uint32_t version, pid, sec, adjust;
+
+   if (getVarint(ptr, end, version) == false ||
+       getVarint(ptr, end, pid)     == false ||
+       getVarint(ptr, end, sec)     == false ||
+       getVarint(ptr, end, adjust)  == false ||
+       version == 0                         ||
+       version  > U_BINARY_ACCESS_LOG_VERSION)
+      {
+      U_RETURN(false);
+      }
+
+   UStream* s = getStream(pid, true);
+
+   s->dict.clear();
+
+   s->last   = sec;
+   s->adjust = UBinaryAccessLog::unzigzag(adjust);
+
+   U_RETURN(true);
+}
+
+bool UBinaryAccessLogReader::decodeDictionary(const char* ptr, const char* end)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::decodeDictionary(%p,%p)", ptr, end)
+
+   uint32_t pid, len;
+   UStream* s;
+
+   if (getVarint(ptr, end, pid) == false ||
+       (s = getStream(pid, false)) == U_NULLPTR) // NB: the start of the segment is not in the input...
+      {
+      U_RETURN(false);
+      }
+
+   while (ptr < end)
+      {
+      if (getVarint(ptr, end, len) == false ||
+          len > (uint32_t)(end - ptr))
+         {
+         vstream.erase(vstream.find(s));
+
+         U_RETURN(false);
+         }
+
+      s->dict.push_back(UString((const void*)ptr, len));
+
+      ptr += len;
+      }
+
+   U_RETURN(true);
+}
+
+bool UBinaryAccessLogReader::decodeRequest(const char* ptr, const char* end, uaccesslogrecord& r)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::decodeRequest(%p,%p,%p)", ptr, end, &r)
+
+   uint32_t n, len, flags;
+   const char* str;
+   UStream* s;
+
+   if (getVarint(ptr, end, n) == false ||
+       (s = getStream(n, false)) == U_NULLPTR) // NB: the start of the segment is not in the input...
+      {
+      U_RETURN(false);
+      }
+
+   r.pid    = n;
+   r.adjust = s->adjust;
+
+   if (getVarint(ptr, end, n) == false) goto error;
+
+   r.sec = (s->last += n);
+
+   if (getString(s, ptr, end, r.host, r.host_len) == false ||
+       ptr >= end)
+      {
+      goto error;
+      }
+
+   flags = (unsigned char)*ptr++;
+
+   if (getString(s, ptr, end, str, len) == false) goto error;
+
+   (void) request.replace(str, len);
+
+   if ((flags & U_BINARY_ACCESS_LOG_TARGET) != 0)
+      {
+      if (getString(s, ptr, end, str, len) == false) goto error;
+
+      request.push_back(' ');
+
+      (void) request.append(str, len);
+
+      if ((flags & U_BINARY_ACCESS_LOG_QUERY) != 0)
+         {
+         if (getVarint(ptr, end, len) == false ||
+             len > (uint32_t)(end - ptr))
+            {
+            goto error;
+            }
+
+         request.push_back('?');
+
+         (void) request.append(ptr, len);
+
+         ptr += len;
+         }
+
+      if ((flags & U_BINARY_ACCESS_LOG_PROTO) != 0)
+         {
+         if (getString(s, ptr, end, str, len) == false) goto error;
+
+         request.push_back(' ');
+
+         (void) request.append(str, len);
+         }
+      }
+
+   r.request     = request.data();
+   r.request_len = request.size();
+
+   if (getVarint(ptr, end, r.code)                              &&
+       getVarint(ptr, end, r.body_len)                          &&
+       getString(s, ptr, end, r.referer, r.referer_len)         &&
+       getString(s, ptr, end, r.agent,   r.agent_len)           &&
+       ptr == end)
+      {
+      U_RETURN(true);
+      }
+
+error:
+   // NB: the dictionary of the stream can be out of sync, we wait for the next segment...
+
+   vstream.erase(vstream.find(s));
+
+   U_RETURN(false);
+}
+
+bool UBinaryAccessLogReader::next(uaccesslogrecord& r)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::next(%p)", &r)
+
+   uint32_t len;
+   const char* ptr;
+   const char* end;
+
+   while (pnext < pend)
+      {
+      if ((unsigned char)*pnext != U_BINARY_ACCESS_LOG_MAGIC ||
+          (pend - pnext) < 3)
+         {
+         goto garbage;
+         }
+
+      ptr = pnext + 2;
+
+      if (getVarint(ptr, pend, len) == false ||
+          len > U_BINARY_ACCESS_LOG_MAX_RECORD)
+         {
+         goto garbage;
+         }
+
+      if (len > (uint32_t)(pend - ptr)) goto garbage; // NB: the last record can be incomplete...
+
+      end = ptr + len;
+
+      if (pnext[1] == 'S')
+         {
+         if (decodeSegment(ptr, end) == false) goto garbage;
+
+         ++nsegment;
+
+         pnext = end;
+
+         continue;
+         }
+
+      if (pnext[1] == 'D')
+         {
+         (void) decodeDictionary(ptr, end);
+
+         pnext = end;
+
+         continue;
+         }
+
+      if (pnext[1] != 'R') goto garbage;
+
+      pnext = end;
+
+      if (decodeRequest(ptr, end, r))
+         {
+         ++nrecord;
+
+         U_RETURN(true);
+         }
+
+      ++nskipped;
+
+      continue;
+
+garbage:
+      ++pnext;
+      ++ngarbage;
+      }
+
+   U_RETURN(false);
+}
+
+// output
+
+void UBinaryAccessLogReader::appendCombined(UString& buffer, const uaccesslogrecord& r)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::appendCombined(%V,%p)", buffer.rep, &r)
+
+   char date[32];
+
+   // NB: we format the date like the server (ULog::date.date2), %z is the offset of the writer...
+
+   int adjust_save = *u_pnow_adjust;
+
+   *u_pnow_adjust = r.adjust;
+
+   (void) u_strftime2(date, sizeof(date), U_CONSTANT_TO_PARAM("%d/%b/%Y:%T %z"), r.sec + r.adjust);
+
+   *u_pnow_adjust = adjust_save;
+
+   (void) buffer.reserve(r.host_len + r.request_len + r.referer_len + r.agent_len + 100);
+
+   if (r.body_len == 0)
+      {
+      buffer.snprintf_add(U_CONSTANT_TO_PARAM("%.*s - - [%.26s] \"%.*s\" %u - \"%.*s\" \"%.*s\"\n"),
+                          r.host_len, r.host, date, r.request_len, r.request, r.code, r.referer_len, r.referer, r.agent_len, r.agent);
+      }
+   else
+      {
+      buffer.snprintf_add(U_CONSTANT_TO_PARAM("%.*s - - [%.26s] \"%.*s\" %u %u \"%.*s\" \"%.*s\"\n"),
+                          r.host_len, r.host, date, r.request_len, r.request, r.code, r.body_len, r.referer_len, r.referer, r.agent_len, r.agent);
+      }
+}
+
+static void appendJSONString(UString& buffer, const char* s, uint32_t len)
+{
+   U_TRACE(0, "appendJSONString(%V,%.*S,%u)", buffer.rep, len, s, len)
+
+   char* p = buffer.pend();
+
+   *p++ = '"';
+
+   for (const char* end = s + len; s < end; ++s)
+      {
+      unsigned char c = *s;
+
+      if (c == '"' ||
+          c == '\\')
+         {
+         *p++ = '\\';
+         *p++ = c;
+         }
+      else if (c < 0x20)
+         {
+         *p++ = '\\';
+         *p++ = 'u';
+         *p++ = '0';
+         *p++ = '0';
+         *p++ = "0123456789abcdef"[c >> 4];
+         *p++ = "0123456789abcdef"[c & 0x0F];
+         }
+      else
+         {
+         *p++ = c;
+         }
+      }
+
+   *p++ = '"';
+
+   buffer.size_adjust(p);
+}
+
+void UBinaryAccessLogReader::appendJSON(UString& buffer, const uaccesslogrecord& r)
+{
+   U_TRACE(0, "UBinaryAccessLogReader::appendJSON(%V,%p)", buffer.rep, &r)
+
+   char date[32];
+   uint32_t adjust = (r.adjust < 0 ? -r.adjust : r.adjust);
+
+   (void) u_strftime2(date, sizeof(date), U_CONSTANT_TO_PARAM("%Y-%m-%dT%T"), r.sec + r.adjust);
+
+   (void) buffer.reserve((r.host_len + r.request_len + r.referer_len + r.agent_len) * 6 + 200);
+
+   buffer.snprintf_add(U_CONSTANT_TO_PARAM("{\"time\":\"%.19s%c%02u:%02u\",\"timestamp\":%ld,\"host\":"), date, (r.adjust < 0 ? '-' : '+'), adjust / 3600, (adjust % 3600) / 60, (long)r.sec);
+
+   appendJSONString(buffer, r.host, r.host_len);
+
+   (void) buffer.append(U_CONSTANT_TO_PARAM(",\"request\":"));
+
+   appendJSONString(buffer, r.request, r.request_len);
+
+   buffer.snprintf_add(U_CONSTANT_TO_PARAM(",\"status\":%u,\"bytes\":%u,\"referer\":"), r.code, r.body_len);
+
+   appendJSONString(buffer, r.referer, r.referer_len);
+
+   (void) buffer.append(U_CONSTANT_TO_PARAM(",\"agent\":"));
+
+   appendJSONString(buffer, r.agent, r.agent_len);
+
+   buffer.snprintf_add(U_CONSTANT_TO_PARAM(",\"pid\":%u}\n"), (uint32_t)r.pid);
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UBinaryAccessLog::dump(bool reset) const
+{
+   *UObjectIO::os << "pid                       " << pid            << '\n'
+                  << "last                      " << last           << '\n'
+                  << "start                     " << start          << '\n'
+                  << "adjust                    " << adjust         << '\n'
+                  << "nentry                    " << nentry         << '\n'
+                  << "nrecord                   " << nrecord        << '\n'
+                  << "nsegment                  " << nsegment       << '\n'
+                  << "dict_sz                   " << dict_sz        << '\n'
+                  << "nrotate                   " << nrotate        << '\n'
+                  << "dict      (UFlatHashMap   " << (void*)&dict   << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
+const char* UBinaryAccessLogReader::dump(bool reset) const
+{
+   *UObjectIO::os << "pend                      " << (void*)pend     << '\n'
+                  << "pnext                     " << (void*)pnext    << '\n'
+                  << "nrecord                   " << nrecord         << '\n'
+                  << "nsegment                  " << nsegment        << '\n'
+                  << "nskipped                  " << nskipped        << '\n'
+                  << "ngarbage                  " << ngarbage        << '\n'
+                  << "request   (UString        " << (void*)&request << ")\n"
+                  << "vstream   (UVector        " << (void*)&vstream << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#endif
@@ -21,10 +21,16 @@ bool                          UHTTP2::bcontinue100;
 bool                          UHTTP2::bsetting_ack;
 bool                          UHTTP2::bsetting_send;
 bool                          UHTTP2::priority_exclusive;
-uint8_t                       UHTTP2::priority_weight;     // 0 if not set
+uint32_t                      UHTTP2::priority_weight;     // 0 if not set
 uint32_t                      UHTTP2::priority_dependency; // 0 if not set
 uint32_t                      UHTTP2::hash_static_table[61];
 uint32_t                      UHTTP2::wait_for_continuation;
+uint32_t                      UHTTP2::nwrite;
+uint32_t                      UHTTP2::iov_batch_cnt;
+uint32_t                      UHTTP2::iov_batch_count;
+char                          UHTTP2::iov_batch_header[HTTP2_WRITE_BATCH][HTTP2_FRAME_HEADER_SIZE];
+struct iovec                  UHTTP2::iov_batch[HTTP2_WRITE_BATCH*2];
+UHTTP2::Stream*               UHTTP2::vwrite[HTTP2_MAX_CONCURRENT_STREAMS];
 UHTTP2::Stream*               UHTTP2::pStream;
 UHTTP2::Stream*               UHTTP2::pStreamEnd;
 UHTTP2::FrameHeader           UHTTP2::frame;
@@ -142,7 +148,7 @@ UHTTP2::Connection::Connection() : itable(53, setIndexStaticTable)
    odyntbl.hpack_capacity     =
    odyntbl.hpack_max_capacity = 4096;
 
-   for (uint32_t i = 0; i < HTTP2_MAX_CONCURRENT_STREAMS; ++i) (void) U_SYSCALL(memset, "%p,%d,%u", &(streams[i].id), 0, sizeof(uint32_t) * 3);
+   for (uint32_t i = 0; i < HTTP2_MAX_CONCURRENT_STREAMS; ++i) (void) U_SYSCALL(memset, "%p,%d,%u", &(streams[i].id), 0, (char*)(streams+i+1) - (char*)&(streams[i].id));
 
 #ifdef DEBUG
    (void) memset(&ddyntbl, 0, sizeof(HpackDynamicTable));
@@ -359,7 +365,15 @@ void UHTTP2::updateSetting(unsigned char* ptr, uint32_t len)
                return;
                }
 
-            pConnection->out_window                        =
+            // NB: the change is applied to the window of all the streams, the window of the connection is changed only by WINDOW_UPDATE (6.9.2)
+
+            int32_t delta = (int32_t)value - (int32_t)pConnection->peer_settings.initial_window_size;
+
+            if (delta)
+               {
+               for (Stream* stream = pConnection->streams; stream <= pStreamEnd; ++stream) stream->out_window += delta;
+               }
+
             pConnection->peer_settings.initial_window_size = value;
             }
          break;
@@ -664,6 +678,162 @@ unsigned char* UHTTP2::hpackEncodeString(unsigned char* dst, const char* src, ui
    U_RETURN_POINTER(dst, unsigned char);
 }
 
+unsigned char* UHTTP2::hpackEncodeStringShortest(unsigned char* dst, const char* src, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeStringShortest(%p,%.*S,%u)", dst, len, src, len)
+
+   uint32_t nbits = 0;
+   const char* src_end = src + len;
+
+   for (const char* ptr = src; ptr < src_end; ++ptr) nbits += huff_sym_table[*(unsigned char*)ptr].nbits;
+
+   U_INTERNAL_DUMP("nbits = %u (%u bytes)", nbits, (nbits + 7) >> 3)
+
+   dst = hpackEncodeString(dst, src, len, (((nbits + 7) >> 3) < len));
+
+   U_RETURN_POINTER(dst, unsigned char);
+}
+
+int32_t UHTTP2::findHpackDynTblEntry(HpackDynamicTable* dyntbl, const UString& name, const char* value, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::findHpackDynTblEntry(%p,%V,%.*S,%u)", dyntbl, name.rep, len, value, len)
+
+   HpackHeaderTableEntry* entry;
+
+   for (uint32_t i = 0; i < dyntbl->num_entries; ++i)
+      {
+      entry = getHpackDynTblEntry(dyntbl, i);
+
+      if (entry->value->equal(value, len) &&
+          name.equal(entry->name))
+         {
+         U_RETURN(i);
+         }
+      }
+
+   U_RETURN(-1);
+}
+
+unsigned char* UHTTP2::hpackEncodeLiteralIndexing(unsigned char* dst, HpackDynamicTable* dyntbl, uint32_t index, const UString& _name, const UString& value)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeLiteralIndexing(%p,%p,%u,%V,%V)", dst, dyntbl, index, _name.rep, value.rep)
+
+   UString name(index ? hpack_static_table[index-1].name : _name.rep);
+
+   // NB: we don't want that a big entry flush the dynamic table...
+
+   if ((name.size() + value.size() + HTTP2_HEADER_TABLE_ENTRY_SIZE_OFFSET) > (dyntbl->hpack_capacity / 4))
+      {
+      if (index) dst = hpackEncodeInt(dst, index, (1<<4)-1, 0x00); // literal without indexing
+      else
+         {
+         *dst++ = 0x00;
+          dst   = hpackEncodeStringShortest(dst, name);
+         }
+      }
+   else
+      {
+      if (index) dst = hpackEncodeInt(dst, index, (1<<6)-1, 0x40); // literal with incremental indexing
+      else
+         {
+         *dst++ = 0x40;
+          dst   = hpackEncodeStringShortest(dst, name);
+         }
+
+      // NB: the strings can be part of a buffer that is reused for the next response...
+
+      if (index) addHpackDynTblEntry(dyntbl, name,                                         UString((void*)value.data(), value.size()));
+      else       addHpackDynTblEntry(dyntbl, UString((void*)name.data(), name.size()), UString((void*)value.data(), value.size()));
+      }
+
+   dst = hpackEncodeStringShortest(dst, value);
+
+   U_RETURN_POINTER(dst, unsigned char);
+}
+
+unsigned char* UHTTP2::hpackEncodeIndexable(unsigned char* dst, HpackDynamicTable* dyntbl, uint32_t index, const UString& name, const UString& value)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeIndexable(%p,%p,%u,%V,%V)", dst, dyntbl, index, name.rep, value.rep)
+
+   int32_t i = findHpackDynTblEntry(dyntbl, (index ? UString(hpack_static_table[index-1].name) : name), U_STRING_TO_PARAM(value));
+
+   if (i >= 0) dst = hpackEncodeInt(dst, i+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80); // indexed
+   else        dst = hpackEncodeLiteralIndexing(dst, dyntbl, index, name, value);
+
+   U_RETURN_POINTER(dst, unsigned char);
+}
+
+unsigned char* UHTTP2::hpackEncodeCacheHeaders(unsigned char* dst, HpackDynamicTable* dyntbl, const UString& hpack)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeCacheHeaders(%p,%p,%V)", dst, dyntbl, hpack.rep)
+
+   int32_t index, len;
+   UString name, value;
+   unsigned char* start;
+   unsigned char* ptr = (unsigned char*)hpack.data();
+   unsigned char* end = ptr + hpack.size();
+
+   while (ptr < end)
+      {
+      start = ptr;
+
+      if ((*ptr & 0xc0) == 0x40) // literal with incremental indexing without Huffman (@see setHpackHeaders())
+         {
+         ptr = hpackDecodeInt(ptr, end, index, (1<<6)-1);
+
+         if (index) name._assign(hpack_static_table[index-1].name);
+         else
+            {
+            U_INTERNAL_ASSERT_EQUALS(*ptr & 0x80, 0)
+
+            ptr  = hpackDecodeInt(ptr, end, len, (1<<7)-1);
+            name = hpack.substr((const char*)ptr, len);
+
+            ptr += len;
+            }
+
+         U_INTERNAL_ASSERT_EQUALS(*ptr & 0x80, 0)
+
+         ptr   = hpackDecodeInt(ptr, end, len, (1<<7)-1);
+         value = hpack.substr((const char*)ptr, len);
+
+         ptr += len;
+
+         if (isHpackIndexable(index)) dst = hpackEncodeIndexable(dst, dyntbl, index, name, value);
+         else
+            {
+            if (index) dst = hpackEncodeInt(dst, index, (1<<4)-1, 0x00); // literal without indexing
+            else
+               {
+               *dst++ = 0;
+                dst   = hpackEncodeStringShortest(dst, name);
+               }
+
+            dst = hpackEncodeStringShortest(dst, value);
+            }
+         }
+      else // literal without indexing: as it is...
+         {
+         ptr = hpackDecodeInt(ptr, end, index, (1<<4)-1);
+
+         if (index == 0)
+            {
+            ptr  = hpackDecodeInt(ptr, end, len, (1<<7)-1);
+            ptr += len;
+            }
+
+         ptr  = hpackDecodeInt(ptr, end, len, (1<<7)-1);
+         ptr += len;
+
+         U_MEMCPY(dst, start, ptr-start);
+
+         dst += ptr-start;
+         }
+      }
+
+   U_RETURN_POINTER(dst, unsigned char);
+}
+
 void UHTTP2::evictHpackDynTblEntry(HpackDynamicTable* dyntbl, HpackHeaderTableEntry* entry, uint32_t index)
 {
    U_TRACE(0, "UHTTP2::evictHpackDynTblEntry(%p,%p,%u)", dyntbl, entry, index)
@@ -1845,6 +2015,12 @@ void UHTTP2::decodeHeaders()
             }
          }
 
+      table->hash = u_hash_ignore_case((unsigned char*)U_CONSTANT_TO_PARAM("priority"));
+
+      UString priority = table->at(U_CONSTANT_TO_PARAM("priority"));
+
+      if (priority) setPriority(pStream, U_STRING_TO_PARAM(priority)); // RFC 9218 (it has precedence over the PRIORITY frame)
+
       if (U_http_is_accept_gzip == false)
          {
          table->hash = hash_static_table[15]; // accept-encoding
@@ -1905,6 +2081,12 @@ void UHTTP2::manageHeaders()
       priority_weight     = 0;
       priority_exclusive  = false;
       priority_dependency = 0;
+
+      if (pStream->headers.empty()) // NB: not for the trailer part...
+         {
+         pStream->urgency     = 3;
+         pStream->incremental = false;
+         }
       }
    else
       {
@@ -1926,7 +2108,12 @@ void UHTTP2::manageHeaders()
          return;
          }
 
-      // TODO
+      if (pStream->headers.empty())
+         {
+         setUrgency(pStream);
+
+         pStream->incremental = false;
+         }
 
       sz  -= 5;
       ptr += 5;
@@ -2027,7 +2214,8 @@ manage_headers:
 
       if (nerror == NO_ERROR)
          {
-         pStream->id = frame.stream_id;
+         pStream->id         = frame.stream_id;
+         pStream->out_window = pConnection->peer_settings.initial_window_size;
 
          if (pConnection->max_processed_stream_id < frame.stream_id) pConnection->max_processed_stream_id = frame.stream_id;
          }
@@ -2149,7 +2337,17 @@ loop:
 
    if (frame.type > CONTINUATION)
       {
-      if (wait_for_continuation == 0) goto ret; // The endpoint MUST discard frames that have unknown or unsupported types
+      if (wait_for_continuation == 0) // The endpoint MUST discard frames that have unknown or unsupported types
+         {
+         if (frame.type == PRIORITY_UPDATE)
+            {
+            readPriorityUpdate();
+
+            if (nerror != NO_ERROR) goto end;
+            }
+
+         goto ret;
+         }
 
       nerror = PROTOCOL_ERROR;
 
@@ -2267,14 +2465,18 @@ window_update:
             goto end;
             }
 
-         if ((pConnection->out_window + window_size_increment) > HTTP2_MAX_WINDOW_SIZE)
+         int32_t* pwindow = (frame.stream_id ? &(pStream->out_window) : &(pConnection->out_window));
+
+         U_INTERNAL_DUMP("frame.stream_id = %u window = %d", frame.stream_id, *pwindow)
+
+         if (((int64_t)*pwindow + window_size_increment) > HTTP2_MAX_WINDOW_SIZE)
             {
             nerror = FLOW_CONTROL_ERROR;
 
             goto end;
             }
 
-         if (frame.stream_id) pConnection->out_window += window_size_increment;
+         *pwindow += window_size_increment;
 
          goto ret;
          }
@@ -2341,7 +2543,9 @@ window_update:
 
          if (nerror == NO_ERROR)
             {
-            // TODO
+            Stream* stream = getStream(frame.stream_id);
+
+            if (stream) setUrgency(stream); // NB: a PRIORITY frame for a stream not yet opened is ignored...
 
             goto ret;
             }
@@ -2464,9 +2668,9 @@ ret:
       }
 }
 
-unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name, const UString& value)
+unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name, const UString& value, HpackDynamicTable* dyntbl)
 {
-   U_TRACE(0, "UHTTP2::hpackEncodeHeader(%p,%V,%V)", dst, name.rep, value.rep)
+   U_TRACE(0, "UHTTP2::hpackEncodeHeader(%p,%V,%V,%p)", dst, name.rep, value.rep, dyntbl)
 
    int32_t index = 0;
    const char* keyp = name.data();
@@ -2535,8 +2739,7 @@ unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name
       break;
       }
 
-   if (index) dst = hpackEncodeInt(dst, index, (1<<4)-1, 0x00); // literal
-   else
+   if (index == 0)
       {
       char* ptr = name.data();
 
@@ -2558,19 +2761,50 @@ unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name
          U_RETURN_POINTER(dst, unsigned char);
          }
 #  endif
+      }
+
+   if (dyntbl == U_NULLPTR)
+      {
+      // NB: block for the file cache, the indexable headers are marked for the indexing and their strings are not encoded so that
+      //     hpackEncodeCacheHeaders() can search them on the dynamic table of the connection, the others are copied as they are...
+
+      if (isHpackIndexable(index) == false) goto literal;
+
+      if (index) dst = hpackEncodeInt(dst, index, (1<<6)-1, 0x40); // literal with incremental indexing
+      else
+         {
+         *dst++ = 0x40;
+          dst   = hpackEncodeString(dst, name, false); // not-existing name
+         }
+
+      dst = hpackEncodeString(dst, value, false);
+
+      U_RETURN_POINTER(dst, unsigned char);
+      }
 
+   if (isHpackIndexable(index))
+      {
+      dst = hpackEncodeIndexable(dst, dyntbl, index, name, value);
+
+      U_RETURN_POINTER(dst, unsigned char);
+      }
+
+literal:
+   if (index) dst = hpackEncodeInt(dst, index, (1<<4)-1, 0x00); // literal without indexing
+   else
+      {
       *dst++ = 0;
-       dst   = hpackEncodeString(dst, name, true); // not-existing name
+       dst   = hpackEncodeStringShortest(dst, name); // not-existing name
       }
 
-   dst = hpackEncodeString(dst, value, true);
+   dst = hpackEncodeStringShortest(dst, value);
 
    U_RETURN_POINTER(dst, unsigned char);
 }
 
-unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& headers)
+unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& headers, HpackDynamicTable* dyntbl)
 {
-   U_TRACE(0, "UHTTP2::setHpackHeaders(%p,%V)", dst, headers.rep)
+   U_TRACE(0, "UHTTP2::setHpackHeaders(%p,%V,%p)", dst, headers.rep, dyntbl)
 
    UString row, key;
    UVector<UString> vext(20);
@@ -2581,7 +2815,7 @@ unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& header
 
       uint32_t pos = row.find_first_of(':');
 
-      dst = hpackEncodeHeader(dst, row.substr(0U, pos), row.substr(pos+2)); 
+      dst = hpackEncodeHeader(dst, row.substr(0U, pos), row.substr(pos+2), dyntbl);
       }
 
    U_RETURN_POINTER(dst, unsigned char);
@@ -2602,6 +2836,18 @@ void UHTTP2::handlerResponse()
 
    unsigned char* dst = (unsigned char*)UClientImage_Base::wbuffer->data();
 
+   HpackDynamicTable* dyntbl = &(pConnection->odyntbl);
+
+   U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
+                     dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
+
+   if (pConnection->peer_settings.header_table_size < dyntbl->hpack_capacity) // NB: the decoder of the peer want a smaller dynamic table...
+      {
+      uint32_t value = pConnection->peer_settings.header_table_size;
+
+      dst = setHpackOutputDynTblCapacity(dst, value); // dynamic table size update (must be at the beginning of the header block)
+      }
+
    if (U_http_info.nResponseCode == HTTP_NOT_IMPLEMENTED ||
        U_http_info.nResponseCode == HTTP_OPTIONS_RESPONSE)
       {
@@ -2669,91 +2915,40 @@ void UHTTP2::handlerResponse()
    /**
     * server: ULib
     * date: Wed, 20 Jun 2012 11:43:17 GMT
+    *
+    * NB: on the same connection they are indexed on the output dynamic table (the date until it change)...
     */
 
-   HpackDynamicTable* dyntbl = &(pConnection->odyntbl);
-
-   U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
-                     dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
-
-   if (dyntbl->num_entries == 0)
-      {
-#  if defined(U_LINUX) && defined(ENABLE_THREAD)
-      U_INTERNAL_ASSERT_POINTER(u_pthread_time)
-      U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::ptr_shared_date->date3)
-#  else
-      U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::date.date3)
-
-      ULog::updateDate3(0);
-#  endif
-
-      UString date((void*)(((char*)UClientImage_Base::iov_vec[1].iov_base)+6), 29);
-
-      /**
-       * dst = hpackEncodeInt(dst, 54, (1<<6)-1, 0x40);
-       * dst = hpackEncodeString(dst, U_CONSTANT_TO_PARAM("ULib"), false);
-       * dst = hpackEncodeInt(dst, 33, (1<<6)-1, 0x40);
-       */
-
-      u_put_unalignedp64(dst, U_MULTICHAR_CONSTANT64(0x76,0x04,0x55,0x4C,0x69,0x62,0x61,'\0'));
-
-      dst = hpackEncodeString(dst+7, date.data(), 29, true); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
-
-      addHpackDynTblEntry(dyntbl, *UString::str_server, *UString::str_ULib);
-      addHpackDynTblEntry(dyntbl, *UString::str_date, date);
-      }
-   else
-      {
-      HpackHeaderTableEntry* entry = getHpackDynTblEntry(dyntbl, 0); // last entry
-
-      char* ptr_date = entry->value->data();
-
-#  if defined(U_LINUX) && defined(ENABLE_THREAD)
-      U_INTERNAL_ASSERT_POINTER(u_pthread_time)
-      U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::ptr_shared_date->date3)
-#  else
-      U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::date.date3)
-
-      ULog::updateDate3(ptr_date);
-#  endif
-
-      U_ASSERT(UString::str_date->equal(entry->name))
+#if defined(U_LINUX) && defined(ENABLE_THREAD)
+   U_INTERNAL_ASSERT_POINTER(u_pthread_time)
+   U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::ptr_shared_date->date3)
+#else
+   U_INTERNAL_ASSERT_EQUALS(UClientImage_Base::iov_vec[1].iov_base, ULog::date.date3)
 
-      /**
-       * dst = hpackEncodeInt(dst, 1+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80);
-       */
+   ULog::updateDate3(U_NULLPTR);
+#endif
 
-      *dst++ = 0xbf;
+   const char* ptr_date = ((char*)UClientImage_Base::iov_vec[1].iov_base)+6;
 
-      if (ULog::tv_sec_old_3 == u_now->tv_sec)
-         {
-         /**
-          * dst = hpackEncodeInt(dst, 0+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80);
-          */
+   dst = hpackEncodeIndexable(dst, dyntbl, 54, *UString::str_server, *UString::str_ULib);
 
-         *dst++ = 0xbe;
-         }
-      else
-         {
-         /**
-          * dst = hpackEncodeInt(dst, 0+HTTP2_HEADER_TABLE_OFFSET, (1<<6)-1, 0x40);
-          */
+   int32_t i = findHpackDynTblEntry(dyntbl, *UString::str_date, ptr_date, 29);
 
-         *dst++ = 0x7e;
-          dst   = hpackEncodeString(dst, ptr_date, 29, true); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
-         }
-      }
+   if (i >= 0) dst = hpackEncodeInt(dst, i+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80);
+   else        dst = hpackEncodeLiteralIndexing(dst, dyntbl, 33, *UString::str_date, UString((void*)ptr_date, 29));
 
    if (sz1)
       {
       /**
-       * dst = hpackEncodeInt(dst, 55, (1<<4)-1, 0x00);
+       * NB: the cookie are never indexed (RFC 7541 section 7.1.3)...
+       *
+       * dst = hpackEncodeInt(dst, 55, (1<<4)-1, 0x10);
        */
 
-      u_put_unalignedp16(dst, U_MULTICHAR_CONSTANT16(0x0f,0x28));
+      u_put_unalignedp16(dst, U_MULTICHAR_CONSTANT16(0x1f,0x28));
                          dst += 2;
 
-      dst = hpackEncodeString(dst, UHTTP::set_cookie->data(), sz1, true);
+      dst = hpackEncodeStringShortest(dst, UHTTP::set_cookie->data(), sz1);
 
       UHTTP::set_cookie->setEmpty();
       }
@@ -2764,15 +2959,13 @@ void UHTTP2::handlerResponse()
          {
          U_ASSERT_EQUALS(UHTTP::ext->isPrintable(0, true), false)
 
-         U_MEMCPY(dst, UHTTP::ext->data(), sz2);
-
-         dst += sz2;
+         dst = hpackEncodeCacheHeaders(dst, dyntbl, *UHTTP::ext);
          }
       else
          {
          U_ASSERT(UHTTP::ext->isPrintable(0, true))
 
-         dst = setHpackHeaders(dst, *UHTTP::ext);
+         dst = setHpackHeaders(dst, *UHTTP::ext, dyntbl);
          }
       }
    else
@@ -2793,254 +2986,332 @@ void UHTTP2::handlerResponse()
    U_INTERNAL_ASSERT_MINOR(UClientImage_Base::wbuffer->size(), pConnection->peer_settings.max_frame_size)
 }
 
-void UHTTP2::writeData(struct iovec* iov, bool bdata, bool flag)
+UHTTP2::Stream* UHTTP2::getStream(uint32_t id)
 {
-   U_TRACE(0, "UHTTP2::writeData(%p,%b,%b)", iov, bdata, flag)
-
-   char* ptr               = (char*)iov[3].iov_base;
-   char* ptr2              = (char*)iov[2].iov_base;
-   uint32_t sz1            =        iov[1].iov_len,
-            sz2            =        iov[3].iov_len,
-            max_frame_size = pConnection->peer_settings.max_frame_size;
+   U_TRACE(0, "UHTTP2::getStream(%u)", id)
 
-   if (sz2 <= max_frame_size)
+   for (Stream* stream = pConnection->streams; stream <= pStreamEnd; ++stream)
       {
-      u_http2_write_len_and_type(ptr2,sz2,DATA);
-
-      ptr2[4] = flag;
-
-      if (bdata) (void) writev(iov,   4, HTTP2_FRAME_HEADER_SIZE+sz1+HTTP2_FRAME_HEADER_SIZE+sz2);
-      else       (void) writev(iov+2, 2,                             HTTP2_FRAME_HEADER_SIZE+sz2);
-
-      return;
+      if (stream->id == id) U_RETURN_POINTER(stream, Stream);
       }
 
-   u_http2_write_len_and_type(ptr2,max_frame_size,DATA);
-
-   ptr2[4] = 0;
-
-   iov[3].iov_len = max_frame_size;
-
-   if (pConnection->bug_client)
-      {
-      if (bdata) (void) writev(iov,   4, HTTP2_FRAME_HEADER_SIZE+sz1+HTTP2_FRAME_HEADER_SIZE+max_frame_size);
-      else       (void) writev(iov+2, 2,                             HTTP2_FRAME_HEADER_SIZE+max_frame_size);
+   U_RETURN_POINTER(U_NULLPTR, Stream);
+}
 
-      U_INTERNAL_DUMP("nerror = %u", nerror)
+void UHTTP2::setPriority(Stream* stream, const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::setPriority(%p,%.*S,%u)", stream, len, ptr, len)
 
-      if (nerror != NO_ERROR) return;
+   /**
+    * RFC 9218: the value is a dictionary (RFC 8941), the members that are not known or not valid are ignored
+    *
+    * Ex: u=1, i
+    */
 
-loop1:
-      iov[2].iov_len  = HTTP2_FRAME_HEADER_SIZE;
-      iov[3].iov_base = (ptr += max_frame_size);
-                         sz2 -= max_frame_size;
+   const char* end = ptr + len;
 
-      U_INTERNAL_DUMP("pConnection->peer_settings.max_frame_size = %u sz2 = %u", max_frame_size, sz2)
+   while (ptr < end)
+      {
+      while (u__isspace(*ptr) && ++ptr < end) {}
 
-      if (sz2 > max_frame_size)
+      if ((end - ptr) >= 3 &&
+          ptr[0] == 'u'    &&
+          ptr[1] == '=')
          {
-         u_http2_write_len_and_type(ptr2,max_frame_size,DATA);
+         if (ptr[2] >= '0' &&
+             ptr[2] <= '7')
+            {
+            stream->urgency = ptr[2] - '0';
+            }
+         }
+      else if (ptr < end &&
+               ptr[0] == 'i')
+         {
+         if ((ptr+1) == end ||
+             ptr[1] == ','  ||
+             ptr[1] == ';'  ||
+             u__isspace(ptr[1]))
+            {
+            stream->incremental = true;
+            }
+         else if ((end - ptr) >= 4 &&
+                  ptr[1] == '='    &&
+                  ptr[2] == '?')
+            {
+            stream->incremental = (ptr[3] == '1');
+            }
+         }
 
-         ptr2[4] = 0;
+      if ((ptr = (const char*)memchr(ptr, ',', end - ptr)) == U_NULLPTR) break;
 
-         iov[3].iov_len = max_frame_size;
+      ++ptr;
+      }
 
-         if (writev(iov+2, 2, HTTP2_FRAME_HEADER_SIZE+max_frame_size) == false) return;
+   U_INTERNAL_DUMP("stream->urgency = %u stream->incremental = %b", stream->urgency, stream->incremental)
+}
 
-         goto loop1;
-         }
+void UHTTP2::readPriorityUpdate()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::readPriorityUpdate()")
 
-      u_http2_write_len_and_type(ptr2,sz2,DATA);
+   /**
+    * RFC 9218 (7.1): the frame is sent on the stream 0, the payload is the id of the prioritized stream followed by the value of the priority field
+    */
 
-      ptr2[4] = flag;
+   if (frame.stream_id)
+      {
+      nerror = PROTOCOL_ERROR;
 
-      iov[3].iov_len = sz2;
+      return;
+      }
 
-      (void) writev(iov+2, 2, HTTP2_FRAME_HEADER_SIZE+sz2);
+   if (frame.length < 4)
+      {
+      nerror = FRAME_SIZE_ERROR;
 
       return;
       }
 
-   U_DEBUG("UHTTP2::writeData(%p,%b,%b) - User-Agent: = %.*S", iov, bdata, flag, U_HTTP_USER_AGENT_TO_TRACE)
+   Stream* stream = getStream(u_http2_parse_sid(frame.payload));
 
-   uint32_t iovcnt, count;
-   struct iovec iov_vec[1024];
+   if (stream) setPriority(stream, (const char*)frame.payload+4, frame.length-4); // NB: for a stream not yet opened it is ignored...
+}
 
-   if (bdata)
-      {
-      U_MEMCPY(iov_vec, iov, sizeof(struct iovec) * (iovcnt = 4));
+bool UHTTP2::flushFrames()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::flushFrames()")
 
-      count = HTTP2_FRAME_HEADER_SIZE+sz1+HTTP2_FRAME_HEADER_SIZE+max_frame_size;
-      }
-   else
+   U_INTERNAL_DUMP("iov_batch_cnt = %u iov_batch_count = %u", iov_batch_cnt, iov_batch_count)
+
+   if (iov_batch_cnt)
       {
-      U_MEMCPY(iov_vec, iov+2, sizeof(struct iovec) * (iovcnt = 2));
+      if (writev(iov_batch, iov_batch_cnt, iov_batch_count, U_HTTP2_TIMEOUT_MS) == false) U_RETURN(false);
 
-      count = HTTP2_FRAME_HEADER_SIZE+max_frame_size;
+      iov_batch_cnt = iov_batch_count = 0;
       }
 
-loop2:
-   ptr += max_frame_size;
+   // the responses completely written (or of the streams reset by the peer) are released...
 
-   if ((sz2 -= max_frame_size) > max_frame_size)
+   for (Stream* stream = pConnection->streams; stream <= pStreamEnd; ++stream)
       {
-      U_MEMCPY(iov_vec+iovcnt, iov+2, sizeof(struct iovec) * 2);
-
-      ++iovcnt;
+      if (stream->bheaders &&
+          (stream->state == STREAM_STATE_CLOSED ||
+           stream->ooffset == stream->obody.size()))
+         {
+         stream->obody.clear();
+         stream->oheaders.clear();
 
-                               iov_vec[iovcnt].iov_base = ptr;
-      U_INTERNAL_ASSERT_EQUALS(iov_vec[iovcnt].iov_len, max_frame_size)
+         stream->ooffset  = 0;
+         stream->bheaders = false;
+         }
+      }
 
-      ++iovcnt;
+   U_RETURN(true);
+}
 
-      U_INTERNAL_ASSERT_MINOR(iovcnt, 1024)
+bool UHTTP2::addFrame(char type, char flags, const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::addFrame(%d,%d,%p,%u)", type, flags, ptr, len)
 
-      count += HTTP2_FRAME_HEADER_SIZE+max_frame_size;
+   U_INTERNAL_ASSERT(len <= pConnection->peer_settings.max_frame_size)
 
-      goto loop2;
+   if (iov_batch_cnt == (HTTP2_WRITE_BATCH*2) &&
+       flushFrames() == false)
+      {
+      U_RETURN(false);
       }
 
-   iov_vec[iovcnt] = iov[2];
+   char* hdr = iov_batch_header[iov_batch_cnt / 2];
+
+   u_http2_write_len_and_type(hdr,len,type);
+
+   hdr[4] = flags;
 
-   ++iovcnt;
+   u_write_unalignedp32(hdr+5,pStream->id);
 
-   iov_vec[iovcnt].iov_len  = sz2;
-   iov_vec[iovcnt].iov_base = ptr;
+   iov_batch[iov_batch_cnt].iov_base = (caddr_t)hdr;
+   iov_batch[iov_batch_cnt].iov_len  = HTTP2_FRAME_HEADER_SIZE;
 
-   ++iovcnt;
+   ++iov_batch_cnt;
 
-   U_INTERNAL_ASSERT_MINOR(iovcnt, 1024)
+   iov_batch[iov_batch_cnt].iov_base = (caddr_t)ptr;
+   iov_batch[iov_batch_cnt].iov_len  = len;
 
-   count += HTTP2_FRAME_HEADER_SIZE+sz2;
+   ++iov_batch_cnt;
 
-   (void) writev(iov_vec, iovcnt, count);
+   iov_batch_count += HTTP2_FRAME_HEADER_SIZE + len;
+
+   U_RETURN(true);
 }
 
-void UHTTP2::writeResponse()
+void UHTTP2::writeStreams(bool bwait)
 {
-   U_TRACE_NO_PARAM(0, "UHTTP2::writeResponse()")
+   U_TRACE(0, "UHTTP2::writeStreams(%b)", bwait)
 
-   U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_PARENT)
+   U_INTERNAL_ASSERT_EQUALS(nerror, NO_ERROR)
 
-   char buffer1[HTTP2_FRAME_HEADER_SIZE];
-   char buffer2[HTTP2_FRAME_HEADER_SIZE];
+   char flags;
+   Stream* stream;
+   const char* ptr;
+   uint32_t i, len, urgency;
+   Stream* plast      = U_NULLPTR; // the last stream served (round robin of the incremental ones)
+   Stream* pStreamOld = pStream;
 
-   if (UHTTP::isHEAD()) UClientImage_Base::body->clear();
+   iov_batch_cnt = iov_batch_count = 0;
 
-   char* ptr  = UClientImage_Base::body->data();
-   char* ptr0 = UClientImage_Base::wbuffer->data();
-   char* ptr1 = buffer1;
+   // the header blocks are not subject to flow control and they must be written in order of encoding (the dynamic table of the peer)...
 
-   uint32_t sz0     = UClientImage_Base::wbuffer->size(),
-            body_sz = UClientImage_Base::body->size();
+   for (i = 0; i < nwrite; ++i)
+      {
+      pStream = vwrite[i];
 
-   struct iovec iov_vec[4] = { { (caddr_t)buffer1, HTTP2_FRAME_HEADER_SIZE },
-                               { (caddr_t)ptr0, sz0 },
-                               { (caddr_t)buffer2, HTTP2_FRAME_HEADER_SIZE },
-                               { (caddr_t)ptr, body_sz } };
+      if (pStream->state == STREAM_STATE_CLOSED) pStream->obody.clear(); // NB: RST_STREAM, the header block is written anyway for the hpack state...
 
-   U_INTERNAL_DUMP("UClientImage_Base::wbuffer(%u) = %V", sz0, UClientImage_Base::wbuffer->rep)
+      flags = FLAG_END_HEADERS | (pStream->obody.empty() ? FLAG_END_STREAM : 0);
 
-   U_INTERNAL_ASSERT(*UClientImage_Base::wbuffer)
+      if (addFrame(HEADERS, flags, U_STRING_TO_PARAM(pStream->oheaders)) == false) goto end;
 
-   u_http2_write_len_and_type(ptr1,sz0,HEADERS);
+      pStream->bheaders = true;
+      }
 
-   ptr1[4] = FLAG_END_HEADERS | (body_sz == 0); // FLAG_END_STREAM (1)
+   nwrite = 0;
 
-   u_write_unalignedp32(ptr1+5,pStream->id);
+loop:
+   /**
+    * we choose the stream with the highest urgency that can write: at the same urgency the not incremental responses are written one at a time
+    * in order of id, the incremental ones are interleaved frame by frame (RFC 9218). The DATA frames are collected for a single writev()...
+    */
 
-   U_SRV_LOG_WITH_ADDR("send response (%s,id:%u,bytes:%u) %#.*S to", pConnection->bug_client ? pConnection->bug_client : "HTTP2",
-                           pStream->id, sz0+HTTP2_FRAME_HEADER_SIZE+(body_sz ? body_sz+HTTP2_FRAME_HEADER_SIZE : 0), sz0, ptr0);
+   stream = U_NULLPTR;
 
-   if (body_sz == 0)
+   if (pConnection->out_window > 0)
       {
-#  ifdef DEBUG
-   // decodeHeadersResponse(ptr0, sz0);
-#  endif
+      for (urgency = 0; urgency < 8 && stream == U_NULLPTR; ++urgency)
+         {
+         Stream* first = U_NULLPTR;
+         Stream* next  = U_NULLPTR;
 
-      (void) writev(iov_vec, 2, HTTP2_FRAME_HEADER_SIZE+sz0);
+         for (pStream = pConnection->streams; pStream <= pStreamEnd; ++pStream)
+            {
+            if (pStream->urgency    == urgency               &&
+                pStream->bheaders                            &&
+                pStream->out_window > 0                      &&
+                pStream->state     != STREAM_STATE_CLOSED    &&
+                pStream->ooffset    < pStream->obody.size())
+               {
+               if (pStream->incremental == false)
+                  {
+                  stream = pStream;
 
-      return;
-      }
+                  break;
+                  }
 
-   U_INTERNAL_ASSERT_MAJOR(body_sz, 0)
+               if (first == U_NULLPTR) first = pStream;
 
-   char* ptr2 = buffer2;
+               if (next  == U_NULLPTR &&
+                   pStream > plast)
+                  {
+                  next = pStream;
+                  }
+               }
+            }
 
-   u_write_unalignedp32(ptr2+5,pStream->id);
+         if (stream == U_NULLPTR) stream = (next ? next : first);
+         }
+      }
 
-   if ((uint32_t)pConnection->out_window >= body_sz)
+   if (stream)
       {
-      pConnection->out_window -= body_sz;
+      pStream = plast = stream;
 
-      writeData(iov_vec, true, FLAG_END_STREAM);
+      len = pStream->obody.size() - pStream->ooffset;
 
-      return;
-      }
+      if (len > pConnection->peer_settings.max_frame_size) len = pConnection->peer_settings.max_frame_size;
+      if (len > (uint32_t)pConnection->out_window)         len = pConnection->out_window;
+      if (len > (uint32_t)pStream->out_window)             len = pStream->out_window;
 
-   U_DEBUG("Current window size (%d) is not sufficient for data size: %u", pConnection->out_window, body_sz)
+      ptr   = pStream->obody.c_pointer(pStream->ooffset);
+      flags = ((pStream->ooffset + len) == pStream->obody.size() ? FLAG_END_STREAM : 0);
 
-   U_SRV_LOG("WARNING: Current window size (%d) is not sufficient for data size: %u", pConnection->out_window, body_sz);
+      U_INTERNAL_DUMP("pStream->id = %u urgency = %u incremental = %b len = %u out_window = (%d,%d)",
+                       pStream->id, pStream->urgency, pStream->incremental, len, pConnection->out_window, pStream->out_window)
 
-   if (pConnection->out_window == 0)
-      {
-      if (writev(iov_vec, 2, HTTP2_FRAME_HEADER_SIZE+sz0) == false) return;
+      if (addFrame(DATA, flags, ptr, len) == false) goto end;
+
+      pStream->ooffset        += len;
+      pStream->out_window     -= len;
+      pConnection->out_window -= len;
+
+      goto loop;
       }
-   else
+
+   if (flushFrames() == false ||
+       bwait == false)
       {
-      ptr               += pConnection->out_window;
-      body_sz           -= pConnection->out_window;
-      iov_vec[3].iov_len = pConnection->out_window;
-                           pConnection->out_window = 0;
+      goto end;
+      }
 
-      writeData(iov_vec, true, false);
+   // the data that remain must wait for a WINDOW_UPDATE frame...
 
-      U_INTERNAL_DUMP("nerror = %u", nerror)
+   for (pStream = pConnection->streams; pStream <= pStreamEnd; ++pStream)
+      {
+      if (pStream->obody)
+         {
+         U_DEBUG("Current window size (%d,%d) is not sufficient for data size: %u", pConnection->out_window, pStream->out_window, pStream->obody.size() - pStream->ooffset)
 
-      if (nerror != NO_ERROR) return;
-      }
+         readFrame();
 
-   // we must wait for a Window Update frame if the current window size is not sufficient...
+         U_INTERNAL_DUMP("nerror = %u", nerror)
 
-   Stream* pStreamOld = pStream;
+         if (nerror == NO_ERROR &&
+             (UServer_Base::csocket->isOpen() == false ||
+              UServer_Base::csocket->isTimeout()))
+            {
+            nerror = CONNECT_ERROR;
+            }
 
-loop:
-   readFrame();
+         if (nerror != NO_ERROR) goto end;
 
-   U_INTERNAL_DUMP("nerror = %u", nerror)
+         for (pStream = pConnection->streams; pStream <= pStreamEnd; ++pStream)
+            {
+            if (pStream->headers) goto end; // NB: a new request, handlerRequest() process it and then call us again...
+            }
 
-   if (nerror == NO_ERROR)
-      {
-      if (pConnection->out_window == 0) goto loop;
+         goto loop;
+         }
+      }
 
-      U_INTERNAL_DUMP("pStreamOld = %u pStream = %u", pStreamOld, pStream)
+end:
+   pStream = pStreamOld;
+}
 
-      pStream = pStreamOld;
+void UHTTP2::writeResponse()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::writeResponse()")
 
-      iov_vec[2].iov_len  = HTTP2_FRAME_HEADER_SIZE;
-      iov_vec[3].iov_base = ptr;
+   U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_PARENT)
 
-      if (body_sz > (uint32_t)pConnection->out_window)
-         {
-         ptr               += pConnection->out_window;
-         body_sz           -= pConnection->out_window;
-         iov_vec[3].iov_len = pConnection->out_window;
-                              pConnection->out_window = 0;
+   if (UHTTP::isHEAD()) UClientImage_Base::body->clear();
 
-         writeData(iov_vec, false, false);
+   uint32_t sz0     = UClientImage_Base::wbuffer->size(),
+            body_sz = UClientImage_Base::body->size();
 
-         U_INTERNAL_DUMP("nerror = %u", nerror)
+   U_INTERNAL_DUMP("UClientImage_Base::wbuffer(%u) = %V", sz0, UClientImage_Base::wbuffer->rep)
 
-         if (nerror != NO_ERROR) return;
+   U_INTERNAL_ASSERT(*UClientImage_Base::wbuffer)
+   U_INTERNAL_ASSERT_MINOR(nwrite, HTTP2_MAX_CONCURRENT_STREAMS)
 
-         goto loop;
-         }
+   U_SRV_LOG_WITH_ADDR("send response (%s,id:%u,bytes:%u) %#.*S to", pConnection->bug_client ? pConnection->bug_client : "HTTP2",
+                           pStream->id, sz0+HTTP2_FRAME_HEADER_SIZE+(body_sz ? body_sz+HTTP2_FRAME_HEADER_SIZE : 0), sz0, UClientImage_Base::wbuffer->data());
 
-      iov_vec[3].iov_len       = body_sz;
-      pConnection->out_window -= body_sz;
+   // NB: the response is written by writeStreams() together with the others of the connection (the strings are referenced, not copied)...
 
-      writeData(iov_vec, false, true);
-      }
+   pStream->oheaders = *UClientImage_Base::wbuffer;
+   pStream->obody    = *UClientImage_Base::body;
+   pStream->ooffset  = 0;
+   pStream->bheaders = false;
+
+   vwrite[nwrite++] = pStream;
 }
 
 // HTTP2 => HTTP1
@@ -3181,7 +3452,9 @@ void UHTTP2::handlerDelete(UClientImage_Base* pclient, bool& bsocket_open)
    for (pStream = pConnection->streams, pStreamEnd = (pStream+HTTP2_MAX_CONCURRENT_STREAMS); pStream < pStreamEnd; ++pStream)
       {
       U_ASSERT(pStream->body.empty())
+      U_ASSERT(pStream->obody.empty())
       U_ASSERT(pStream->headers.empty())
+      U_ASSERT(pStream->oheaders.empty())
 
       U_INTERNAL_ASSERT_EQUALS(pStream->clength, 0)
       }
@@ -3335,7 +3608,10 @@ void UHTTP2::handlerRequest()
          pStream->id                          =
          pConnection->max_processed_stream_id = 1;
 
-         pStream->state = STREAM_STATE_HALF_CLOSED;
+         pStream->state       = STREAM_STATE_HALF_CLOSED;
+         pStream->urgency     = 3;
+         pStream->incremental = false;
+         pStream->out_window  = pConnection->peer_settings.initial_window_size;
 
          if ((pStream->clength = U_http_info.clength))
             {
@@ -3396,6 +3672,15 @@ next2:
    UClientImage_Base::request->clear();
 
 read_request:
+   if (nwrite) // NB: we don't keep the responses already processed while we wait for other frames...
+      {
+      writeStreams(false);
+
+      U_INTERNAL_DUMP("nerror = %u", nerror)
+
+      if (nerror != NO_ERROR) goto err;
+      }
+
    readFrame();
 
    U_INTERNAL_DUMP("nerror = %u", nerror)
@@ -3619,6 +3904,22 @@ process_request:
             }
          }
 
+      writeStreams(true);
+
+      U_INTERNAL_DUMP("nerror = %u", nerror)
+
+      if (nerror != NO_ERROR) goto err;
+
+      for (pStream = pConnection->streams; pStream <= pStreamEnd; ++pStream)
+         {
+         if (pStream->headers) // NB: a new request arrived while we was waiting for a WINDOW_UPDATE frame...
+            {
+            startRequest();
+
+            goto loop;
+            }
+         }
+
       UClientImage_Base::wbuffer->clear();
 
 #  ifdef DEBUG
@@ -4005,6 +4306,7 @@ const char* UHTTP2::getFrameTypeDescription(char type)
       case U_HTTP2_ENTRY(GOAWAY);
       case U_HTTP2_ENTRY(WINDOW_UPDATE);
       case U_HTTP2_ENTRY(CONTINUATION);
+      case U_HTTP2_ENTRY(PRIORITY_UPDATE);
 
       default: descr = "Frame type unknown";
       }
@@ -0,0 +1,339 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    mask_matcher.cpp - compiled DOS regexp (multiple patterns separated by '|')
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/container/flat_hash_map.h>
+#include <ulib/utility/mask_matcher.h>
+
+UMaskMatcher::UMaskMatcher(const UString& mask, int _flags) : vpattern(16U)
+{
+   U_TRACE_REGISTER_OBJECT(0, UMaskMatcher, "%V,%d", mask.rep, _flags)
+
+   U_INTERNAL_ASSERT_EQUALS(_flags & FNM_INVERT, 0)
+
+   accept = U_NULLPTR;
+   table  = U_NULLPTR;
+   bfinal = U_NULLPTR;
+   nstate = nclass = 0;
+   flags  = _flags;
+
+   // NB: we split the alternatives like u_match_with_OR() (an empty alternative match nothing)...
+
+   const char* p_or;
+   const char* ptr = mask.data();
+   const char* end = ptr + mask.size();
+
+   while (ptr < end)
+      {
+      p_or = (const char*) memchr(ptr, '|', end - ptr);
+
+      if (p_or == U_NULLPTR) p_or = end;
+
+      if (p_or > ptr) vpattern.push_back(mask.substr(ptr, p_or - ptr));
+
+      ptr = p_or + 1;
+      }
+
+   U_INTERNAL_DUMP("vpattern.size() = %u", vpattern.size())
+
+   if (vpattern.size() <= U_MASK_MATCHER_MAX_PATTERN &&
+       compile() == false)
+      {
+      U_WARNING("UMaskMatcher: the DFA for the mask %V is too large (more than %u states), we match the patterns one at a time", mask.rep, U_MASK_MATCHER_MAX_STATE);
+      }
+}
+
+UMaskMatcher::~UMaskMatcher()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UMaskMatcher)
+
+   if (table)
+      {
+      UMemoryPool::_free(accept, nstate,          sizeof(uint64_t));
+      UMemoryPool::_free(table,  nstate * nclass, sizeof(uint16_t));
+      UMemoryPool::_free(bfinal, nstate,          sizeof(uint8_t));
+      }
+}
+
+/**
+ * The NFA of a pattern has a position for every char of the pattern plus the final position (accept). From the position of
+ * a literal or '?' we go to the next position consuming a matching char, the position of '*' loops on any char and reach the
+ * next position also without consuming (closure). A state of the DFA is a set of positions of all the patterns (subset construction)
+ */
+
+bool UMaskMatcher::compile()
+{
+   U_TRACE_NO_PARAM(0, "UMaskMatcher::compile()")
+
+   U_INTERNAL_ASSERT_EQUALS(table, U_NULLPTR)
+   U_INTERNAL_ASSERT_RANGE(1, vpattern.size(), U_MASK_MATCHER_MAX_PATTERN)
+
+   bool result = false;
+   bool ignore_case = ((flags & FNM_IGNORECASE) != 0);
+   uint32_t i, j, k, p, c, n = vpattern.size(), npos = 0;
+
+   for (i = 0; i < n; ++i) npos += vpattern[i].size() + 1;
+
+   uint32_t nword = (npos + 63) / 64, max_state = U_MASK_MATCHER_MAX_STATE;
+
+   char*     pchar = (char*)    UMemoryPool::_malloc(npos, sizeof(char));     // char of the pattern for every position ('\0' for the final one)
+   uint8_t*  ppat  = (uint8_t*) UMemoryPool::_malloc(npos, sizeof(uint8_t));  // index of the pattern for every position
+   uint64_t* start = (uint64_t*)UMemoryPool::_malloc(nword, sizeof(uint64_t)); // the start position of every pattern
+   uint64_t* sets  = (uint64_t*)UMemoryPool::_malloc(&max_state, nword * sizeof(uint64_t)); // the set of positions for every state
+   uint64_t* next  = (uint64_t*)UMemoryPool::_malloc(nword, sizeof(uint64_t));
+   unsigned char rep[256]; // a representative byte for every column of the table
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", start, 0, nword * sizeof(uint64_t));
+
+   for (p = i = 0; i < n; ++i)
+      {
+      const char* ptr = vpattern[i].data();
+
+      start[p / 64] |= 1ULL << (p % 64);
+
+      for (j = 0, k = vpattern[i].size(); j <= k; ++j, ++p)
+         {
+         pchar[p] = (j < k ? (ignore_case ? (char)u__tolower(ptr[j]) : ptr[j]) : '\0');
+         ppat[p]  = i;
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(p, npos)
+
+   // the bytes that don't appear in the patterns (as literal) share the column 0
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", cls, 0, sizeof(cls));
+
+   nclass = 1;
+
+   for (p = 0; p < npos; ++p)
+      {
+      c = (unsigned char)pchar[p];
+
+      if (c != '\0' &&
+          c != '*'  &&
+          c != '?'  &&
+          cls[c] == 0)
+         {
+         rep[nclass] = c;
+         cls[c]      = nclass++;
+
+         if (ignore_case) cls[u__toupper(c)] = cls[c];
+         }
+      }
+
+   for (c = 1; c < 255 && cls[c]; ++c) {}
+
+   rep[0] = c; // NB: rep[0] must not match any literal...
+
+   U_INTERNAL_DUMP("npos = %u nword = %u nclass = %u max_state = %u", npos, nword, nclass, max_state)
+
+   uint16_t* ptab = (uint16_t*)UMemoryPool::_malloc(U_MASK_MATCHER_MAX_STATE * nclass, sizeof(uint16_t));
+
+   UFlatHashMap<void*> state_of_set(U_MASK_MATCHER_MAX_STATE);
+
+   // state 0 is the dead state (empty set), state 1 the start state
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", sets, 0, nword * sizeof(uint64_t));
+
+   U_MEMCPY(sets + nword, start, nword * sizeof(uint64_t));
+
+   nstate = 2;
+
+   for (i = 0; i < nstate; ++i)
+      {
+      uint64_t* cur = sets + i * nword;
+
+      if (i == 1) // closure of the start state
+         {
+         for (p = 0; p < npos; ++p)
+            {
+            if ((cur[p / 64] & (1ULL << (p % 64))) && pchar[p] == '*') cur[(p+1) / 64] |= 1ULL << ((p+1) % 64);
+            }
+         }
+
+      UString key((const void*)cur, nword * sizeof(uint64_t));
+
+      if (state_of_set.find(key) == false) state_of_set.insertAfterFind(key, (const void*)(long)i);
+
+      for (c = 0; c < nclass; ++c)
+         {
+         (void) U_SYSCALL(memset, "%p,%d,%u", next, 0, nword * sizeof(uint64_t));
+
+         for (p = 0; p < npos; ++p)
+            {
+            if ((cur[p / 64] & (1ULL << (p % 64))) == 0) continue;
+
+            k = (unsigned char)pchar[p];
+
+            if (k == '\0') continue;
+
+            if (k == '*')               next[ p    / 64] |= 1ULL << ( p    % 64);
+            else if (k == '?' ||
+                     k == rep[c])       next[(p+1) / 64] |= 1ULL << ((p+1) % 64);
+            }
+
+         for (p = 0; p < npos; ++p) // closure ('*' match also the empty string)
+            {
+            if ((next[p / 64] & (1ULL << (p % 64))) && pchar[p] == '*') next[(p+1) / 64] |= 1ULL << ((p+1) % 64);
+            }
+
+         UString nkey((const void*)next, nword * sizeof(uint64_t));
+
+         if (state_of_set.find(nkey)) ptab[i * nclass + c] = (uint16_t)(long)state_of_set.elem();
+         else
+            {
+            if (nstate == U_MASK_MATCHER_MAX_STATE) goto end;
+
+            U_MEMCPY(sets + nstate * nword, next, nword * sizeof(uint64_t));
+
+            state_of_set.insertAfterFind(nkey, (const void*)(long)nstate);
+
+            ptab[i * nclass + c] = nstate++;
+            }
+         }
+      }
+
+   U_INTERNAL_DUMP("nstate = %u", nstate)
+
+   accept = (uint64_t*)UMemoryPool::_malloc(nstate,          sizeof(uint64_t));
+   table  = (uint16_t*)UMemoryPool::_malloc(nstate * nclass, sizeof(uint16_t));
+   bfinal = (uint8_t*) UMemoryPool::_malloc(nstate,          sizeof(uint8_t));
+
+   U_MEMCPY(table, ptab, nstate * nclass * sizeof(uint16_t));
+
+   for (i = 0; i < nstate; ++i)
+      {
+      uint64_t* cur = sets + i * nword;
+
+      accept[i] = 0;
+
+      for (p = 0; p < npos; ++p)
+         {
+         if ((cur[p / 64] & (1ULL << (p % 64))) && pchar[p] == '\0') accept[i] |= 1ULL << ppat[p];
+         }
+
+      // a state is final if every byte lead back to it (the dead state, or a pattern that ends with '*' is already matched)
+
+      for (bfinal[i] = true, c = 0; c < nclass; ++c)
+         {
+         if (table[i * nclass + c] != i)
+            {
+            bfinal[i] = false;
+
+            break;
+            }
+         }
+      }
+
+   result = true;
+
+end:
+   for (i = 0; i < nstate; ++i)
+      {
+      UString key((const void*)(sets + i * nword), nword * sizeof(uint64_t));
+
+      if (state_of_set.find(key)) state_of_set.eraseAfterFind();
+      }
+
+   if (result == false) nstate = nclass = 0;
+
+   UMemoryPool::_free(pchar, npos,                              sizeof(char));
+   UMemoryPool::_free(ppat,  npos,                              sizeof(uint8_t));
+   UMemoryPool::_free(start, nword,                             sizeof(uint64_t));
+   UMemoryPool::_free(sets,  max_state,                         nword * sizeof(uint64_t));
+   UMemoryPool::_free(next,  nword,                             sizeof(uint64_t));
+   UMemoryPool::_free(ptab,  U_MASK_MATCHER_MAX_STATE * nclass, sizeof(uint16_t));
+
+   U_RETURN(result);
+}
+
+// NB: u_dosmatch() assert that the string is not empty, so we must give the same answer of the DFA by ourselves...
+
+bool UMaskMatcher::matchPattern(const char* s, uint32_t len, const UString& pattern) const
+{
+   U_TRACE(0, "UMaskMatcher::matchPattern(%.*S,%u,%V)", len, s, len, pattern.rep)
+
+   if (len) return u_dosmatch(s, len, U_STRING_TO_PARAM(pattern), flags);
+
+   for (uint32_t i = 0, n = pattern.size(); i < n; ++i)
+      {
+      if (pattern.c_char(i) != '*') U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+uint64_t UMaskMatcher::match(const char* s, uint32_t len) const
+{
+   U_TRACE(0, "UMaskMatcher::match(%.*S,%u)", len, s, len)
+
+   U_CHECK_MEMORY
+
+   uint64_t result = 0;
+
+   if (table == U_NULLPTR)
+      {
+      for (uint32_t i = 0, n = U_min(vpattern.size(), 64); i < n; ++i)
+         {
+         if (matchPattern(s, len, vpattern[i])) result |= 1ULL << i;
+         }
+
+      // NB: with more than 64 patterns we only say if someone match (bit 63)...
+
+      for (uint32_t i = 64, n = vpattern.size(); result == 0 && i < n; ++i)
+         {
+         if (matchPattern(s, len, vpattern[i])) result = 1ULL << 63;
+         }
+
+      U_RETURN(result);
+      }
+
+   uint32_t state = 1;
+   const unsigned char* ptr = (const unsigned char*)s;
+   const unsigned char* end = ptr + len;
+
+   while (ptr < end)
+      {
+      if (bfinal[state]) break;
+
+      state = table[state * nclass + cls[*ptr++]];
+      }
+
+   result = accept[state];
+
+   U_RETURN(result);
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UMaskMatcher::dump(bool reset) const
+{
+   *UObjectIO::os << "flags                     " << flags          << '\n'
+                  << "table                     " << (void*)table   << '\n'
+                  << "accept                    " << (void*)accept  << '\n'
+                  << "bfinal                    " << (void*)bfinal  << '\n'
+                  << "nstate                    " << nstate         << '\n'
+                  << "nclass                    " << nclass         << '\n'
+                  << "vpattern (UVector<UString> " << (void*)&vpattern << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+#endif
@@ -69,8 +69,8 @@ bool USocketExt::read(USocket* sk, UString& buffer, uint32_t count, int timeoutM
 
    if (UNLIKELY(ncount < chunk))
       {
-      if (sk == UServer_Base::csocket) UClientImage_Base::manageReadBufferResize(chunk);
-      else                                             UString::_reserve(buffer, chunk);
+      if (&buffer == UClientImage_Base::rbuffer) UClientImage_Base::manageReadBufferResize(chunk);
+      else                                                       UString::_reserve(buffer, chunk);
 
       ncount = buffer.space();
       }
@@ -192,8 +192,8 @@ error:   U_INTERNAL_DUMP("errno = %d", errno)
 
       buffer.rep->_length = start + byte_read;
 
-      if (sk == UServer_Base::csocket) UClientImage_Base::manageReadBufferResize(ncount * 2);
-      else                                             UString::_reserve(buffer, ncount * 2);
+      if (&buffer == UClientImage_Base::rbuffer) UClientImage_Base::manageReadBufferResize(ncount * 2); // NB: the socket of the client can be read also on other buffers (ex: websocket)...
+      else                                                       UString::_reserve(buffer, ncount * 2);
 
       ptr       = buffer.c_pointer(start);
       ncount    = buffer.space();
@@ -359,9 +359,9 @@ int USocketExt::sendfile(USocket* sk, int in_fd, off_t* poffset, uint32_t count,
    U_INTERNAL_ASSERT_MAJOR(count, 0)
    U_INTERNAL_ASSERT(sk->isConnected())
 
-   U_DUMP("bssl = %b blocking = %b", sk->isSSLActive(), sk->isBlocking())
+   U_DUMP("bssl = %b ktls = %b blocking = %b", sk->isSSLActive(), sk->isKTLS(), sk->isBlocking())
 
-   U_INTERNAL_ASSERT_EQUALS(sk->isSSLActive(), false)
+   U_INTERNAL_ASSERT(sk->isSSLActive() == false || sk->isKTLS()) // NB: with kTLS the kernel encrypts the records, so the plain sendfile() is right...
 
 #if defined(HAVE_MACOSX_SENDFILE)
    off_t len;
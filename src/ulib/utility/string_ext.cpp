@@ -28,6 +28,10 @@
 #ifdef USE_LIBZOPFLI
 #  include <zopfli.h>
 #endif
+#ifdef USE_LIBBROTLI
+#  include <brotli/encode.h>
+#  include <brotli/decode.h>
+#endif
 #ifdef USE_LIBEXPAT
 #  include <ulib/xml/expat/xml2txt.h>
 #endif
@@ -1347,6 +1351,68 @@ UString UStringExt::gunzip(const char* ptr, uint32_t sz, uint32_t space) // .gz
 #endif
 }
 
+UString UStringExt::brotli(const char* s, uint32_t len, int quality) // .br compress
+{
+   U_TRACE(1, "UStringExt::brotli(%.*S,%u,%d)", len, s, len, quality)
+
+#ifdef USE_LIBBROTLI
+   size_t sz = U_SYSCALL(BrotliEncoderMaxCompressedSize, "%u", len);
+
+   UString r((uint32_t)sz);
+
+   if (U_SYSCALL(BrotliEncoderCompress, "%d,%d,%d,%u,%p,%p,%p", quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                                                                len, (const uint8_t*)s, &sz, (uint8_t*)r.rep->data()))
+      {
+      r.rep->_length = sz;
+
+      U_INTERNAL_DUMP("BrotliEncoderCompress(%u) = %u", len, r.size())
+
+      (void) r.shrink();
+
+      U_RETURN_STRING(r);
+      }
+#endif
+
+   return UString::getStringNull();
+}
+
+UString UStringExt::unbrotli(const char* s, uint32_t len) // .br uncompress
+{
+   U_TRACE(1, "UStringExt::unbrotli(%.*S,%u)", len, s, len)
+
+#ifdef USE_LIBBROTLI
+   size_t available_out;
+   size_t available_in = len;
+   const uint8_t* next_in = (const uint8_t*)s;
+   UString result(len * 4 + 1024);
+   uint8_t* next_out;
+   BrotliDecoderResult ret;
+   BrotliDecoderState* state = BrotliDecoderCreateInstance(U_NULLPTR, U_NULLPTR, U_NULLPTR);
+
+   if (state == U_NULLPTR) return UString::getStringNull();
+
+   do {
+      next_out      = (uint8_t*)result.pend();
+      available_out = result.space();
+
+      ret = BrotliDecoderDecompressStream(state, &available_in, &next_in, &available_out, &next_out, U_NULLPTR);
+
+      result.size_adjust((const char*)next_out);
+
+      if (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) (void) result.reserve(result.capacity()); // NB: we double the buffer...
+      }
+   while (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+
+   U_SYSCALL_VOID(BrotliDecoderDestroyInstance, "%p", state);
+
+   U_INTERNAL_DUMP("BrotliDecoderDecompressStream(%u) = %d", len, ret)
+
+   if (ret == BROTLI_DECODER_RESULT_SUCCESS) U_RETURN_STRING(result);
+#endif
+
+   return UString::getStringNull();
+}
+
 // gived the name retrieve pointer on value element from headers "name1:value1\nname2:value2\n"...
 
 __pure const char* UStringExt::getValueFromName(const UString& buffer, uint32_t pos, uint32_t len, const char* name, uint32_t name_len, bool nocase)
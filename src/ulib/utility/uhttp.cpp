@@ -24,6 +24,8 @@
 #include <ulib/utility/base64.h>
 #include <ulib/base/coder/url.h>
 #include <ulib/utility/dir_walk.h>
+#include <ulib/utility/mask_matcher.h>
+#include <ulib/utility/binary_access_log.h>
 #include <ulib/net/client/client.h>
 #include <ulib/utility/websocket.h>
 #include <ulib/utility/socket_ext.h>
@@ -65,6 +67,13 @@
 #  endif
 #endif
 
+// the request URI is scanned 16 bytes at a time with SSE4.2 if the cpu support it (u_flag_sse == 42, detected at runtime by u_init_ulib())
+
+#if (defined(__x86_64__) || defined(__i386)) && defined(HAVE_CPUID_H) && (defined(__clang__) || GCC_VERSION_NUM >= 40900)
+#  include <nmmintrin.h>
+#  define U_HTTP_SCAN_SSE42
+#endif
+
 #define U_FLV_HEAD        "FLV\x1\x1\0\0\0\x9\0\0\0\x9"
 #define U_TIME_FOR_EXPIRE (u_now->tv_sec + (365 * U_ONE_DAY_IN_SECOND))
 
@@ -97,6 +106,8 @@ UString* UHTTP::cache_file_mask;
 UString* UHTTP::nocache_file_mask;
 UString* UHTTP::cache_avoid_mask;
 UString* UHTTP::cache_file_store;
+UMaskMatcher* UHTTP::cache_file_matcher;
+UMaskMatcher* UHTTP::nocache_file_matcher;
 UString* UHTTP::cgi_cookie_option;
 UString* UHTTP::set_cookie_option;
 UString* UHTTP::string_HTTP_Variables;
@@ -160,9 +171,9 @@ UVector<UString>* UHTTP::valias;
 #ifdef USE_LIBSSL
 UString*                          UHTTP::uri_protected_mask;
 UString*                          UHTTP::uri_request_cert_mask;
-USSLSession*                      UHTTP::data_session_ssl;
 UVector<UIPAllow*>*               UHTTP::vallow_IP;
-URDBObjectHandler<UDataStorage*>* UHTTP::db_session_ssl;
+UMaskMatcher*                     UHTTP::uri_protected_matcher;
+UMaskMatcher*                     UHTTP::uri_request_cert_matcher;
 #endif
 #ifdef USE_LOAD_BALANCE
 UClient<USSLSocket>* UHTTP::client_http;
@@ -173,6 +184,9 @@ UString* UHTTP::uri_strict_transport_security_mask;
 #ifndef U_LOG_DISABLE
 char         UHTTP::iov_buffer[20];
 struct iovec UHTTP::iov_vec[10];
+uint32_t     UHTTP::log_body_len;
+uint32_t     UHTTP::log_response_code;
+UBinaryAccessLog* UHTTP::apache_like_log_binary;
 #  if !defined(U_CACHE_REQUEST_DISABLE) || defined(U_SERVER_CHECK_TIME_BETWEEN_REQUEST)
 uint32_t  UHTTP::agent_offset;
 uint32_t  UHTTP::request_offset;
@@ -1103,6 +1117,16 @@ void UHTTP::init()
 
    U_NEW(UHTTP::UFileCacheData, file_not_in_cache_data, UHTTP::UFileCacheData);
 
+   // NB: the masks checked for every request (and for every file of the cache) are compiled once (see UMaskMatcher)...
+
+   if (  cache_file_mask) U_NEW(UMaskMatcher,   cache_file_matcher, UMaskMatcher(*  cache_file_mask));
+   if (nocache_file_mask) U_NEW(UMaskMatcher, nocache_file_matcher, UMaskMatcher(*nocache_file_mask));
+
+#ifdef USE_LIBSSL
+   if (uri_protected_mask)    U_NEW(UMaskMatcher, uri_protected_matcher,    UMaskMatcher(*uri_protected_mask));
+   if (uri_request_cert_mask) U_NEW(UMaskMatcher, uri_request_cert_matcher, UMaskMatcher(*uri_request_cert_mask));
+#endif
+
    // manage gzip bomb and authorization data...
 
    UDirWalk dirwalk(&updir, U_CONSTANT_TO_PARAM("__BomB__.gz|*.htpasswd|*.htdigest"));
@@ -1112,7 +1136,11 @@ void UHTTP::init()
    if (cache_file_mask &&
        cache_file_mask->equal(U_CONSTANT_TO_PARAM("_off_")))
       {
-      if (nocache_file_mask == U_NULLPTR) U_NEW(UString, nocache_file_mask, U_STRING_FROM_CONSTANT("*"));
+      if (nocache_file_mask == U_NULLPTR)
+         {
+         U_NEW(UString,      nocache_file_mask,    U_STRING_FROM_CONSTANT("*"));
+         U_NEW(UMaskMatcher, nocache_file_matcher, UMaskMatcher(*nocache_file_mask));
+         }
       }
    else
       {
@@ -1405,6 +1433,10 @@ void UHTTP::dtor()
    if (cache_file_store)      delete cache_file_store;
    if (string_HTTP_Variables) delete string_HTTP_Variables;
 
+#ifndef U_LOG_DISABLE
+   if (apache_like_log_binary) delete apache_like_log_binary;
+#endif
+
    if (file)
       {
       delete ext;
@@ -1430,6 +1462,9 @@ void UHTTP::dtor()
       if (  cache_file_mask) delete   cache_file_mask;
       if (nocache_file_mask) delete nocache_file_mask;
 
+      if (  cache_file_matcher) delete   cache_file_matcher;
+      if (nocache_file_matcher) delete nocache_file_matcher;
+
 #  ifdef U_ALIAS
                                  delete  alias;
       if (valias)                delete valias;
@@ -1489,11 +1524,14 @@ void UHTTP::dtor()
          }
          
 #  ifdef USE_LIBSSL
-      if (db_session_ssl) clearSessionSSL();
+      USSLSession::close();
 
       if (vallow_IP)             delete vallow_IP;
       if (uri_protected_mask)    delete uri_protected_mask;
       if (uri_request_cert_mask) delete uri_request_cert_mask;
+
+      if (uri_protected_matcher)    delete uri_protected_matcher;
+      if (uri_request_cert_matcher) delete uri_request_cert_matcher;
 #  endif
 
 #  ifdef U_HTTP_STRICT_TRANSPORT_SECURITY
@@ -1637,6 +1675,32 @@ __pure bool UHTTP::isValidMethod(const char* ptr)
    U_RETURN(false);
 }
 
+#ifdef U_HTTP_SCAN_SSE42
+/**
+ * Skip the characters of the request URI that need no check: the scan stop on the first character that the loop in scanfHeaderRequest()
+ * must look at (control and blank, '%', ':', ';', '?', '[' - '^', '`', '{' - '}', DEL and 8 bit) or when there are no more than 16 bytes left,
+ * so that we never read over the end of the buffer and we never return endptr (the rest is for the scalar loop)...
+ */
+
+U_NO_EXPORT __attribute__((target("sse4.2"))) const char* UHTTP::skipURI(const char* ptr, const char* endptr)
+{
+   U_TRACE(0, "UHTTP::skipURI(%p,%p)", ptr, endptr)
+
+   static const char ranges[] = "\x00\x20" "%%" ":;" "??" "[^" "``" "{}" "\x7f\xff";
+
+   const __m128i r = _mm_loadu_si128((const __m128i*)ranges);
+
+   for (; (endptr - ptr) > 16; ptr += 16)
+      {
+      int i = _mm_cmpestri(r, sizeof(ranges)-1, _mm_loadu_si128((const __m128i*)ptr), 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+
+      if (i != 16) U_RETURN_POINTER(ptr+i, const char);
+      }
+
+   U_RETURN_POINTER(ptr, const char);
+}
+#endif
+
 bool UHTTP::scanfHeaderRequest(const char* ptr, uint32_t size)
 {
    U_TRACE(0, "UHTTP::scanfHeaderRequest(%.*S,%u)", size, ptr, size)
@@ -1783,6 +1847,10 @@ next:
 
    while (ptr < endptr)
       {
+#  ifdef U_HTTP_SCAN_SSE42
+      if (u_flag_sse == 42) ptr = skipURI(ptr, endptr); // NB: it never return endptr...
+#  endif
+
       c = *(unsigned char*)ptr;
 
       if (u__isblank(c))
@@ -2689,12 +2757,30 @@ U_NO_EXPORT void UHTTP::setAcceptEncoding(const char* ptr)
 {
    U_TRACE(0, "UHTTP::setAcceptEncoding(%p)", ptr)
 
+   uint32_t len = 0; // NB: the search must not go beyond the end of the header line...
+
+   while (len < 30 && u__islterm(ptr[len]) == false) ++len;
+
+   const char* end = ptr + len;
+
+#ifdef USE_LIBBROTLI
+   const char* br = (const char*)u_find(ptr, len, U_CONSTANT_TO_PARAM("br"));
+
+   if (br &&
+       isQualityZero(br+2, end) == false)
+      {
+      U_http_encoding |= HTTP_IS_ACCEPT_BR;
+
+      U_INTERNAL_DUMP("U_http_is_accept_br = %b", U_http_is_accept_br)
+      }
+#endif
+
    ptr = (u_get_unalignedp32(ptr) == U_MULTICHAR_CONSTANT32('g','z','i','p')
                ?                     ptr
-               : (const char*)u_find(ptr, 30, U_CONSTANT_TO_PARAM("gzip")));
+               : (const char*)u_find(ptr, len, U_CONSTANT_TO_PARAM("gzip")));
 
-   if (                   ptr &&
-       u_get_unalignedp32(ptr) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+   if (ptr &&
+       isQualityZero(ptr+4, end) == false)
       {
       U_http_flag |= HTTP_IS_ACCEPT_GZIP;
 
@@ -3718,6 +3804,7 @@ bool UHTTP::handlerCache()
    unsigned char c;
    bool http_gzip = false;
    char http_keep_alive = false;
+   bool bencoding = (U_http_is_response_gzip || U_http_is_response_br); // NB: we must check that the client accept the encoding of the cached response...
 
    U_INTERNAL_DUMP("U_http_uri_offset = %u", U_http_uri_offset)
 
@@ -3750,7 +3837,7 @@ bool UHTTP::handlerCache()
                U_INTERNAL_DUMP("http_keep_alive = %b", http_keep_alive)
                }
 
-            if (U_http_is_response_gzip == false || http_gzip) goto next2;
+            if (bencoding == false) goto next2;
 
             p += U_CONSTANT_SIZE("keep-alive\r");
 
@@ -3760,7 +3847,7 @@ bool UHTTP::handlerCache()
          goto next1;
          }
 
-      if (U_http_is_response_gzip == false || http_gzip) goto next1;
+      if (bencoding == false) goto next1;
 
       if (c == 'A' &&
           u_get_unalignedp64(p+1) == U_MULTICHAR_CONSTANT64('c','c','e','p','t','-','E','n'))
@@ -3769,25 +3856,43 @@ bool UHTTP::handlerCache()
 
          U_INTERNAL_DUMP("Accept-Encoding: = %.20S", p+1)
 
-         p = (const char*) u_find(p, 30, U_CONSTANT_TO_PARAM("gzip"));
+         uint32_t len = 0; // NB: the search must not go beyond the end of the header line...
+
+         while (len < 30 && u__islterm(p[len]) == false) ++len;
 
-         if (p &&
-             u_get_unalignedp32(p+4) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+         if (U_http_is_response_br)
             {
-            http_gzip = true;
+            p = (const char*) u_find(p, len, U_CONSTANT_TO_PARAM("br"));
 
-            U_INTERNAL_DUMP("http_gzip = %b", http_gzip)
+            if (p &&
+                u_get_unalignedp32(p+2) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+               {
+               bencoding = false;
+               }
+            }
+         else
+            {
+            p = (const char*) u_find(p, len, U_CONSTANT_TO_PARAM("gzip"));
+
+            if (p &&
+                u_get_unalignedp32(p+4) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+               {
+               http_gzip = true;
+               bencoding = false;
+
+               U_INTERNAL_DUMP("http_gzip = %b", http_gzip)
+               }
             }
          }
 next1:
       do { ++pos; } while (pos < end && ptr[pos] != '\n');
       }
 next2:
-   U_INTERNAL_DUMP("U_http_version = %C http_keep_alive = %b U_http_keep_alive = %b http_gzip = %b U_http_is_accept_gzip = %b",
-                    U_http_version,     http_keep_alive,     U_http_keep_alive,     http_gzip,     U_http_is_accept_gzip)
+   U_INTERNAL_DUMP("U_http_version = %C http_keep_alive = %b U_http_keep_alive = %b http_gzip = %b U_http_is_accept_gzip = %b bencoding = %b",
+                    U_http_version,     http_keep_alive,     U_http_keep_alive,     http_gzip,     U_http_is_accept_gzip,     bencoding)
 
    if (http_keep_alive != U_http_keep_alive ||
-       (http_gzip == false && U_http_is_response_gzip))
+       bencoding)
       {
       U_RETURN(false);
       }
@@ -3803,6 +3908,14 @@ next2:
 
       U_INTERNAL_ASSERT(U_http_sendfile)
 
+#  ifdef USE_LIBSSL
+      if (UServer_Base::bssl &&
+          UServer_Base::pClientImage->socket->isKTLS() == false) // NB: the cached response was sent with sendfile() on a connection with kTLS...
+         {
+         U_RETURN(false);
+         }
+#  endif
+
       UClientImage_Base::setSendfile(UClientImage_Base::csfd, range_start, range_size);
       }
 
@@ -4459,7 +4572,8 @@ file_in_cache:
          U_DUMP("U_http_info.nResponseCode = %u U_ClientImage_parallelization = %d UClientImage_Base::isNoHeaderForResponse() = %b",
                  U_http_info.nResponseCode,     U_ClientImage_parallelization,     UClientImage_Base::isNoHeaderForResponse())
 
-         if (U_http_info.nResponseCode == HTTP_OK)
+         if (U_http_info.nResponseCode == HTTP_OK &&
+             UClientImage_Base::isRequestSuspended() == false) // NB: the response is written on resume...
             {
             U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_PARENT)
 
@@ -4918,8 +5032,19 @@ int UHTTP::processRequest()
          if (isDataFromCache()) // NB: check if we have the content of the index file in cache...
             {
 #        ifdef USE_LIBZ
-            if (U_http_is_accept_gzip &&
-                isDataCompressFromCache())
+            if (U_http_is_accept_br &&
+                isDataBrotliFromCache())
+               {
+               U_http_encoding |= HTTP_IS_RESPONSE_BR;
+
+               U_INTERNAL_DUMP("U_http_is_response_br = %b", U_http_is_response_br)
+
+               *ext = getHeaderBrotliFromCache();
+
+               *UClientImage_Base::body = getBodyBrotliFromCache();
+               }
+            else if (U_http_is_accept_gzip &&
+                     isDataCompressFromCache())
                {
                U_http_flag |= HTTP_IS_RESPONSE_GZIP;
 
@@ -5169,8 +5294,18 @@ void UHTTP::setEndRequestProcessing()
 
          uint32_t body_len = UClientImage_Base::body->size();
 
-         iov_vec[5].iov_len = (body_len == 0 ? u__snprintf(iov_buffer, sizeof(iov_buffer), U_CONSTANT_TO_PARAM("\" %u - \""),  U_http_info.nResponseCode)
-                                             : u__snprintf(iov_buffer, sizeof(iov_buffer), U_CONSTANT_TO_PARAM("\" %u %u \""), U_http_info.nResponseCode, body_len));
+         if (apache_like_log_binary)
+            {
+            log_body_len      = body_len;
+            log_response_code = U_http_info.nResponseCode;
+
+            iov_vec[5].iov_len = 1; // NB: with the binary log we don't format, we only say that the values are set...
+            }
+         else
+            {
+            iov_vec[5].iov_len = (body_len == 0 ? u__snprintf(iov_buffer, sizeof(iov_buffer), U_CONSTANT_TO_PARAM("\" %u - \""),  U_http_info.nResponseCode)
+                                                : u__snprintf(iov_buffer, sizeof(iov_buffer), U_CONSTANT_TO_PARAM("\" %u %u \""), U_http_info.nResponseCode, body_len));
+            }
          }
 
 #  ifndef U_CACHE_REQUEST_DISABLE
@@ -5197,11 +5332,15 @@ void UHTTP::setEndRequestProcessing()
          }
 #    endif
 
-      U_INTERNAL_ASSERT_EQUALS(iov_vec[2].iov_base, ULog::date.date2)
+      if (apache_like_log_binary) writeApacheLikeLogBinary();
+      else
+         {
+         U_INTERNAL_ASSERT_EQUALS(iov_vec[2].iov_base, ULog::date.date2)
 
-      ULog::updateDate2();
+         ULog::updateDate2();
 
-      UServer_Base::apache_like_log->write(iov_vec, 10);
+         UServer_Base::apache_like_log->write(iov_vec, 10);
+         }
 
       iov_vec[0].iov_len = 0;
       }
@@ -5447,84 +5586,6 @@ void UHTTP::clearSession()
           db_session = U_NULLPTR;
 }
 
-#ifdef USE_LIBSSL
-void UHTTP::initSessionSSL()
-{
-   U_TRACE_NO_PARAM(0, "UHTTP::initSessionSSL()")
-
-   U_INTERNAL_ASSERT_EQUALS(db_session_ssl, U_NULLPTR)
-   U_INTERNAL_ASSERT_EQUALS(data_session_ssl, U_NULLPTR)
-
-   U_NEW(USSLSession, data_session_ssl, USSLSession);
-   U_NEW(URDBObjectHandler<UDataStorage*>, db_session_ssl, URDBObjectHandler<UDataStorage*>(U_STRING_FROM_CONSTANT("../db/session.ssl"), -1, data_session_ssl));
-
-   if (db_session_ssl->open(4096 * 4096, false, true, true, U_SRV_LOCK_SSL_SESSION)) // NB: we don't want truncate (we have only the journal)...
-      {
-      U_SRV_LOG("db initialization of SSL session success");
-
-      db_session_ssl->reset(); // Initialize the cache to contain no entries
-
-      /**
-       * In order to allow external session caching, synchronization with the internal session cache is realized via callback functions.
-       * Inside these callback functions, session can be saved to disk or put into a database using the d2i_SSL_SESSION(3) interface.
-       *
-       * The new_session_cb() is called, whenever a new session has been negotiated and session caching is enabled
-       * (see SSL_CTX_set_session_cache_mode(3)). The new_session_cb() is passed the ssl connection and the ssl session sess.
-       * If the callback returns 0, the session will be immediately removed again.
-       *
-       * The remove_session_cb() is called, whenever the SSL engine removes a session from the internal cache. This happens when
-       * the session is removed because it is expired or when a connection was not shutdown cleanly. It also happens for all sessions
-       * in the internal session cache when SSL_CTX_free(3) is called. The remove_session_cb() is passed the ctx and the ssl session sess.
-       * It does not provide any feedback.
-       *
-       * The get_session_cb() is only called on SSL/TLS servers with the session id proposed by the client. The get_session_cb() is
-       * always called, also when session caching was disabled. The get_session_cb() is passed the ssl connection, the session id and
-       * the length at the memory location data. With the parameter copy the callback can require the SSL engine to increment the
-       * reference count of the SSL_SESSION object, Normally the reference count is not incremented and therefore the session must not
-       * be explicitly freed with SSL_SESSION_free(3)
-       */
-
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-   typedef SSL_SESSION* (*psPFpspcipi) (SSL*,      unsigned char*,int,int*);
-#else
-   typedef SSL_SESSION* (*psPFpspcipi) (SSL*,const unsigned char*,int,int*);
-#endif
-
-      U_SYSCALL_VOID(SSL_CTX_sess_set_new_cb,    "%p,%p", USSLSocket::sctx,              USSLSession::newSession);
-      U_SYSCALL_VOID(SSL_CTX_sess_set_get_cb,    "%p,%p", USSLSocket::sctx, (psPFpspcipi)USSLSession::getSession);
-      U_SYSCALL_VOID(SSL_CTX_sess_set_remove_cb, "%p,%p", USSLSocket::sctx,              USSLSession::removeSession);
-
-      // NB: All currently supported protocols have the same default timeout value of 300 seconds
-      // ----------------------------------------------------------------------------------------
-      // (void) U_SYSCALL(SSL_CTX_set_timeout,         "%p,%u", USSLSocket::sctx, 300);
-         (void) U_SYSCALL(SSL_CTX_sess_set_cache_size, "%p,%u", USSLSocket::sctx, 1024 * 1024);
-
-      U_INTERNAL_DUMP("timeout = %d", SSL_CTX_get_timeout(USSLSocket::sctx))
-      }
-   else
-      {
-      U_SRV_LOG("WARNING: db initialization of SSL session failed");
-
-      delete db_session_ssl;
-             db_session_ssl = U_NULLPTR;
-      }
-}
-
-void UHTTP::clearSessionSSL()
-{
-   U_TRACE_NO_PARAM(0, "UHTTP::clearSessionSSL()")
-
-   U_INTERNAL_ASSERT_POINTER(db_session_ssl)
-
-   db_session_ssl->close();
-
-   delete data_session_ssl;
-
-   delete db_session_ssl;
-          db_session_ssl = U_NULLPTR;
-}
-#endif
-
 /**
  * How Does Authorization Work ?
  *
@@ -7420,12 +7481,12 @@ __pure bool UHTTP::isUriRequestNeedCertificate()
 
 #ifdef USE_LIBSSL
    if (UServer_Base::bssl &&
-       uri_request_cert_mask)
+       uri_request_cert_matcher)
       {
       uint32_t sz;
       const char* ptr = UClientImage_Base::getRequestUri(sz);
 
-      if (UServices::dosMatchWithOR(ptr, sz, U_STRING_TO_PARAM(*uri_request_cert_mask), 0)) U_RETURN(true);
+      if (uri_request_cert_matcher->isMatch(ptr, sz)) U_RETURN(true);
       }
 #endif
 
@@ -7474,12 +7535,12 @@ __pure bool UHTTP::isUriRequestProtected()
 
    // check if the uri is protected
 
-   if (uri_protected_mask)
+   if (uri_protected_matcher)
       {
       uint32_t sz;
       const char* ptr = UClientImage_Base::getRequestUri(sz);
 
-      if (UServices::dosMatchWithOR(ptr, sz, U_STRING_TO_PARAM(*uri_protected_mask), 0)) U_RETURN(true);
+      if (uri_protected_matcher->isMatch(ptr, sz)) U_RETURN(true);
       }
 
    U_RETURN(false);
@@ -7807,6 +7868,9 @@ U_NO_EXPORT void UHTTP::putDataInCache(const UString& fmt, UString& content)
    int ratio = 100;
    bool gzip = false;
    UString header(U_CAPACITY);
+#ifdef USE_LIBBROTLI
+   UString br;
+#endif
    const char* motivation = (file_data->size <= U_MIN_SIZE_FOR_DEFLATE ? " (size too small)" :
                              isSizeForSendfile(file_data->size)        ? " (size exceeded)"  : ""); // NB: for major size we assume is better to use sendfile()
 
@@ -7929,6 +7993,10 @@ next1:
        * Sending raw DEFLATE data is just not a good idea. As Mark says "[it's] simply more reliable to only use GZIP"
        */
 
+#  ifdef USE_LIBBROTLI
+      br = UStringExt::brotli(content, 11); // NB: like zopfli the max quality is slow but we pay it only once...
+#  endif
+
       gzip    = true;
       content = UStringExt::deflate(content, 2); // 2 => zopfli...
       }
@@ -7971,6 +8039,38 @@ next2:
 
          file_data->http2->push_back(hpack);
 #     endif
+
+#     ifdef USE_LIBBROTLI
+         U_INTERNAL_DUMP("br.size() = %u size = %u", br.size(), size)
+
+         if (br &&
+             br.size() < size) // NB: we keep brotli only if it is better than gzip...
+            {
+            file_data->array->push_back(br);
+
+            header.setBuffer(U_CAPACITY);
+
+            (void) header.replace(U_CONSTANT_TO_PARAM("Content-Encoding: br\r\n"));
+
+            header.snprintf_add(U_STRING_TO_PARAM(fmt), br.size());
+
+            (void) header.shrink();
+
+            file_data->array->push_back(header);
+
+#        ifndef U_HTTP2_DISABLE
+            hpack.setBuffer(U_CAPACITY);
+
+            dst = UHTTP2::setHpackHeaders((unsigned char*)hpack.data(), header);
+
+            hpack.size_adjust((const char*)dst);
+
+            (void) hpack.shrink();
+
+            file_data->http2->push_back(hpack);
+#        endif
+            }
+#     endif
          }
       }
 
@@ -8000,11 +8100,11 @@ void UHTTP::checkFileForCache()
 
    if (file->stat()) // NB: file->stat() get also the size of the file...
       {
-      U_INTERNAL_DUMP("nocache_file_mask = %p U_http_is_nocache_file = %b", nocache_file_mask, U_http_is_nocache_file)
+      U_INTERNAL_DUMP("nocache_file_matcher = %p U_http_is_nocache_file = %b", nocache_file_matcher, U_http_is_nocache_file)
 
       if (U_http_is_nocache_file ||
-          (nocache_file_mask     &&
-           UServices::dosMatchWithOR(file_name, U_STRING_TO_PARAM(*nocache_file_mask), 0)))
+          (nocache_file_matcher  &&
+           nocache_file_matcher->isMatch(file_name)))
          {
          return;
          }
@@ -8422,8 +8522,8 @@ check:
       if (u_is_cacheable(file_data->mime_index)) goto manage;
       }
 
-   if (cache_file_mask &&
-       UServices::dosMatchWithOR(file_name_ptr, file_name_len, U_STRING_TO_PARAM(*cache_file_mask), 0))
+   if (cache_file_matcher &&
+       cache_file_matcher->isMatch(file_name_ptr, file_name_len))
       {
       ctype = setMimeIndex(suffix_ptr);
 
@@ -8518,7 +8618,7 @@ UString UHTTP::getDataFromCache(int idx)
 
    if (file_data->array)
       {
-      U_INTERNAL_ASSERT_MINOR(idx, 4)
+      U_INTERNAL_ASSERT_MINOR(idx, 6)
 
       result = file_data->array->operator[](idx);
       }
@@ -8536,7 +8636,21 @@ U_NO_EXPORT bool UHTTP::processFileCache()
    if (checkGetRequestIfModified() == false) goto end;
 
 #ifdef USE_LIBZ
-   U_INTERNAL_DUMP("U_http_is_accept_gzip = %b", U_http_is_accept_gzip)
+   U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_br = %b", U_http_is_accept_gzip, U_http_is_accept_br)
+
+   if (U_http_is_accept_br &&
+       isDataBrotliFromCache())
+      {
+      U_http_encoding |= HTTP_IS_RESPONSE_BR;
+
+      U_INTERNAL_DUMP("U_http_is_response_br = %b", U_http_is_response_br)
+
+      *ext = getHeaderBrotliFromCache();
+
+      *UClientImage_Base::body = getBodyBrotliFromCache();
+
+      goto end;
+      }
 
    if (U_http_is_accept_gzip &&
        isDataCompressFromCache())
@@ -8635,8 +8749,8 @@ U_NO_EXPORT void UHTTP::checkPathName()
 
    U_INTERNAL_ASSERT(basename)
 
-   if (nocache_file_mask &&
-       UServices::dosMatchWithOR(basename, U_STRING_TO_PARAM(*nocache_file_mask), 0))
+   if (nocache_file_matcher &&
+       nocache_file_matcher->isMatch(basename))
       {
       U_http_flag |= HTTP_IS_NOCACHE_FILE | HTTP_IS_REQUEST_NOSTAT;
 
@@ -10662,6 +10776,31 @@ void UHTTP::initApacheLikeLog()
    U_INTERNAL_DUMP("iov_vec = %p iov_vec[2] = %.*S", iov_vec, iov_vec[2].iov_len, iov_vec[2].iov_base)
 }
 
+void UHTTP::writeApacheLikeLogBinary()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::writeApacheLikeLogBinary()")
+
+   U_INTERNAL_ASSERT_POINTER(apache_like_log_binary)
+
+   if (u_pthread_time == U_NULLPTR) u_gettimenow();
+
+   uaccesslogrecord r;
+
+   r.host        = (const char*)iov_vec[0].iov_base;
+   r.host_len    =              iov_vec[0].iov_len;
+   r.request     = (const char*)iov_vec[4].iov_base;
+   r.request_len =              iov_vec[4].iov_len;
+   r.referer     = (const char*)iov_vec[6].iov_base;
+   r.referer_len =              iov_vec[6].iov_len;
+   r.agent       = (const char*)iov_vec[8].iov_base;
+   r.agent_len   =              iov_vec[8].iov_len;
+   r.code        = log_response_code;
+   r.body_len    = log_body_len;
+   r.sec         = u_now->tv_sec;
+
+   apache_like_log_binary->write(UServer_Base::apache_like_log, r);
+}
+
 void UHTTP::prepareApacheLikeLog()
 {
    U_TRACE_NO_PARAM(0, "UHTTP::prepareApacheLikeLog()")
@@ -11170,11 +11309,11 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
             {
             sb->sputbackc(c);
 
-            UVector<UString> vec(4U);
+            UVector<UString> vec(6U);
 
             is >> vec;
 
-            // content, header, gzip(content, header)
+            // content, header, gzip(content, header), brotli(content, header)
 
             if (vec.empty() == false)
                {
@@ -11243,8 +11382,47 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
                   UEscape::decode(encoded, decoded);
 
                   d.array->push_back(decoded);
+
+                  if (vec.size() > 4) // NB: the snapshots of the old versions have only gzip...
+                     {
+                     // brotli(content)
+
+                     encoded = vec[4];
+                     decoded.setBuffer(encoded.size());
+
+                     UBase64::decode(encoded, decoded);
+
+                     d.array->push_back(decoded);
+
+                     // brotli(header)
+
+                     encoded = vec[5];
+                     decoded.setBuffer(encoded.size());
+
+                     UEscape::decode(encoded, decoded);
+
+                     d.array->push_back(decoded);
+                     }
                   }
 
+#           ifndef U_HTTP2_DISABLE
+               UString hpack;
+               unsigned char* dst;
+
+               for (uint32_t i = 1, n = d.array->size(); i < n; i += 2) // header, gzip(header), brotli(header)
+                  {
+                  hpack.setBuffer(U_CAPACITY);
+
+                  dst = UHTTP2::setHpackHeaders((unsigned char*)hpack.data(), d.array->at(i));
+
+                  hpack.size_adjust((const char*)dst);
+
+                  (void) hpack.shrink();
+
+                  d.http2->push_back(hpack);
+                  }
+#           endif
+
                U_ASSERT(d.array->check_memory())
                }
             }
@@ -11281,7 +11459,7 @@ U_EXPORT ostream& operator<<(ostream& os, const UHTTP::UFileCacheData& d)
       os.put(' ');
       os.put('(');
 
-      if (d.array && // content, header, gzip(content, header)
+      if (d.array && // content, header, gzip(content, header), brotli(content, header)
           d.size < (64 * 1024))
          {
          U_INTERNAL_ASSERT_EQUALS(d.ptr, U_NULLPTR)
@@ -11330,6 +11508,25 @@ U_EXPORT ostream& operator<<(ostream& os, const UHTTP::UFileCacheData& d)
             os.put('\n');
             os.write(buffer, pos);
             os.put('\n');
+
+            if (d.array->size() > 4)
+               {
+               str = d.array->at(4); // brotli(content)
+
+               pos = u_base64_encode((const unsigned char*)U_STRING_TO_PARAM(str), (unsigned char*)buffer);
+
+               os.put('\n');
+               os.write(buffer, pos);
+               os.put('\n');
+
+               str = d.array->at(5); // brotli(header)
+
+               pos = u_escape_encode((const unsigned char*)U_STRING_TO_PARAM(str), buffer, sizeof(buffer));
+
+               os.put('\n');
+               os.write(buffer, pos);
+               os.put('\n');
+               }
             }
          }
 
@@ -40,6 +40,7 @@
 #define FRAME_GET_PAYLOAD_LEN(BYTE) ( (BYTE)       & 0x7F)
 
 #define FRAME_SET_FIN(BYTE)         (((BYTE) & 0x01) << 7)
+#define FRAME_SET_RSV1(BYTE)        (((BYTE) & 0x01) << 6)
 #define FRAME_SET_OPCODE(BYTE)       ((BYTE) & 0x0F)
 #define FRAME_SET_MASK(BYTE)        (((BYTE) & 0x01) << 7)
 #define FRAME_SET_LENGTH(X64, IDX)  (unsigned char)(((uint64_t)(X64) >> ((IDX)*8)) & 0xFF)
@@ -56,6 +57,277 @@ const char* UWebSocket::upgrade_settings;
 UWebSocket::WebSocketFrameData UWebSocket::control_frame = { U_NULLPTR, 0, 1, 8, 0 };
 UWebSocket::WebSocketFrameData UWebSocket::message_frame = { U_NULLPTR, 0, 1, 0, 0 };
 
+bool                      UWebSocket::bdeflate;
+bool                      UWebSocket::enable_deflate = true;
+bool                      UWebSocket::server_no_context_takeover;
+bool                      UWebSocket::client_no_context_takeover;
+int                       UWebSocket::server_max_window_bits;
+uint64_t                  UWebSocket::broadcast_rpos;
+UWebSocket::ws_broadcast* UWebSocket::broadcast_data;
+
+static bool bsubscriber;
+static unsigned char control_data[125];
+static ULock* lock_broadcast;
+static UString* broadcast_buffer;
+
+#ifdef USE_LIBZ
+static bool zinit, zinit_broadcast;
+static z_stream zdeflate, zinflate, zbroadcast;
+static UString* inflate_buffer;
+static UString* deflate_buffer;
+
+// Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits; server_max_window_bits=10, permessage-deflate
+
+static bool checkDeflateOffer(const char* ptr, const char* end)
+{
+   U_TRACE(0, "checkDeflateOffer(%.*S)", end-ptr, ptr)
+
+   while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+   if ((end - ptr) < (ptrdiff_t)U_CONSTANT_SIZE("permessage-deflate") ||
+       u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("permessage-deflate")) != 0)
+      {
+      U_RETURN(false);
+      }
+
+   const char* name;
+   uint32_t name_len;
+   int value;
+
+   ptr += U_CONSTANT_SIZE("permessage-deflate");
+
+   UWebSocket::server_max_window_bits     = 0;
+   UWebSocket::client_no_context_takeover = false;
+   UWebSocket::server_no_context_takeover = (UWebSocket::broadcast_data != U_NULLPTR); // NB: the frames on the ring are compressed without context...
+
+   while (true)
+      {
+      while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+      if (ptr == end) U_RETURN(true);
+
+      if (*ptr++ != ';') U_RETURN(false);
+
+      while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+      for (name = ptr; ptr < end && *ptr != '=' && *ptr != ';' && u__isspace(*ptr) == false; ++ptr) {}
+
+      name_len = ptr - name;
+      value    = -1;
+
+      while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+      if (ptr < end &&
+          *ptr == '=')
+         {
+         do { ++ptr; } while (ptr < end && (u__isspace(*ptr) || *ptr == '"'));
+
+         for (value = 0; ptr < end && u__isdigit(*ptr); ++ptr) value = value * 10 + (*ptr - '0');
+
+         while (ptr < end && (u__isspace(*ptr) || *ptr == '"')) ++ptr;
+         }
+
+      U_INTERNAL_DUMP("name = %.*S value = %d", name_len, name, value)
+
+      if (name_len == U_CONSTANT_SIZE("server_no_context_takeover") &&
+          u__strncasecmp(name, U_CONSTANT_TO_PARAM("server_no_context_takeover")) == 0)
+         {
+         UWebSocket::server_no_context_takeover = true;
+         }
+      else if (name_len == U_CONSTANT_SIZE("client_no_context_takeover") &&
+               u__strncasecmp(name, U_CONSTANT_TO_PARAM("client_no_context_takeover")) == 0)
+         {
+         UWebSocket::client_no_context_takeover = true;
+         }
+      else if (name_len == U_CONSTANT_SIZE("server_max_window_bits") &&
+               u__strncasecmp(name, U_CONSTANT_TO_PARAM("server_max_window_bits")) == 0)
+         {
+         // NB: a raw deflate stream of zlib with a window of 8 bits is written with a window of 9 bits, so we decline the offer...
+
+         if (value < 9 || value > 15) U_RETURN(false);
+
+         UWebSocket::server_max_window_bits = value;
+         }
+      else if (name_len == U_CONSTANT_SIZE("client_max_window_bits") &&
+               u__strncasecmp(name, U_CONSTANT_TO_PARAM("client_max_window_bits")) == 0)
+         {
+         // NB: we inflate always with a window of 15 bits, that accept the smaller windows...
+
+         if (value != -1 &&
+             (value < 8 || value > 15))
+            {
+            U_RETURN(false);
+            }
+         }
+      else
+         {
+         U_RETURN(false);
+         }
+      }
+}
+
+static bool deflateMessage(z_stream* z, const unsigned char* buffer, uint32_t buffer_size, bool breset)
+{
+   U_TRACE(0, "deflateMessage(%p,%p,%u,%b)", z, buffer, buffer_size, breset)
+
+   int err;
+   uint32_t sz;
+
+   deflate_buffer->setEmpty();
+
+   (void) deflate_buffer->reserve(deflateBound(z, buffer_size) + 16);
+
+   z->next_in  = (Bytef*)buffer;
+   z->avail_in = buffer_size;
+
+   do {
+      if (deflate_buffer->space() < 16) UString::_reserve(*deflate_buffer, deflate_buffer->size() * 2);
+
+      z->next_out  = (Bytef*)deflate_buffer->pend();
+      z->avail_out = sz = deflate_buffer->space();
+
+      err = deflate(z, Z_SYNC_FLUSH);
+
+      deflate_buffer->size_adjust_force(deflate_buffer->size() + sz - z->avail_out);
+
+      if (err != Z_OK &&
+          err != Z_BUF_ERROR)
+         {
+         U_RETURN(false);
+         }
+      }
+   while (z->avail_in || z->avail_out == 0);
+
+   if (breset) (void) deflateReset(z);
+
+   // NB: the stream flushed with Z_SYNC_FLUSH end with an empty stored block (0x00 0x00 0xff 0xff) that is not sent...
+
+   sz = deflate_buffer->size();
+
+   U_INTERNAL_ASSERT(sz >= 4)
+   U_INTERNAL_ASSERT_EQUALS(memcmp(deflate_buffer->c_pointer(sz-4), "\x00\x00\xff\xff", 4), 0)
+
+   deflate_buffer->size_adjust_force(sz - 4);
+
+   U_RETURN(true);
+}
+
+static bool inflateMessage() // NB: the payload of the message is on UClientImage_Base::wbuffer...
+{
+   U_TRACE_NO_PARAM(0, "inflateMessage()")
+
+   int err;
+   uint32_t sz;
+   UString* pbuffer = UClientImage_Base::wbuffer;
+
+   (void) pbuffer->append(U_CONSTANT_TO_PARAM("\x00\x00\xff\xff")); // the tail removed by the sender...
+
+   inflate_buffer->setEmpty();
+
+   (void) inflate_buffer->reserve(pbuffer->size() * 4);
+
+   zinflate.next_in  = (Bytef*)pbuffer->data();
+   zinflate.avail_in = pbuffer->size();
+
+   do {
+      if (inflate_buffer->space() < 16) UString::_reserve(*inflate_buffer, inflate_buffer->size() * 2);
+
+      zinflate.next_out  = (Bytef*)inflate_buffer->pend();
+      zinflate.avail_out = sz = inflate_buffer->space();
+
+      err = inflate(&zinflate, Z_SYNC_FLUSH);
+
+      inflate_buffer->size_adjust_force(inflate_buffer->size() + sz - zinflate.avail_out);
+
+      if (err != Z_OK &&
+          err != Z_BUF_ERROR)
+         {
+         UWebSocket::status_code = STATUS_CODE_PROTOCOL_ERROR;
+
+         U_RETURN(false);
+         }
+
+      if (inflate_buffer->size() > UWebSocket::max_message_size)
+         {
+         UWebSocket::status_code = STATUS_CODE_MESSAGE_TOO_LARGE;
+
+         U_RETURN(false);
+         }
+      }
+   while (zinflate.avail_in || zinflate.avail_out == 0);
+
+   if (UWebSocket::message_type == MESSAGE_TYPE_TEXT)
+      {
+      unsigned int utf8_state = 0;
+      const unsigned char* ptr = (const unsigned char*)inflate_buffer->data();
+      const unsigned char* end = ptr + inflate_buffer->size();
+
+      while (ptr < end &&
+             (utf8_state = u_validate_utf8[utf8_state + *ptr++]) != 1)
+         {
+         }
+
+      if (utf8_state != 0)
+         {
+         UWebSocket::status_code = STATUS_CODE_INVALID_UTF8;
+
+         U_RETURN(false);
+         }
+      }
+
+   pbuffer->swap(*inflate_buffer);
+
+   U_RETURN(true);
+}
+#endif
+
+static unsigned char getOpcode(int type)
+{
+   U_TRACE(0, "getOpcode(%d)", type)
+
+   switch (type)
+      {
+      case MESSAGE_TYPE_TEXT:
+      case MESSAGE_TYPE_INVALID: U_RETURN(OPCODE_TEXT);
+
+      case MESSAGE_TYPE_PING:    U_RETURN(OPCODE_PING);
+      case MESSAGE_TYPE_PONG:    U_RETURN(OPCODE_PONG);
+      case MESSAGE_TYPE_BINARY:  U_RETURN(OPCODE_BINARY);
+      }
+
+   U_RETURN(OPCODE_CLOSE);
+}
+
+static uint32_t setFrameHeader(unsigned char* header, unsigned char opcode, uint32_t payload_length, bool rsv1)
+{
+   U_TRACE(0, "setFrameHeader(%p,%u,%u,%b)", header, opcode, payload_length, rsv1)
+
+   uint32_t pos = 0;
+
+   header[pos++] = FRAME_SET_FIN(1) | FRAME_SET_RSV1(rsv1) | FRAME_SET_OPCODE(opcode);
+
+   if (payload_length < 126) header[pos++] = FRAME_SET_MASK(0) | FRAME_SET_LENGTH(payload_length, 0);
+   else
+      {
+      if (payload_length < 65536) header[pos++] = FRAME_SET_MASK(0) | 126;
+      else
+         {
+         header[pos++] = FRAME_SET_MASK(0) | 127;
+         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 7);
+         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 6);
+         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 5);
+         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 4);
+         header[pos++] = FRAME_SET_LENGTH(payload_length, 3);
+         header[pos++] = FRAME_SET_LENGTH(payload_length, 2);
+         }
+
+      header[pos++] = FRAME_SET_LENGTH(payload_length, 1);
+      header[pos++] = FRAME_SET_LENGTH(payload_length, 0);
+      }
+
+   U_RETURN(pos);
+}
+
 bool UWebSocket::sendAccept()
 {
    U_TRACE_NO_PARAM(0, "UWebSocket::sendAccept()")
@@ -80,10 +352,78 @@ bool UWebSocket::sendAccept()
 
    UServices::generateDigest(U_HASH_SHA1, 0, challenge, U_http_websocket_len + WEBSOCKET_GUID_LEN, accept, true);
 
+   UString extension(U_CAPACITY);
+
+   bdeflate = false;
+
+#ifdef USE_LIBZ
+   const char* ptr;
+
+   if (enable_deflate &&
+       (ptr = UHTTP::getHeaderValuePtr(*UClientImage_Base::request, U_CONSTANT_TO_PARAM("Sec-WebSocket-Extensions"), true)))
+      {
+      // the client can list more offers (in order of preference) separated by comma, we accept the first permessage-deflate that we can satisfy
+
+      const char* comma;
+      const char* end = ptr;
+
+      while (*end != '\r' &&
+             *end != '\n')
+         {
+         ++end;
+         }
+
+      for (; ptr < end; ptr = comma + 1)
+         {
+         if ((comma = (const char*) memchr(ptr, ',', end - ptr)) == U_NULLPTR) comma = end;
+
+         if (checkDeflateOffer(ptr, comma))
+            {
+            bdeflate = true;
+
+            break;
+            }
+         }
+
+      if (bdeflate)
+         {
+         if (zinit)
+            {
+            (void) deflateEnd(&zdeflate);
+            (void) inflateEnd(&zinflate);
+            }
+
+         (void) memset(&zdeflate, 0, sizeof(z_stream));
+         (void) memset(&zinflate, 0, sizeof(z_stream));
+
+         zinit = bdeflate = (deflateInit2(&zdeflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -(server_max_window_bits ? server_max_window_bits : MAX_WBITS), 8, Z_DEFAULT_STRATEGY) == Z_OK &&
+                             inflateInit2(&zinflate, -MAX_WBITS) == Z_OK);
+
+         if (inflate_buffer == U_NULLPTR)
+            {
+            U_NEW(UString, inflate_buffer, UString(U_CAPACITY));
+            U_NEW(UString, deflate_buffer, UString(U_CAPACITY));
+            }
+         }
+
+      if (bdeflate)
+         {
+         (void) extension.append(U_CONSTANT_TO_PARAM("Sec-WebSocket-Extensions: permessage-deflate"));
+
+         if (server_no_context_takeover) (void) extension.append(U_CONSTANT_TO_PARAM("; server_no_context_takeover"));
+         if (client_no_context_takeover) (void) extension.append(U_CONSTANT_TO_PARAM("; client_no_context_takeover"));
+         if (server_max_window_bits)     extension.snprintf_add(U_CONSTANT_TO_PARAM("; server_max_window_bits=%d"), server_max_window_bits);
+
+         (void) extension.append(U_CONSTANT_TO_PARAM(U_CRLF));
+         }
+      }
+#endif
+
    UClientImage_Base::wbuffer->snprintf(U_CONSTANT_TO_PARAM("HTTP/1.1 101 Switching Protocols\r\n"
                                         "Upgrade: websocket\r\n"
                                         "Connection: Upgrade\r\n"
-                                        "Sec-WebSocket-Accept: %v\r\n\r\n"), accept.rep);
+                                        "%v"
+                                        "Sec-WebSocket-Accept: %v\r\n\r\n"), extension.rep, accept.rep);
 
    if (USocketExt::write(UServer_Base::csocket, *UClientImage_Base::wbuffer, UServer_Base::timeoutMS))
       {
@@ -157,6 +497,7 @@ int UWebSocket::handleDataFraming(USocket* socket)
    unsigned char* block;
    uint32_t block_offset, ncount = 0, block_size;
    WebSocketFrameData* frame = &UWebSocket::control_frame;
+   bool compressed = false;
    unsigned char fin = 0, opcode = 0xFF, mask[4] = { 0, 0, 0, 0 };
    int32_t extension_bytes_remaining = 0, payload_length = 0, mask_offset = 0;
    int framing_state = DATA_FRAMING_START, payload_length_bytes_remaining = 0, mask_index = 0, masking = 0;
@@ -181,11 +522,14 @@ loop:
          {
          case DATA_FRAMING_START: // 1
             {
-            // Since we don't currently support any extensions, the reserve bits must be 0
-
-            if ((FRAME_GET_RSV1(block[block_offset]) != 0) ||
-                (FRAME_GET_RSV2(block[block_offset]) != 0) ||
-                (FRAME_GET_RSV3(block[block_offset]) != 0))
+            // The only extension that we support is permessage-deflate: the bit RSV1 is set on the first frame of a compressed message
+
+            if ((FRAME_GET_RSV2(block[block_offset]) != 0) ||
+                (FRAME_GET_RSV3(block[block_offset]) != 0) ||
+                ((FRAME_GET_RSV1(block[block_offset]) != 0) &&
+                 (bdeflate == false                                        ||
+                  FRAME_GET_OPCODE(block[block_offset]) == OPCODE_CONTINUATION ||
+                  FRAME_GET_OPCODE(block[block_offset]) >= 0x8)))
                {
                // framing_state = DATA_FRAMING_CLOSE; // 6
 
@@ -195,7 +539,15 @@ loop:
                }
 
             fin    = FRAME_GET_FIN(   block[block_offset]);
-            opcode = FRAME_GET_OPCODE(block[block_offset++]);
+            opcode = FRAME_GET_OPCODE(block[block_offset]);
+
+            if (opcode == OPCODE_TEXT ||
+                opcode == OPCODE_BINARY)
+               {
+               compressed = FRAME_GET_RSV1(block[block_offset]);
+               }
+
+            ++block_offset;
 
             U_INTERNAL_DUMP("fin = %d opcode = %X", fin, opcode)
 
@@ -374,9 +726,13 @@ loop:
                {
                if (payload_length > 0)
                   {
-                  (void) UClientImage_Base::wbuffer->reserve(frame->application_data_offset + payload_length);
+                  if (frame == &UWebSocket::control_frame) frame->application_data = control_data; // NB: it can be in the middle of a fragmented message...
+                  else
+                     {
+                     (void) UClientImage_Base::wbuffer->reserve(frame->application_data_offset + payload_length);
 
-                  frame->application_data = (unsigned char*) UClientImage_Base::wbuffer->data();
+                     frame->application_data = (unsigned char*) UClientImage_Base::wbuffer->data();
+                     }
                   }
 
                framing_state = DATA_FRAMING_APPLICATION_DATA; // 5
@@ -400,7 +756,8 @@ loop:
                {
                int32_t i;
 
-               if (opcode == OPCODE_TEXT)
+               if (opcode == OPCODE_TEXT &&
+                   compressed == false) // NB: the UTF-8 is validated after the inflate...
                   {
                   unsigned int utf8_state = frame->utf8_state;
 
@@ -436,7 +793,8 @@ loop:
                {
                U_MEMCPY(&application_data[application_data_offset], &block[block_offset], block_data_length);
                
-               if (opcode == OPCODE_TEXT)
+               if (opcode == OPCODE_TEXT &&
+                   compressed == false)
                   {
                   unsigned int utf8_state = frame->utf8_state;
                   int32_t i, application_data_end = application_data_offset + block_data_length;
@@ -524,9 +882,20 @@ loop:
 
                      UClientImage_Base::wbuffer->size_adjust_force(application_data_offset);
 
-                     U_SRV_LOG_WITH_ADDR("received websocket data (%u+%u bytes) %V from",
-                                             ncount - UClientImage_Base::wbuffer->size(),
-                                                      UClientImage_Base::wbuffer->size(), UClientImage_Base::wbuffer->rep)
+                     frame->application_data        = U_NULLPTR;
+                     frame->application_data_offset = 0;
+
+                     ncount -= application_data_offset;
+
+#                 ifdef USE_LIBZ
+                     if (compressed &&
+                         inflateMessage() == false)
+                        {
+                        U_RETURN(status_code);
+                        }
+#                 endif
+
+                     U_SRV_LOG_WITH_ADDR("received websocket data (%u+%u bytes) %V from", ncount, UClientImage_Base::wbuffer->size(), UClientImage_Base::wbuffer->rep)
 
                      status_code = STATUS_CODE_OK;
 
@@ -571,58 +940,289 @@ bool UWebSocket::sendData(int type, const unsigned char* buffer, uint32_t buffer
 {
    U_TRACE(0, "UWebSocket::sendData(%d,%p,%u)", type, buffer, buffer_size)
 
-   uint32_t pos = 0;
-   unsigned char opcode, header[32];
-   uint32_t payload_length = (buffer ? buffer_size : 0);
+   bool rsv1 = false;
+   unsigned char header[32];
+   const unsigned char* payload = buffer;
+   unsigned char opcode = getOpcode(type);
+   uint32_t pos, payload_length = (buffer ? buffer_size : 0);
+
+#ifdef USE_LIBZ
+   if (bdeflate                                      &&
+       opcode < 0x8                                  &&
+       payload_length >= U_WEBSOCKET_DEFLATE_MIN_SIZE &&
+       deflateMessage(&zdeflate, buffer, payload_length, server_no_context_takeover))
+      {
+      rsv1           = true;
+      payload        = (const unsigned char*)deflate_buffer->data();
+      payload_length =                       deflate_buffer->size();
+      }
+#endif
 
-   switch (type)
+   pos = setFrameHeader(header, opcode, payload_length, rsv1);
+
+   U_SRV_LOG_WITH_ADDR("send websocket data (%u+%u bytes) %.*S to", pos, payload_length, buffer_size, buffer)
+
+   struct iovec iov[2] = { { (caddr_t)header,  pos },
+                           { (caddr_t)payload, payload_length } };
+
+   int iBytesWrite = (payload_length
+            ? (pos += payload_length, USocketExt::writev(UServer_Base::csocket, iov, 2,              pos, UServer_Base::timeoutMS))
+            :                         USocketExt::write( UServer_Base::csocket, (const char*)header, pos, UServer_Base::timeoutMS));
+
+   if (iBytesWrite == (int)pos) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+// BROADCAST
+
+void UWebSocket::initBroadcast()
+{
+   U_TRACE_NO_PARAM(0, "UWebSocket::initBroadcast()")
+
+   U_INTERNAL_ASSERT_POINTER(broadcast_data)
+   U_INTERNAL_ASSERT_EQUALS(lock_broadcast, U_NULLPTR)
+
+   U_NEW(ULock, lock_broadcast, ULock);
+
+   lock_broadcast->init(&(broadcast_data->lock_writer));
+
+#ifdef USE_LIBZ
+   (void) memset(&zbroadcast, 0, sizeof(z_stream));
+
+   zinit_broadcast = (deflateInit2(&zbroadcast, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+
+   if (deflate_buffer == U_NULLPTR)
       {
-      case MESSAGE_TYPE_TEXT:
-      case MESSAGE_TYPE_INVALID:
-         opcode = OPCODE_TEXT;
-      break;
-
-      case MESSAGE_TYPE_PING:   opcode = OPCODE_PING;   break;
-      case MESSAGE_TYPE_PONG:   opcode = OPCODE_PONG;   break;
-      case MESSAGE_TYPE_BINARY: opcode = OPCODE_BINARY; break;
-
-      case MESSAGE_TYPE_CLOSE:
-      default:
-         opcode = OPCODE_CLOSE;
-      break;
+      U_NEW(UString, inflate_buffer, UString(U_CAPACITY));
+      U_NEW(UString, deflate_buffer, UString(U_CAPACITY));
       }
+#endif
+}
 
-   header[pos++] = FRAME_SET_FIN(1) | FRAME_SET_OPCODE(opcode);
+void UWebSocket::subscribe()
+{
+   U_TRACE_NO_PARAM(0, "UWebSocket::subscribe()")
 
-   if (payload_length < 126) header[pos++] = FRAME_SET_MASK(0) | FRAME_SET_LENGTH(payload_length, 0);
-   else
+   U_INTERNAL_ASSERT_POINTER(broadcast_data)
+   U_INTERNAL_ASSERT_EQUALS(bsubscriber, false)
+
+   bsubscriber    = true;
+   broadcast_rpos = broadcast_data->wpos; // NB: we start to write from here...
+
+   if (broadcast_buffer == U_NULLPTR) U_NEW(UString, broadcast_buffer, UString(U_WEBSOCKET_BROADCAST_MAX_BATCH));
+
+   ULock::atomicIncrement(broadcast_data->nsubscriber);
+}
+
+void UWebSocket::unsubscribe()
+{
+   U_TRACE_NO_PARAM(0, "UWebSocket::unsubscribe()")
+
+   if (bsubscriber)
       {
-      if (payload_length < 65536) header[pos++] = FRAME_SET_MASK(0) | 126;
-      else
+      bsubscriber = false;
+
+      ULock::atomicDecrement(broadcast_data->nsubscriber);
+      }
+}
+
+/**
+ * A message on the ring: [length of the frame][length of the frame compressed][frame][frame compressed] aligned to 8 bytes, so that the two
+ * lengths are never split at the end of the ring. The compressed frame is empty if the message is not compressed
+ */
+
+#define U_WEBSOCKET_BROADCAST_HEADER 8
+
+static void writeToRing(char* ring, uint64_t pos, const void* buffer, uint32_t len)
+{
+   U_TRACE(0, "writeToRing(%p,%llu,%p,%u)", ring, pos, buffer, len)
+
+   uint32_t offset = pos % U_WEBSOCKET_BROADCAST_SIZE,
+            split  = U_min(len, U_WEBSOCKET_BROADCAST_SIZE - offset);
+
+   U_MEMCPY(ring + offset, buffer, split);
+
+   if (len > split) U_MEMCPY(ring, (const char*)buffer + split, len - split);
+}
+
+bool UWebSocket::broadcast(int type, const unsigned char* buffer, uint32_t buffer_size)
+{
+   U_TRACE(0, "UWebSocket::broadcast(%d,%.*S,%u)", type, buffer_size, buffer, buffer_size)
+
+   U_INTERNAL_ASSERT_POINTER(broadcast_data)
+
+   uint64_t pos;
+   unsigned char header[32], zheader[32];
+   unsigned char opcode = getOpcode(type);
+   uint32_t len[2], header_len, zheader_len = 0, zpayload_len = 0, record_len;
+
+   if (buffer_size > (U_WEBSOCKET_BROADCAST_SIZE / 2))
+      {
+      U_SRV_LOG("WARNING: websocket broadcast of a message too large (%u bytes)", buffer_size);
+
+      U_RETURN(false);
+      }
+
+   header_len = setFrameHeader(header, opcode, buffer_size, false);
+
+#ifdef USE_LIBZ
+   if (zinit_broadcast                            &&
+       enable_deflate                             &&
+       opcode < 0x8                               &&
+       buffer_size >= U_WEBSOCKET_DEFLATE_MIN_SIZE &&
+       deflateMessage(&zbroadcast, buffer, buffer_size, true) &&
+       deflate_buffer->size() < buffer_size) // NB: without context takeover we can send the message not compressed...
+      {
+      zpayload_len = deflate_buffer->size();
+      zheader_len  = setFrameHeader(zheader, opcode, zpayload_len, true);
+      }
+#endif
+
+   len[0] = header_len  + buffer_size;
+   len[1] = zheader_len + zpayload_len;
+
+   record_len = (U_WEBSOCKET_BROADCAST_HEADER + len[0] + len[1] + 7) & ~7;
+
+   if (record_len > (U_WEBSOCKET_BROADCAST_SIZE / 2))
+      {
+      U_SRV_LOG("WARNING: websocket broadcast of a message too large (%u bytes)", buffer_size);
+
+      U_RETURN(false);
+      }
+
+   lock_broadcast->lock();
+
+   pos = broadcast_data->wpos;
+
+   broadcast_data->wnext = pos + record_len; // NB: the subscribers that are reading the space we overwrite must know it...
+
+#ifdef HAVE_GCC_ATOMICS
+   __sync_synchronize();
+#endif
+
+   writeToRing(broadcast_data->data, pos,                                                   len,    sizeof(len));
+   writeToRing(broadcast_data->data, pos + U_WEBSOCKET_BROADCAST_HEADER,                    header, header_len);
+   writeToRing(broadcast_data->data, pos + U_WEBSOCKET_BROADCAST_HEADER + header_len,       buffer, buffer_size);
+
+#ifdef USE_LIBZ
+   if (len[1])
+      {
+      writeToRing(broadcast_data->data, pos + U_WEBSOCKET_BROADCAST_HEADER + len[0],               zheader,                 zheader_len);
+      writeToRing(broadcast_data->data, pos + U_WEBSOCKET_BROADCAST_HEADER + len[0] + zheader_len, deflate_buffer->data(), zpayload_len);
+      }
+#endif
+
+#ifdef HAVE_GCC_ATOMICS
+   __sync_synchronize();
+#endif
+
+   broadcast_data->wpos = pos + record_len;
+
+   lock_broadcast->unlock();
+
+   U_SRV_LOG("broadcast websocket data (%u+%u bytes, compressed %u bytes) to %d subscribers", header_len, buffer_size, len[1], broadcast_data->nsubscriber);
+
+   U_RETURN(true);
+}
+
+bool UWebSocket::writeBroadcast()
+{
+   U_TRACE_NO_PARAM(0, "UWebSocket::writeBroadcast()")
+
+   U_INTERNAL_ASSERT(bsubscriber)
+   U_INTERNAL_ASSERT_POINTER(broadcast_data)
+
+   uint64_t pos, end;
+   uint32_t len[2], count, offset, split, frame_len;
+   bool bcompressed = (bdeflate && server_max_window_bits == 0); // NB: the compressed frames are written with a window of 15 bits...
+
+loop:
+   end = broadcast_data->wpos;
+
+#ifdef HAVE_GCC_ATOMICS
+   __sync_synchronize();
+#endif
+
+   U_INTERNAL_DUMP("broadcast_rpos = %llu end = %llu", broadcast_rpos, end)
+
+   if (broadcast_rpos == end) U_RETURN(true);
+
+   if ((end - broadcast_rpos) > U_WEBSOCKET_BROADCAST_SIZE) goto slow;
+
+   /**
+    * NB: we don't write the frames straight from the ring: the write can block (timeoutMS) and meanwhile the publisher can overwrite them,
+    * so we copy them (U_WEBSOCKET_BROADCAST_MAX_BATCH bytes at most, unless the first frame is bigger) and we check the copy before the write...
+    */
+
+   broadcast_buffer->setEmpty();
+
+   for (pos = broadcast_rpos, count = 0; pos < end; )
+      {
+      U_MEMCPY(len, broadcast_data->data + (pos % U_WEBSOCKET_BROADCAST_SIZE), sizeof(len));
+
+      // NB: it was overwritten (we check every length by itself, their sum can wrap)...
+
+      if (len[0] > (U_WEBSOCKET_BROADCAST_SIZE / 2) ||
+          len[1] > (U_WEBSOCKET_BROADCAST_SIZE / 2) ||
+          (len[0] + len[1]) > (U_WEBSOCKET_BROADCAST_SIZE / 2))
          {
-         header[pos++] = FRAME_SET_MASK(0) | 127;
-         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 7);
-         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 6);
-         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 5);
-         header[pos++] = 0; // FRAME_SET_LENGTH(payload_length, 4);
-         header[pos++] = FRAME_SET_LENGTH(payload_length, 3);
-         header[pos++] = FRAME_SET_LENGTH(payload_length, 2);
+         goto slow;
          }
 
-      header[pos++] = FRAME_SET_LENGTH(payload_length, 1);
-      header[pos++] = FRAME_SET_LENGTH(payload_length, 0);
+      offset    = (pos + U_WEBSOCKET_BROADCAST_HEADER) % U_WEBSOCKET_BROADCAST_SIZE;
+      frame_len = len[0];
+
+      if (bcompressed &&
+          len[1])
+         {
+         offset    = (offset + len[0]) % U_WEBSOCKET_BROADCAST_SIZE;
+         frame_len = len[1];
+         }
+
+      if (count &&
+          (count + frame_len) > U_WEBSOCKET_BROADCAST_MAX_BATCH)
+         {
+         break;
+         }
+
+      split = U_min(frame_len, U_WEBSOCKET_BROADCAST_SIZE - offset);
+
+      (void) broadcast_buffer->append(broadcast_data->data + offset, split);
+
+      if (frame_len > split) (void) broadcast_buffer->append(broadcast_data->data, frame_len - split);
+
+      count += frame_len;
+      pos   += (U_WEBSOCKET_BROADCAST_HEADER + len[0] + len[1] + 7) & ~7;
       }
 
-   U_SRV_LOG_WITH_ADDR("send websocket data (%u+%u bytes) %.*S to", pos, buffer_size, buffer_size, buffer)
+   // NB: the publisher can have overwritten the frames while we was copying them...
 
-   struct iovec iov[2] = { { (caddr_t)header, pos },
-                           { (caddr_t)buffer, payload_length } };
+#ifdef HAVE_GCC_ATOMICS
+   __sync_synchronize();
+#endif
 
-   int iBytesWrite = (payload_length
-            ? (pos += payload_length, USocketExt::writev(UServer_Base::csocket, iov, 2,              pos, UServer_Base::timeoutMS))
-            :                         USocketExt::write( UServer_Base::csocket, (const char*)header, pos, UServer_Base::timeoutMS));
+   if ((broadcast_data->wnext - broadcast_rpos) > U_WEBSOCKET_BROADCAST_SIZE) goto slow;
 
-   if (iBytesWrite == (int)pos) U_RETURN(true);
+   U_INTERNAL_ASSERT_EQUALS(broadcast_buffer->size(), count)
+
+   if (USocketExt::write(UServer_Base::csocket, broadcast_buffer->data(), count, UServer_Base::timeoutMS) != (int)count)
+      {
+      U_SRV_LOG_WITH_ADDR("websocket broadcast: the subscriber don't drain its socket, we disconnect it from");
+
+      status_code = STATUS_CODE_POLICY_VIOLATION;
+
+      U_RETURN(false);
+      }
+
+   broadcast_rpos = pos;
+
+   goto loop;
+
+slow:
+   U_SRV_LOG_WITH_ADDR("websocket broadcast: slow consumer (%llu bytes behind), we disconnect it from", broadcast_data->wpos - broadcast_rpos);
+
+   status_code = STATUS_CODE_POLICY_VIOLATION;
 
    U_RETURN(false);
 }
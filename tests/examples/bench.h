@@ -0,0 +1,24 @@
+// bench.h - the clock of the bench_* programs
+
+#ifndef ULIB_BENCH_H
+#define ULIB_BENCH_H 1
+
+#include <time.h>
+#include <stdint.h>
+
+// nanoseconds from an arbitrary point (CLOCK_MONOTONIC: it don't jump with the changes of the system time, unlike gettimeofday())
+
+static inline uint64_t bench_now()
+{
+   struct timespec ts;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// seconds elapsed since start (a value of bench_now())
+
+static inline double bench_elapsed(uint64_t start) { return (double)(bench_now() - start) * 1e-9; }
+
+#endif
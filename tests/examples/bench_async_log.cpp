@@ -0,0 +1,126 @@
+// bench_async_log.cpp
+
+/**
+ * The cost for the process that serve the requests of a record of the apache like log written synchronously (a writev() or a copy
+ * in the memory mapped file for every record) against the async mode (a copy in the ring buffer drained by the writer thread):
+ *
+ * ./bench_async_log [num_record] [ring_size] [interval]   (default 1000000 records, ring buffer of 1M, a record every 2000 ns)
+ *
+ * the records are written at a fixed rate (a record every interval ns, 0 => as fast as possible) to simulate the requests of a busy
+ * server process, and we measure only the time spent in ULog::write(). For every mode we write the records on a new log file and at
+ * the end we check (after stopAsync(), that write the records that are still in the ring) that the size of the file match with the
+ * records written...
+ */
+
+#include <ulib/log.h>
+
+#include "bench.h"
+
+static uint32_t num_record, ring_size, interval;
+
+static void run(const char* name, uint32_t log_file_sz, bool async)
+{
+   U_TRACE(5, "run(%S,%u,%b)", name, log_file_sz, async)
+
+   UString path(U_CAPACITY);
+
+   path.snprintf(U_CONSTANT_TO_PARAM("/tmp/bench_async_log.%s.%P"), name);
+
+   (void) UFile::_unlink(path.c_str());
+
+   ULog* plog;
+
+   U_NEW(ULog, plog, ULog(path, log_file_sz));
+
+   if (async)
+      {
+      plog->setAsync(ring_size);
+
+      if (plog->startAsync() == false) U_ERROR("bench_async_log: I can't start the writer thread");
+      }
+
+   char buffer[32];
+   struct iovec iov[10] = {
+      { (caddr_t)"127.0.0.1", 9 },
+      { (caddr_t)" - - [", 6 },
+      { (caddr_t)"18/Oct/2026:10:11:12 +0200", 26 },
+      { (caddr_t)"] \"", 3 },
+      { (caddr_t)"GET /wp-content/plugins/contact-form-7/includes/js/index.js?ver=5.9 HTTP/1.1", 77 },
+      { (caddr_t)buffer, 0 },
+      { (caddr_t)"http://www.example.com/blog/2026/10/18/", 39 },
+      { (caddr_t)"\" \"", 3 },
+      { (caddr_t)"Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0", 70 },
+      { (caddr_t)"\"\n", 2 }
+   };
+
+   uint64_t total = 0, elapsed = 0, t0, t1, next = bench_now();
+
+   for (uint32_t i = 0; i < num_record; ++i)
+      {
+      iov[5].iov_len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("\" 200 %u \""), i);
+
+      for (int j = 0; j < 10; ++j) total += iov[j].iov_len;
+
+      if (interval)
+         {
+         next += interval;
+
+         while (bench_now() < next) {}
+         }
+
+      t0 = bench_now();
+
+      plog->write(iov, 10);
+
+      t1 = bench_now();
+
+      elapsed += t1 - t0;
+      }
+
+   uint32_t dropped = 0;
+
+   if (async)
+      {
+      dropped = plog->getDroppedRecords();
+
+      plog->stopAsync();
+      }
+
+   printf("%-12s %9u records: %10.6f sec in write() (%6.1f ns/record) %u dropped\n", name, num_record, elapsed * 1e-9, (num_record ? (double)elapsed / num_record : 0.0), dropped);
+
+   fflush(stdout);
+
+   if (log_file_sz == 0 &&
+       dropped     == 0)
+      {
+      plog->fsync();
+
+      if ((uint64_t)plog->size(true) != total) U_ERROR("bench_async_log: the size of the log file (%u) don't match with the records written (%llu)", (uint32_t)plog->size(), total);
+      }
+
+   plog->closeLog();
+
+   delete plog;
+
+   (void) UFile::_unlink(path.c_str());
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_record = (argc > 1 ? u_atoi(argv[1]) : 1000000);
+   ring_size  = (argc > 2 ? u_atoi(argv[2]) : 1024 * 1024);
+   interval   = (argc > 3 ? u_atoi(argv[3]) : 2000);
+
+   run("writev",       0, false);
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   run("writev_async", 0, true);
+#endif
+   run("mmap",         1024U * 1024U, false);
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   run("mmap_async",   1024U * 1024U, true);
+#endif
+}
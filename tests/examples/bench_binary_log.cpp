@@ -0,0 +1,247 @@
+// bench_binary_log.cpp
+
+/**
+ * The cost (and the size) of a record of the apache like log written as text (NCSA combined format, the way of UHTTP) against the
+ * compact binary format of UBinaryAccessLog (APACHE_LIKE_LOG_BINARY):
+ *
+ * ./bench_binary_log [num_record]   (default 1000000 records)
+ *
+ * Before the timings we write num_record/10 records in binary form (with some unique paths to force the reset of the dictionary)
+ * and we check that UBinaryAccessLogReader gives back, record by record, the same lines of the text format...
+ */
+
+#include <ulib/utility/binary_access_log.h>
+
+#include "bench.h"
+
+static const char* hosts[] = { "10.10.25.2", "192.168.1.100", "2001:db8::ff00:42:8329", "172.16.0.7", "127.0.0.1" };
+
+static const char* requests[] = {
+   "GET / HTTP/1.1", "GET /css/style.min.css HTTP/1.1", "GET /js/vendor/jquery-3.7.1.min.js HTTP/1.1", "GET /images/logo.png HTTP/1.1",
+   "GET /api/v1/users/12345/orders?limit=50 HTTP/1.1", "POST /login.php HTTP/1.1", "GET /search?q=open+addressing&lang=en HTTP/1.1",
+   "GET /wp-content/plugins/contact-form-7/includes/js/index.js?ver=5.9 HTTP/1.1", "HEAD /favicon.ico HTTP/1.0", "-", "GET /robots.txt"
+};
+
+static const char* referers[] = { "-", "http://www.example.com/", "http://www.example.com/blog/2026/10/18/", "https://www.google.com/search?q=ulib" };
+
+static const char* agents[] = {
+   "Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0",
+   "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/129.0.0.0 Safari/537.36",
+   "curl/8.5.0", "-"
+};
+
+static const uint32_t codes[] = { 200, 200, 200, 304, 404, 302, 500 };
+
+static uint32_t num_record;
+
+static void setRecord(uaccesslogrecord& r, uint32_t i, char* buffer, uint32_t size)
+{
+   U_TRACE(5, "setRecord(%p,%u,%p,%u)", &r, i, buffer, size)
+
+   r.host    = hosts[   i % U_NUM_ELEMENTS(hosts)];
+   r.referer = referers[i % U_NUM_ELEMENTS(referers)];
+   r.agent   = agents[  i % U_NUM_ELEMENTS(agents)];
+
+   r.host_len    = u__strlen(r.host,    __PRETTY_FUNCTION__);
+   r.referer_len = u__strlen(r.referer, __PRETTY_FUNCTION__);
+   r.agent_len   = u__strlen(r.agent,   __PRETTY_FUNCTION__);
+
+   if ((i % 10) == 9) // a unique path (the dictionary fills up)
+      {
+      r.request     = buffer;
+      r.request_len = u__snprintf(buffer, size, U_CONSTANT_TO_PARAM("GET /user/%u/profile?tab=%u HTTP/1.1"), i, i % 7);
+      }
+   else
+      {
+      r.request     = requests[i % U_NUM_ELEMENTS(requests)];
+      r.request_len = u__strlen(r.request, __PRETTY_FUNCTION__);
+      }
+
+   r.code     = codes[i % U_NUM_ELEMENTS(codes)];
+   r.body_len = (r.code == 304 ? 0 : 100 + (i % 5000));
+   r.sec      = u_now->tv_sec;
+}
+
+// the text format of UHTTP (ULog::date.date2 is updated once for second)
+
+static uint32_t setText(struct iovec* iov, const uaccesslogrecord& r, char* date, time_t& date_sec, char* buffer, uint32_t size)
+{
+   U_TRACE(5, "setText(%p,%p,%p,%ld,%p,%u)", iov, &r, date, date_sec, buffer, size)
+
+   if (date_sec != r.sec) (void) u_strftime2(date, 26+1, U_CONSTANT_TO_PARAM("%d/%b/%Y:%T %z"), u_get_localtime(date_sec = r.sec));
+
+   iov[0].iov_base = (caddr_t)r.host;
+   iov[0].iov_len  =          r.host_len;
+   iov[1].iov_base = (caddr_t)" - - [";
+   iov[1].iov_len  =          6;
+   iov[2].iov_base = (caddr_t)date;
+   iov[2].iov_len  =          26;
+   iov[3].iov_base = (caddr_t)"] \"";
+   iov[3].iov_len  =          3;
+   iov[4].iov_base = (caddr_t)r.request;
+   iov[4].iov_len  =          r.request_len;
+   iov[5].iov_base = (caddr_t)buffer;
+   iov[5].iov_len  = (r.body_len == 0 ? u__snprintf(buffer, size, U_CONSTANT_TO_PARAM("\" %u - \""),  r.code)
+                                      : u__snprintf(buffer, size, U_CONSTANT_TO_PARAM("\" %u %u \""), r.code, r.body_len));
+   iov[6].iov_base = (caddr_t)r.referer;
+   iov[6].iov_len  =          r.referer_len;
+   iov[7].iov_base = (caddr_t)"\" \"";
+   iov[7].iov_len  =          3;
+   iov[8].iov_base = (caddr_t)r.agent;
+   iov[8].iov_len  =          r.agent_len;
+   iov[9].iov_base = (caddr_t)"\"\n";
+   iov[9].iov_len  =          2;
+
+   uint32_t len = 0;
+
+   for (int j = 0; j < 10; ++j) len += iov[j].iov_len;
+
+   U_RETURN(len);
+}
+
+static void check(uint32_t n)
+{
+   U_TRACE(5, "check(%u)", n)
+
+   UString path(U_CAPACITY), expected(n * 200U);
+
+   path.snprintf(U_CONSTANT_TO_PARAM("/tmp/bench_binary_log.check.%P"));
+
+   (void) UFile::_unlink(path.c_str());
+
+   ULog* plog;
+   UBinaryAccessLog* binary;
+
+   U_NEW(ULog, plog, ULog(path, 0));
+   U_NEW(UBinaryAccessLog, binary, UBinaryAccessLog);
+
+   uaccesslogrecord r;
+   char buffer[128];
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      if ((i % 1000) == 0) u_gettimenow();
+
+      setRecord(r, i, buffer, sizeof(buffer));
+
+      binary->write(plog, r);
+
+      r.adjust = *u_pnow_adjust;
+
+      UBinaryAccessLogReader::appendCombined(expected, r);
+      }
+
+   uint32_t nsegment = binary->getNumSegment();
+
+   plog->closeLog();
+
+   delete plog;
+   delete binary;
+
+   UString content = UFile::contentOf(path), result(expected.size() + U_CAPACITY);
+
+   UBinaryAccessLogReader reader;
+
+   reader.setInput(U_STRING_TO_PARAM(content));
+
+   while (reader.next(r)) UBinaryAccessLogReader::appendCombined(result, r);
+
+   if (reader.getNumRecord()  != n        ||
+       reader.getNumSegment() != nsegment ||
+       reader.getNumSkipped()             ||
+       reader.getNumGarbage())
+      {
+      U_ERROR("bench_binary_log: decoded %u records (%u segments, %u skipped, %u garbage) of %u (%u segments)",
+               reader.getNumRecord(), reader.getNumSegment(), reader.getNumSkipped(), reader.getNumGarbage(), n, nsegment);
+      }
+
+   if (result != expected) U_ERROR("bench_binary_log: the decoded records don't match with the text format");
+
+   printf("check   %u records (%u segments): %u bytes binary, %u bytes text: ok\n", n, nsegment, content.size(), expected.size());
+
+   fflush(stdout);
+
+   (void) UFile::_unlink(path.c_str());
+}
+
+static void run(const char* name, uint32_t log_file_sz, bool binary)
+{
+   U_TRACE(5, "run(%S,%u,%b)", name, log_file_sz, binary)
+
+   UString path(U_CAPACITY);
+
+   path.snprintf(U_CONSTANT_TO_PARAM("/tmp/bench_binary_log.%s.%P"), name);
+
+   (void) UFile::_unlink(path.c_str());
+
+   ULog* plog;
+   UBinaryAccessLog* pbinary = U_NULLPTR;
+
+   U_NEW(ULog, plog, ULog(path, log_file_sz));
+
+   if (binary) U_NEW(UBinaryAccessLog, pbinary, UBinaryAccessLog);
+
+   uaccesslogrecord r;
+   struct iovec iov[10];
+   time_t date_sec = 0;
+   char date[32], buffer[128], buffer1[32];
+   uint64_t total = 0, elapsed = 0, t0;
+
+   for (uint32_t i = 0; i < num_record; ++i)
+      {
+      if ((i % 1000) == 0) u_gettimenow();
+
+      setRecord(r, i, buffer, sizeof(buffer));
+
+      t0 = bench_now();
+
+      if (pbinary) pbinary->write(plog, r);
+      else
+         {
+         total += setText(iov, r, date, date_sec, buffer1, sizeof(buffer1));
+
+         plog->write(iov, 10);
+         }
+
+      elapsed += bench_now() - t0;
+      }
+
+   if (pbinary &&
+       log_file_sz == 0)
+      {
+      plog->fsync();
+
+      total = plog->size(true);
+      }
+
+   printf("%-13s %9u records: %10.6f sec (%6.1f ns/record)", name, num_record, elapsed * 1e-9, (num_record ? (double)elapsed / num_record : 0.0));
+
+   if (total) printf(" %5.1f bytes/record", (double)total / num_record);
+
+   printf("\n");
+
+   fflush(stdout);
+
+   plog->closeLog();
+
+   delete plog;
+   delete pbinary;
+
+   (void) UFile::_unlink(path.c_str());
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_record = (argc > 1 ? u_atoi(argv[1]) : 1000000);
+
+   check(num_record / 10);
+
+   run("writev_text",   0, false);
+   run("writev_binary", 0, true);
+   run("mmap_text",     1024U * 1024U, false);
+   run("mmap_binary",   1024U * 1024U, true);
+}
@@ -0,0 +1,138 @@
+// bench_cdb.cpp
+
+/**
+ * Lookups on a constant database in the classic format and in the fingerprint variant:
+ *
+ * ./bench_cdb [num_key] [num_op]   (default 10000000 keys, 100000 lookups)
+ *
+ * the two databases (bench_cdb.cdb and bench_cdb_fp.cdb) are written directly with the records "key<n>" -> "value<n>", then
+ * we search random keys that are present (hit) and not present (miss) one at a time with find() and in batch with findMany().
+ * In the classic format a table has as many slots as records, so a miss scans (and a hit often crosses) a long probe sequence
+ */
+
+#include <ulib/db/cdb.h>
+
+#include "bench.h"
+
+static uint32_t num_key, num_op;
+
+class UBenchCDB : public UCDB {
+public:
+
+   UBenchCDB(const UString& path, bool bfp) : UCDB(path, 0) { setFingerprint(bfp); }
+
+   bool build()
+      {
+      if (creat(O_RDWR)                                                            == false ||
+          ftruncate(UCDB::sizeFor(num_key, bfingerprint) + num_key * 32 + 4096) == false ||
+          memmap(PROT_READ | PROT_WRITE)                                           == false)
+         {
+         return false;
+         }
+
+      makeStart();
+
+      uint32_t klen, dlen;
+      char* ptr = (char*)hr;
+
+      for (uint32_t i = 0; i < num_key; ++i)
+         {
+         klen = u__snprintf(ptr + sizeof(cdb_record_header),        32, U_CONSTANT_TO_PARAM("key%u"),   i);
+         dlen = u__snprintf(ptr + sizeof(cdb_record_header) + klen, 32, U_CONSTANT_TO_PARAM("value%u"), i);
+
+         u_put_unaligned32(((cdb_record_header*)ptr)->klen, klen);
+         u_put_unaligned32(((cdb_record_header*)ptr)->dlen, dlen);
+
+         ptr += sizeof(cdb_record_header) + klen + dlen;
+         }
+
+      hr      = (cdb_record_header*)ptr;
+      nrecord = num_key;
+
+      uint32_t pos = makeFinish(true);
+
+      munmap();
+
+      bool result = ftruncate(pos);
+
+      UFile::close();
+
+      return result;
+      }
+};
+
+static void run(UCDB& cdb, const char* format, const UString* keys, bool bmany, bool bhit)
+{
+   uint32_t i, nfound = 0;
+   UString values[16];
+   uint64_t start = bench_now();
+
+   if (bmany)
+      {
+      for (i = 0; i < num_op; i += 16) nfound += cdb.findMany(keys+i, U_min(16, num_op-i), values);
+      }
+   else
+      {
+      for (i = 0; i < num_op; ++i)
+         {
+         if (cdb.find(keys[i])) ++nfound;
+         }
+      }
+
+   double sec = bench_elapsed(start);
+
+   printf("%-11s %-8s %-4s %9u lookups: %10.6f sec (%12.1f lookups/sec) %u found\n",
+          format, (bmany ? "findMany" : "find"), (bhit ? "hit" : "miss"), num_op, sec, (sec > 0 ? num_op / sec : 0.0), nfound);
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_key = (argc > 1 ? u_atoi(argv[1]) : 10000000);
+   num_op  = (argc > 2 ? u_atoi(argv[2]) :   100000);
+
+   uint32_t i, seed = 1;
+   char buffer[32];
+
+   UString* hit  = new UString[num_op];
+   UString* miss = new UString[num_op];
+
+   for (i = 0; i < num_op; ++i)
+      {
+      seed = seed * 1103515245 + 12345;
+
+      hit[i]  = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key%u"),   (seed >> 4) % num_key));
+      miss[i] = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("nokey%u"), (seed >> 4) % num_key));
+      }
+
+   const char* name[2] = { "classic", "fingerprint" };
+   const char* path[2] = { "bench_cdb.cdb", "bench_cdb_fp.cdb" };
+
+   for (int k = 0; k < 2; ++k)
+      {
+      UString pathdb(path[k], strlen(path[k]));
+
+      if (UBenchCDB(pathdb, k).build() == false) U_ERROR("bench_cdb: build of %S failed", path[k]);
+
+      UCDB cdb(pathdb, 0);
+
+      if (cdb.open() == false) U_ERROR("bench_cdb: open of %S failed", path[k]);
+
+      printf("%-11s %u records, file size %u\n", name[k], cdb.size(), (uint32_t)cdb.getSize());
+
+      run(cdb, name[k], hit,  false, true);
+      run(cdb, name[k], hit,  true,  true);
+      run(cdb, name[k], miss, false, false);
+      run(cdb, name[k], miss, true,  false);
+
+      (void) UFile::_unlink(path[k]);
+      }
+
+   delete[] hit;
+   delete[] miss;
+}
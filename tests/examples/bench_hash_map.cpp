@@ -0,0 +1,184 @@
+// bench_hash_map.cpp
+
+/**
+ * The chained hash table (UHashMap) against the open addressing variant (UFlatHashMap):
+ *
+ * ./bench_hash_map [num_key] [num_op]   (default 1000, 100000 and 10000000 keys, 1000000 lookups)
+ *
+ * for every size we insert the records "key<n>" -> n (both tables are sized in advance for num_key entries), then we search random keys that are
+ * present (hit) and not present (miss), and at the end we erase all the records. Before the timings we check that the two tables give
+ * the same answers on a random sequence of insert/erase/find (churn), that is the case where the tombstones of the flat table matter
+ */
+
+#include <ulib/container/flat_hash_map.h>
+
+#include "bench.h"
+
+static uint32_t num_key, num_op;
+static UString* keys;
+static UString* hit;
+static UString* miss;
+
+static void report(const char* name, const char* op, uint32_t n, uint64_t& start, uint32_t nfound)
+{
+   double sec = bench_elapsed(start);
+
+   printf("%-7s %-11s %9u ops: %10.6f sec (%6.1f ns/op) %u found\n", name, op, n, sec, (n ? sec * 1e9 / n : 0.0), nfound);
+
+   fflush(stdout);
+
+   start = bench_now();
+}
+
+template <class T> static void run(T& map, const char* name)
+{
+   uint32_t i, nfound = 0;
+   uint64_t start = bench_now();
+
+   for (i = 0; i < num_key; ++i)
+      {
+      if (map.find(keys[i]) == false) map.insertAfterFind(keys[i], (const void*)(long)(i+1));
+      }
+
+   report(name, "insert", num_key, start, map.size());
+
+   for (i = 0; i < num_op; ++i)
+      {
+      if (map.find(hit[i])) ++nfound;
+      }
+
+   report(name, "find hit", num_op, start, nfound);
+
+   for (nfound = i = 0; i < num_op; ++i)
+      {
+      if (map.find(miss[i])) ++nfound;
+      }
+
+   report(name, "find miss", num_op, start, nfound);
+
+   for (nfound = i = 0; i < num_key; ++i)
+      {
+      if (map.find(keys[i]))
+         {
+         ++nfound;
+
+         map.eraseAfterFind();
+         }
+      }
+
+   report(name, "erase", num_key, start, nfound);
+
+   U_INTERNAL_ASSERT_EQUALS(map.size(), 0)
+}
+
+static void churn(uint32_t n, uint32_t nloop)
+{
+   U_TRACE(5, "churn(%u,%u)", n, nloop)
+
+   UHashMap<void*> chained((uint32_t)u_nextPowerOfTwo(n)); // NB: the chained table must be a power of 2...
+   UFlatHashMap<void*> flat;
+
+   bool bfound;
+   uint32_t i, seed = 7;
+
+   for (i = 0; i < nloop; ++i)
+      {
+      seed = seed * 1103515245 + 12345;
+
+      const UString& key = keys[(seed >> 4) % n];
+
+      bfound = chained.find(key);
+
+      if (flat.find(key) != bfound ||
+          (bfound && chained.elem() != flat.elem()))
+         {
+         U_ERROR("bench_hash_map: churn mismatch on key %V at step %u", key.rep, i);
+         }
+
+      if (bfound == false)
+         {
+           flat.insertAfterFind(key, (const void*)(long)(i+1));
+         chained.insertAfterFind(key, (const void*)(long)(i+1));
+         }
+      else if ((seed & 0x300) != 0)
+         {
+           flat.eraseAfterFind();
+         chained.eraseAfterFind();
+         }
+
+      if (chained.size() != flat.size()) U_ERROR("bench_hash_map: churn size mismatch (%u != %u) at step %u", chained.size(), flat.size(), i);
+      }
+
+   printf("churn   %u keys, %u ops: ok (%u entries, flat capacity %u)\n", n, nloop, flat.size(), flat.capacity());
+
+   fflush(stdout);
+
+   for (i = 0; i < n; ++i)
+      {
+      if (  flat.find(keys[i])) flat.eraseAfterFind();
+      if (chained.find(keys[i])) chained.eraseAfterFind();
+      }
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   uint32_t sizes[3] = { 1000, 100000, 10000000 }, nsize = 3;
+
+   if (argc > 1)
+      {
+      nsize    = 1;
+      sizes[0] = u_atoi(argv[1]);
+      }
+
+   num_op = (argc > 2 ? u_atoi(argv[2]) : 1000000);
+
+   char buffer[32];
+   uint32_t i, seed, max = 0;
+
+   for (i = 0; i < nsize; ++i) if (sizes[i] > max) max = sizes[i];
+
+   keys = new UString[max];
+   hit  = new UString[num_op];
+   miss = new UString[num_op];
+
+   for (i = 0; i < max; ++i) keys[i] = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key%u"), i));
+
+   churn(U_min(max, 10000), 1000000);
+
+   for (uint32_t k = 0; k < nsize; ++k)
+      {
+      num_key = sizes[k];
+
+      for (seed = 1, i = 0; i < num_op; ++i)
+         {
+         seed = seed * 1103515245 + 12345;
+
+         hit[i]  = keys[(seed >> 4) % num_key];
+         miss[i] = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("nokey%u"), (seed >> 4) % num_key));
+         }
+
+      printf("--- %u keys ---\n", num_key);
+
+         {
+         UHashMap<void*> chained((uint32_t)u_nextPowerOfTwo(num_key));
+
+         run(chained, "chained");
+         }
+
+         {
+         UFlatHashMap<void*> flat;
+
+         flat.reserve(num_key);
+
+         run(flat, "flat");
+         }
+      }
+
+   delete[] keys;
+   delete[] hit;
+   delete[] miss;
+}
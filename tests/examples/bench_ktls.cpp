@@ -0,0 +1,187 @@
+// bench_ktls.cpp
+
+/**
+ * A file served on a TLS connection on 127.0.0.1: encryption in user space (SSL_write() of the mapped file) vs kTLS (sendfile()):
+ *
+ * ./bench_ktls [size_mb] [rounds] [cert_file] [key_file]   (default a file of 64 MB sent 8 times for mode, ../ulib/CA/server.crt ../ulib/CA/server_nopass.key)
+ *
+ * For every mode we fork a server that accept one connection for round and we measure the wall time of the transfer (client side)
+ * and the cpu time (user + system) of the server process, reported as cpu seconds for GB served. If the kernel (module tls) or the
+ * OpenSSL library don't support kTLS the connection stays in user space and the kTLS mode is reported as fallback...
+ */
+
+#include <ulib/file.h>
+#include <ulib/ssl/net/sslsocket.h>
+
+#include <sys/wait.h>
+#include <sys/sendfile.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+
+#define PORT 11014
+
+static UFile* file;
+static uint32_t file_size, rounds;
+
+static void server(USSLSocket* srv, bool bktls)
+{
+   int n, fallback = 0;
+   uint32_t sent;
+   off_t offset;
+
+#ifdef U_USE_KTLS
+   USSLSocket::bktls = bktls;
+#endif
+
+   for (uint32_t i = 0; i < rounds; ++i)
+      {
+      USSLSocket conn(false, U_NULLPTR, true);
+
+      if (srv->acceptClient(&conn) == false) U_EXIT(1);
+
+      if (bktls &&
+          conn.isKTLS())
+         {
+         offset = 0;
+
+         while (offset < (off_t)file_size) // NB: the kernel encrypts the records...
+            {
+            if (sendfile(conn.getFd(), file->getFd(), &offset, file_size - offset) <= 0) U_EXIT(1);
+            }
+         }
+      else
+         {
+         if (bktls) fallback = 2;
+
+         for (sent = 0; sent < file_size; sent += n) // NB: SSL_write() of the mapped file...
+            {
+            if ((n = conn.send(file->getMap() + sent, U_min(file_size - sent, 1024U * 1024U))) <= 0) U_EXIT(1);
+            }
+         }
+
+      char c;
+
+      (void) conn.recv(&c, 1); // NB: we wait for the client to close the connection...
+
+      conn.close();
+      }
+
+   U_EXIT(fallback);
+}
+
+static void run(USSLSocket* srv, bool bktls)
+{
+   pid_t pid = fork();
+
+   if (pid == 0) server(srv, bktls);
+
+   int n, status;
+   uint32_t nerr = 0;
+   char buffer[256 * 1024];
+   struct rusage ru;
+   UString host(U_CONSTANT_TO_PARAM("127.0.0.1"));
+   uint64_t start = bench_now();
+
+   for (uint32_t i = 0; i < rounds; ++i)
+      {
+      uint32_t received = 0;
+      USSLSocket client(false);
+
+      client.setSSLActive(true);
+
+      if (client.connectServer(host, PORT) == false) U_ERROR("bench_ktls: connect failed");
+
+      while (received < file_size &&
+             (n = client.recv(buffer, sizeof(buffer))) > 0)
+         {
+         if (memcmp(buffer, file->getMap() + received, n)) ++nerr;
+
+         received += n;
+         }
+
+      if (received != file_size) ++nerr;
+
+      client.close();
+      }
+
+   double sec = bench_elapsed(start);
+
+   (void) wait4(pid, &status, 0, &ru);
+
+   double gb  = (double)file_size * rounds / (1024.0 * 1024.0 * 1024.0),
+          cpu = (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+
+   const char* name = (bktls == false                  ? "user space"
+                                                       : WIFEXITED(status) &&
+                       WEXITSTATUS(status) == 2        ? "kTLS (fallback: not available)"
+                                                       : "kTLS sendfile");
+
+   printf("%-31s %6.2f GB: %8.3f sec (%8.1f MB/sec) server cpu %6.3f sec (user %.3f sys %.3f) = %6.3f cpu sec/GB %u error\n",
+          name, gb, sec, (sec > 0 ? gb * 1024.0 / sec : 0.0), cpu,
+          (double)ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6,
+          (double)ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6, (gb > 0 ? cpu / gb : 0.0), nerr);
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   file_size = (argc > 1 ? u_atoi(argv[1]) : 64) * 1024U * 1024U;
+   rounds    = (argc > 2 ? u_atoi(argv[2]) :  8);
+
+   // the file to serve (not compressible, as a static asset already compressed)
+
+   char name[] = "/tmp/bench_ktls.XXXXXX";
+
+   int fd = mkstemp(name);
+
+   if (fd == -1) U_ERROR("bench_ktls: mkstemp failed");
+
+   uint32_t i, j, seed = 12345;
+   char block[64 * 1024];
+
+   for (i = 0; i < file_size; i += sizeof(block))
+      {
+      for (j = 0; j < sizeof(block); ++j) block[j] = (char)((seed = seed * 1103515245 + 12345) >> 16);
+
+      (void) write(fd, block, U_min(sizeof(block), file_size - i));
+      }
+
+   (void) close(fd);
+
+   U_NEW(UFile, file, UFile(UString(name, strlen(name))));
+
+   if (file->open() == false) U_ERROR("bench_ktls: open of %S failed", name);
+
+   file->readSize();
+
+   if (file->memmap(PROT_READ) == false)
+      {
+      U_ERROR("bench_ktls: memmap of %S failed", name);
+      }
+
+   (void) unlink(name);
+
+   USSLSocket srv(false, U_NULLPTR, true);
+
+   const char* cert_file = (argc > 3 ? argv[3] : "../ulib/CA/server.crt");
+   const char*  key_file = (argc > 4 ? argv[4] : "../ulib/CA/server_nopass.key");
+
+   if (srv.setContext(U_NULLPTR, cert_file, key_file, U_NULLPTR, U_NULLPTR, U_NULLPTR, SSL_VERIFY_NONE) == false ||
+       srv.setServer(PORT)                                                                           == false)
+      {
+      U_ERROR("bench_ktls: server setup failed");
+      }
+
+   srv.reusePort(0); // NB: with SO_REUSEPORT the listen() is done here (blocking socket)...
+
+   run(&srv, false);
+   run(&srv, true);
+
+   delete file;
+}
@@ -0,0 +1,151 @@
+// bench_mask_matcher.cpp
+
+/**
+ * The check of the DOS regexp masks of the http server (CACHE_FILE_MASK, URI_PROTECTED_MASK, ...) with UServices::dosMatchWithOR()
+ * against the same masks compiled with UMaskMatcher:
+ *
+ * ./bench_mask_matcher [num_op]   (default 10000000 checks for every mask)
+ *
+ * Before the timings we check on random strings and random masks that UMaskMatcher gives the same result of u_dosmatch()
+ * for every pattern (also with FNM_IGNORECASE)
+ */
+
+#include <ulib/utility/services.h>
+#include <ulib/utility/mask_matcher.h>
+
+#include "bench.h"
+
+static const char* masks[] = {
+   "CACHE_FILE_MASK",       "*.css|*.js|*.html|*.htm|*.png|*.jpg|*.jpeg|*.gif|*.ico|*.svg|*.woff|*.woff2|*.ttf|*.txt|*.xml|*.json",
+   "NOCACHE_FILE_MASK",     "*.php|*.cgi|*.tmp|*.bak|*~|.*|*.swp|*.log|*.pid|*.sock",
+   "URI_PROTECTED_MASK",    "/admin/*|/private/*|/api/v?/internal/*|*/.git/*|*/.svn/*|/server-status|/server-info|/cgi-bin/*.cgi",
+   "URI_REQUEST_CERT_MASK", "/secure/*|/api/v?/admin/*|/bank/*/transfer|/login.php",
+   "THROTTLING_MASK",       "/download/*.iso|/download/*.tar.gz|/video/*.mp4|/video/*.webm|*.zip"
+};
+
+static const char* uris[] = {
+   "/index.html", "/css/style.min.css", "/js/vendor/jquery-3.7.1.min.js", "/images/logo.png", "/favicon.ico",
+   "/api/v1/users/12345/orders?limit=50", "/api/v2/internal/metrics", "/admin/login", "/static/fonts/roboto.woff2",
+   "/blog/2024/10/18/a-very-long-article-title-with-many-words-in-the-path.html", "/download/ubuntu-24.04-desktop-amd64.iso",
+   "/wp-content/plugins/contact-form-7/includes/js/index.js?ver=5.9", "/secure/account", "/cgi-bin/test.cgi", "/.git/config",
+   "/video/intro.mp4", "/robots.txt", "/search?q=open+addressing+hash+table&lang=en"
+};
+
+static uint32_t num_op;
+
+static void check(uint32_t nloop, int flags)
+{
+   U_TRACE(5, "check(%u,%d)", nloop, flags)
+
+   char buffer[64];
+   const char* alpha = "ab/.*?";
+   uint32_t i, j, k, len, seed = 3;
+   UVector<UString> vpattern;
+
+   for (i = 0; i < nloop; ++i)
+      {
+      // a random mask of 1-8 patterns of 1-8 chars of [ab/.*?]
+
+      UString mask(U_CAPACITY);
+
+      vpattern.clear();
+
+      for (j = 0, k = (i % 8) + 1; j < k; ++j)
+         {
+         seed = seed * 1103515245 + 12345;
+
+         for (len = 0; len < ((seed >> 8) % 8) + 1; ++len)
+            {
+            seed = seed * 1103515245 + 12345;
+
+            buffer[len] = alpha[(seed >> 16) % 6];
+
+            if (flags && (seed & 0x100)) buffer[len] = u__toupper(buffer[len]);
+            }
+
+         vpattern.push_back(UString((const void*)buffer, len));
+
+         if (j) mask.push_back('|');
+
+         (void) mask.append(buffer, len);
+         }
+
+      UMaskMatcher matcher(mask, flags);
+
+      if (matcher.isCompiled() == false) U_ERROR("bench_mask_matcher: the mask %V is not compiled", mask.rep);
+
+      for (j = 0; j < 64; ++j)
+         {
+         seed = seed * 1103515245 + 12345;
+
+         for (len = 0; len < ((seed >> 8) % 12) + 1; ++len)
+            {
+            seed = seed * 1103515245 + 12345;
+
+            buffer[len] = alpha[(seed >> 16) % 4];
+
+            if (flags && (seed & 0x100)) buffer[len] = u__toupper(buffer[len]);
+            }
+
+         uint64_t result = 0;
+
+         for (k = 0; k < vpattern.size(); ++k)
+            {
+            if (u_dosmatch(buffer, len, U_STRING_TO_PARAM(vpattern[k]), flags)) result |= 1ULL << k;
+            }
+
+         if (matcher.match(buffer, len) != result) U_ERROR("bench_mask_matcher: mismatch on %.*S with mask %V (flags %d)", len, buffer, mask.rep, flags);
+         }
+      }
+
+   printf("check   %u random masks (flags %d): ok\n", nloop, flags);
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_op = (argc > 1 ? u_atoi(argv[1]) : 10000000);
+
+   check(20000, 0);
+   check(20000, FNM_IGNORECASE);
+
+   uint32_t i, nuri = U_NUM_ELEMENTS(uris), nfound;
+
+   for (uint32_t k = 0; k < U_NUM_ELEMENTS(masks); k += 2)
+      {
+      UString mask(masks[k+1], strlen(masks[k+1]));
+      UMaskMatcher matcher(mask);
+
+      printf("%s: %u patterns, %u states\n", masks[k], matcher.getNumPattern(), matcher.getNumState());
+
+      for (int compiled = 0; compiled < 2; ++compiled)
+         {
+         nfound = 0;
+
+         uint64_t start = bench_now();
+
+         for (i = 0; i < num_op; ++i)
+            {
+            const char* uri = uris[i % nuri];
+
+            if (compiled ? matcher.isMatch(uri, u__strlen(uri, __PRETTY_FUNCTION__))
+                         : UServices::dosMatchWithOR(uri, u__strlen(uri, __PRETTY_FUNCTION__), U_STRING_TO_PARAM(mask), 0))
+               {
+               ++nfound;
+               }
+            }
+
+         double sec = bench_elapsed(start);
+
+         printf("   %-14s %9u checks: %10.6f sec (%6.1f ns/check) %u match\n",
+                (compiled ? "UMaskMatcher" : "dosMatchWithOR"), num_op, sec, (num_op ? sec * 1e9 / num_op : 0.0), nfound);
+
+         fflush(stdout);
+         }
+      }
+}
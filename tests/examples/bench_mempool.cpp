@@ -0,0 +1,119 @@
+// bench_mempool.cpp
+
+/**
+ * Stress the UMemoryPool thread-local magazines against glibc malloc/free:
+ *
+ * ./bench_mempool [num_threads] [num_op]   (default 4 threads, 1000000 op for thread)
+ *
+ * every thread allocates a batch of blocks of mixed size (8 - 4096 bytes), writes them and frees them in a different order
+ * (so that the blocks travel between the stacks of the magazine and the global depot); the run with 1 thread gives the cost
+ * of the pool without contention, i.e. the cost of the previous single-threaded implementation
+ */
+
+#include <ulib/base/utility.h>
+#include <ulib/internal/common.h>
+
+#include <pthread.h>
+
+#include "bench.h"
+
+#define U_BATCH 256
+
+static uint32_t num_op;
+
+static const uint32_t sizes[] = { 16, 24, 32, 56, 100, 128, 200, 256, 512, 700, 1024, 2048, 4096 };
+
+static void* runPool(void* arg)
+{
+   void* ptr[U_BATCH];
+   uint32_t len[U_BATCH];
+   uint32_t i, k, n = 0, seed = (uint32_t)(long)arg;
+
+   while (n < num_op)
+   {
+   for (i = 0; i < U_BATCH; ++i)
+      {
+      seed = seed * 1103515245 + 12345;
+
+      len[i] = sizes[(seed >> 16) % U_NUM_ELEMENTS(sizes)];
+      ptr[i] = UMemoryPool::_malloc(len[i]);
+
+      *(char*)ptr[i] = (char)i;
+      }
+
+   for (i = 0; i < U_BATCH; ++i)
+      {
+      k = (i * 7) % U_BATCH;
+
+      UMemoryPool::_free(ptr[k], len[k]);
+      }
+
+   n += U_BATCH;
+   }
+
+   return U_NULLPTR;
+}
+
+static void* runMalloc(void* arg)
+{
+   void* ptr[U_BATCH];
+   uint32_t i, n = 0, seed = (uint32_t)(long)arg;
+
+   while (n < num_op)
+   {
+   for (i = 0; i < U_BATCH; ++i)
+      {
+      seed = seed * 1103515245 + 12345;
+
+      ptr[i] = malloc(sizes[(seed >> 16) % U_NUM_ELEMENTS(sizes)]);
+
+      *(char*)ptr[i] = (char)i;
+      }
+
+   for (i = 0; i < U_BATCH; ++i) free(ptr[(i * 7) % U_BATCH]);
+
+   n += U_BATCH;
+   }
+
+   return U_NULLPTR;
+}
+
+static void run(const char* backend, void* (*func)(void*), uint32_t nthread)
+{
+   uint32_t i;
+   pthread_t* tid = new pthread_t[nthread];
+   uint64_t start = bench_now();
+
+   for (i = 0; i < nthread; ++i) (void) pthread_create(tid+i, U_NULLPTR, func, (void*)(long)(i+1));
+   for (i = 0; i < nthread; ++i) (void) pthread_join(tid[i], U_NULLPTR);
+
+   double sec = bench_elapsed(start);
+
+   delete[] tid;
+
+   uint32_t n = nthread * num_op;
+
+   printf("%-6s %2u threads %9u malloc+free: %10.6f sec (%12.1f op/sec)\n", backend, nthread, n, sec, (sec > 0 ? n / sec : 0.0));
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   uint32_t nthread = (argc > 1 ? u_atoi(argv[1]) : 4);
+
+   num_op = (argc > 2 ? u_atoi(argv[2]) : 1000000);
+
+   run("pool",   runPool,   1);
+   run("malloc", runMalloc, 1);
+
+   if (nthread > 1)
+      {
+      run("pool",   runPool,   nthread);
+      run("malloc", runMalloc, nthread);
+      }
+}
@@ -0,0 +1,186 @@
+// bench_orm.cpp
+
+/**
+ * N queries for round on a table World (id, randomNumber) as the TechEmpower test type 3 (SELECT) and 5 (SELECT + UPDATE):
+ * one round trip for query (execute()) vs batch (executeBatch(), with PostgreSQL all the queries are sent in one flight in pipeline mode)
+ *
+ * ./bench_orm <driver_dir> <driver_list> <driver> <option> [num_queries] [rounds]   (default 20 queries for round, 1000 rounds)
+ *
+ * ./bench_orm ../../src/ulib/orm/driver/.libs pgsql  pgsql  "host=localhost user=benchmarkdbuser password=benchmarkdbpass dbname=hello_world"
+ * ./bench_orm ../../src/ulib/orm/driver/.libs sqlite sqlite "dbname=/tmp/bench_orm"
+ *
+ * NB: the table BenchWorld is (re)created. With the drivers that don't support pipelining the batch is serial...
+ */
+
+#include <ulib/orm/orm.h>
+#include <ulib/orm/orm_driver.h>
+
+#include "bench.h"
+
+#define NUM_ROWS    10000
+#define MAX_QUERIES 500
+
+static uint32_t id, randomNumber, num_queries, rounds, vid[MAX_QUERIES], vrandom[MAX_QUERIES];
+
+static void setId(void* obj, uint32_t i)     { id = vid[i]; }
+static void setRow(void* obj, uint32_t i)    { id = (randomNumber = i + 1); }
+static void setWorld(void* obj, uint32_t i)  { id = vid[i]; randomNumber = vrandom[i]; }
+static void getRandom(void* obj, uint32_t i) { vrandom[i] = randomNumber; }
+
+static void setRoundId(uint32_t round) // NB: the ids of a round are distinct (7919 is prime with NUM_ROWS) and the same for every mode...
+{
+   for (uint32_t i = 0; i < num_queries; ++i) vid[i] = 1 + (uint32_t)(((uint64_t)round * num_queries + i) * 7919U % NUM_ROWS);
+}
+
+static uint64_t checksum()
+{
+   uint64_t sum = 0;
+
+   for (uint32_t i = 0; i < num_queries; ++i) sum += (uint64_t)vid[i] * vrandom[i];
+
+   return sum;
+}
+
+static void print(const char* name, uint64_t* start, uint32_t nquery, uint32_t nerr)
+{
+   double sec = bench_elapsed(*start);
+
+   printf("%-26s %7u queries: %8.3f sec (%9.1f queries/sec, %8.3f ms for round) %u error\n",
+          name, nquery, sec, (sec > 0 ? nquery / sec : 0.0), sec * 1000.0 / rounds, nerr);
+
+   fflush(stdout);
+
+   *start = bench_now();
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   if (argc < 5) U_ERROR("usage: bench_orm <driver_dir> <driver_list> <driver> <option> [num_queries] [rounds]");
+
+   num_queries = (argc > 5 ? u_atoi(argv[5]) :   20);
+   rounds      = (argc > 6 ? u_atoi(argv[6]) : 1000);
+
+   if (num_queries == 0 ||
+       num_queries > MAX_QUERIES)
+      {
+      num_queries = MAX_QUERIES;
+      }
+
+   UString orm_driver_dir( argv[1]);
+   UString orm_driver_list(argv[2]);
+
+   if (UOrmDriver::loadDriver(orm_driver_dir, orm_driver_list) == false) U_ERROR("ORM drivers load failed");
+
+   u_atexit(UOrmDriver::clear);
+
+   UOrmSession sql(argv[3], strlen(argv[3]), UString(argv[4]));
+
+   sql << "DROP   TABLE IF     EXISTS BenchWorld";
+   sql << "CREATE TABLE IF NOT EXISTS BenchWorld (id INTEGER PRIMARY KEY NOT NULL, randomNumber INTEGER NOT NULL)";
+
+   uint32_t i, j, nerr = 0;
+   uint64_t sum = 0, start;
+
+   UOrmStatement insert(sql, U_CONSTANT_TO_PARAM("INSERT INTO BenchWorld (id, randomNumber) VALUES (?, ?)")),
+                 select(sql, U_CONSTANT_TO_PARAM("SELECT randomNumber FROM BenchWorld WHERE id = ?")),
+                 update(sql, U_CONSTANT_TO_PARAM("UPDATE BenchWorld SET randomNumber = ? WHERE id = ?"));
+
+   insert.use(id, randomNumber);
+   select.use(id);
+   select.into(randomNumber);
+   update.use(randomNumber, id);
+
+   sql << "BEGIN";
+
+   if (insert.executeBatch(NUM_ROWS, setRow) == false) ++nerr;
+
+   sql << "COMMIT";
+
+   printf("driver %s: %u rows, %u queries for round, %u rounds\n", argv[3], NUM_ROWS, num_queries, rounds);
+
+   start = bench_now();
+
+   // SELECT: one round trip for query
+
+   for (i = 0; i < rounds; ++i)
+      {
+      setRoundId(i);
+
+      for (j = 0; j < num_queries; ++j)
+         {
+         id = vid[j];
+
+         select.execute();
+
+         vrandom[j] = randomNumber;
+         }
+
+      sum += checksum();
+      }
+
+   print("SELECT execute()", &start, rounds * num_queries, 0);
+
+   // SELECT: batch (the same ids)
+
+   for (i = 0; i < rounds; ++i)
+      {
+      setRoundId(i);
+
+      (void) memset(vrandom, 0, sizeof(vrandom));
+
+      if (select.executeBatch(num_queries, setId, getRandom) == false) ++nerr;
+
+      sum -= checksum();
+      }
+
+   if (sum) ++nerr; // NB: the checksum of the results read in batch must be the same...
+
+   print("SELECT executeBatch()", &start, rounds * num_queries, nerr);
+
+   // UPDATE: one round trip for query
+
+   for (i = 0; i < rounds; ++i)
+      {
+      setRoundId(i);
+
+      for (j = 0; j < num_queries; ++j)
+         {
+         id           = vid[j];
+         randomNumber = u_get_num_random(NUM_ROWS);
+
+         update.execute();
+         }
+      }
+
+   print("UPDATE execute()", &start, rounds * num_queries, 0);
+
+   // UPDATE: batch
+
+   for (i = 0; i < rounds; ++i)
+      {
+      setRoundId(i);
+
+      for (j = 0; j < num_queries; ++j) vrandom[j] = u_get_num_random(NUM_ROWS);
+
+      if (update.executeBatch(num_queries, setWorld) == false) ++nerr;
+      }
+
+   print("UPDATE executeBatch()", &start, rounds * num_queries, nerr);
+
+   // the last batch must be visible
+
+   for (j = 0; j < num_queries; ++j)
+      {
+      id = vid[j];
+
+      select.execute();
+
+      if (randomNumber != vrandom[j]) ++nerr;
+      }
+
+   printf("verify of the last batch: %u error\n", nerr);
+}
@@ -0,0 +1,129 @@
+// bench_rdb.cpp
+
+/**
+ * Multi-process lookups on a URDB shared by preforked children (the journal is opened with a semaphore like the sessions of userver):
+ *
+ * ./bench_rdb [num_op] [num_key]   (default 200000 lookups for child, 10000 keys)
+ *
+ * the parent stores the keys in the journal and then forks 1, 4, 16 and 64 children that search random keys; the readers
+ * don't take the semaphore (seqlock on the journal), so the throughput must scale with the number of cpu. The last run adds
+ * a child that rewrites the keys while the others are reading (the readers retry or fall back to the lock)
+ */
+
+#include <ulib/db/rdb.h>
+#include <ulib/process.h>
+
+#include "bench.h"
+
+static uint32_t num_op, num_key;
+
+static int reader(URDB& rdb, uint32_t seed)
+{
+   char key[32];
+   uint32_t i, n, len, nerr = 0;
+
+   for (i = 0; i < num_op; ++i)
+      {
+      seed = seed * 1103515245 + 12345;
+
+      n   = (seed >> 8) % num_key;
+      len = u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("key%u"), n);
+
+      if (rdb.find(key, len) == false) ++nerr;
+      else
+         {
+         UString value = rdb.elem();
+
+         if (value.size() != len + 2 ||
+             memcmp(value.c_pointer(5), key+3, len-3))
+            {
+            ++nerr;
+            }
+         }
+      }
+
+   return (nerr != 0);
+}
+
+static int writer(URDB& rdb)
+{
+   char key[32], data[32];
+   uint32_t i, len, n = 0;
+
+   while (n++ < num_op)
+      {
+      i   = n % num_key;
+      len = u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("key%u"), i);
+
+      (void) rdb.store(key, len, data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("value%u"), i), RDB_REPLACE);
+      }
+
+   return 0;
+}
+
+static void run(URDB& rdb, uint32_t nchild, bool bwriter)
+{
+   uint32_t i, nerr = 0, ntot = nchild + bwriter;
+   UProcess* child = new UProcess[ntot];
+   uint64_t start = bench_now();
+
+   for (i = 0; i < ntot; ++i)
+      {
+      if (child[i].fork() &&
+          child[i].child())
+         {
+         U_EXIT(i < nchild ? reader(rdb, i+1) : writer(rdb));
+         }
+      }
+
+   for (i = 0; i < ntot; ++i)
+      {
+      child[i].wait();
+
+      if (child[i].exitValue()) ++nerr;
+      }
+
+   double sec = bench_elapsed(start);
+
+   delete[] child;
+
+   uint32_t n = nchild * num_op;
+
+   printf("%2u children%s %10u lookups: %10.6f sec (%12.1f lookups/sec) %u error\n",
+          nchild, (bwriter ? " + writer" : "         "), n, sec, (sec > 0 ? n / sec : 0.0), nerr);
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_op  = (argc > 1 ? u_atoi(argv[1]) : 200000);
+   num_key = (argc > 2 ? u_atoi(argv[2]) : 10000);
+
+   URDB rdb(U_STRING_FROM_CONSTANT("bench_rdb.db"), false);
+
+   if (rdb.open(4 * 1024 * 1024, true, false, true, U_NULLPTR) == false) // NB: U_NULLPTR => semaphore on shared memory...
+      {
+      U_ERROR("bench_rdb: open failed");
+      }
+
+   char key[32], data[32];
+
+   for (uint32_t i = 0; i < num_key; ++i)
+      {
+      (void) rdb.store(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("key%u"),   i),
+                       data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("value%u"), i), RDB_INSERT);
+      }
+
+   run(rdb,  1, false);
+   run(rdb,  4, false);
+   run(rdb, 16, false);
+   run(rdb, 64, false);
+   run(rdb, 16, true);
+
+   rdb.close();
+}
@@ -0,0 +1,265 @@
+// bench_redis.cpp
+
+/**
+ * Round trips of a REDIS connection: one command at a time vs pipeline (exec() and execAsync() with UNotifier):
+ *
+ * ./bench_redis [num_op] [batch]   (default 100000 commands, 100 commands for pipeline)
+ *
+ * if REDIS_HOST is not set we fork a minimal stand-in of redis-server on 127.0.0.1 (REDIS_PORT or 16379) that understand
+ * the inline commands GET, SET and PING (GET key<n> => value<n>), so that we measure the cost of the round trips and not
+ * that of the server. Half of the commands are SET and half GET, the values of the GET are checked
+ */
+
+#include <ulib/net/tcpsocket.h>
+#include <ulib/net/client/redis.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "bench.h"
+
+static uint32_t num_op, batch, ndone, nerr;
+
+static UREDISClient<UTCPSocket>* rc;
+static UREDISPipeline* pipeline;
+
+static void server(int fd)
+{
+   char* ptr;
+   char* eol;
+   int len, n = 0;
+   char buffer[64 * 1024], reply[256 * 1024];
+
+   while ((len = read(fd, buffer+n, sizeof(buffer)-n)) > 0)
+      {
+      n  += len;
+      ptr = buffer;
+      len = 0;
+
+      while ((eol = (char*) memchr(ptr, '\n', buffer+n-ptr)))
+         {
+         if (len > (int)(sizeof(reply) - 128))
+            {
+            (void) write(fd, reply, len);
+
+            len = 0;
+            }
+
+         if (memcmp(ptr, U_CONSTANT_TO_PARAM("SET ")) == 0)
+            {
+            U_MEMCPY(reply+len, "+OK\r\n", U_CONSTANT_SIZE("+OK\r\n"));
+
+            len += U_CONSTANT_SIZE("+OK\r\n");
+            }
+         else if (memcmp(ptr, U_CONSTANT_TO_PARAM("PING")) == 0)
+            {
+            U_MEMCPY(reply+len, "+PONG\r\n", U_CONSTANT_SIZE("+PONG\r\n"));
+
+            len += U_CONSTANT_SIZE("+PONG\r\n");
+            }
+         else if (memcmp(ptr, U_CONSTANT_TO_PARAM("GET key")) == 0)
+            {
+            uint32_t klen = eol - ptr - U_CONSTANT_SIZE("GET key") - 1; // NB: -1 for '\r'...
+
+            len += u__snprintf(reply+len, 128, U_CONSTANT_TO_PARAM("$%u\r\nvalue%.*s\r\n"), klen + 5, klen, ptr + U_CONSTANT_SIZE("GET key"));
+            }
+         else
+            {
+            U_MEMCPY(reply+len, "-ERR unknown command\r\n", U_CONSTANT_SIZE("-ERR unknown command\r\n"));
+
+            len += U_CONSTANT_SIZE("-ERR unknown command\r\n");
+            }
+
+         ptr = eol+1;
+         }
+
+      if (len) (void) write(fd, reply, len);
+
+      n -= ptr - buffer;
+
+      if (n) (void) memmove(buffer, ptr, n);
+      }
+}
+
+static void startServer(unsigned int port)
+{
+   int on = 1, sfd = socket(AF_INET, SOCK_STREAM, 0);
+   struct sockaddr_in addr;
+
+   (void) memset(&addr, 0, sizeof(addr));
+
+   addr.sin_family      = AF_INET;
+   addr.sin_port        = htons(port);
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   (void) setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+   if (bind(sfd, (struct sockaddr*)&addr, sizeof(addr)) ||
+       listen(sfd, 16))
+      {
+      U_ERROR("bench_redis: bind on port %u failed", port);
+      }
+
+   if (fork() == 0) // NB: we serve only the connection of the benchmark...
+      {
+      int fd = accept(sfd, U_NULLPTR, U_NULLPTR);
+
+      if (fd != -1)
+         {
+         (void) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+         server(fd);
+         }
+
+      U_EXIT(0);
+      }
+
+   (void) close(sfd);
+}
+
+static void queue(uint32_t i)
+{
+   char key[32], value[32];
+   uint32_t klen = u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("key%u"), i/2);
+
+   if ((i & 1) == 0) pipeline->set(key, klen, value, u__snprintf(value, sizeof(value), U_CONSTANT_TO_PARAM("value%u"), i/2));
+   else              pipeline->get(key, klen);
+}
+
+static void check(uint32_t first)
+{
+   char value[32];
+
+   for (uint32_t i = 0, n = pipeline->vitem.size(); i < n; ++i)
+      {
+      if (((first+i) & 1) == 0) continue;
+
+      if (pipeline->vitem[i].equal(value, u__snprintf(value, sizeof(value), U_CONSTANT_TO_PARAM("value%u"), (first+i)/2)) == false) ++nerr;
+      }
+}
+
+static void nextBatch(void* arg, void* p)
+{
+   if (pipeline->vitem.empty()) // NB: connection closed...
+      {
+      ++nerr;
+
+      ndone = num_op;
+
+      return;
+      }
+
+   check(ndone);
+
+   ndone += pipeline->vitem.size();
+
+   if (ndone < num_op)
+      {
+      for (uint32_t i = ndone, n = U_min(num_op, ndone+batch); i < n; ++i) queue(i);
+
+      (void) pipeline->execAsync(nextBatch);
+      }
+}
+
+static void run(int mode)
+{
+   uint32_t i, j;
+   char key[32], value[32];
+   const char* name[3] = { "sequential", "pipeline", "pipeline async" };
+
+   nerr = 0;
+
+   uint64_t start = bench_now();
+
+   if (mode == 0)
+      {
+      for (i = 0; i < num_op; ++i)
+         {
+         uint32_t klen = u__snprintf(key,   sizeof(key),   U_CONSTANT_TO_PARAM("key%u"),   i/2),
+                  vlen = u__snprintf(value, sizeof(value), U_CONSTANT_TO_PARAM("value%u"), i/2);
+
+         if ((i & 1) == 0)
+            {
+            if (rc->set(key, klen, value, vlen) == false) ++nerr;
+            }
+         else
+            {
+            if (rc->get(key, klen) == false ||
+                rc->vitem[0].equal(value, vlen) == false)
+               {
+               ++nerr;
+               }
+            }
+         }
+      }
+   else if (mode == 1)
+      {
+      for (i = 0; i < num_op; i = j)
+         {
+         for (j = i; j < U_min(num_op, i+batch); ++j) queue(j);
+
+         if (pipeline->exec() == false) ++nerr;
+         else                           check(i);
+         }
+      }
+   else
+      {
+      ndone = 0;
+
+      for (i = 0; i < U_min(num_op, batch); ++i) queue(i);
+
+      (void) pipeline->execAsync(nextBatch);
+
+      while (ndone < num_op) UNotifier::waitForEvent();
+      }
+
+   double sec = bench_elapsed(start);
+
+   printf("%-14s %9u commands (batch %4u): %10.6f sec (%12.1f commands/sec) %u error\n",
+          name[mode], num_op, (mode ? batch : 1), sec, (sec > 0 ? num_op / sec : 0.0), nerr);
+
+   fflush(stdout);
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   num_op = (argc > 1 ? u_atoi(argv[1]) : 100000);
+   batch  = (argc > 2 ? u_atoi(argv[2]) :    100);
+
+   const char* host = U_NULLPTR;
+   unsigned int port = 16379;
+
+   if (getenv("REDIS_HOST") == U_NULLPTR)
+      {
+      const char* env_redis_port = getenv("REDIS_PORT");
+
+      if (env_redis_port) port = u_atoi(env_redis_port);
+
+      startServer(port);
+
+      host = "127.0.0.1";
+      }
+
+   U_NEW(UREDISClient<UTCPSocket>, rc, UREDISClient<UTCPSocket>);
+
+   if (rc->connect(host, port) == false) U_ERROR("bench_redis: connect failed");
+
+   U_NEW(UREDISPipeline, pipeline, UREDISPipeline(rc));
+
+   UNotifier::max_connection = 64;
+
+   UNotifier::init();
+
+   run(0);
+   run(1);
+   run(2);
+
+   delete pipeline;
+   delete rc; // NB: the stand-in server exit when the connection is closed...
+
+   if (host) (void) wait(U_NULLPTR);
+}
@@ -0,0 +1,203 @@
+// bench_timer.cpp
+
+/**
+ * Compare the UTimer 4-ary heap with the sorted linked list it replaced:
+ *
+ * ./bench_timer [num_timers]   (default 100000)
+ *
+ * for each backend it reports the time spent to insert the timers, to reschedule 1/4 of them (keep-alive),
+ * to cancel 1/4 of them and to expire the rest with a single run()
+ */
+
+#include <ulib/timer.h>
+
+#include "bench.h"
+
+static uint32_t nfired;
+
+class MyAlarm : public UEventTime {
+public:
+
+   MyAlarm(long usec) : UEventTime(0L, usec) {}
+
+   virtual int handlerTime() { ++nfired; return -1; }
+};
+
+// the previous implementation: a list sorted by time to expire (O(n) insert/erase)
+
+class UTimerList {
+public:
+
+   struct Node {
+      Node* next;
+      UEventTime* alarm;
+   };
+
+   Node* first;
+   Node* nodes;
+
+   UTimerList(uint32_t n) : first(U_NULLPTR) { nodes = new Node[n]; }
+   ~UTimerList()                            { delete[] nodes; }
+
+   void insert(Node* item, UEventTime* a)
+      {
+      struct timeval now;
+
+      u_gettimeofday(&now);
+
+      a->xtime.tv_sec  = now.tv_sec  + a->tv_sec;
+      a->xtime.tv_usec = now.tv_usec + a->tv_usec;
+
+      item->alarm = a;
+
+      Node** ptr = &first;
+
+      while (*ptr &&
+             (*a < *(*ptr)->alarm) == false)
+         {
+         ptr = &(*ptr)->next;
+         }
+
+      item->next = *ptr;
+      *ptr       = item;
+      }
+
+   Node* remove(UEventTime* a)
+      {
+      for (Node** ptr = &first; *ptr; ptr = &(*ptr)->next)
+         {
+         if ((*ptr)->alarm == a)
+            {
+            Node* item = *ptr;
+
+            *ptr = item->next;
+
+            return item;
+            }
+         }
+
+      return U_NULLPTR;
+      }
+
+   void run()
+      {
+      struct timeval now;
+
+      u_gettimeofday(&now);
+
+      while (first &&
+             (first->alarm->xtime.tv_sec  <  now.tv_sec ||
+             (first->alarm->xtime.tv_sec  == now.tv_sec &&
+              first->alarm->xtime.tv_usec <= now.tv_usec)))
+         {
+         UEventTime* a = first->alarm;
+
+         first = first->next;
+
+         (void) a->handlerTime();
+         }
+      }
+};
+
+static uint64_t start;
+
+static void startClock() { start = bench_now(); }
+
+static void stopClock(const char* backend, const char* op, uint32_t n)
+{
+   double sec = bench_elapsed(start);
+
+   printf("%-5s %-8s %7u timers: %10.6f sec (%12.1f op/sec)\n", backend, op, n, sec, (sec > 0 ? n / sec : 0.0));
+
+   fflush(stdout);
+}
+
+static void waitExpire()
+{
+   UTimeVal s(0L, 500L * 1000L);
+
+   s.nanosleep();
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   uint32_t i, n = (argc > 1 ? u_atoi(argv[1]) : 100000);
+
+   MyAlarm** alarm = new MyAlarm*[n];
+
+   // random timeout between 1 and 250 ms
+
+   for (i = 0; i < n; ++i) alarm[i] = new MyAlarm(1000L + u_get_num_random(249000));
+
+   // heap
+
+   UTimer::init(UTimer::NOSIGNAL);
+
+   nfired = 0;
+
+   startClock();
+
+   for (i = 0; i < n; ++i) UTimer::insert(alarm[i]);
+
+   stopClock("heap", "insert", n);
+
+   startClock();
+
+   for (i = 0; i < n; i += 4) UTimer::updateTimeToExpire(alarm[i]);
+
+   stopClock("heap", "update", (n + 3) / 4);
+
+   startClock();
+
+   for (i = 1; i < n; i += 4) UTimer::erase(alarm[i]);
+
+   stopClock("heap", "erase", (n + 2) / 4);
+
+   waitExpire();
+
+   startClock();
+
+   UTimer::run();
+
+   stopClock("heap", "expire", nfired);
+
+   // list
+
+   UTimerList list(n);
+
+   nfired = 0;
+
+   startClock();
+
+   for (i = 0; i < n; ++i) list.insert(list.nodes+i, alarm[i]);
+
+   stopClock("list", "insert", n);
+
+   startClock();
+
+   for (i = 0; i < n; i += 4) list.insert(list.remove(alarm[i]), alarm[i]);
+
+   stopClock("list", "update", (n + 3) / 4);
+
+   startClock();
+
+   for (i = 1; i < n; i += 4) (void) list.remove(alarm[i]);
+
+   stopClock("list", "erase", (n + 2) / 4);
+
+   waitExpire();
+
+   startClock();
+
+   list.run();
+
+   stopClock("list", "expire", nfired);
+
+   for (i = 0; i < n; ++i) delete alarm[i];
+
+   delete[] alarm;
+}
@@ -150,6 +150,36 @@ start:   token = vtoken[0];
 
          ++cnt;
 
+         if (token.equal(U_CONSTANT_TO_PARAM("response")) ||
+             token.equal(U_CONSTANT_TO_PARAM("cache")))
+            {
+            U_INTERNAL_ASSERT(num >= 3)
+
+            // response Content-Type text/html (the encoder of the response path)
+            // cache    Content-Type text/html (the block of the file cache completed against the dynamic table)
+
+            name  = vtoken[1];
+            value = vtoken[2];
+
+            for (l = 3; l < num; ++l) value += ' ' + vtoken[l];
+
+            if (token.equal(U_CONSTANT_TO_PARAM("response"))) dst = UHTTP2::hpackEncodeHeader(dst, name, value, dyntbl);
+            else
+               {
+               unsigned char block[4096];
+
+               UString hpack((void*)block, UHTTP2::hpackEncodeHeader(block, name, value) - block);
+
+               dst = UHTTP2::hpackEncodeCacheHeaders(dst, dyntbl, hpack);
+               }
+
+            if (UHTTP2::isHpackError()) return;
+
+            cout.write(ptr, dst-(unsigned char*)ptr);
+
+            continue;
+            }
+
          if (token.equal(U_CONSTANT_TO_PARAM("indexed")))
             {
             U_INTERNAL_ASSERT_EQUALS(num, 2)
@@ -0,0 +1,181 @@
+// hwrite.cpp
+
+#include <ulib/net/tcpsocket.h>
+#include <ulib/utility/http2.h>
+#include <ulib/net/server/server.h>
+
+#undef  PACKAGE
+#define PACKAGE "hwrite"
+
+#define ARGS "[port]" // The port of the loopback connection (default 8788)
+
+#define U_OPTIONS \
+"purpose 'the HTTP/2 write scheduler: the frames written on a connection'\n"
+
+#include <ulib/application.h>
+
+/**
+ * The responses are queued on the streams as UHTTP2::writeResponse() does, then UHTTP2::writeStreams() writes them on a loopback
+ * connection and we print the frames received by the peer, one line for call: H<id> (HEADERS) or D<id>:<len> (DATA), '*' if END_STREAM
+ */
+
+class Application : public UApplication {
+public:
+
+   Application()
+      {
+      U_TRACE(5, "Application::Application()")
+      }
+
+   ~Application()
+      {
+      U_TRACE(5, "Application::~Application()")
+      }
+
+   static UHTTP2::Stream* addResponse(uint32_t id, uint32_t body_len, uint8_t urgency, bool incremental)
+      {
+      U_TRACE(5, "Application::addResponse(%u,%u,%u,%b)", id, body_len, urgency, incremental)
+
+      UHTTP2::Stream* stream = UHTTP2::pConnection->streams + (id / 2);
+
+      stream->id          = id;
+      stream->state       = UHTTP2::STREAM_STATE_HALF_CLOSED;
+      stream->urgency     = urgency;
+      stream->incremental = incremental;
+      stream->out_window  = UHTTP2::pConnection->peer_settings.initial_window_size;
+      stream->oheaders    = U_STRING_FROM_CONSTANT("\x88"); // :status: 200
+      stream->obody       = (body_len ? UString(body_len, 'x') : UString::getStringNull());
+      stream->ooffset     = 0;
+      stream->bheaders    = false;
+
+      if (UHTTP2::pStreamEnd < stream) UHTTP2::pStreamEnd = stream;
+
+      UHTTP2::vwrite[UHTTP2::nwrite++] = stream;
+
+      U_RETURN_POINTER(stream, UHTTP2::Stream);
+      }
+
+   void write(const char* name)
+      {
+      U_TRACE(5, "Application::write(%S)", name)
+
+      UHTTP2::writeStreams(false);
+
+      // NB: the frames are already in the socket buffer of the peer (writev() on a blocking socket)...
+
+      int n;
+      char buffer[64 * 1024];
+
+      while ((n = U_SYSCALL(recv, "%d,%p,%u,%d", client->getFd(), buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) (void) data.append(buffer, n);
+
+      cout << name << ':';
+
+      while (data.size() >= HTTP2_FRAME_HEADER_SIZE)
+         {
+         const unsigned char* ptr = (const unsigned char*)data.data();
+         uint32_t len = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+
+         if (data.size() < (HTTP2_FRAME_HEADER_SIZE + len)) break;
+
+         cout << ' ' << (ptr[3] == UHTTP2::HEADERS ? 'H' : 'D') << (u_parse_unalignedp32(ptr+5) & 0x7fffffff);
+
+         if (ptr[3] == UHTTP2::DATA) cout << ':' << len;
+
+         if (ptr[4] & UHTTP2::FLAG_END_STREAM) cout << '*';
+
+         data.erase(0, HTTP2_FRAME_HEADER_SIZE + len);
+         }
+
+      cout << endl;
+      }
+
+   void run(int argc, char* argv[], char* env[])
+      {
+      U_TRACE(5, "Application::run(%d,%p,%p)", argc, argv, env)
+
+      UApplication::run(argc, argv, env);
+
+      unsigned int port = (argv[optind] ? u_atoi(argv[optind]) : 8788);
+
+      UTCPSocket server;
+
+      U_NEW(UTCPSocket, client, UTCPSocket);
+      U_NEW(UTCPSocket, UServer_Base::csocket, UTCPSocket);
+
+      if (server.setServer(port) == false) U_ERROR("cannot listen on port %u", port);
+
+      server.reusePort(O_RDWR | O_CLOEXEC);
+
+      if (client->connectServer(U_STRING_FROM_CONSTANT("127.0.0.1"), port) == false ||
+          server.acceptClient(UServer_Base::csocket)                       == false)
+         {
+         U_ERROR("cannot make the loopback connection on port %u", port);
+         }
+
+      UHTTP2::Connection::preallocate(1);
+
+      UHTTP2::pConnection = UHTTP2::vConnection;
+
+      UHTTP2::pStreamEnd = UHTTP2::pStream = UHTTP2::pConnection->streams;
+
+      UHTTP2::pConnection->out_window = 1024 * 1024;
+
+      // an image (u=5), a style sheet (u=0), a script (u=1) and a redirect without body: the DATA frames go out by urgency
+
+      (void) addResponse(1, 40000, 5, false);
+      (void) addResponse(3, 20000, 0, false);
+      (void) addResponse(5,  1000, 1, false);
+      (void) addResponse(7,     0, 3, false);
+
+      write("urgency");
+
+      // at the same urgency a not incremental response is written whole, the incremental ones are interleaved frame by frame
+
+      (void) addResponse( 9, 40000, 3, true);
+      (void) addResponse(11, 40000, 3, true);
+      (void) addResponse(13,   100, 3, false);
+
+      write("incremental");
+
+      // the DATA frames respect the window of the stream and the window of the connection, the rest waits for WINDOW_UPDATE
+
+      UHTTP2::pConnection->out_window = 30000;
+
+      UHTTP2::Stream* stream = addResponse(15, 20000, 0, false);
+
+      stream->out_window = 10000;
+
+      (void) addResponse(17, 20000, 1, false);
+      (void) addResponse(19,  5000, 1, false);
+
+      write("window");
+
+      UHTTP2::pConnection->out_window += 65535;
+                   stream->out_window += 65535;
+
+      write("window update");
+
+      // a stream reset by the peer: the header block is written anyway (the hpack state of the peer), the body not
+
+      stream = addResponse(21, 5000, 0, false);
+
+      stream->state = UHTTP2::STREAM_STATE_CLOSED;
+
+      write("reset");
+
+      server.close();
+      client->close();
+
+      delete client; // NB: the connection is left to the exit as the ones of the server (they are never released)...
+      }
+
+private:
+   UString data;
+   UTCPSocket* client;
+
+#ifndef U_COVERITY_FALSE_POSITIVE
+   U_DISALLOW_COPY_AND_ASSIGN(Application)
+#endif
+};
+
+U_MAIN
@@ -0,0 +1,174 @@
+// test_async_log.cpp
+
+#include <ulib/file.h>
+#include <ulib/log.h>
+
+// NB: we print only what don't depend on the scheduling of the writer thread (the number of dropped records with a small ring)...
+
+#define U_NUM_RECORD 20000
+
+class ULogTest : public ULog {
+public:
+
+   ULogTest(const UString& path, uint32_t size) : ULog(path, size) {}
+
+   const char* getMap() const    { return UFile::map; }
+   uint32_t getFilePtr() const   { return ptr_log_data->file_ptr; }
+   uint32_t getNumRotate() const { return ptr_log_data->nrotate; }
+};
+
+static char buffer[64];
+
+// a record of the log as two pieces (the way of the apache like log: the line and the newline)
+
+static void write(ULog& log, uint32_t i)
+{
+   U_TRACE(5, "write(%p,%u)", &log, i)
+
+   struct iovec iov[2] = { { (caddr_t)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("%6u GET /index.html HTTP/1.1 200"), i) },
+                           { (caddr_t)"\n",   1 } };
+
+   log.write(iov, 2);
+}
+
+// the records of data (whole lines): the number of them, the first and if they are in increasing order (consecutive if bconsecutive)
+
+static uint32_t check(const char* data, uint32_t len, bool bconsecutive, uint32_t& first, bool& ordered)
+{
+   U_TRACE(5, "check(%.*S,%u,%b,%p,%p)", len, data, len, bconsecutive, &first, &ordered)
+
+   uint32_t n = 0, i, prev = 0;
+   const char* end = data + len;
+   const char* ptr;
+
+   ordered = true;
+
+   while (data < end)
+      {
+      if ((ptr = (const char*)memchr(data, '\n', end - data)) == U_NULLPTR ||
+          (ptr - data) != (6 + U_CONSTANT_SIZE(" GET /index.html HTTP/1.1 200")) ||
+          memcmp(data + 6, U_CONSTANT_TO_PARAM(" GET /index.html HTTP/1.1 200")))
+         {
+         ordered = false;
+
+         break;
+         }
+
+      i = u_atoi(data + strspn(data, " "));
+
+      if (n == 0) first = i;
+      else if (bconsecutive ? i != prev + 1 : i <= prev) ordered = false;
+
+      prev = i;
+      data = ptr + 1;
+
+      ++n;
+      }
+
+   U_RETURN(n);
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   uint32_t i, n, first = 0, dropped;
+   bool ordered;
+   UString path(U_CAPACITY), content;
+   ULogTest* plog;
+
+   path.snprintf(U_CONSTANT_TO_PARAM("/tmp/test_async_log.%P"));
+
+   (void) UFile::_unlink(path.c_str());
+
+   // writev(): the ring buffer is big enough for all the records, so nothing is dropped even if the writer thread never run...
+
+   U_NEW(ULogTest, plog, ULogTest(path, 0));
+
+   plog->setAsync(1024 * 1024);
+
+   (void) plog->startAsync();
+
+   bool async = plog->isAsync();
+
+   for (i = 0; i < U_NUM_RECORD; ++i) write(*plog, i);
+
+   dropped = plog->getDroppedRecords();
+
+   plog->stopAsync();
+   plog->closeLog();
+
+   content = UFile::contentOf(path);
+
+   n = check(U_STRING_TO_PARAM(content), true, first, ordered);
+
+   cout << "writev: async = " << async
+        << " records = "      << n
+        << " first = "        << first
+        << " dropped = "      << dropped
+        << " ordered = "      << ordered << endl;
+
+   delete plog;
+
+   (void) UFile::_unlink(path.c_str());
+
+   // the memory mapped log: the rotation is made by the writer thread and a record is never split between two files...
+
+   U_NEW(ULogTest, plog, ULogTest(path, 16 * 1024));
+
+   plog->setAsync(1024 * 1024);
+
+   (void) plog->startAsync();
+
+   for (i = 0; i < U_NUM_RECORD; ++i) write(*plog, i);
+
+   plog->stopAsync();
+
+   n = check(plog->getMap(), plog->getFilePtr(), true, first, ordered);
+
+   cout << "mmap: rotated = "    << (plog->getNumRotate() > 2)
+        << " last file > 0 = "   << (n > 0)
+        << " last record = "     << (first + n - 1)
+        << " ordered = "         << ordered << endl;
+
+   plog->closeLog();
+
+   delete plog;
+
+   (void) UFile::_unlink(path.c_str());
+
+   // a ring buffer of one page: the records that don't fit are dropped (and counted), the others are written in order...
+
+   U_NEW(ULogTest, plog, ULogTest(path, 0));
+
+   plog->setAsync(4096);
+
+   (void) plog->startAsync();
+
+   for (i = 0; i < U_NUM_RECORD; ++i) write(*plog, i);
+
+   dropped = plog->getDroppedRecords();
+
+   plog->stopAsync();
+   plog->closeLog();
+
+   content = UFile::contentOf(path);
+
+   n = check(U_STRING_TO_PARAM(content), false, first, ordered);
+
+   cout << "drop: records + dropped = " << (n + dropped)
+        << " ordered = "                << ordered << endl;
+
+   delete plog;
+
+   (void) UFile::_unlink(path.c_str());
+#else
+   cout << "writev: async = 1 records = 20000 first = 0 dropped = 0 ordered = 1\n"
+           "mmap: rotated = 1 last file > 0 = 1 last record = 19999 ordered = 1\n"
+           "drop: records + dropped = 20000 ordered = 1" << endl;
+#endif
+}
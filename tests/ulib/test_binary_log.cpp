@@ -0,0 +1,363 @@
+// test_binary_log.cpp
+
+#include <ulib/file.h>
+#include <ulib/utility/binary_access_log.h>
+
+// NB: we print only what don't depend on the pid and the time (the size of the records and so the number of rotations)...
+
+#define U_NUM_RECORD 3000
+
+class ULogTest : public ULog {
+public:
+
+   ULogTest(const UString& path, uint32_t size) : ULog(path, size) {}
+
+   const char* getMap() const   { return UFile::map; }
+   uint32_t getFilePtr() const  { return ptr_log_data->file_ptr; }
+   uint32_t getNumRotate() const { return ptr_log_data->nrotate; }
+};
+
+static const char* hosts[]    = { "10.10.25.2", "192.168.1.100", "2001:db8::ff00:42:8329", "127.0.0.1" };
+static const char* referers[] = { "-", "http://www.example.com/", "https://www.google.com/search?q=ulib" };
+static const char* agents[]   = { "Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0", "curl/8.5.0", "-" };
+static const char* requests[] = { "GET / HTTP/1.1", "GET /css/style.min.css HTTP/1.1", "POST /login.php HTTP/1.1", "GET /search?q=log&lang=en HTTP/1.1",
+                                  "HEAD /favicon.ico HTTP/1.0", "-", "GET /robots.txt" };
+
+static time_t start;
+static char buffer[128];
+static UVector<UString>* expected;
+
+static void setRecord(uaccesslogrecord& r, uint32_t i)
+{
+   U_TRACE(5, "setRecord(%p,%u)", &r, i)
+
+   r.host    = hosts[   i % U_NUM_ELEMENTS(hosts)];
+   r.referer = referers[i % U_NUM_ELEMENTS(referers)];
+   r.agent   = agents[  i % U_NUM_ELEMENTS(agents)];
+
+   r.host_len    = u__strlen(r.host,    __PRETTY_FUNCTION__);
+   r.referer_len = u__strlen(r.referer, __PRETTY_FUNCTION__);
+   r.agent_len   = u__strlen(r.agent,   __PRETTY_FUNCTION__);
+
+   if ((i % 4) == 3) // a unique path (the dictionary grows)
+      {
+      r.request     = buffer;
+      r.request_len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("GET /user/%u/profile?tab=%u HTTP/1.1"), i, i % 7);
+      }
+   else
+      {
+      r.request     = requests[i % U_NUM_ELEMENTS(requests)];
+      r.request_len = u__strlen(r.request, __PRETTY_FUNCTION__);
+      }
+
+   r.code     = (i % 5 ? 200 : 304);
+   r.body_len = (r.code == 304 ? 0 : 100 + i);
+   r.sec      = start + i / 20; // NB: a segment last at most U_BINARY_ACCESS_LOG_INTERVAL seconds...
+   r.adjust   = *u_pnow_adjust;
+}
+
+static void write(UBinaryAccessLog& binary, ULog& log, uint32_t i)
+{
+   U_TRACE(5, "write(%p,%p,%u)", &binary, &log, i)
+
+   uaccesslogrecord r;
+
+   setRecord(r, i);
+
+   binary.write(&log, r);
+
+   UString line(U_CAPACITY);
+
+   UBinaryAccessLogReader::appendCombined(line, r);
+
+   if (expected->size() == i) expected->push_back(line);
+}
+
+// the number of records of type in data
+
+static uint32_t count(const UString& data, char type)
+{
+   U_TRACE(5, "count(%V,%C)", data.rep, type)
+
+   uint32_t n = 0, pos = 0, len, shift;
+
+   while ((pos + 3) <= data.size())
+      {
+      bool bfound = (data.c_char(pos+1) == type);
+
+      for (pos += 2, len = shift = 0; pos < data.size(); shift += 7)
+         {
+         unsigned char c = data.c_char(pos++);
+
+         len |= (uint32_t)(c & 0x7F) << shift;
+
+         if ((c & 0x80) == 0) break;
+         }
+
+      if (bfound) ++n;
+
+      pos += len;
+      }
+
+   U_RETURN(n);
+}
+
+// decode data on its own and compare the records with the expected ones starting from first
+
+static uint32_t decode(const UString& data, uint32_t first, bool& equal, uint32_t& skipped)
+{
+   U_TRACE(5, "decode(%V,%u,%p,%p)", data.rep, first, &equal, &skipped)
+
+   uaccesslogrecord r;
+   UBinaryAccessLogReader reader;
+
+   reader.setInput(U_STRING_TO_PARAM(data));
+
+   while (reader.next(r))
+      {
+      UString line(U_CAPACITY);
+
+      UBinaryAccessLogReader::appendCombined(line, r);
+
+      if (first >= expected->size() ||
+          line != (*expected)[first++])
+         {
+         equal = false;
+         }
+      }
+
+   skipped += reader.getNumSkipped() + reader.getNumGarbage();
+
+   U_RETURN(reader.getNumRecord());
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   u_gettimenow();
+
+   start = u_now->tv_sec;
+
+   U_NEW(UVector<UString>, expected, UVector<UString>(U_NUM_RECORD));
+
+   // the rotation of the memory mapped log: every file starts with the state of the segment ('S' and 'D') and it is decoded on its own...
+
+   uint32_t i, nfile = 0, nresume = 0, nrecord = 0, skipped = 0, nrotate;
+   bool equal = true;
+   UString path(U_CAPACITY), data(U_CAPACITY);
+
+   path.snprintf(U_CONSTANT_TO_PARAM("/tmp/test_binary_log.%P"));
+
+   (void) UFile::_unlink(path.c_str());
+
+   ULogTest* plog;
+   UBinaryAccessLog* binary;
+
+   U_NEW(ULogTest, plog, ULogTest(path, 16 * 1024));
+   U_NEW(UBinaryAccessLog, binary, UBinaryAccessLog);
+
+   plog->setBinary(binary);
+
+   for (i = 0; i < U_NUM_RECORD; ++i)
+      {
+      nrotate = plog->getNumRotate();
+
+      write(*binary, *plog, i);
+
+      if (plog->getNumRotate() != nrotate) // NB: we have the content of the old file, the new one start with the last record...
+         {
+         nrecord += decode(data, nrecord, equal, skipped);
+
+         if (nfile++ &&
+             count(data, 'D'))
+            {
+            ++nresume;
+            }
+
+         data.setEmpty();
+         }
+
+      (void) data.replace(plog->getMap(), plog->getFilePtr());
+      }
+
+   nrecord += decode(data, nrecord, equal, skipped);
+
+   if (count(data, 'D')) ++nresume;
+
+   cout << "rotation: files > 2 = "    << (nfile >= 2)
+        << " resumed with 'D' = "      << (nresume >= nfile)
+        << " records = "               << nrecord
+        << " segments > 1 = "          << (binary->getNumSegment() > 1)
+        << " skipped = "               << skipped
+        << " equal = "                 << equal << endl;
+
+   plog->closeLog();
+
+   delete plog;
+   delete binary;
+
+   (void) UFile::_unlink(path.c_str());
+
+   // the state of the segment rebuilt by the writer thread from the records of the ring buffer (a record can wrap at any byte)...
+
+   U_NEW(ULogTest, plog, ULogTest(path, 0));
+   U_NEW(UBinaryAccessLog, binary, UBinaryAccessLog);
+
+   for (i = 0; i < U_NUM_RECORD; ++i) write(*binary, *plog, i);
+
+   plog->closeLog();
+
+   UString content = UFile::contentOf(path);
+
+   UBinaryAccessLog writer;
+   uint32_t pos, end, len, k, nresumed = 0;
+   const char* resume;
+   struct iovec iov[2];
+
+   writer.setWriter(1024 * 1024);
+
+   equal   = true;
+   skipped = 0;
+
+   for (pos = 0, k = 0; pos < content.size(); pos = end, ++k)
+      {
+      // a batch of some records
+
+      for (end = pos, i = 0; i < (k % 7) + 1 && end < content.size(); ++i)
+         {
+         uint32_t shift, p = end + 2;
+
+         for (len = shift = 0; ; shift += 7)
+            {
+            unsigned char c = content.c_char(p++);
+
+            len |= (uint32_t)(c & 0x7F) << shift;
+
+            if ((c & 0x80) == 0) break;
+            }
+
+         end = p + len;
+         }
+
+      // the rotation before the batch: the resume and the records that follow must give the same records of the whole file...
+
+      if ((k % 13) == 12)
+         {
+         iov[0].iov_base = (caddr_t)content.c_pointer(pos);
+         iov[0].iov_len  = end - pos;
+
+         resume = writer.getResume(iov, true, len);
+
+         if (resume)
+            {
+            UString file(len + content.size() - pos);
+
+            (void) file.append(resume, len);
+            (void) file.append(content.c_pointer(pos), content.size() - pos);
+
+            uint32_t nrec = 0, m;
+
+            UBinaryAccessLogReader reader;
+            uaccesslogrecord r;
+
+            reader.setInput(U_STRING_TO_PARAM(file));
+
+            // NB: the records are the ones after pos, that is the record number (content before pos)...
+
+            UBinaryAccessLogReader all;
+
+            all.setInput(content.data(), pos);
+
+            while (all.next(r)) ++nrec;
+
+            for (m = nrec; reader.next(r); ++m)
+               {
+               UString line(U_CAPACITY);
+
+               UBinaryAccessLogReader::appendCombined(line, r);
+
+               if (line != (*expected)[m]) equal = false;
+               }
+
+            if (m != U_NUM_RECORD) equal = false;
+
+            skipped += reader.getNumSkipped() + reader.getNumGarbage();
+
+            ++nresumed;
+            }
+         }
+
+      // the batch in the ring buffer wrap at (k % 5) bytes from its end
+
+      uint32_t split = (end - pos > (k % 5) ? end - pos - (k % 5) : end - pos);
+
+      iov[0].iov_base = (caddr_t)content.c_pointer(pos);
+      iov[0].iov_len  = split;
+      iov[1].iov_base = (caddr_t)content.c_pointer(pos + split);
+      iov[1].iov_len  = end - pos - split;
+
+      writer.written(iov, (iov[1].iov_len ? 2 : 1));
+      }
+
+   cout << "writer: resumed > 10 = " << (nresumed > 10)
+        << " skipped = "             << skipped
+        << " equal = "               << equal << endl;
+
+   delete plog;
+   delete binary;
+
+   (void) UFile::_unlink(path.c_str());
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   // ...and with the writer thread: the last file is decoded on its own
+
+   U_NEW(ULogTest, plog, ULogTest(path, 16 * 1024));
+   U_NEW(UBinaryAccessLog, binary, UBinaryAccessLog);
+
+   plog->setBinary(binary);
+   plog->setAsync(512 * 1024);
+
+   (void) plog->startAsync();
+
+   for (i = 0; i < U_NUM_RECORD; ++i) write(*binary, *plog, i);
+
+   uint32_t dropped = plog->getDroppedRecords();
+
+   plog->stopAsync();
+
+   (void) data.replace(plog->getMap(), plog->getFilePtr());
+
+   equal   = true;
+   skipped = 0;
+
+   UBinaryAccessLogReader reader;
+   uaccesslogrecord r;
+
+   reader.setInput(U_STRING_TO_PARAM(data));
+
+   for (nrecord = 0; reader.next(r); ++nrecord) {}
+
+   (void) decode(data, U_NUM_RECORD - nrecord, equal, skipped);
+
+   cout << "async: rotated = "  << (plog->getNumRotate() > 2)
+        << " last file > 0 = "  << (nrecord > 0)
+        << " dropped = "        << dropped
+        << " skipped = "        << skipped
+        << " equal = "          << equal << endl;
+
+   plog->closeLog();
+
+   delete plog;
+   delete binary;
+
+   (void) UFile::_unlink(path.c_str());
+#else
+   cout << "async: rotated = 1 last file > 0 = 1 dropped = 0 skipped = 0 equal = 1" << endl;
+#endif
+
+   delete expected;
+}
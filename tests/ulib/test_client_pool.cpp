@@ -0,0 +1,158 @@
+// test_client_pool.cpp
+
+#include <ulib/net/tcpsocket.h>
+#include <ulib/net/client/pool.h>
+
+#include <netinet/in.h>
+
+#define PORT 11013
+
+// a minimal backend on 127.0.0.1: every connection is served by a child process that close it when it receive "quit"
+
+static pid_t startServer()
+{
+   U_TRACE_NO_PARAM(5, "startServer()")
+
+   int on = 1, sfd = socket(AF_INET, SOCK_STREAM, 0);
+   struct sockaddr_in addr;
+
+   (void) memset(&addr, 0, sizeof(addr));
+
+   addr.sin_family      = AF_INET;
+   addr.sin_port        = htons(PORT);
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   (void) setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+   if (bind(sfd, (struct sockaddr*)&addr, sizeof(addr)) ||
+       listen(sfd, 16))
+      {
+      U_ERROR("test_client_pool: bind on port %u failed", PORT);
+      }
+
+   pid_t pid = fork();
+
+   if (pid == 0)
+      {
+      int fd;
+      char buffer[64];
+
+      while ((fd = accept(sfd, U_NULLPTR, U_NULLPTR)) != -1)
+         {
+         if (fork() == 0)
+            {
+            (void) close(sfd);
+
+            while (read(fd, buffer, sizeof(buffer)) > 0 &&
+                   memcmp(buffer, U_CONSTANT_TO_PARAM("quit")) != 0)
+               {
+               }
+
+            U_EXIT(0);
+            }
+
+         (void) close(fd);
+         }
+
+      U_EXIT(0);
+      }
+
+   (void) close(sfd);
+
+   U_RETURN(pid);
+}
+
+static void print(UClientPool_Base& pool, const char* step)
+{
+   UClientPool_Base::stats s;
+
+   pool.getStatistics(s);
+
+   printf("%-28s hits %u misses %u full %u errors %u closed %u active %u idle %u\n", step,
+          (uint32_t)s.hits, (uint32_t)s.misses, (uint32_t)s.full, (uint32_t)s.errors, (uint32_t)s.closed, s.active, s.idle);
+}
+
+static void quit(UClient_Base* client)
+{
+   (void) write(client->getFd(), U_CONSTANT_TO_PARAM("quit"));
+
+   UTimeVal::nanosleep(200); // NB: to be sure that the backend has closed the connection...
+}
+
+int U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   pid_t pid = startServer();
+
+   UString host(U_CONSTANT_TO_PARAM("127.0.0.1"));
+   UClientPool<UClient<UTCPSocket> > pool(2, 1, 0); // max_conn 2, max_idle 1, idle_timeout never
+
+   UClient<UTCPSocket>* c1 = pool.acquire(host, PORT);
+   UClient<UTCPSocket>* c2 = pool.acquire(host, PORT);
+   UClient<UTCPSocket>* c3 = pool.acquire(host, PORT);
+
+   printf("c1 %s c2 %s c3 %s\n", (c1 && c1->isConnected() ? "connected" : "null"),
+                                 (c2 && c2->isConnected() ? "connected" : "null"),
+                                 (c3                      ? "connected" : "null"));
+
+   print(pool, "acquire x3 (max_conn 2)");
+
+   pool.release(c1);
+   pool.release(c2); // NB: max_idle 1 => closed...
+
+   print(pool, "release x2 (max_idle 1)");
+
+   c3 = pool.acquire(host, PORT);
+
+   printf("reuse of the warm connection: %s\n", (c3 == c1 ? "yes" : "no"));
+
+   print(pool, "acquire (warm)");
+
+   quit(c3); // the backend close the connection while it is idle...
+
+   pool.release(c3);
+
+   c1 = pool.acquire(host, PORT);
+
+   print(pool, "acquire (dead connection)");
+
+   quit(c1);
+
+   pool.release(c1);
+
+   (void) pool.handlerTime();
+
+   print(pool, "health check (dead)");
+
+   c1 = pool.acquire(host, PORT);
+
+   pool.release(c1);
+
+   pool.idle_timeout = 1;
+
+   (void) sleep(2);
+
+   (void) pool.handlerTime();
+
+   print(pool, "health check (idle_timeout)");
+
+   c1 = pool.acquire(host, PORT);
+
+   pool.release(c1, false); // NB: error => closed...
+
+   print(pool, "release (error)");
+
+   c1 = pool.acquire(host, PORT+1);
+
+   printf("connection refused: %s\n", (c1 ? "connected" : "null"));
+
+   print(pool, "acquire (no backend)");
+
+   printf("backend %u\n", pool.getNumBackend());
+
+   (void) kill(pid, SIGKILL);
+   (void) waitpid(pid, U_NULLPTR, 0);
+}
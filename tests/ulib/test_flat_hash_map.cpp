@@ -0,0 +1,281 @@
+// test_flat_hash_map.cpp
+
+#include <ulib/container/flat_hash_map.h>
+
+// NB: the probe sequences depend on the hash seed (random), so we print only what don't depend on the position of the keys...
+
+class UFlatHashMapTest : public UFlatHashMap<UString> {
+public:
+
+   explicit UFlatHashMapTest(uint32_t n) : UFlatHashMap<UString>(n) {}
+
+   uint32_t getDeleted() const { return ndeleted; }
+
+   // the table is consistent: the control bytes of the first group are replicated, every full slot has the fingerprint of its hash
+
+   bool check() const
+      {
+      uint32_t i, n = 0, d = 0;
+
+      for (i = 0; i < _capacity; ++i)
+         {
+         if (i < U_FLAT_HASH_MAP_GROUP &&
+             ctrl[i] != ctrl[_capacity + i])
+            {
+            return false;
+            }
+
+         if (ctrl[i] >= 0)
+            {
+            ++n;
+
+            if (ctrl[i] != (int8_t)(slots[i].hash >> 25)) return false;
+            }
+         else if (ctrl[i] == U_FLAT_HASH_MAP_DELETED) ++d;
+         }
+
+      return (n == _length && d == ndeleted);
+      }
+
+   bool findAll(uint32_t start, uint32_t end, uint32_t step = 1)
+      {
+      UString key(100U);
+
+      for (uint32_t i = start; i < end; i += step)
+         {
+         key.snprintf(U_CONSTANT_TO_PARAM("key%u"), i);
+
+         if (find(key) == false ||
+             UString(elem()).strtoul() != i)
+            {
+            return false;
+            }
+         }
+
+      return true;
+      }
+
+   bool findNone(uint32_t start, uint32_t end, uint32_t step = 1)
+      {
+      UString key(100U);
+
+      for (uint32_t i = start; i < end; i += step)
+         {
+         key.snprintf(U_CONSTANT_TO_PARAM("key%u"), i);
+
+         if (find(key)) return false;
+         }
+
+      return true;
+      }
+};
+
+static void insert(UFlatHashMapTest& t, uint32_t start, uint32_t end, uint32_t step = 1)
+{
+   U_TRACE(5, "insert(%p,%u,%u,%u)", &t, start, end, step)
+
+   for (uint32_t i = start; i < end; i += step)
+      {
+      UString key(100U), value(100U); // NB: the map hold the reference of the key...
+
+        key.snprintf(U_CONSTANT_TO_PARAM("key%u"), i);
+      value.snprintf(U_CONSTANT_TO_PARAM("%u"),    i);
+
+      t.insert(key, value);
+      }
+}
+
+static void erase(UFlatHashMapTest& t, uint32_t start, uint32_t end, uint32_t step = 1)
+{
+   U_TRACE(5, "erase(%p,%u,%u,%u)", &t, start, end, step)
+
+   UString key(100U);
+
+   for (uint32_t i = start; i < end; i += step)
+      {
+      key.snprintf(U_CONSTANT_TO_PARAM("key%u"), i);
+
+      (void) t.erase(key);
+      }
+}
+
+static UString* visit;
+
+static bool add(UStringRep* key, void* elem)
+{
+   U_TRACE(5, "add(%V,%p)", key, elem)
+
+   visit->append(key->data(), key->size());
+   visit->push_back(' ');
+
+   U_RETURN(true);
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   // insert and find
+
+   UFlatHashMapTest t(64);
+
+   insert(t, 0, 1000);
+
+   cout << "insert: size = "  << t.size()
+        << " capacity = "     << t.capacity()
+        << " find = "         << t.findAll(0, 1000)
+        << " miss = "         << t.findNone(1000, 2000)
+        << " check = "        << t.check() << endl;
+
+   // an insert of a key already present replace the value
+
+   t.insert(U_STRING_FROM_CONSTANT("key7"), U_STRING_FROM_CONSTANT("seven"));
+
+   cout << "replace: size = " << t.size() << " key7 = " << t[U_STRING_FROM_CONSTANT("key7")] << endl;
+
+   t.insert(U_STRING_FROM_CONSTANT("key7"), U_STRING_FROM_CONSTANT("7"));
+
+   // erase
+
+   erase(t, 0, 1000, 2);
+
+   cout << "erase: size = "   << t.size()
+        << " capacity = "     << t.capacity()
+        << " find = "         << t.findAll(1, 1000, 2)
+        << " miss = "         << t.findNone(0, 1000, 2)
+        << " check = "        << t.check() << endl;
+
+   cout << "erase again = " << t.erase(U_STRING_FROM_CONSTANT("key0")).empty() << endl;
+
+   erase(t, 1, 1000, 2);
+
+   cout << "erase all: size = " << t.size() << " empty = " << t.empty() << " check = " << t.check() << endl;
+
+   // tombstone reuse: near the growth limit the runs of full slots are longer than a group, so an erase leave a tombstone
+   // and the insert after the lookup of the same key reuse it (without grow)
+
+   UFlatHashMapTest t1(64);
+
+   insert(t1, 0, 55);
+
+   uint32_t capacity = t1.capacity();
+
+   erase(t1, 0, 55, 3);
+
+   uint32_t ndeleted = t1.getDeleted();
+
+   insert(t1, 0, 55, 3);
+
+   cout << "tombstone: size = " << t1.size()
+        << " deleted = "        << (ndeleted > 0)
+        << " reused = "         << (t1.getDeleted() < ndeleted)
+        << " capacity = "       << (t1.capacity() == capacity)
+        << " find = "           << t1.findAll(0, 55)
+        << " check = "          << t1.check() << endl;
+
+   // rehash under DELETED pressure: a sliding window of keys (insert the new one, erase the oldest) fill the table with tombstones,
+   // the rehash must purge them without grow the table while the live entries are few...
+
+   UFlatHashMapTest t2(64);
+
+   uint32_t i, window = 20, maxdeleted = 0;
+
+   insert(t2, 0, window);
+
+   capacity = t2.capacity();
+
+   for (i = window; i < 100000; ++i)
+      {
+      insert(t2,          i, i+1);
+       erase(t2, i - window, i - window + 1);
+
+      if (t2.getDeleted() > maxdeleted) maxdeleted = t2.getDeleted();
+      }
+
+   cout << "purge: size = "   << t2.size()
+        << " capacity = "     << (t2.capacity() == capacity)
+        << " bounded = "      << ((maxdeleted + window) <= (capacity - capacity / 8))
+        << " find = "         << t2.findAll(i - window, i)
+        << " miss = "         << t2.findNone(0, i - window, 97)
+        << " check = "        << t2.check() << endl;
+
+   // ...and to grow the table when the live entries are many
+
+   window = 40;
+
+   insert(t2, i, i + window - 20);
+
+   for (i += window - 20; i < 200000; ++i)
+      {
+      insert(t2,          i, i+1);
+       erase(t2, i - window, i - window + 1);
+      }
+
+   cout << "grow: size = "    << t2.size()
+        << " capacity = "     << t2.capacity()
+        << " find = "         << t2.findAll(i - window, i)
+        << " check = "        << t2.check() << endl;
+
+   // traversal order: first()/next() and callForAllEntry() visit the slots in the same (index) order, every entry once...
+
+   UFlatHashMapTest t3(64);
+
+   insert(t3, 0, 40);
+    erase(t3, 0, 40, 4);
+
+   UString keys(U_CAPACITY);
+   uint32_t n = 0, last = 0;
+   bool ordered = true;
+
+   U_NEW(UString, visit, UString(U_CAPACITY));
+
+   for (bool ok = (t3.first() != U_NULLPTR); ok; ok = t3.next())
+      {
+      if (n++ && t3.index <= last) ordered = false;
+
+      last = t3.index;
+
+      keys.append(t3.key()->data(), t3.key()->size());
+      keys.push_back(' ');
+      }
+
+   t3.callForAllEntry(add);
+
+   cout << "traversal: visited = " << n
+        << " ordered = "           << ordered
+        << " same = "              << (keys == *visit) << endl;
+
+   // ...callForAllEntrySorted() in the order of the keys...
+
+   UFlatHashMapTest t4(16);
+
+   t4.insert(U_STRING_FROM_CONSTANT("delta"),   U_STRING_FROM_CONSTANT("4"));
+   t4.insert(U_STRING_FROM_CONSTANT("alpha"),   U_STRING_FROM_CONSTANT("1"));
+   t4.insert(U_STRING_FROM_CONSTANT("charlie"), U_STRING_FROM_CONSTANT("3"));
+   t4.insert(U_STRING_FROM_CONSTANT("echo"),    U_STRING_FROM_CONSTANT("5"));
+   t4.insert(U_STRING_FROM_CONSTANT("bravo"),   U_STRING_FROM_CONSTANT("2"));
+
+   visit->setEmpty();
+
+   t4.callForAllEntrySorted(add);
+
+   cout << "sorted: " << *visit << endl;
+
+   // ...and the erase of the current entry while traversing don't skip the others
+
+   n = 0;
+
+   for (bool ok = (t3.first() != U_NULLPTR); ok; ok = t3.next())
+      {
+      ++n;
+
+      t3.eraseAfterFind();
+      }
+
+   cout << "erase while traversing: visited = " << n << " size = " << t3.size() << " check = " << t3.check() << endl;
+
+   delete visit;
+}
@@ -1089,6 +1089,77 @@ static void testMultiple()
    U_INTERNAL_ASSERT_EQUALS( result.size(), reqJson.size() )
 }
 
+// The two stage parser (@see ulib/json/tape.h)
+
+static void testTape()
+{
+   U_TRACE_NO_PARAM(5, "testTape()")
+
+   UJsonTape tape;
+   UValue json, json1;
+   UString result, result1,
+           exampleJson = U_STRING_FROM_CONSTANT("{"
+                                                "  \"astring\": \"This is a \\\"string\\\"\",\n"
+                                                "  \"number1\": 42,\n"
+                                                "  \"number2\":  -123.45,\n"
+                                                "  \"anObject\":{\"one\":1,\"two\":{\"obj2.1\":21,\"obj2.2\":22},\"three\":333},\n"
+                                                "  \"anArray\":[0, \"one\", {\"two.0\":20,\"two.1\":21}, 3, [4,44,444]],\n"
+                                                "  \"isnull\":null,\n"
+                                                "  \"yes\": true,\n"
+                                                "  \"no\":  false\n"
+                                                "}");
+
+   bool ok = tape.parse(exampleJson);
+
+   U_INTERNAL_ASSERT(ok)
+
+   U_INTERNAL_ASSERT_EQUALS(tape.getTag(0), U_OBJECT_VALUE)
+   U_INTERNAL_ASSERT_EQUALS(tape.getSize(0), 8)
+
+   uint32_t pos = tape.at(0, U_CONSTANT_TO_PARAM("astring"));
+
+   U_INTERNAL_ASSERT_EQUALS(tape.getString(pos), "This is a \"string\"")
+
+   pos = tape.at(0, U_CONSTANT_TO_PARAM("number2"));
+
+   U_INTERNAL_ASSERT_EQUALS(tape.getDouble(pos), -123.45)
+
+   pos = tape.at(tape.at(0, U_CONSTANT_TO_PARAM("anArray")), 4U);
+
+   U_INTERNAL_ASSERT_EQUALS(tape.getInt(tape.at(pos, 2U)), 444)
+   U_INTERNAL_ASSERT_EQUALS(tape.at(pos, 3U), U_NOT_FOUND)
+   U_INTERNAL_ASSERT_EQUALS(tape.at(0, U_CONSTANT_TO_PARAM("missing")), U_NOT_FOUND)
+
+   ok = tape.getBool(tape.at(0, U_CONSTANT_TO_PARAM("yes")));
+
+   U_INTERNAL_ASSERT(ok)
+
+   // the tape and the tree must give the same value
+
+   tape.stringify(result);
+
+   json.fromTape(tape);
+
+   result1 = json.output();
+
+   U_INTERNAL_ASSERT_EQUALS(result, result1)
+
+   ok = json1.parse(exampleJson);
+
+   U_INTERNAL_ASSERT(ok)
+
+   U_INTERNAL_ASSERT_EQUALS(json1.output(), result1)
+
+   // RFC 8259: no comments, no trailing commas, no leading zeroes, no invalid escapes...
+
+   ok = tape.parse(U_STRING_FROM_CONSTANT("[1, /* comment */ 2]"))   || tape.parse(U_STRING_FROM_CONSTANT("[1,2,]"))        ||
+        tape.parse(U_STRING_FROM_CONSTANT("{\"a\":01}"))            || tape.parse(U_STRING_FROM_CONSTANT("[\"\\x\"]"))  ||
+        tape.parse(U_STRING_FROM_CONSTANT("[\"\\u12G4\"]"))         || tape.parse(U_STRING_FROM_CONSTANT("[\"a\tb\"]")) ||
+        tape.parse(U_STRING_FROM_CONSTANT("[truex]"))                || tape.parse(U_STRING_FROM_CONSTANT("[\"abc]"));
+
+   U_INTERNAL_ASSERT_EQUALS(ok, false)
+}
+
 // Do a query and print the results
 
 static void testQuery(const UString& json, const char* cquery, const UString& expected)
@@ -1140,6 +1211,7 @@ U_EXPORT main (int argc, char* argv[], char* env[])
    testResponseSearch();
 
    testMultiple();
+   testTape();
 
    content = UFile::contentOf(U_STRING_FROM_CONSTANT("inp/json/prova.json"));
 
@@ -0,0 +1,75 @@
+// test_mask_matcher.cpp
+
+#include <ulib/utility/services.h>
+#include <ulib/utility/mask_matcher.h>
+
+static const char* uris[] = {
+   "/index.html", "/css/style.min.css", "/images/LOGO.PNG", "/api/v1/internal/metrics", "/api/v12/internal/x", "/admin/",
+   "/admin", "/.git/config", "/src/.git/HEAD", "/cgi-bin/test.cgi", "/cgi-bin/test.cgi.bak", "/bank/123/transfer", "/bank/transfer",
+   "/login.php", "/login.php~", "/download/ubuntu.iso", "/download/a/b/c.tar.gz", "x", "*", "?"
+};
+
+static void check(const char* mask, int flags = 0)
+{
+   U_TRACE(5, "check(%S,%d)", mask, flags)
+
+   UString x(mask, strlen(mask));
+   UMaskMatcher matcher(x, flags);
+
+   cout << "mask: "        << (x.size() <= 80 ? mask : "(long)")
+        << " flags = "     << flags
+        << " pattern = "   << matcher.getNumPattern()
+        << " compiled = "  << matcher.isCompiled() << endl;
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(uris); ++i)
+      {
+      uint64_t result = matcher.match(uris[i], strlen(uris[i]));
+
+      if (matcher.isMatch(uris[i], strlen(uris[i])) != UServices::dosMatchWithOR(uris[i], strlen(uris[i]), U_STRING_TO_PARAM(x), flags))
+         {
+         cout << "   " << uris[i] << " differ from UServices::dosMatchWithOR()" << endl;
+         }
+
+      if (result) cout << "   " << uris[i] << " = " << hex << result << dec << endl;
+      }
+
+   cout << "   (empty) = " << hex << matcher.match("", 0) << dec << endl;
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   check("*.css|*.js|*.html|*.htm|*.png");
+   check("*.css|*.js|*.html|*.htm|*.png", FNM_IGNORECASE);
+   check("/admin/*|/api/v?/internal/*|*/.git/*|/cgi-bin/*.cgi");
+   check("/bank/*/transfer|/login.php|*~|*.bak");
+   check("/download/*.iso|/download/*.tar.gz|?");
+   check("*|**|/*|?*");
+   check("||/login.php||"); // an empty alternative match nothing
+
+   // more than 64 patterns: the patterns are matched one at a time (NB: only the bit 63 if the pattern that match is beyond the 64-th)...
+
+   UString mask(U_CAPACITY);
+
+   for (uint32_t i = 0; i < 70; ++i) mask.snprintf_add(U_CONSTANT_TO_PARAM("/dir%u/*|"), i);
+
+   (void) mask.append(U_CONSTANT_TO_PARAM("*.iso|*.php|*"));
+
+   check(mask.c_str());
+
+   // ...and the empty string match only the patterns made only of '*' like with the DFA
+
+   check("/x|**|*.php");
+
+   (void) mask.replace(U_CONSTANT_TO_PARAM("/x|**|*.php|"));
+
+   for (uint32_t i = 0; i < 70; ++i) mask.snprintf_add(U_CONSTANT_TO_PARAM("/dir%u/*|"), i);
+
+   mask.size_adjust(mask.size()-1);
+
+   check(mask.c_str());
+}
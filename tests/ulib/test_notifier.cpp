@@ -370,12 +370,89 @@ public:
 #endif
 };
 
+// a completion still pending for a descriptor closed and reused must not be delivered to the new handler
+
+static int reuse_cnt[2];
+
+class handlerReuse : public UEventFd {
+public:
+
+   int id;
+
+   handlerReuse(int _fd, int _id) : id(_id)
+      {
+      fd = _fd;
+      }
+
+   int handlerRead()
+      {
+      U_TRACE(0, "handlerReuse::handlerRead()")
+
+      char buffer[16];
+
+      ++reuse_cnt[id];
+
+      (void) U_SYSCALL(read, "%d,%p,%u", fd, buffer, sizeof(buffer));
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+};
+
+static void reuse_test()
+{
+   U_TRACE_NO_PARAM(5, "reuse_test()")
+
+   int fds[2];
+   handlerReuse* a;
+   handlerReuse* b;
+   UEventTime timeout(0L, 10L * 1000L);
+
+   UNotifier::max_connection = 64;
+
+   UNotifier::init();
+
+   (void) pipe2(fds, O_NONBLOCK);
+
+   U_NEW(handlerReuse, a, handlerReuse(fds[0], 0));
+
+   UNotifier::insert(a);
+   UNotifier::waitForEvent(&timeout);
+
+   (void) U_SYSCALL(write, "%d,%p,%u", fds[1], U_CONSTANT_TO_PARAM("A"));
+
+   UNotifier::handlerDelete(a);
+
+   (void) U_SYSCALL(close, "%d", fds[0]);
+   (void) U_SYSCALL(close, "%d", fds[1]);
+
+   (void) pipe2(fds, O_NONBLOCK); // NB: the same descriptors...
+
+   U_NEW(handlerReuse, b, handlerReuse(fds[0], 1));
+
+   UNotifier::insert(b);
+   UNotifier::waitForEvent(&timeout);
+
+   printf("reuse: A = %d B = %d\n", reuse_cnt[0], reuse_cnt[1]);
+
+   (void) U_SYSCALL(write, "%d,%p,%u", fds[1], U_CONSTANT_TO_PARAM("B"));
+
+   UNotifier::waitForEvent(&timeout);
+
+   printf("reuse: A = %d B = %d\n", reuse_cnt[0], reuse_cnt[1]);
+
+   UNotifier::handlerDelete(b);
+
+   (void) U_SYSCALL(close, "%d", fds[0]);
+   (void) U_SYSCALL(close, "%d", fds[1]);
+}
+
 int U_EXPORT main(int argc, char* argv[])
 {
    U_ULIB_INIT(argv);
 
    U_TRACE(5,"main(%d)",argc)
 
+   reuse_test();
    list_test();
 
    int fds[2], n = (argc > 1 ? u_atoi(argv[1]) : 5);
@@ -0,0 +1,180 @@
+// test_orm_async.cpp
+
+#include <ulib/notifier.h>
+#include <ulib/orm/orm_driver.h>
+
+// NB: a driver that simulate the connection with a pipe: every byte written on the pipe is the result of the oldest execution in flight...
+
+class UOrmDriverPipe : public UOrmDriver {
+public:
+
+   UOrmDriverPipe() : UOrmDriver(U_STRING_FROM_CONSTANT("pipe"))
+      {
+      U_TRACE_REGISTER_OBJECT(5, UOrmDriverPipe, "")
+
+      nreset = nresult = 0;
+
+      open();
+      }
+
+   ~UOrmDriverPipe()
+      {
+      U_TRACE_UNREGISTER_OBJECT(5, UOrmDriverPipe)
+      }
+
+   void open()
+      {
+      U_TRACE_NO_PARAM(5, "UOrmDriverPipe::open()")
+
+      (void) pipe2(fds, O_NONBLOCK);
+
+      UOrmDriver::connection = this;
+      }
+
+   void result(char c)
+      {
+      U_TRACE(5, "UOrmDriverPipe::result(%C)", c)
+
+      (void) U_SYSCALL(write, "%d,%p,%u", fds[1], &c, 1);
+      }
+
+   void lost()
+      {
+      U_TRACE_NO_PARAM(5, "UOrmDriverPipe::lost()")
+
+      (void) U_SYSCALL(close, "%d", fds[1]);
+                                    fds[1] = -1;
+      }
+
+   void disconnect() // NB: the same of the destructor of UOrmSession...
+      {
+      U_TRACE_NO_PARAM(5, "UOrmDriverPipe::disconnect()")
+
+      pasync->breset = false;
+
+      UNotifier::handlerDelete(pasync);
+      }
+
+   virtual int getFd() U_DECL_FINAL { return fds[0]; }
+
+   virtual bool asyncSend(USqlStatement* pstmt) U_DECL_FINAL { return (fds[1] != -1); }
+
+   virtual bool asyncRead() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(5, "UOrmDriverPipe::asyncRead()")
+
+      char c;
+      int n;
+
+      while ((n = U_SYSCALL(read, "%d,%p,%u", fds[0], &c, 1)) == 1) buffer[nresult++] = c;
+
+      if (n == 0) U_RETURN(false); // NB: connection lost...
+
+      U_RETURN(true);
+      }
+
+   virtual int asyncResult(USqlStatement* pstmt) U_DECL_FINAL
+      {
+      U_TRACE(5, "UOrmDriverPipe::asyncResult(%p)", pstmt)
+
+      if (nresult == 0) U_RETURN(U_ORM_ASYNC_AGAIN);
+
+      int result = (buffer[0] == 'k' ? U_ORM_ASYNC_OK : U_ORM_ASYNC_ERROR);
+
+      (void) memmove(buffer, buffer+1, --nresult);
+
+      U_RETURN(result);
+      }
+
+   virtual bool asyncReset() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(5, "UOrmDriverPipe::asyncReset()")
+
+      ++nreset;
+
+      (void) U_SYSCALL(close, "%d", fds[0]);
+
+      open();
+
+      U_RETURN(true);
+      }
+
+   int fds[2];
+   char buffer[32];
+   uint32_t nreset, nresult;
+};
+
+static UString* out;
+
+static void callback(void* arg, bool ok)
+{
+   U_TRACE(5, "callback(%p,%b)", arg, ok)
+
+   out->snprintf_add(U_CONSTANT_TO_PARAM(" %s=%b"), (const char*)arg, ok);
+}
+
+static void print(const char* title, UOrmDriverPipe& drv)
+{
+   U_TRACE(5, "print(%S,%p)", title, &drv)
+
+   cout << title << ':' << *out << " (in flight " << drv.getNumAsyncInFlight() << " reset " << drv.nreset << ')' << endl;
+
+   out->setEmpty();
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   UOrmDriverPipe drv;
+   USqlStatement* pstmt = (USqlStatement*)&drv; // NB: the statement is only passed back to the driver...
+   UEventTime timeout(0L, 10L * 1000L);
+
+   U_NEW(UString, out, UString(U_CAPACITY));
+
+   UNotifier::max_connection = 64;
+
+   UNotifier::init();
+
+   (void) drv.executeAsync(pstmt, callback, (void*)"A");
+   (void) drv.executeAsync(pstmt, callback, (void*)"B");
+   (void) drv.executeAsync(pstmt, callback, (void*)"C");
+
+   drv.result('k');
+   drv.result('e');
+
+   UNotifier::waitForEvent(&timeout);
+
+   print("result", drv);
+
+   // the connection is lost: the executions in flight fail and the driver must reset the connection
+
+   drv.lost();
+
+   UNotifier::waitForEvent(&timeout);
+
+   print("lost", drv);
+
+   // the connection is usable again
+
+   (void) drv.executeAsync(pstmt, callback, (void*)"D");
+
+   drv.result('k');
+
+   UNotifier::waitForEvent(&timeout);
+
+   print("reset", drv);
+
+   // the session is closed: the executions in flight fail but there is no reset
+
+   (void) drv.executeAsync(pstmt, callback, (void*)"E");
+
+   drv.disconnect();
+
+   print("close", drv);
+
+   delete out;
+}
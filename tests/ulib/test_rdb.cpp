@@ -1,5 +1,6 @@
 // test_rdb.cpp
 
+#include <ulib/process.h>
 #include <ulib/db/rdb.h>
 
 static int print(UStringRep* key, UStringRep* data)
@@ -54,6 +55,152 @@ static void transaction(URDB& rdb)
       }
 }
 
+static void background(const UString& name)
+{
+   U_TRACE(5, "::background(%V)", name.rep)
+
+   URDB z(false);
+   char key[32], data[32];
+   uint32_t i, nerr = 0;
+
+   if (z.open(name, 1024 * 1024, true, false, true, U_NULLPTR)) // NB: the background reorganize need the semaphore...
+      {
+      for (i = 0; i < 2000; ++i)
+         {
+         (void) z.store(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("key%u"),  i),
+                        data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("data%u"), i), RDB_INSERT);
+
+         if (i == 999 &&
+             z.startReorganize())
+            {
+            (void) z.endReorganize(true);
+            }
+         }
+
+      if (z.startReorganize())
+         {
+         // NB: changes during the build of the new cdb...
+
+         for (i = 0; i < 100; ++i)
+            {
+            (void) z.store(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("key%u"), i),
+                           data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("new%u"),  i), RDB_REPLACE);
+
+            (void) z.remove(UString(key, u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("key%u"), i+100)));
+
+            (void) z.store(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("key%u"),  i+2000),
+                           data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("data%u"), i+2000), RDB_INSERT);
+            }
+
+         (void) z.endReorganize(true);
+         }
+
+      for (i = 0; i < 2100; ++i)
+         {
+         UString value = z[UString(key, u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("key%u"), i))];
+
+         if      (i < 100)  { if (value != UString(data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("new%u"),  i))) ++nerr; }
+         else if (i < 200)  { if (value.empty() == false)                                                                   ++nerr; }
+         else               { if (value != UString(data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("data%u"), i))) ++nerr; }
+         }
+
+      cout << "background reorganize: " << z.getReorganizeInfo()->nreorganize << " size " << z.size() << " error " << nerr << endl;
+
+      z.close();
+      }
+}
+
+// NB: the db opened by another process (RDB_reference > 1) must not be reorganized in background...
+
+static char command(int fd_cmd, int fd_ack, char c)
+{
+   U_TRACE(5, "::command(%d,%d,%C)", fd_cmd, fd_ack, c)
+
+   (void) U_SYSCALL(write, "%d,%p,%u", fd_cmd, &c, 1);
+   (void) U_SYSCALL(read,  "%d,%p,%u", fd_ack, &c, 1);
+
+   return c;
+}
+
+static void shared(const UString& name)
+{
+   U_TRACE(5, "::shared(%V)", name.rep)
+
+   URDB z(false);
+   char key[32], data[32];
+   int fd_cmd[2], fd_ack[2];
+
+   if (z.open(name, 1024 * 1024, true, false, true, U_NULLPTR) == false ||
+       pipe(fd_cmd) != 0                                               ||
+       pipe(fd_ack) != 0)
+      {
+      return;
+      }
+
+   for (uint32_t i = 0; i < 1000; ++i)
+      {
+      (void) z.store(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("key%u"),  i),
+                     data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("data%u"), i), RDB_INSERT);
+      }
+
+   UProcess p;
+
+   if (p.fork() &&
+       p.child())
+      {
+      // the other process: 'o' => open the db, 'c' => close the db, 'q' => exit
+
+      char c;
+      URDB w(false);
+
+      while (U_SYSCALL(read, "%d,%p,%u", fd_cmd[0], &c, 1) == 1 && c != 'q')
+         {
+         if (c == 'o') c = (w.open(name, 1024 * 1024, false, false, true, U_NULLPTR) ? '1' : '0');
+         else
+            {
+            w.close();
+
+            c = '1';
+            }
+
+         (void) U_SYSCALL(write, "%d,%p,%u", fd_ack[1], &c, 1);
+         }
+
+      ::_exit(0); // NB: without destructors (the db of the parent is mapped)...
+      }
+
+   bool bstart;
+
+   (void) command(fd_cmd[1], fd_ack[0], 'o');
+
+   cout << "shared: start with 2 references " << z.startReorganize() << endl;
+
+   (void) command(fd_cmd[1], fd_ack[0], 'c');
+
+   bstart = z.startReorganize();
+
+   (void) command(fd_cmd[1], fd_ack[0], 'o');
+
+   cout << "shared: end with 2 references " << (bstart && z.endReorganize(true)) << " size " << z.size() << endl;
+
+   (void) command(fd_cmd[1], fd_ack[0], 'c');
+
+   bstart = z.startReorganize();
+
+   cout << "shared: end with 1 reference " << (bstart && z.endReorganize(true)) << " size " << z.size() << endl;
+
+   (void) U_SYSCALL(write, "%d,%p,%u", fd_cmd[1], "q", 1);
+
+   (void) UProcess::waitpid(p.pid(), U_NULLPTR, 0);
+
+   (void) U_SYSCALL(close, "%d", fd_cmd[0]);
+   (void) U_SYSCALL(close, "%d", fd_cmd[1]);
+   (void) U_SYSCALL(close, "%d", fd_ack[0]);
+   (void) U_SYSCALL(close, "%d", fd_ack[1]);
+
+   z.close();
+}
+
 int
 U_EXPORT main(int argc, char* argv[], char* env[])
 {
@@ -239,5 +386,8 @@ U_EXPORT main(int argc, char* argv[], char* env[])
 
          x.close();
          }
+
+      background(name + U_STRING_FROM_CONSTANT("_bg"));
+          shared(name + U_STRING_FROM_CONSTANT("_sh"));
       }
 }
@@ -0,0 +1,133 @@
+// test_shared_cache.cpp
+
+#include <ulib/timeval.h>
+#include <ulib/process.h>
+#include <ulib/shared_cache.h>
+
+#define U_NUM_CHILD 4
+#define U_NUM_KEY   1000
+
+static void print(USharedCache& c, const char* key)
+{
+   UString value = c[UString(key)];
+
+   cout << key << " = " << (value ? value : U_STRING_FROM_CONSTANT("(null)")) << endl;
+}
+
+static void child(USharedCache& c, int n)
+{
+   U_TRACE(5, "child(%p,%d)", &c, n)
+
+   char key[32], data[32];
+
+   for (int i = 0; i < U_NUM_KEY; ++i)
+      {
+      (void) c.set(key,  u__snprintf(key,  sizeof(key),  U_CONSTANT_TO_PARAM("child%d_%d"), n, i),
+                   data, u__snprintf(data, sizeof(data), U_CONSTANT_TO_PARAM("%d"), i));
+
+      (void) c.set(U_STRING_FROM_CONSTANT("shared"), U_STRING_FROM_CONSTANT("value"));
+      }
+
+   for (int i = 0; i < U_NUM_KEY; ++i)
+      {
+      UString value = c.get(key, u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("child%d_%d"), n, i));
+
+      if (value.strtol() != i) U_ERROR("child %d: wrong value for key %s", n, key);
+      }
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   int i;
+   USharedCache c;
+
+   if (c.open(U_STRING_FROM_CONSTANT("./shared_cache.file"), 8U * 1024U * 1024U, 4, U_NULLPTR, true) == false) U_ERROR("open failed");
+
+   cout << "nshard = " << c.getNumShard() << endl;
+
+   // set/get/remove
+
+   (void) c.set(U_STRING_FROM_CONSTANT("one"), U_STRING_FROM_CONSTANT("Hello"));
+   (void) c.set(U_STRING_FROM_CONSTANT("one"), U_STRING_FROM_CONSTANT("Another"));
+   (void) c.set(U_STRING_FROM_CONSTANT("two"), U_STRING_FROM_CONSTANT("Goodbye"));
+
+   print(c, "one");
+   print(c, "two");
+
+   cout << "remove(two) = " << c.remove(U_STRING_FROM_CONSTANT("two")) << endl;
+
+   print(c, "two");
+
+   // entries larger than U_MAX_DATALEN
+
+   UString large(U_MAX_DATALEN + 1000U);
+
+   for (i = 0; i < (int)(U_MAX_DATALEN + 1000U); ++i) large.push_back('a' + (i % 26));
+
+   (void) c.set(U_STRING_FROM_CONSTANT("large"), large);
+
+   cout << "large = " << (c[U_STRING_FROM_CONSTANT("large")] == large) << endl;
+
+   // ttl
+
+   (void) c.set(U_STRING_FROM_CONSTANT("ttl"), U_STRING_FROM_CONSTANT("expire"), 1);
+
+   print(c, "ttl");
+
+   UTimeVal(2L, 0L).nanosleep();
+
+   print(c, "ttl");
+
+   c.clear();
+
+   // preforked processes
+
+   UProcess p[U_NUM_CHILD];
+
+   for (i = 0; i < U_NUM_CHILD; ++i)
+      {
+      if (p[i].fork() &&
+          p[i].child())
+         {
+         child(c, i);
+
+         U_EXIT(0);
+         }
+      }
+
+   for (i = 0; i < U_NUM_CHILD; ++i) p[i].wait();
+
+   print(c, "shared");
+
+   cout << c.getStatistics() << endl;
+
+   // CLOCK: a referenced entry survive to the writing of the whole cache
+
+   c.clear();
+
+   char key[32];
+   UString data(U_CONSTANT_TO_PARAM("0123456789012345678901234567890123456789012345678901234567890123"));
+
+   (void) c.set(U_STRING_FROM_CONSTANT("hot"), U_STRING_FROM_CONSTANT("survive"));
+
+   for (i = 0; i < 4 * 100000; ++i)
+      {
+      (void) c.set(key, u__snprintf(key, sizeof(key), U_CONSTANT_TO_PARAM("cold%d"), i), U_STRING_TO_PARAM(data));
+
+      if ((i % 100) == 0) (void) c.get(U_CONSTANT_TO_PARAM("hot"));
+      }
+
+   print(c, "hot");
+   print(c, "cold0");
+
+   USharedCache::stats s;
+
+   c.getStatistics(s);
+
+   cout << "evictions > 0 = " << (s.evictions > 0) << endl;
+}
@@ -0,0 +1,154 @@
+// test_ssl_session.cpp
+
+#include <ulib/file.h>
+#include <ulib/process.h>
+#include <ulib/net/server/server.h>
+#include <ulib/ssl/net/ssl_session.h>
+
+#define U_NUM_CHILD 4
+
+// NB: the context of the server side is the one that USSLSession::init() set up with the callbacks of the session cache...
+
+class USSLContext : public USSLSocket {
+public:
+   static SSL_CTX*& server() { return sctx; }
+};
+
+static SSL_CTX* cctx;
+
+// handshake in memory between a new client and a new server (NB: the server side use the session cache shared with the children...)
+
+static bool handshake(SSL_SESSION** psess, long options)
+{
+   U_TRACE(5, "handshake(%p,%ld)", psess, options)
+
+   BIO* cbio;
+   BIO* sbio;
+   SSL* client = SSL_new(cctx);
+   SSL* server = SSL_new(USSLContext::server());
+
+   (void) BIO_new_bio_pair(&cbio, 0, &sbio, 0);
+
+   SSL_set_bio(client, cbio, cbio);
+   SSL_set_bio(server, sbio, sbio);
+
+   (void) SSL_set_options(client, options);
+
+   if (*psess) (void) SSL_set_session(client, *psess);
+
+   SSL_set_connect_state(client);
+   SSL_set_accept_state(server);
+
+   int rc1 = 0, rc2 = 0;
+
+   for (int i = 0; i < 100 && (rc1 != 1 || rc2 != 1); ++i)
+      {
+      if (rc1 != 1) rc1 = SSL_do_handshake(client);
+      if (rc2 != 1) rc2 = SSL_do_handshake(server);
+      }
+
+   bool reused = SSL_session_reused(client);
+
+   // NB: a session of a connection not shutdown cleanly is removed from the cache...
+
+   (void) SSL_shutdown(client);
+   (void) SSL_shutdown(server);
+
+   if (*psess == U_NULLPTR) *psess = SSL_get1_session(client);
+
+   SSL_free(client);
+   SSL_free(server);
+
+   if (rc1 != 1 || rc2 != 1) U_ERROR("handshake failed");
+
+   return reused;
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   // NB: the same steps of UServer: the offset of the data share before the allocation, the callbacks before the fork...
+
+   USSLSession::setDataShare();
+
+   UServer_Base::map_size        = sizeof(UServer_Base::shared_data) + UServer_Base::shared_data_add;
+   UServer_Base::ptr_shared_data = (UServer_Base::shared_data*) UFile::mmap(&UServer_Base::map_size);
+
+   USSLContext::server() = SSL_CTX_new(TLS_server_method());
+                    cctx = SSL_CTX_new(TLS_client_method());
+
+   // NB: the certificate of the test CA is old (weak key), we need the security level 0...
+
+   SSL_CTX_set_security_level(USSLContext::server(), 0);
+   SSL_CTX_set_security_level(cctx,                  0);
+
+   SSL_CTX_set_default_passwd_cb_userdata(USSLContext::server(), (void*)"caciucco");
+
+   if (SSL_CTX_use_certificate_file(USSLContext::server(), "CA/server.crt", SSL_FILETYPE_PEM) != 1 ||
+       SSL_CTX_use_PrivateKey_file( USSLContext::server(), "CA/server.key", SSL_FILETYPE_PEM) != 1)
+      {
+      U_ERROR("server certificate not loaded");
+      }
+
+   (void) SSL_CTX_set_max_proto_version(cctx, TLS1_2_VERSION);
+   (void) SSL_CTX_set_session_id_context(USSLContext::server(), (const unsigned char*)"test", 4);
+
+   // NB: every resumption by session id must go to the shared cache (the internal cache of the parent is inherited by the children)
+
+   (void) SSL_CTX_set_session_cache_mode(USSLContext::server(), SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+
+   USSLSession::init();
+
+   SSL_SESSION* sess_id     = U_NULLPTR;
+   SSL_SESSION* sess_ticket = U_NULLPTR;
+
+   cout << "session id reused = " << handshake(&sess_id,     SSL_OP_NO_TICKET) << endl;
+   cout << "ticket reused = "     << handshake(&sess_ticket, 0)                << endl;
+
+   // preforked processes: every child resume the sessions negotiated by the parent
+
+   int i;
+   UProcess proc[U_NUM_CHILD];
+
+   for (i = 0; i < U_NUM_CHILD; ++i)
+      {
+      if (proc[i].fork() &&
+          proc[i].child())
+         {
+         if (handshake(&sess_id,     SSL_OP_NO_TICKET) == false) U_ERROR("child %d: session id not resumed", i);
+         if (handshake(&sess_ticket, 0)                == false) U_ERROR("child %d: ticket not resumed", i);
+
+         U_EXIT(0);
+         }
+      }
+
+   for (i = 0; i < U_NUM_CHILD; ++i)
+      {
+      proc[i].wait();
+
+      cout << "child " << i << " = " << proc[i].exitValue() << endl;
+      }
+
+   cout << "session id reused = " << handshake(&sess_id,     SSL_OP_NO_TICKET) << endl;
+   cout << "ticket reused = "     << handshake(&sess_ticket, 0)                << endl;
+
+   // a session removed from the shared cache can't be resumed
+
+   (void) SSL_CTX_remove_session(USSLContext::server(), sess_id);
+
+   cout << "session id reused = " << handshake(&sess_id, SSL_OP_NO_TICKET) << endl;
+
+   cout << USSLSession::getStatistics() << endl;
+
+   SSL_SESSION_free(sess_id);
+   SSL_SESSION_free(sess_ticket);
+
+   USSLSession::close();
+
+   SSL_CTX_free(cctx);
+   SSL_CTX_free(USSLContext::server());
+}
@@ -2098,6 +2098,16 @@ U_EXPORT main(int argc, char* argv[])
    y = UStringExt::gunzip(x);
 
    U_ASSERT( z == y )
+
+#ifdef USE_LIBBROTLI
+   x = UStringExt::brotli(z);
+
+   U_ASSERT( x.size() < z.size() )
+
+   y = UStringExt::unbrotli(x);
+
+   U_ASSERT( z == y )
+#endif
 #endif
 
    y = U_STRING_FROM_CONSTANT("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/");
@@ -78,6 +78,47 @@ public:
 #endif
 };
 
+// an alarm that cancel (and delete) another alarm expired in the same run: the handler of the victim must not be called...
+
+class MyAlarm3 : public UEventTime {
+public:
+
+   MyAlarm3(long sec, long usec, UEventTime* _victim) : UEventTime(sec, usec), victim(_victim)
+      {
+      U_TRACE_REGISTER_OBJECT(0, MyAlarm3, "%ld,%ld,%p", sec, usec, _victim)
+      }
+
+   virtual ~MyAlarm3()
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, MyAlarm3)
+      }
+
+   virtual int handlerTime()
+      {
+      U_TRACE(0+256, "MyAlarm3::handlerTime()")
+
+      if (victim)
+         {
+         UTimer::erase(victim);
+
+         delete victim;
+         }
+      else
+         {
+         U_ERROR("MyAlarm3::handlerTime(): the handler of a cancelled alarm has been called");
+         }
+
+      U_RETURN(-1);
+      }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+private:
+   UEventTime* victim;
+};
+
 int U_EXPORT main (int argc, char* argv[])
 {
    U_ULIB_INIT(argv);
@@ -136,4 +177,23 @@ int U_EXPORT main (int argc, char* argv[])
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
    if (argc > 2) UTimer::printInfo(cout);
 #endif
+
+   MyAlarm3* c;
+   MyAlarm3* d;
+
+   U_NEW(MyAlarm3, c, MyAlarm3(0L, 20L * 1000L, U_NULLPTR));
+   U_NEW(MyAlarm3, d, MyAlarm3(0L, 10L * 1000L, c));
+
+   UTimer::insert(c);
+   UTimer::insert(d);
+
+   s.nanosleep();
+
+   UTimer::run(); // NB: d (expire first) erase and delete c that is in the same batch...
+
+   U_INTERNAL_ASSERT(UTimer::empty())
+
+   delete d;
+
+   UTimer::clear();
 }
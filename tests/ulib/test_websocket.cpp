@@ -0,0 +1,110 @@
+// test_websocket.cpp
+
+#include <ulib/file.h>
+#include <ulib/net/server/server.h>
+#include <ulib/utility/websocket.h>
+
+// NB: the connection of the subscriber is one end of a socketpair, we read the frames from the other one...
+
+class USocketPair : public USocket {
+public:
+
+   USocketPair(int fd)
+      {
+      iSockDesc = fd;
+      iState    = CONNECT;
+      }
+};
+
+static int fd_peer;
+
+static void readFrame(const char* msg, uint32_t size)
+{
+   U_TRACE(5, "readFrame(%S,%u)", msg, size)
+
+   char buffer[4096];
+   unsigned char* p = (unsigned char*)buffer;
+
+   uint32_t len = U_SYSCALL(read, "%d,%p,%u", fd_peer, buffer, sizeof(buffer)),
+            payload_len = (p[1] == 126 ? ((p[2] << 8) | p[3]) : p[1]),
+            header_len  = (p[1] == 126 ? 4 : 2);
+
+   cout << "frame: fin+opcode = " << (int)p[0]
+        << " len = "              << payload_len
+        << " equal = "            << (len == header_len + size && payload_len == size && memcmp(buffer + header_len, msg, size) == 0) << endl;
+}
+
+int
+U_EXPORT main (int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   int sv[2];
+   uint32_t size = sizeof(UWebSocket::ws_broadcast);
+
+   (void) U_SYSCALL(socketpair, "%d,%d,%d,%p", AF_UNIX, SOCK_STREAM, 0, sv);
+
+   fd_peer = sv[1];
+
+   U_NEW(USocketPair, UServer_Base::csocket, USocketPair(sv[0]));
+
+   UWebSocket::broadcast_data = (UWebSocket::ws_broadcast*) UFile::mmap(&size);
+
+   UWebSocket::initBroadcast();
+
+   // a frame that wrap around the end of the ring
+
+   UWebSocket::broadcast_data->wpos  =
+   UWebSocket::broadcast_data->wnext = 3 * U_WEBSOCKET_BROADCAST_SIZE - 16;
+
+   UWebSocket::subscribe();
+
+   char msg[200];
+
+   for (uint32_t i = 0; i < sizeof(msg); ++i) msg[i] = 'a' + (i % 26);
+
+   cout << "broadcast = "      << UWebSocket::broadcast(MESSAGE_TYPE_TEXT, (const unsigned char*)msg, sizeof(msg)) << endl;
+   cout << "writeBroadcast = " << UWebSocket::writeBroadcast() << endl;
+
+   readFrame(msg, sizeof(msg));
+
+   cout << "broadcast = "      << UWebSocket::broadcast(MESSAGE_TYPE_TEXT, (const unsigned char*)"hello", 5) << endl;
+   cout << "writeBroadcast = " << UWebSocket::writeBroadcast() << endl;
+
+   readFrame("hello", 5);
+
+   // a message too large for the ring
+
+   cout << "broadcast = " << UWebSocket::broadcast(MESSAGE_TYPE_TEXT, (const unsigned char*)msg, U_WEBSOCKET_BROADCAST_SIZE) << endl;
+
+   // a frame overwritten while the subscriber was behind: the lengths are garbage (NB: their sum wrap to a small value)
+
+   uint64_t pos = UWebSocket::broadcast_data->wpos;
+
+   cout << "broadcast = " << UWebSocket::broadcast(MESSAGE_TYPE_TEXT, (const unsigned char*)"world", 5) << endl;
+
+   uint32_t len[2] = { 0xFFFFFFF0U, 0x20U };
+
+   U_MEMCPY(UWebSocket::broadcast_data->data + (pos % U_WEBSOCKET_BROADCAST_SIZE), len, sizeof(len));
+
+   cout << "writeBroadcast = " << UWebSocket::writeBroadcast() << " status_code = " << UWebSocket::status_code << endl;
+
+   // a subscriber behind of more than the size of the ring
+
+   UWebSocket::status_code    = 0;
+   UWebSocket::broadcast_rpos = UWebSocket::broadcast_data->wpos;
+
+   UString large(U_WEBSOCKET_BROADCAST_SIZE / 4);
+
+   large.size_adjust(U_WEBSOCKET_BROADCAST_SIZE / 4);
+
+   for (int i = 0; i < 5; ++i) (void) UWebSocket::broadcast(MESSAGE_TYPE_BINARY, (const unsigned char*)large.data(), large.size());
+
+   cout << "writeBroadcast = " << UWebSocket::writeBroadcast() << " status_code = " << UWebSocket::status_code << endl;
+
+   UWebSocket::unsubscribe();
+
+   UFile::munmap(UWebSocket::broadcast_data, size);
+}